@@ -75,6 +75,11 @@ find_dependency(umpire REQUIRED
                NO_DEFAULT_PATH
                PATHS ${UMPIRE_DIR})
 
+###############################################################################
+# Threads, used by the image writer
+###############################################################################
+find_dependency(Threads REQUIRED)
+
 
 if(NOT APCOMP_DIR)
   set(APCOMP_DIR ${DRAY_APCOMP_DIR})
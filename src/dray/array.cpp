@@ -13,10 +13,10 @@ template <typename T>
 Array<T>::Array () : m_internals (new ArrayInternals<T> ()){};
 
 template <typename T>
-Array<T>::Array (const T *data, const int32 size)
+Array<T>::Array (const T *data, const size_t size)
 : m_internals (new ArrayInternals<T> (data, size)){};
 
-template <typename T> void Array<T>::set (const T *data, const int32 size)
+template <typename T> void Array<T>::set (const T *data, const size_t size)
 {
   m_internals->set (data, size);
 };
@@ -65,13 +65,14 @@ template <typename T> void Array<T>::summary ()
   m_internals->summary ();
 }
 
-template <typename T> T Array<T>::get_value (const int32 i) const
+template <typename T> T Array<T>::get_value (const index_int i) const
 {
   return m_internals->get_value (i);
 }
 
 // Type Explicit instatiations
 template class Array<uint8>;
+template class Array<uint16>;
 template class Array<int32>;
 template class Array<uint32>;
 template class Array<int64>;
@@ -20,12 +20,12 @@ template <typename T> class Array
 {
   public:
   Array ();
-  Array (const T *data, const int32 size);
+  Array (const T *data, const size_t size);
   ~Array ();
 
   size_t size () const;
   void resize (const size_t size);
-  void set (const T *data, const int32 size);
+  void set (const T *data, const size_t size);
   T *get_host_ptr ();
   T *get_device_ptr ();
   const T *get_host_ptr_const () const;
@@ -34,7 +34,7 @@ template <typename T> class Array
   void operator= (const Array<T> &other);
   // gets a single value and does not synch data between
   // host and device
-  T get_value (const int32 i) const;
+  T get_value (const index_int i) const;
   Array<T> copy ();
 
   protected:
@@ -47,7 +47,7 @@ template <typename T> class ArrayInternals : public ArrayInternalsBase
 #endif
   }
 
-  ArrayInternals (const T *data, const int32 size)
+  ArrayInternals (const T *data, const size_t size)
   : ArrayInternalsBase (), m_device (nullptr), m_host (nullptr),
     m_device_dirty (true), m_host_dirty (false), m_size (size)
   {
@@ -66,10 +66,10 @@ template <typename T> class ArrayInternals : public ArrayInternalsBase
     memcpy (m_host, data, sizeof (T) * m_size);
   }
 
-  T get_value (const int32 i)
+  T get_value (const index_int i)
   {
     assert (i >= 0);
-    assert (i < m_size);
+    assert (size_t (i) < m_size);
     T val = T();
     // host only
     if (!m_cuda_enabled && !m_hip_enabled)
@@ -135,7 +135,7 @@ template <typename T> class ArrayInternals : public ArrayInternalsBase
     return val;
   }
 
-  void set (const T *data, const int32 size)
+  void set (const T *data, const size_t size)
   {
     if (m_host)
     {
@@ -358,10 +358,7 @@ template <typename T> class ArrayInternals : public ArrayInternalsBase
   {
     if (m_host != nullptr)
     {
-      auto &rm = umpire::ResourceManager::getInstance ();
-      const int allocator_id = ArrayRegistry::host_allocator_id();
-      umpire::Allocator host_allocator = rm.getAllocator (allocator_id);
-      host_allocator.deallocate (m_host);
+      ArrayRegistry::deallocate_host (m_host);
       m_host = nullptr;
       m_host_dirty = true;
     }
@@ -372,10 +369,7 @@ template <typename T> class ArrayInternals : public ArrayInternalsBase
     if (m_size == 0) return;
     if (m_host == nullptr)
     {
-      auto &rm = umpire::ResourceManager::getInstance ();
-      const int allocator_id = ArrayRegistry::host_allocator_id();
-      umpire::Allocator host_allocator = rm.getAllocator (allocator_id);
-      m_host = static_cast<T *> (host_allocator.allocate (m_size * sizeof (T)));
+      m_host = static_cast<T *> (ArrayRegistry::allocate_host (m_size * sizeof (T)));
     }
   }
 
@@ -385,10 +379,7 @@ template <typename T> class ArrayInternals : public ArrayInternalsBase
     {
       if (m_device != nullptr)
       {
-        auto &rm = umpire::ResourceManager::getInstance ();
-        const int allocator_id = ArrayRegistry::device_allocator_id();
-        umpire::Allocator device_allocator = rm.getAllocator (allocator_id);
-        device_allocator.deallocate (m_device);
+        ArrayRegistry::deallocate_device (m_device);
         m_device = nullptr;
         m_device_dirty = true;
       }
@@ -402,10 +393,7 @@ template <typename T> class ArrayInternals : public ArrayInternalsBase
     {
       if (m_device == nullptr)
       {
-        auto &rm = umpire::ResourceManager::getInstance ();
-        const int allocator_id = ArrayRegistry::device_allocator_id();
-        umpire::Allocator device_allocator = rm.getAllocator (allocator_id);
-        m_device = static_cast<T *> (device_allocator.allocate (m_size * sizeof (T)));
+        m_device = static_cast<T *> (ArrayRegistry::allocate_device (m_size * sizeof (T)));
       }
     }
   }
@@ -6,36 +6,148 @@
 #include <dray/exports.hpp>
 #include <dray/array_internals_base.hpp>
 #include <dray/array_registry.hpp>
+#include <dray/utils/data_logger.hpp>
 
 #include <umpire/Umpire.hpp>
+#include <umpire/strategy/DynamicPoolList.hpp>
+#include <umpire/strategy/MixedPool.hpp>
 #include <umpire/strategy/QuickPool.hpp>
 #include <umpire/util/MemoryResourceTraits.hpp>
 
 #include <algorithm>
 #include <iostream>
+#include <mutex>
+#include <string>
 
 namespace dray
 {
 
 std::list<ArrayInternalsBase *> ArrayRegistry::m_arrays;
 
+namespace
+{
+// arrays can be created and destroyed from several threads when
+// domains are rendered concurrently. Recursive since releasing
+// device memory asks for the allocator again
+std::recursive_mutex& registry_mutex()
+{
+  static std::recursive_mutex mutex;
+  return mutex;
+}
+
+// the umpire pools are not thread safe. Every allocation of the
+// arrays and every coalesce goes through this lock
+std::mutex& pool_mutex()
+{
+  static std::mutex mutex;
+  return mutex;
+}
+
+umpire::Allocator make_pool(const std::string &name,
+                            umpire::Allocator resource,
+                            const ArrayRegistry::PoolStrategy strategy,
+                            const size_t pool_size)
+{
+  auto &rm = umpire::ResourceManager::getInstance ();
+  if(strategy == ArrayRegistry::List)
+  {
+    return rm.makeAllocator<umpire::strategy::DynamicPoolList>(name,
+                                                               resource,
+                                                               pool_size);
+  }
+  else if(strategy == ArrayRegistry::Mixed)
+  {
+    // buckets from 256B to 128KB, every bucket 16x the previous
+    return rm.makeAllocator<umpire::strategy::MixedPool>(name,
+                                                         resource,
+                                                         1ul << 8,
+                                                         1ul << 17,
+                                                         2ul * 1024ul * 1024ul,
+                                                         16,
+                                                         pool_size);
+  }
+  else if(strategy == ArrayRegistry::None)
+  {
+    return resource;
+  }
+  return rm.makeAllocator<umpire::strategy::QuickPool>(name,
+                                                       resource,
+                                                       pool_size);
+}
+
+ArrayRegistry::PoolStats pool_stats(const int id)
+{
+  ArrayRegistry::PoolStats stats = {0, 0, 0, 0};
+  if(id == -1)
+  {
+    return stats;
+  }
+  auto &rm = umpire::ResourceManager::getInstance ();
+  umpire::Allocator allocator = rm.getAllocator(id);
+  stats.m_current = allocator.getCurrentSize();
+  stats.m_high_water = allocator.getHighWatermark();
+  stats.m_actual = allocator.getActualSize();
+  stats.m_allocations = allocator.getAllocationCount();
+  return stats;
+}
+
+// merges the free blocks of a pool into one, like umpire::coalesce,
+// under the pool lock. Returns the bytes requested from the system
+size_t coalesce_pool(const int id)
+{
+  std::lock_guard<std::mutex> lock(pool_mutex());
+  auto &rm = umpire::ResourceManager::getInstance ();
+  umpire::Allocator allocator = rm.getAllocator(id);
+  const size_t size_pre = allocator.getActualSize();
+  allocator.release();
+  const size_t size_post = allocator.getActualSize();
+  const size_t merged = size_pre > size_post ? size_pre - size_post : 0;
+  if(merged > 0)
+  {
+    allocator.deallocate(allocator.allocate(merged));
+  }
+  return merged;
+}
+
+void print_stats(std::ostream &out,
+                 const std::string &name,
+                 const ArrayRegistry::PoolStats &stats)
+{
+  const double mb = 1024. * 1024.;
+  out << name << ": current " << stats.m_current / mb << " MB"
+      << ", high water " << stats.m_high_water / mb << " MB"
+      << ", pool " << stats.m_actual / mb << " MB"
+      << ", allocations " << stats.m_allocations << "\n";
+}
+
+} // namespace
+
 int ArrayRegistry::m_device_allocator_id = -1;
 int ArrayRegistry::m_host_allocator_id = -1;
+int ArrayRegistry::m_device_pool_id = -1;
+int ArrayRegistry::m_host_pool_id = -1;
 bool ArrayRegistry::m_external_device_allocator = false;
+ArrayRegistry::PoolStrategy ArrayRegistry::m_pool_strategy = ArrayRegistry::Quick;
+// we can use the umpire profiling to find a good default size
+size_t ArrayRegistry::m_pool_size = 1ul * // 1GB default size
+                                    1024ul * 1024ul * 1024ul + 1;
+int ArrayRegistry::m_frame_depth = 0;
+size_t ArrayRegistry::m_frame_start_size = 0;
+size_t ArrayRegistry::m_frame_growth = 0;
 
 int ArrayRegistry::device_allocator_id()
 {
+  std::lock_guard<std::recursive_mutex> lock(registry_mutex());
   if(m_device_allocator_id == -1)
   {
     auto &rm = umpire::ResourceManager::getInstance ();
     auto allocator = rm.getAllocator("DEVICE");
-    // we can use the umpire profiling to find a good default size
-    auto pooled_allocator = rm.makeAllocator<umpire::strategy::QuickPool>(
-                            "GPU_POOL",
-                            allocator,
-                            1ul * // 1GB default size
-                            1024ul * 1024ul * 1024ul + 1);
+    auto pooled_allocator = make_pool("GPU_POOL",
+                                      allocator,
+                                      m_pool_strategy,
+                                      m_pool_size);
     m_device_allocator_id = pooled_allocator.getId();
+    m_device_pool_id = m_device_allocator_id;
   }
   return m_device_allocator_id;
 }
@@ -95,6 +207,7 @@ bool ArrayRegistry::device_allocator_id(int id)
   {
     release_device_res();
     m_device_allocator_id = id;
+    m_device_pool_id = id;
   }
   m_external_device_allocator = true;
   return true;
@@ -102,28 +215,166 @@ bool ArrayRegistry::device_allocator_id(int id)
 
 int ArrayRegistry::host_allocator_id()
 {
+  std::lock_guard<std::recursive_mutex> lock(registry_mutex());
   if(m_host_allocator_id == -1)
   {
     auto &rm = umpire::ResourceManager::getInstance ();
     auto allocator = rm.getAllocator("HOST");
-    // we can use the umpire profiling to find a good default size
-    auto pooled_allocator = rm.makeAllocator<umpire::strategy::QuickPool>(
-                            "HOST_POOL",
-                            allocator,
-                            1ul * // 1GB default size
-                            1024ul * 1024ul * 1024ul + 1);
-    m_host_allocator_id = pooled_allocator.getId();
+    auto pooled_allocator = make_pool("HOST_POOL",
+                                      allocator,
+                                      m_pool_strategy,
+                                      m_pool_size);
+    m_host_pool_id = pooled_allocator.getId();
+    // the pool itself is not thread safe, arrays allocate through
+    // allocate_host which serializes access
+    m_host_allocator_id = m_host_pool_id;
   }
   return m_host_allocator_id;
 }
 
+bool ArrayRegistry::pool_strategy(PoolStrategy strategy)
+{
+  std::lock_guard<std::recursive_mutex> lock(registry_mutex());
+  if(m_host_pool_id != -1 || m_device_pool_id != -1)
+  {
+    return strategy == m_pool_strategy;
+  }
+  m_pool_strategy = strategy;
+  return true;
+}
+
+ArrayRegistry::PoolStrategy ArrayRegistry::pool_strategy()
+{
+  return m_pool_strategy;
+}
+
+bool ArrayRegistry::pool_size(size_t bytes)
+{
+  std::lock_guard<std::recursive_mutex> lock(registry_mutex());
+  if(m_host_pool_id != -1 || m_device_pool_id != -1)
+  {
+    return bytes == m_pool_size;
+  }
+  m_pool_size = bytes;
+  return true;
+}
+
+ArrayRegistry::PoolStats ArrayRegistry::host_pool_stats()
+{
+  std::lock_guard<std::recursive_mutex> lock(registry_mutex());
+  return pool_stats(m_host_pool_id);
+}
+
+ArrayRegistry::PoolStats ArrayRegistry::device_pool_stats()
+{
+  std::lock_guard<std::recursive_mutex> lock(registry_mutex());
+  return pool_stats(m_device_pool_id);
+}
+
+void ArrayRegistry::memory_report(std::ostream &out)
+{
+  print_stats(out, "host", host_pool_stats());
+  print_stats(out, "device", device_pool_stats());
+}
+
+void ArrayRegistry::begin_frame()
+{
+  std::lock_guard<std::recursive_mutex> lock(registry_mutex());
+  if(m_frame_depth == 0)
+  {
+    m_frame_start_size = host_pool_stats().m_actual +
+                         device_pool_stats().m_actual;
+  }
+  m_frame_depth++;
+}
+
+void ArrayRegistry::end_frame()
+{
+  std::lock_guard<std::recursive_mutex> lock(registry_mutex());
+  m_frame_depth--;
+  if(m_frame_depth > 0)
+  {
+    return;
+  }
+  m_frame_depth = 0;
+
+  const size_t end_size = host_pool_stats().m_actual +
+                          device_pool_stats().m_actual;
+  m_frame_growth = end_size > m_frame_start_size ? end_size - m_frame_start_size : 0;
+
+  // A frame that grew the pools left them split into several system
+  // blocks. All transients of the frame are gone by now, so merge the
+  // free blocks and the next frame finds one large chunk. Frames that
+  // fit skip this, since coalescing frees and requests system memory.
+  // Those requests count towards the growth of this frame.
+  int coalesced = 0;
+  if(m_frame_growth > 0 && (m_pool_strategy == Quick || m_pool_strategy == List))
+  {
+    if(m_host_pool_id != -1)
+    {
+      m_frame_growth += coalesce_pool(m_host_pool_id);
+    }
+    if(m_device_pool_id != -1 && !m_external_device_allocator)
+    {
+      m_frame_growth += coalesce_pool(m_device_pool_id);
+    }
+    coalesced = 1;
+  }
+
+  PoolStats host = host_pool_stats();
+  PoolStats device = device_pool_stats();
+  DRAY_LOG_ENTRY("frame_pool_growth", m_frame_growth);
+  DRAY_LOG_ENTRY("coalesced", coalesced);
+  DRAY_LOG_ENTRY("host_high_water", host.m_high_water);
+  DRAY_LOG_ENTRY("device_high_water", device.m_high_water);
+}
+
+size_t ArrayRegistry::frame_growth()
+{
+  return m_frame_growth;
+}
+
+void *ArrayRegistry::allocate_host (const size_t bytes)
+{
+  const int id = host_allocator_id();
+  std::lock_guard<std::mutex> lock(pool_mutex());
+  auto &rm = umpire::ResourceManager::getInstance ();
+  return rm.getAllocator(id).allocate(bytes);
+}
+
+void ArrayRegistry::deallocate_host (void *ptr)
+{
+  const int id = host_allocator_id();
+  std::lock_guard<std::mutex> lock(pool_mutex());
+  auto &rm = umpire::ResourceManager::getInstance ();
+  rm.getAllocator(id).deallocate(ptr);
+}
+
+void *ArrayRegistry::allocate_device (const size_t bytes)
+{
+  const int id = device_allocator_id();
+  std::lock_guard<std::mutex> lock(pool_mutex());
+  auto &rm = umpire::ResourceManager::getInstance ();
+  return rm.getAllocator(id).allocate(bytes);
+}
+
+void ArrayRegistry::deallocate_device (void *ptr)
+{
+  const int id = device_allocator_id();
+  std::lock_guard<std::mutex> lock(pool_mutex());
+  auto &rm = umpire::ResourceManager::getInstance ();
+  rm.getAllocator(id).deallocate(ptr);
+}
+
 void ArrayRegistry::add_array (ArrayInternalsBase *array)
 {
+  std::lock_guard<std::recursive_mutex> lock(registry_mutex());
   m_arrays.push_front (array);
 }
 
 void ArrayRegistry::remove_array (ArrayInternalsBase *array)
 {
+  std::lock_guard<std::recursive_mutex> lock(registry_mutex());
   auto it =
   std::find_if (m_arrays.begin (), m_arrays.end (),
                 [=] (ArrayInternalsBase *other) { return other == array; });
@@ -136,6 +387,7 @@ void ArrayRegistry::remove_array (ArrayInternalsBase *array)
 
 size_t ArrayRegistry::device_usage ()
 {
+  std::lock_guard<std::recursive_mutex> lock(registry_mutex());
   size_t tot = 0;
   for (auto b = m_arrays.begin (); b != m_arrays.end (); ++b)
   {
@@ -146,6 +398,7 @@ size_t ArrayRegistry::device_usage ()
 
 size_t ArrayRegistry::host_usage ()
 {
+  std::lock_guard<std::recursive_mutex> lock(registry_mutex());
   size_t tot = 0;
   for (auto b = m_arrays.begin (); b != m_arrays.end (); ++b)
   {
@@ -156,6 +409,7 @@ size_t ArrayRegistry::host_usage ()
 
 void ArrayRegistry::release_device_res ()
 {
+  std::lock_guard<std::recursive_mutex> lock(registry_mutex());
   for (auto b = m_arrays.begin (); b != m_arrays.end (); ++b)
   {
     (*b)->release_device_ptr ();
@@ -7,6 +7,7 @@
 #define DRAY_ARRAY_REGISTRY_HPP
 
 #include <list>
+#include <ostream>
 #include <stddef.h>
 
 namespace dray
@@ -17,6 +18,23 @@ class ArrayInternalsBase;
 class ArrayRegistry
 {
   public:
+  // how the host and device pools carve up memory
+  enum PoolStrategy
+  {
+    Quick,   // umpire QuickPool (default)
+    List,    // umpire DynamicPoolList, slower but smaller footprint
+    Mixed,   // fixed size class buckets for small arrays, dynamic pool for the rest
+    None     // no pooling, every array goes to the system (debugging)
+  };
+
+  struct PoolStats
+  {
+    size_t m_current;     // bytes currently held by arrays
+    size_t m_high_water;  // peak of m_current
+    size_t m_actual;      // bytes the pool holds from the system
+    size_t m_allocations; // number of live allocations
+  };
+
   static void add_array (ArrayInternalsBase *array);
   static void remove_array (ArrayInternalsBase *array);
   static void release_device_res ();
@@ -31,12 +49,72 @@ class ArrayRegistry
   
   static int host_allocator_id();
 
+  // pool allocations of the arrays. The pools are not thread safe,
+  // these serialize access so arrays can be created from several
+  // threads and coalesced between frames
+  static void *allocate_host(size_t bytes);
+  static void deallocate_host(void *ptr);
+  static void *allocate_device(size_t bytes);
+  static void deallocate_device(void *ptr);
+
+  // pool configuration. Only has an effect before the first
+  // array is allocated, returns false otherwise
+  static bool pool_strategy(PoolStrategy strategy);
+  static PoolStrategy pool_strategy();
+  // initial size of each pool in bytes
+  static bool pool_size(size_t bytes);
+
+  // usage of the pools. All zero if the pool has not been created
+  static PoolStats host_pool_stats();
+  static PoolStats device_pool_stats();
+  // human readable high water mark report of both pools
+  static void memory_report(std::ostream &out);
+
+  // frames nest, only the outermost one is tracked. A frame that
+  // grew the pools coalesces their free blocks when it ends
+  static void begin_frame();
+  static void end_frame();
+  // bytes the pools had to request from the system during the last
+  // frame, including a coalesce at its end. Zero once rendering
+  // reaches a steady state.
+  static size_t frame_growth();
+
   private:
   static std::list<ArrayInternalsBase *> m_arrays;
 
   static int m_device_allocator_id;
   static int m_host_allocator_id;
+  // the pools behind the allocators, used for statistics
+  static int m_device_pool_id;
+  static int m_host_pool_id;
   static bool m_external_device_allocator;
+
+  static PoolStrategy m_pool_strategy;
+  static size_t m_pool_size;
+
+  static int m_frame_depth;
+  static size_t m_frame_start_size;
+  static size_t m_frame_growth;
+};
+
+// Scoped frame arena. Transient arrays created while it is alive
+// go back to the pools when they leave scope. If the frame had to
+// grow the pools, the arena merges their free blocks when it closes
+// so the next frame can be served without touching the system
+// allocator.
+class FrameArena
+{
+  public:
+  FrameArena()
+  {
+    ArrayRegistry::begin_frame();
+  }
+  ~FrameArena()
+  {
+    ArrayRegistry::end_frame();
+  }
+  FrameArena(const FrameArena &) = delete;
+  FrameArena &operator=(const FrameArena &) = delete;
 };
 
 } // namespace dray
@@ -37,12 +37,12 @@ template <typename T, int32 S>
 static inline void array_memset_vec (Array<Vec<T, S>> &array, const Vec<T, S> &val)
 {
 
-  const int32 size = array.size ();
+  const index_int size = array.size ();
 
   Vec<T, S> *array_ptr = array.get_device_ptr ();
 
   RAJA::forall<for_policy> (RAJA::RangeSegment (0, size),
-                            [=] DRAY_LAMBDA (int32 i) { array_ptr[i] = val; });
+                            [=] DRAY_LAMBDA (index_int i) { array_ptr[i] = val; });
   DRAY_ERROR_CHECK();
 }
 
@@ -50,12 +50,12 @@ template <typename T>
 static inline void array_memset (Array<T> &array, const T val)
 {
 
-  const int32 size = array.size ();
+  const index_int size = array.size ();
 
   T *array_ptr = array.get_device_ptr ();
 
   RAJA::forall<for_policy> (RAJA::RangeSegment (0, size),
-                            [=] DRAY_LAMBDA (int32 i) { array_ptr[i] = val; });
+                            [=] DRAY_LAMBDA (index_int i) { array_ptr[i] = val; });
   DRAY_ERROR_CHECK();
 }
 
@@ -63,17 +63,18 @@ template <typename T>
 static inline T array_max(Array<T> &array, const T identity)
 {
 
-  const int32 size = array.size ();
+  const index_int size = array.size ();
 
   const T *array_ptr = array.get_device_ptr_const();
   RAJA::ReduceMax<reduce_policy, T> max_value (identity);
 
-  RAJA::forall<for_policy> (RAJA::RangeSegment (0, size), [=] DRAY_LAMBDA (int32 i)
+  RAJA::forall<for_policy> (RAJA::RangeSegment (0, size), [=] DRAY_LAMBDA (index_int i)
   {
     const T val = array_ptr[i];
     max_value.max(val);
   });
   DRAY_ERROR_CHECK();
+  return max_value.get();
 }
 
 // Only modify array elements at indices in active_idx.
@@ -82,12 +83,12 @@ static inline void array_memset_vec (Array<Vec<T, S>> &array,
                                      const Array<int32> active_idx,
                                      const Vec<T, S> &val)
 {
-  const int32 asize = active_idx.size ();
+  const index_int asize = active_idx.size ();
 
   Vec<T, S> *array_ptr = array.get_device_ptr ();
   const int32 *active_idx_ptr = active_idx.get_device_ptr_const ();
 
-  RAJA::forall<for_policy> (RAJA::RangeSegment (0, asize), [=] DRAY_LAMBDA (int32 aii) {
+  RAJA::forall<for_policy> (RAJA::RangeSegment (0, asize), [=] DRAY_LAMBDA (index_int aii) {
     const int32 i = active_idx_ptr[aii];
     array_ptr[i] = val;
   });
@@ -100,12 +101,12 @@ static inline void array_memset (Array<T> &array,
                                  const Array<int32> active_idx,
                                  const T val)
 {
-  const int32 asize = active_idx.size ();
+  const index_int asize = active_idx.size ();
 
   T *array_ptr = array.get_device_ptr ();
   const int32 *active_idx_ptr = active_idx.get_device_ptr_const ();
 
-  RAJA::forall<for_policy> (RAJA::RangeSegment (0, asize), [=] DRAY_LAMBDA (int32 aii) {
+  RAJA::forall<for_policy> (RAJA::RangeSegment (0, asize), [=] DRAY_LAMBDA (index_int aii) {
     const int32 i = active_idx_ptr[aii];
     array_ptr[i] = val;
   });
@@ -117,13 +118,13 @@ template <typename T>
 static inline void array_copy (Array<T> &dest, const Array<T> &src)
 {
 
-  const int32 size = src.size ();
+  const index_int size = src.size ();
   dest.resize(size);
 
   T *dest_ptr = dest.get_device_ptr ();
   const T *src_ptr = src.get_device_ptr_const ();
 
-  RAJA::forall<for_policy> (RAJA::RangeSegment (0, size), [=] DRAY_LAMBDA (int32 i) {
+  RAJA::forall<for_policy> (RAJA::RangeSegment (0, size), [=] DRAY_LAMBDA (index_int i) {
     dest_ptr[i] = src_ptr[i];
   });
   DRAY_ERROR_CHECK();
@@ -166,7 +167,7 @@ Array<T> array_exc_scan_plus(Array<T> &array_of_sizes, T &total_size)
 
 //
 // return a compact array containing the indices of the flags
-// that are set
+// that are set. Indices are int32 like element and ctrl ids.
 //
 template <typename T>
 static inline Array<T> index_flags (Array<int32> &flags, const Array<T> &ids)
@@ -487,7 +488,7 @@ static inline Array<T> compact (Array<T> &large_ids,
 template <typename T>
 static inline Array<T> gather (const Array<T> input, Array<int32> indices)
 {
-  const int32 size_ind = indices.size ();
+  const index_int size_ind = indices.size ();
 
   Array<T> output;
   output.resize (size_ind);
@@ -496,7 +497,7 @@ static inline Array<T> gather (const Array<T> input, Array<int32> indices)
   const int32 *indices_ptr = indices.get_device_ptr_const ();
   T *output_ptr = output.get_device_ptr ();
 
-  RAJA::forall<for_policy> (RAJA::RangeSegment (0, size_ind), [=] DRAY_LAMBDA (int32 ii) {
+  RAJA::forall<for_policy> (RAJA::RangeSegment (0, size_ind), [=] DRAY_LAMBDA (index_int ii) {
     output_ptr[ii] = input_ptr[indices_ptr[ii]];
   });
   DRAY_ERROR_CHECK();
@@ -510,19 +511,20 @@ static inline Array<T> gather (const Array<T> input, Array<int32> indices)
 template <typename T>
 static Array<T> gather (const Array<T> input, int32 chunk_size, Array<int32> indices)
 {
-  const int32 size_ind = indices.size ();
+  const index_int size_ind = indices.size ();
+  const index_int size_out = size_ind * chunk_size;
 
   Array<T> output;
-  output.resize (chunk_size * size_ind);
+  output.resize (size_out);
 
   const T *input_ptr = input.get_device_ptr_const ();
   const int32 *indices_ptr = indices.get_device_ptr_const ();
   T *output_ptr = output.get_device_ptr ();
 
-  RAJA::forall<for_policy> (RAJA::RangeSegment (0, chunk_size * size_ind), [=] DRAY_LAMBDA (int32 ii) {
-    const int32 chunk_id = ii / chunk_size;  //TODO use nested iteration instead of division.
+  RAJA::forall<for_policy> (RAJA::RangeSegment (0, size_out), [=] DRAY_LAMBDA (index_int ii) {
+    const index_int chunk_id = ii / chunk_size;  //TODO use nested iteration instead of division.
     const int32 within_chunk = ii % chunk_size;
-    output_ptr[ii] = input_ptr[chunk_size * indices_ptr[chunk_id] + within_chunk];
+    output_ptr[ii] = input_ptr[index_int (chunk_size) * indices_ptr[chunk_id] + within_chunk];
   });
   DRAY_ERROR_CHECK();
 
@@ -120,7 +120,7 @@ Collection::local_bounds()
 
   for(DataSet &dom : m_domains)
   {
-    res.include(dom.mesh()->bounds());
+    res.include(dom.bounds());
   }
 
   return res;
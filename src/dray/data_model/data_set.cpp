@@ -5,6 +5,7 @@
 
 #include <dray/data_model/data_set.hpp>
 #include <dray/error.hpp>
+#include <dray/transform_3d.hpp>
 #include <algorithm>
 #include <sstream>
 
@@ -13,15 +14,69 @@ namespace dray
 
 DataSet::DataSet(std::shared_ptr<Mesh> mesh)
  : m_is_valid(true),
-   m_domain_id(0)
+   m_domain_id(0),
+   m_has_transform(false)
 {
   m_meshes.push_back(mesh);
+  m_transform.identity();
+  m_inverse_transform.identity();
 }
 
 DataSet::DataSet()
  : m_is_valid(false),
-   m_domain_id(0)
+   m_domain_id(0),
+   m_has_transform(false)
 {
+  m_transform.identity();
+  m_inverse_transform.identity();
+}
+
+void DataSet::transform(const Matrix<Float, 4, 4> &object_to_world)
+{
+  bool valid;
+  Matrix<Float, 4, 4> inverse = matrix_inverse(object_to_world, valid);
+  if(!valid)
+  {
+    DRAY_ERROR("DataSet transform is not invertible");
+  }
+  m_transform = object_to_world;
+  m_inverse_transform = inverse;
+  m_has_transform = true;
+}
+
+bool DataSet::has_transform() const
+{
+  return m_has_transform;
+}
+
+Matrix<Float, 4, 4> DataSet::transform() const
+{
+  return m_transform;
+}
+
+Matrix<Float, 4, 4> DataSet::inverse_transform() const
+{
+  return m_inverse_transform;
+}
+
+AABB<3> DataSet::bounds()
+{
+  AABB<3> obj_bounds = mesh()->bounds();
+  if(!m_has_transform || obj_bounds.is_empty())
+  {
+    return obj_bounds;
+  }
+
+  AABB<3> res;
+  for(int32 i = 0; i < 8; ++i)
+  {
+    Vec<Float, 3> corner;
+    corner[0] = (i & 1) ? obj_bounds.m_ranges[0].max() : obj_bounds.m_ranges[0].min();
+    corner[1] = (i & 2) ? obj_bounds.m_ranges[1].max() : obj_bounds.m_ranges[1].min();
+    corner[2] = (i & 4) ? obj_bounds.m_ranges[2].max() : obj_bounds.m_ranges[2].min();
+    res.include(transform_point(m_transform, corner));
+  }
+  return res;
 }
 
 void DataSet::domain_id(const int32 id)
@@ -166,6 +221,11 @@ Field* DataSet::field(const std::string &field_name)
 }
 
 Mesh* DataSet::mesh(const int32 mesh_index)
+{
+  return mesh_shared(mesh_index).get();
+}
+
+std::shared_ptr<Mesh> DataSet::mesh_shared(const int32 mesh_index)
 {
   if(!m_is_valid)
   {
@@ -176,7 +236,7 @@ Mesh* DataSet::mesh(const int32 mesh_index)
   {
     DRAY_ERROR ("Invalid mesh index: "<<mesh_index);
   }
-  return m_meshes[mesh_index].get();
+  return m_meshes[mesh_index];
 }
 
 Mesh* DataSet::mesh(const std::string mesh_name)
@@ -8,6 +8,8 @@
 
 #include <dray/data_model/field.hpp>
 #include <dray/data_model/mesh.hpp>
+#include <dray/aabb.hpp>
+#include <dray/matrix.hpp>
 #include <conduit.hpp>
 
 #include <map>
@@ -24,6 +26,11 @@ protected:
   std::vector<std::shared_ptr<Field>> m_fields;
   bool m_is_valid;
   int32 m_domain_id;
+  // instancing: meshes and fields live in object space and are placed
+  // into the world by a rigid transform (rotation, reflection, translation)
+  bool m_has_transform;
+  Matrix<Float, 4, 4> m_transform;
+  Matrix<Float, 4, 4> m_inverse_transform;
 public:
   DataSet();
   DataSet(std::shared_ptr<Mesh> topo);
@@ -31,6 +38,14 @@ public:
   void domain_id(const int32 id);
   int32 domain_id() const;
 
+  // object to world transform. Must be rigid so distances along
+  // rays are the same in both spaces
+  void transform(const Matrix<Float, 4, 4> &object_to_world);
+  bool has_transform() const;
+  Matrix<Float, 4, 4> transform() const;
+  Matrix<Float, 4, 4> inverse_transform() const;
+  // world space bounds of the first mesh
+  AABB<3> bounds();
 
   void clear_meshes();
   int32 number_of_meshes() const;
@@ -38,6 +53,7 @@ public:
   bool has_mesh(const std::string &topo_name) const;
   Mesh* mesh(const int32 topo_index = 0);
   Mesh* mesh(const std::string topo_name);
+  std::shared_ptr<Mesh> mesh_shared(const int32 topo_index = 0);
   std::vector<std::string> meshes() const;
 
   int32 number_of_fields() const;
@@ -60,7 +60,7 @@ DRAY_EXEC ElemT DeviceField<ElemT>::get_elem (int32 el_idx) const
   auto order_p = get_order_policy();
   const int32 dofs_per  = eattr::get_num_dofs(shape, order_p);
 
-  SharedDofPtr<Vec<Float, ncomp>> dof_ptr{ dofs_per * el_idx + m_idx_ptr,
+  SharedDofPtr<Vec<Float, ncomp>> dof_ptr{ index_int (dofs_per) * el_idx + m_idx_ptr,
                                            m_val_ptr };
   ret.construct (el_idx, dof_ptr, m_poly_order);
   return ret;
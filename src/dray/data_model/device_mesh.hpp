@@ -87,7 +87,7 @@ DRAY_EXEC_ONLY ElemT DeviceMesh<ElemT>::get_elem (int32 el_idx) const
   auto order_p = get_order_policy();
   const int32 dofs_per  = eattr::get_num_dofs(shape, order_p);
 
-  const int32 elem_offset = dofs_per * el_idx;
+  const index_int elem_offset = index_int (dofs_per) * el_idx;
 
   using DofVec = Vec<Float, 3u>;
   SharedDofPtr<DofVec> dof_ptr{ elem_offset + m_idx_ptr, m_val_ptr };
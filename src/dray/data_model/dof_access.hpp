@@ -28,7 +28,7 @@ template <typename DofT> struct SharedDofPtr
   // Iterator offset dereference operator.
   DRAY_EXEC const DofT &operator[] (const int32 i) const
   {
-    return m_dof_ptr[m_offset_ptr[i]];
+    return m_dof_ptr[index_int (m_offset_ptr[i])];
   }
 
   // Iterator offset operator.
@@ -47,7 +47,7 @@ template <typename DofT> struct SharedDofPtr
   // Iterator dereference operator.
   DRAY_EXEC const DofT &operator* () const
   {
-    return m_dof_ptr[*m_offset_ptr];
+    return m_dof_ptr[index_int (*m_offset_ptr)];
   }
 
   DRAY_EXEC operator ReadDofPtr<DofT>() const;
@@ -63,7 +63,7 @@ template <typename DofT> struct ReadDofPtr
   // Iterator offset dereference operator.
   DRAY_EXEC const DofT &operator[] (const int32 i) const
   {
-    return m_dof_ptr[m_offset_ptr[i]];
+    return m_dof_ptr[index_int (m_offset_ptr[i])];
   }
 
   // Iterator offset operator.
@@ -82,7 +82,7 @@ template <typename DofT> struct ReadDofPtr
   // Iterator dereference operator.
   DRAY_EXEC const DofT &operator* () const
   {
-    return m_dof_ptr[*m_offset_ptr];
+    return m_dof_ptr[index_int (*m_offset_ptr)];
   }
 
   DRAY_EXEC operator SharedDofPtr<DofT>() const;
@@ -112,7 +112,7 @@ template <typename DofT> struct WriteDofPtr
   // Iterator offset dereference operator.
   DRAY_EXEC DofT &operator[] (const int32 i)
   {
-    return m_dof_ptr[m_offset_ptr[i]];
+    return m_dof_ptr[index_int (m_offset_ptr[i])];
   }
 
   // Iterator offset operator.
@@ -138,7 +138,7 @@ template <typename DofT> struct WriteDofPtr
   // Iterator dereference operator.
   DRAY_EXEC DofT &operator* ()
   {
-    return m_dof_ptr[*m_offset_ptr];
+    return m_dof_ptr[index_int (*m_offset_ptr)];
   }
 };
 
@@ -267,6 +267,50 @@ namespace tet_props
     using V = Vec<uint8, 3>;
     return (vidx == 0 ? V{{1,0,0}} : vidx == 1 ? V{{0,1,0}} : vidx == 2 ? V{{0,0,1}} : V{{0,0,0}});
   }
+
+  // Edges shall be numbered first by edges incident to the origin,
+  // then by the remaining edges. Edge e and edge (5-e) are opposite.
+  //   00: origin--0    03: 0--1
+  //   01: origin--1    04: 0--2
+  //   02: origin--2    05: 1--2
+  enum EdgeIds { eOrig0=0, eOrig1=1, eOrig2=2,
+                 eV01=3,   eV02=4,   eV12=5 };
+
+  constexpr uint8 tet_ev0(const uint8 eid)
+  {
+    return (eid < 3 ? vOrigin : eid < 5 ? 0 : 1);
+  }
+  constexpr uint8 tet_ev1(const uint8 eid)
+  {
+    return (eid < 3 ? eid : eid == eV01 ? 1 : 2);
+  }
+
+  // Faces shall be numbered by the opposite vertex.
+  //   00: u==0   01: v==0   02: w==0   03: u+v+w==1
+  enum FaceIds { fOpp0 = 0, fOpp1 = 1, fOpp2 = 2, fOppOrig = 3 };
+
+  constexpr uint32 edges_in_face[4] = {
+    (1u<<eOrig1) | (1u<<eOrig2) | (1u<<eV12),  // f00
+    (1u<<eOrig0) | (1u<<eOrig2) | (1u<<eV02),  // f01
+    (1u<<eOrig0) | (1u<<eOrig1) | (1u<<eV01),  // f02
+    (1u<<eV01)   | (1u<<eV02)   | (1u<<eV12)   // f03
+  };
+
+  constexpr uint8 tet_common_face(const uint8 e1, const uint8 e2)
+  {
+    return !( ((1u<<e1)|(1u<<e2)) & ~edges_in_face[0] ) ? 0 :
+           !( ((1u<<e1)|(1u<<e2)) & ~edges_in_face[1] ) ? 1 :
+           !( ((1u<<e1)|(1u<<e2)) & ~edges_in_face[2] ) ? 2 :
+           !( ((1u<<e1)|(1u<<e2)) & ~edges_in_face[3] ) ? 3 : uint8(-1);
+  }
+}
+
+namespace tet_flags
+{
+  enum EdgeFlags { e00=(1u<< 0),  e01=(1u<< 1),  e02=(1u<< 2),
+                   e03=(1u<< 3),  e04=(1u<< 4),  e05=(1u<< 5) };
+
+  enum FaceFlags { f00=(1u<<0), f01=(1u<<1), f02=(1u<<2), f03=(1u<<3) };
 }
 
 
@@ -39,11 +39,11 @@ namespace dray
       //   (elen)(elen+1)(elen+2)/6 - (idx - (2*elen + 1 - j)*j/2 - i)
       //   = (elen-k)(elen-k+1)(elen-k+2)/6
       //
-      //   (e)(e+1)(e+2)/6 - (e-k)(e+1-k)(e+2-k)/6 + (2e + 1 - j)*j/2 + i = idx
+      //   (e)(e+1)(e+2)/6 - (e-k)(e+1-k)(e+2-k)/6 + (2(e-k) + 1 - j)*j/2 + i = idx
       //
-      //   ((k - 3e - 3)(k) + (3e + 6)e + 2)k/6 + (2e + 1 - j)*j/2 + i = idx
+      //   ((k - 3e - 3)(k) + (3e + 6)e + 2)k/6 + (2(e-k) + 1 - j)*j/2 + i = idx
 
-      return (((-1-e)*3+k)*k + (3*e + 6)*e + 2)*k/6 + (2*e + 1 - j)*j/2 + i;
+      return (((-1-e)*3+k)*k + (3*e + 6)*e + 2)*k/6 + (2*(e-k) + 1 - j)*j/2 + i;
     }
   }
 
@@ -155,6 +155,34 @@ namespace dray
     };
 
 
+    /** TetEdgeWalker */
+    template <int32 P>
+    struct TetEdgeWalker
+    {
+      DRAY_EXEC constexpr TetEdgeWalker(const OrderPolicy<P> order_p, const int32 eid)
+        : m_order_p(order_p),
+          m_p(eattr::get_order(order_p)),
+          m_v0(tet_props::vertices(tet_props::tet_ev0(eid))),
+          m_v1(tet_props::vertices(tet_props::tet_ev1(eid)))
+      {}
+
+      // i counts from vertex v0 (i==0) to vertex v1 (i==p).
+      DRAY_EXEC int32 edge2tet(int32 i) const
+      {
+        return ::dray::detail::cartesian_to_tet_idx(
+            m_v0[0] * (m_p-i) + m_v1[0] * i,
+            m_v0[1] * (m_p-i) + m_v1[1] * i,
+            m_v0[2] * (m_p-i) + m_v1[2] * i,
+            m_p+1);
+      }
+
+      const OrderPolicy<P> m_order_p;
+      const int32 m_p;
+      const Vec<uint8, 3> m_v0;
+      const Vec<uint8, 3> m_v1;
+    };
+
+
     /** eval_d_edge(ShapeHex, Linear) */
     template <int32 ncomp>
     DRAY_EXEC Vec<Float, ncomp> eval_d_edge( ShapeHex,
@@ -258,6 +286,53 @@ namespace dray
     }
 
 
+    /** eval_d_edge(ShapeTet, General) */
+    template <int32 ncomp>
+    DRAY_EXEC Vec<Float, ncomp> eval_d_edge( ShapeTet,
+                                             const OrderPolicy<General> order_p,
+                                             const int32 eid,
+                                             const ReadDofPtr<Vec<Float, ncomp>> &C,
+                                             const Vec<Float, 1> &rc,
+                                             Vec<Vec<Float, ncomp>, 1> &out_deriv )
+    {
+      // The restriction of a Bernstein simplex to an edge is
+      // a 1D Bernstein polynomial in the edge coefficients.
+      const int32 p = eattr::get_order(order_p);
+      const TetEdgeWalker<General> tew(order_p, eid);
+      const Float &u = rc[0], _u = 1.0-u;
+      Float upow = 1.0;
+
+      out_deriv = 0;
+
+      if (p == 0)
+        return C[0];
+
+      BinomialCoeffTable B(p);
+      Vec<Float, ncomp> result;
+      result = 0;
+
+      for (int32 i = 0; i <= p; ++i)
+      {
+        Vec<Float, ncomp> Ci = C[tew.edge2tet(i)] * B[i];
+
+        result *= _u;
+        if (i > 0)
+        {
+          out_deriv[0] += Ci * (i*upow);
+          upow *= u;
+        }
+        if (i < p)
+        {
+          out_deriv[0] *= _u;
+          out_deriv[0] += Ci * (-(p-i)*upow);
+        }
+        result += Ci * upow;
+      }
+
+      return result;
+    }
+
+
     template <int32 ncomp>
     DRAY_EXEC Vec<Float, ncomp> eval_1d(const OrderPolicy<General> order_p,
                                         const Vec<Float, ncomp> *C,
@@ -800,15 +875,15 @@ namespace dray
 
       // du
       sd[1] = 1.0f;   sd[2] = 0.0f;   sd[3] = 0.0f;
-      out_deriv[0] = C[0] * sd[0] + C[1] * sd[1] + C[2] * sd[2];
+      out_deriv[0] = C[0] * sd[0] + C[1] * sd[1] + C[2] * sd[2] + C[3] * sd[3];
 
-      // du
+      // dv
       sd[1] = 0.0f;   sd[2] = 1.0f;   sd[3] = 0.0f;
-      out_deriv[0] = C[0] * sd[0] + C[1] * sd[1] + C[2] * sd[2];
+      out_deriv[1] = C[0] * sd[0] + C[1] * sd[1] + C[2] * sd[2] + C[3] * sd[3];
 
       // dw
       sd[1] = 0.0f;   sd[2] = 0.0f;   sd[3] = 1.0f;
-      out_deriv[0] = C[0] * sd[0] + C[1] * sd[1] + C[2] * sd[2];
+      out_deriv[2] = C[0] * sd[0] + C[1] * sd[1] + C[2] * sd[2] + C[3] * sd[3];
 
       const Float s[4] = { t, u, v, w };
       return C[0] * s[0] + C[1] * s[1] + C[2] * s[2] + C[3] * s[3];
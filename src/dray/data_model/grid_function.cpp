@@ -5,6 +5,9 @@
 
 #include <dray/data_model/grid_function.hpp>
 #include <dray/array_utils.hpp>
+#include <dray/error.hpp>
+
+#include <limits>
 #include <type_traits>
 
 namespace dray
@@ -72,7 +75,7 @@ void GridFunction<PhysDim>::from_node(const conduit::Node &n_gf)
 
   if(n_gf.has_path("conn") && !n_gf["conn"].dtype().is_empty())
   {
-    const int32 csize = n_gf["conn"].dtype().number_of_elements();
+    const size_t csize = n_gf["conn"].dtype().number_of_elements();
     if(m_ctrl_idx.size() != csize)
     {
       std::cout<<"Error: mismatched conn size\n";
@@ -89,13 +92,19 @@ void GridFunction<PhysDim>::resize (int32 size_el, int32 el_dofs, int32 size_ctr
   m_size_el = size_el;
   m_size_ctrl = size_ctrl;
 
-  m_ctrl_idx.resize (size_el * el_dofs);
+  m_ctrl_idx.resize (size_t (size_el) * el_dofs);
   m_values.resize (size_ctrl);
 }
 
 template <int32 PhysDim>
 void GridFunction<PhysDim>::resize_counting (int32 size_el, int32 el_dofs)
 {
+  // every dof gets its own ctrl id, which is stored as int32
+  if(int64 (size_el) * el_dofs > std::numeric_limits<int32>::max())
+  {
+    DRAY_ERROR("resize_counting: "<<size_el<<" elements with "<<el_dofs
+               <<" dofs each exceed the int32 ctrl id range");
+  }
   m_el_dofs = el_dofs;
   m_size_el = size_el;
   m_size_ctrl = size_el * el_dofs;
@@ -23,6 +23,9 @@ template <int32 PhysDim> struct GridFunction
 
   int32 m_el_dofs;
   int32 m_size_el;
+  // ctrl ids are stored as int32, so this has to fit. The number of
+  // entries in m_ctrl_idx (size_el * el_dofs) may not, offsets into
+  // it are computed with index_int.
   int32 m_size_ctrl;
 
   // zero copy into conduit node
@@ -98,7 +101,7 @@ DeviceGridFunctionConst<ncomp>::DeviceGridFunctionConst(const GridFunction<ncomp
 template <int32 ncomp>
 DRAY_EXEC ReadDofPtr<Vec<Float, ncomp>> DeviceGridFunctionConst<ncomp>::get_rdp(int32 eidx) const
 {
-  return { m_ctrl_idx_ptr + eidx * m_el_dofs, m_values_ptr };
+  return { m_ctrl_idx_ptr + index_int (eidx) * m_el_dofs, m_values_ptr };
 }
 
 
@@ -138,13 +141,13 @@ DeviceGridFunction<ncomp>::DeviceGridFunction(GridFunction<ncomp> &gf)
 template <int32 ncomp>
 DRAY_EXEC WriteDofPtr<Vec<Float, ncomp>> DeviceGridFunction<ncomp>::get_wdp(int32 eidx) const
 {
-  return { m_ctrl_idx_ptr + eidx * m_el_dofs, m_values_ptr };
+  return { m_ctrl_idx_ptr + index_int (eidx) * m_el_dofs, m_values_ptr };
 }
 
 template <int32 ncomp>
 DRAY_EXEC ReadDofPtr<Vec<Float, ncomp>> DeviceGridFunction<ncomp>::get_rdp(int32 eidx) const
 {
-  return { m_ctrl_idx_ptr + eidx * m_el_dofs, m_values_ptr };
+  return { m_ctrl_idx_ptr + index_int (eidx) * m_el_dofs, m_values_ptr };
 }
 
 
@@ -323,17 +323,176 @@ namespace dray
 
 
 
+  // Hex splits are always halves in the subelement's own reference space.
+  DRAY_EXEC Split<Tensor> pick_iso_simple_split(ShapeHex, const IsocutInfo &info, const SubRef<3, Tensor> &)
+  {
+    return pick_iso_simple_split(ShapeHex(), info);
+  }
+
+
+  /** Adapts TetEdgeWalker to the linearize() interface of edge_var(). */
+  struct TetEdgeIdx
+  {
+    TetEdgeWalker<General> m_walker;
+    DRAY_EXEC int32 linearize(int32 i) const { return m_walker.edge2tet(i); }
+  };
+
+  DRAY_EXEC CutEdges get_cut_edges(ShapeTet, const ScalarDP & dofs, Float iota, int32 p)
+  {
+    const OrderPolicy<General> order_p{p};
+
+    // All cut edges and bad edges (bad = cut more than once).
+    uint32 ce = 0u;
+    uint32 be = 0u;
+    for (uint8 e = 0; e < 6; ++e)
+    {
+      const int32 ev = edge_var(TetEdgeIdx{TetEdgeWalker<General>(order_p, e)}, dofs, iota, p);
+      ce |= (1u << e) * (ev > 0);
+      be |= (1u << e) * (ev > 1);
+    }
+
+    CutEdges edge_flags;
+    edge_flags.cut_edges = ce;
+    edge_flags.complex_edges = be;
+    return edge_flags;
+  }
+
+
+  DRAY_EXEC uint8 get_cut_faces(ShapeTet, const ScalarDP & dofs, Float iota, int32 p)
+  {
+    using namespace tet_flags;
+
+    // Face f is where barycentric index f vanishes (mu for the face opposite the origin).
+    // One sweep over the dofs, in storage order, covers all four faces.
+    Range face_range[4];
+    int32 idx = 0;
+    for (int32 k = 0; k <= p; ++k)
+      for (int32 j = 0; j <= p-k; ++j)
+        for (int32 i = 0; i <= p-k-j; ++i, ++idx)
+        {
+          const Float val = dofs[idx][0];
+          if (i == 0)         face_range[0].include(val);
+          if (j == 0)         face_range[1].include(val);
+          if (k == 0)         face_range[2].include(val);
+          if (i + j + k == p) face_range[3].include(val);
+        }
+
+    uint8 cf = 0;
+    cf |= f00 * face_range[0].contains(iota);
+    cf |= f01 * face_range[1].contains(iota);
+    cf |= f02 * face_range[2].contains(iota);
+    cf |= f03 * face_range[3].contains(iota);
+
+    return cf;
+  }
+
+  DRAY_EXEC bool int_cut_tet(const ScalarDP &dofs, Float iota, int32 p)
+  {
+    Range dof_range;
+    const int32 ndofs = (p+1)*(p+2)/2*(p+3)/3;
+    for (int i = 0; i < ndofs; ++i)
+      dof_range.include(dofs[i][0]);
+    return dof_range.contains(iota);
+  }
+
+
   DRAY_EXEC IsocutInfo measure_isocut(ShapeTet, const ScalarDP & dofs, Float iota, int32 p)
   {
-    THROW_LOGIC_ERROR("Not implemented in " __FILE__ " measure_isocut(ShapeTet)")
-    return *(IsocutInfo*)nullptr;
+    IsocutInfo info;
+    info.clear();
+
+    using namespace tet_flags;
+
+    // All cut edges and "bad" edges (bad = cut more than once).
+    CutEdges edge_flags = get_cut_edges(ShapeTet(), dofs, iota, p);
+    const uint32 &ce = edge_flags.cut_edges;
+    const uint32 &be = edge_flags.complex_edges;
+
+    // Update info with edges.
+    info.m_bad_edges_flag = be;
+    info.m_cut_type_flag |= IsocutInfo::EdgeManyPoint * bool(be);
+
+    // All cut faces.
+    const uint8 cf = get_cut_faces(ShapeTet(), dofs, iota, p);
+
+    // FaceNoEdge (A face that is cut without any of its edges being cut).
+    uint8 fne = 0;
+    fne |= f00 * ((cf & f00) && !(ce & (e01 | e02 | e05)));
+    fne |= f01 * ((cf & f01) && !(ce & (e00 | e02 | e04)));
+    fne |= f02 * ((cf & f02) && !(ce & (e00 | e01 | e03)));
+    fne |= f03 * ((cf & f03) && !(ce & (e03 | e04 | e05)));
+
+    // FaceManyEdge (A face for which more than two incident edges are cut).
+    uint8 fme = 0;
+    fme |= f00 * ((ce & (e01 | e02 | e05)) == (e01 | e02 | e05));
+    fme |= f01 * ((ce & (e00 | e02 | e04)) == (e00 | e02 | e04));
+    fme |= f02 * ((ce & (e00 | e01 | e03)) == (e00 | e01 | e03));
+    fme |= f03 * ((ce & (e03 | e04 | e05)) == (e03 | e04 | e05));
+
+    // Update info with faces.
+    info.m_bad_faces_flag |= fne | fme;
+    info.m_cut_type_flag |= IsocutInfo::FaceNoEdge * bool(fne);
+    info.m_cut_type_flag |= IsocutInfo::FaceManyEdge * bool(fme);
+
+    const int8 num_cut_faces
+      = (uint8(0) + bool(cf & f00) + bool(cf & f01) + bool(cf & f02) + bool(cf & f03));
+
+    const bool ci = int_cut_tet(dofs, iota, p);
+
+    // Update info with interior. A tet has only four faces,
+    // so IntManyFace cannot happen.
+    info.m_cut_type_flag |= IsocutInfo::IntNoFace * (ci && !cf);
+
+    // Cut or not.
+    info.m_cut_type_flag |= IsocutInfo::Cut * (ci || cf || ce);
+
+    // Combine all info to describe whether the cut is simple.
+    // A tri cut separates one vertex (3 faces), a quad cut separates two (4 faces).
+    if (info.m_cut_type_flag < 8)
+    {
+      info.m_cut_type_flag |= IsocutInfo::CutSimpleTri *  (num_cut_faces == 3);
+      info.m_cut_type_flag |= IsocutInfo::CutSimpleQuad * (num_cut_faces == 4);
+    }
+
+    return info;
   }
 
 
-  DRAY_EXEC Split<Simplex> pick_iso_simple_split(ShapeTet, const IsocutInfo &info)
+  DRAY_EXEC Split<Simplex> pick_iso_simple_split(ShapeTet,
+                                                 const IsocutInfo &info,
+                                                 const SubRef<3, Simplex> &subref)
   {
-    THROW_LOGIC_ERROR("Not implemented in " __FILE__ " pick_iso_simple_split(ShapeTet)")
-    return *(Split<Simplex>*)nullptr;
+    const uint8 &bf = info.m_bad_faces_flag;
+    const uint32 &be = info.m_bad_edges_flag;
+
+    // Problematic edges should be split, and splitting any edge
+    // of a problematic face also splits that face.
+    // Ties go to the longest edge in the host reference space
+    // so that repeated bisection does not produce slivers.
+    uint8 split_edge = 0;
+    Float split_score = -1.0f;
+    Float split_length = -1.0f;
+    for (uint8 e = 0; e < 6; ++e)
+    {
+      const uint8 v0 = tet_props::tet_ev0(e);
+      const uint8 v1 = tet_props::tet_ev1(e);
+
+      // Face f is opposite vertex f, so it contains e unless f is an endpoint.
+      Float score = 1.0f * bool(be & (1u << e));
+      for (uint8 f = 0; f < 4; ++f)
+        score += 0.5f * (bool(bf & (1u << f)) && f != v0 && f != v1);
+
+      const Float length = (subref[v1] - subref[v0]).magnitude2();
+
+      if (score > split_score || (score == split_score && length > split_length))
+      {
+        split_edge = e;
+        split_score = score;
+        split_length = length;
+      }
+    }
+
+    return Split<Simplex>::half(tet_props::tet_ev0(split_edge), tet_props::tet_ev1(split_edge));
   }
 
 
@@ -435,6 +594,283 @@ namespace dray
   }
 
 
+  DRAY_EXEC Float cut_edge_tet(const uint8 eid, const ScalarDP &C, Float iota, const OrderPolicy<1> order_p)
+  {
+    const TetEdgeWalker<Linear> tew(order_p.as_cxp(), eid);
+    return isointercept_linear(C[tew.edge2tet(0)], C[tew.edge2tet(1)], iota);
+  }
+
+  DRAY_EXEC Float cut_edge_tet(const uint8 eid, const ScalarDP &C, Float iota, const OrderPolicy<2> order_p)
+  {
+    const TetEdgeWalker<Quadratic> tew(order_p.as_cxp(), eid);
+    return isointercept_quadratic(C[tew.edge2tet(0)],
+                                  C[tew.edge2tet(1)],
+                                  C[tew.edge2tet(2)], iota);
+  }
+
+  DRAY_EXEC Float cut_edge_tet(const uint8 eid, const ScalarDP &C, Float iota, const OrderPolicy<General> order_p)
+  {
+    const int32 p = eattr::get_order(order_p);
+    const TetEdgeWalker<General> tew(order_p, eid);
+
+    // Initial guess should be near the crossing (see cut_edge_hex()).
+    int8 v_lo = 0, v_hi = p;
+    const bool sign_lo = C[tew.edge2tet(v_lo)][0] >= iota;
+    const bool sign_hi = C[tew.edge2tet(v_hi)][0] >= iota;
+    while (v_lo < p && (C[tew.edge2tet(v_lo+1)][0] >= iota) == sign_lo)
+      v_lo++;
+    while (v_hi > 0 && (C[tew.edge2tet(v_hi-1)][0] >= iota) == sign_hi)
+      v_hi--;
+    Vec<Float, 1> r = {{0.5f * (v_lo + v_hi) / p}};
+
+    Float scalar;
+    Vec<Vec<Float, 1>, 1> deriv;
+
+    // Do num_iter Newton--Raphson steps.
+    const int8 num_iter = 8;
+    for (int8 step = 0; step < num_iter; step++)
+    {
+      scalar = eval_d_edge(ShapeTet(), order_p, eid, C, r, deriv)[0];
+      r[0] += (iota-scalar)/deriv[0][0];
+    }
+
+    return r[0];
+  }
+
+  /** @brief Reference coordinates of the point at parameter t along a tet edge. */
+  DRAY_EXEC Vec<Float, 3> tet_edge_point(const uint8 eid, const Float t)
+  {
+    const Vec<uint8, 3> v0 = tet_props::vertices(tet_props::tet_ev0(eid));
+    const Vec<uint8, 3> v1 = tet_props::vertices(tet_props::tet_ev1(eid));
+    Vec<Float, 3> pt;
+    for (int32 d = 0; d < 3; ++d)
+      pt[d] = v0[d] * (1.0f - t) + v1[d] * t;
+    return pt;
+  }
+
+
+  /**
+   * @brief Move a point onto the isosurface, searching along the initial gradient direction.
+   */
+  template <class ShapeT, int32 IP>
+  DRAY_EXEC Vec<Float, 3> volume_isopoint(ShapeT,
+                                          const ScalarDP & in,
+                                          Vec<Float, 3> pt3,
+                                          Float iota,
+                                          OrderPolicy<IP> in_order_p)
+  {
+    Vec<Vec<Float, 1>, 3> deriv;
+    Vec<Float, 1> scalar = eval_d(ShapeT(), in_order_p, in, pt3, deriv);
+
+    // For the search direction, use initial gradient direction.
+    const Vec<Float, 3> search_dir =
+        (Vec<Float, 3>{{deriv[0][0], deriv[1][0], deriv[2][0]}}).normalized();
+
+    // Do a few iterations.
+    constexpr int32 num_iter = 5;
+    for (int32 t = 0; t < num_iter; ++t)
+    {
+      scalar = eval_d(ShapeT(), in_order_p, in, pt3, deriv);
+      pt3 += search_dir * ((iota-scalar[0]) * rcp_safe(dot(deriv, search_dir)[0]));
+    }
+
+    return pt3;
+  }
+
+
+  /**
+   * @brief Move a point within a tet face onto the isocontour.
+   *
+   * Tet faces are planar in reference space, so the volume gradient
+   * projected onto the face is the gradient of the restriction to the face.
+   */
+  template <int32 IP>
+  DRAY_EXEC Vec<Float, 3> tet_face_isopoint(const uint8 fid,
+                                            const ScalarDP & in,
+                                            Vec<Float, 3> pt3,
+                                            Float iota,
+                                            OrderPolicy<IP> in_order_p)
+  {
+    Vec<Float, 3> normal = {{0.0f, 0.0f, 0.0f}};
+    if (fid == tet_props::fOppOrig)
+      normal = Vec<Float, 3>{{0.57735027f, 0.57735027f, 0.57735027f}};
+    else
+      normal[fid] = 1.0f;
+
+    Vec<Vec<Float, 1>, 3> deriv;
+    Vec<Float, 1> scalar = eval_d(ShapeTet(), in_order_p, in, pt3, deriv);
+
+    // Option 14: Use (initial) gradient direction as search.
+    const Vec<Float, 3> grad = {{deriv[0][0], deriv[1][0], deriv[2][0]}};
+    const Vec<Float, 3> search_dir = (grad - normal * dot(grad, normal)).normalized();
+
+    // Do a few iterations.
+    constexpr int32 num_iter = 5;
+    for (int32 t = 0; t < num_iter; ++t)
+    {
+      scalar = eval_d(ShapeTet(), in_order_p, in, pt3, deriv);
+      pt3 += search_dir * ((iota-scalar[0]) * rcp_safe(dot(deriv, search_dir)[0]));
+    }
+
+    return pt3;
+  }
+
+
+  /**
+   * @brief Initial guess for the interior of a triangular isopatch,
+   *        given its boundary dofs.
+   */
+  DRAY_EXEC void isopatch_tri_interior_guess(WriteDofPtr<Vec<Float, 3>> & out, const int32 oP)
+  {
+    using ::dray::detail::cartesian_to_tri_idx;
+
+    // Based on paper appendix formula for triangles, with modifications.
+    //
+    // Same basic idea:
+    // - Subtract linear part of each edge function;
+    // - Use rational ramp functions to interpolate nonlinear parts to patch interior;
+    //   - One ramp function per edge, which takes value 1 on that edge, 0 on other edges.
+    //   - Contains poles at triangle vertices, but the nonlinear part is zero there,
+    //       and we don't need to interpolate corners anyway.
+    // - Add back the linear part over the interior.
+    //
+    // I have two small modifications:
+    //   (1.) In order to evaluate the ramp function in the triangle interior,
+    //        the 2D barycentric coordinates must be related to the 1D edge coordinate
+    //        along each edge.  This relation can be accomplished through a projection.
+    //        The original method uses an orthogonal projection onto edges,
+    //        assuming the geometry of a right triangle, which is not symmetric.
+    //        I will also project orthogonally onto edges, but I will assume
+    //        the geometry of an equilateral triangle, which is symmetric.
+    //
+    //   (2.) The original method evaluates the nonlinear part of each edge function,
+    //        using polynomial interpolation over all known edge points.
+    //        I will approximate this by, after projecting to the edge, finding the
+    //        one or two nearest known points, and interpolating linearly between them.
+    //
+    // TODO Modification (2.) should be removed later in favor of full polynomial interpolation,
+    // but Lagrange/Newton evaluation is not supported yet.
+
+    const Vec<Float, 3> vp00 = out[cartesian_to_tri_idx(oP, 0, oP+1)];
+    const Vec<Float, 3> v0p0 = out[cartesian_to_tri_idx(0, oP, oP+1)];
+    const Vec<Float, 3> v00p = out[cartesian_to_tri_idx(0, 0, oP+1)];
+
+    // Orthogonal projections: Follow parallelograms
+    //      [  i  j mu ] (indices)
+    //      [  u  v  t ] (coords)
+    //   --> (-2,+1,+1) till meet (i=0) edge;
+    //   --> (+1,-2,+1) till meet (j=0) edge;
+    //   --> (+1,+1,-2) till meet (mu=0) edge.
+    const Vec<int32, 3> toi0  = {{-2,  1,  1}};
+    const Vec<int32, 3> toj0  = {{ 1, -2,  1}};
+    const Vec<int32, 3> tomu0 = {{ 1,  1, -2}};
+
+    for (int32 j = 1; j < oP; ++j)
+      for (int32 i = 1; i < oP-j; ++i)
+      {
+        const int32 mu = oP-j-i;
+        const Float u = (Float(i)/Float(oP));
+        const Float v = (Float(j)/Float(oP));
+        const Float t = (Float(mu)/Float(oP));
+
+        // Initially, linear part.
+        Vec<Float, 3> outval = vp00 * u + v0p0 * v + v00p * t;
+
+        Vec<int32, 3> bc = {{i, j, mu}};    // Store barycentric coords near edges.
+        Vec<Float, 3> nl;                   // Calculate nonlinear part on edge.
+        Float e;                            // Edge coordinate.
+        int32 count_prllgm;
+        Float ramp;
+
+        // Nonlinear contribution from (i=0) edge [(u=0) edge].
+        count_prllgm = i / 2;
+        bc += toi0 * count_prllgm;
+        e = (bc[0] == 0 ? Float(bc[1])/Float(oP) : Float(bc[1]+0.5f)/Float(oP)); //+:t->v
+        nl = out[cartesian_to_tri_idx(0, bc[1], oP+1)];
+        if (bc[0] > 0)
+          nl = nl * 0.5 + out[cartesian_to_tri_idx(0, bc[1]+1, oP+1)] * 0.5; //TODO
+        nl -= v0p0 * e + v00p * (1.0f-e);       // Subtract edge linear part.
+        ramp = ((v*t) / (e*(1.0f-e)));
+        outval += nl * ramp;
+        bc -= toi0 * count_prllgm;
+
+        // Nonlinear contribution from (j=0) edge [(v=0) edge].
+        count_prllgm = j / 2;
+        bc += toj0 * count_prllgm;
+        e = (bc[1] == 0 ? Float(bc[0])/Float(oP) : Float(bc[0]+0.5f)/Float(oP)); //+:t->u
+        nl = out[cartesian_to_tri_idx(bc[0], 0, oP+1)];
+        if (bc[1] > 0)
+          nl = nl * 0.5 + out[cartesian_to_tri_idx(bc[0]+1, 0, oP+1)] * 0.5; //TODO
+        nl -= vp00 * e + v00p * (1.0f-e);       // Subtract edge linear part.
+        ramp = ((u*t) / (e*(1.0f-e)));
+        outval += nl * ramp;
+        bc -= toj0 * count_prllgm;
+
+        // Nonlinear contribution from (mu=0) edge [(t=0) edge].
+        count_prllgm = mu / 2;
+        bc += tomu0 * count_prllgm;
+        e = (bc[2] == 0 ? Float(bc[1])/Float(oP) : Float(bc[1]+0.5f)/Float(oP)); //+:u->v
+        nl = out[cartesian_to_tri_idx(oP-bc[1], bc[1], oP+1)];
+        if (bc[2] > 0)
+          nl = nl * 0.5 + out[cartesian_to_tri_idx(oP-(bc[1]+1), bc[1]+1, oP+1)] * 0.5; //TODO
+        nl -= v0p0 * e + vp00 * (1.0f-e);       // Subtract edge linear part.
+        ramp = ((u*v) / (e*(1.0f-e)));
+        outval += nl * ramp;
+        bc -= tomu0 * count_prllgm;
+
+        out[cartesian_to_tri_idx(i, j, oP+1)] = outval;
+      }
+  }
+
+
+  /**
+   * @brief Initial guess for the interior of a quad isopatch,
+   *        given its corners and boundary dofs.
+   */
+  DRAY_EXEC void isopatch_quad_interior_guess(WriteDofPtr<Vec<Float, 3>> & out,
+                                              const Vec<Float, 3> * corners,
+                                              const int32 oP)
+  {
+    // Follows paper appendix formula for quads.
+
+    // The paper (transformed to the unit square [0,1]^2) does this:
+    //
+    //  out(i,j) =  corners[0]*(1-xi)*(1-yj) + corners[1]*( xi )*(1-yj)   // Lerp corners
+    //            + corners[2]*(1-xi)*( yj ) + corners[3]*( xi )*( yj )
+    //
+    //            + (out(i,0) - corners[0]*(1-xi) - corners[1]*( xi ))*(1-yj) // Eval deviation on x edges
+    //            + (out(i,p) - corners[2]*(1-xi) - corners[3]*( xi ))*( yj ) //  and lerp the deviation
+    //
+    //            + (out(0,j) - corners[0]*(1-yj) - corners[2]*( yj ))*(1-xi) // Eval deviation on y edges
+    //            + (out(p,j) - corners[1]*(1-yj) - corners[3]*( yj ))*( xi ) //  and lerp the deviation
+    //
+    // Many of the terms cancel, making this equivalent:
+    //
+    for (int32 j = 1; j < oP; ++j)
+    {
+      const Vec<Float, 3> dof_e2 = out[(oP+1)*j + 0];
+      const Vec<Float, 3> dof_e3 = out[(oP+1)*j + oP];
+      const Float yj = Float(j)/Float(oP);
+      const Float _yj = 1.0f - yj;
+
+      for (int32 i = 1; i < oP; ++i)
+      {
+        const Vec<Float, 3> dof_e0 = out[(oP+1)*0 + i];
+        const Vec<Float, 3> dof_e1 = out[(oP+1)*oP + i];
+        const Float xi = Float(i)/Float(oP);
+        const Float _xi = 1.0f - xi;
+
+        out[(oP+1)*j + i] =  dof_e0 * _yj + dof_e1 * yj
+                          + dof_e2 * _xi + dof_e3 * xi
+                          - corners[0] * (_xi * _yj)
+                          - corners[1] * ( xi * _yj)
+                          - corners[2] * (_xi *  yj)
+                          - corners[3] * ( xi *  yj);
+      }
+    }
+  }
+
+
   /**
    * @brief Solve for the reference coordinates of a triangular isopatch inside a hex.
    */
@@ -578,104 +1014,7 @@ namespace dray
     // For the cell volume, solve for points in middle of isopatch.
 
     // Initial guess for patch interior.
-    // Based on paper appendix formula for triangles, with modifications.
-    //
-    // Same basic idea:
-    // - Subtract linear part of each edge function;
-    // - Use rational ramp functions to interpolate nonlinear parts to patch interior;
-    //   - One ramp function per edge, which takes value 1 on that edge, 0 on other edges.
-    //   - Contains poles at triangle vertices, but the nonlinear part is zero there,
-    //       and we don't need to interpolate corners anyway.
-    // - Add back the linear part over the interior.
-    //
-    // I have two small modifications:
-    //   (1.) In order to evaluate the ramp function in the triangle interior,
-    //        the 2D barycentric coordinates must be related to the 1D edge coordinate
-    //        along each edge.  This relation can be accomplished through a projection.
-    //        The original method uses an orthogonal projection onto edges,
-    //        assuming the geometry of a right triangle, which is not symmetric.
-    //        I will also project orthogonally onto edges, but I will assume
-    //        the geometry of an equilateral triangle, which is symmetric.
-    //
-    //   (2.) The original method evaluates the nonlinear part of each edge function,
-    //        using polynomial interpolation over all known edge points.
-    //        I will approximate this by, after projecting to the edge, finding the
-    //        one or two nearest known points, and interpolating linearly between them.
-    //
-    // TODO Modification (2.) should be removed later in favor of full polynomial interpolation,
-    // but Lagrange/Newton evaluation is not supported yet.
-
-    {
-      const Vec<Float, 3> vp00 = out[cartesian_to_tri_idx(oP, 0, oP+1)];
-      const Vec<Float, 3> v0p0 = out[cartesian_to_tri_idx(0, oP, oP+1)];
-      const Vec<Float, 3> v00p = out[cartesian_to_tri_idx(0, 0, oP+1)];
-
-      // Orthogonal projections: Follow parallelograms
-      //      [  i  j mu ] (indices)
-      //      [  u  v  t ] (coords)
-      //   --> (-2,+1,+1) till meet (i=0) edge;
-      //   --> (+1,-2,+1) till meet (j=0) edge;
-      //   --> (+1,+1,-2) till meet (mu=0) edge.
-      const Vec<int32, 3> toi0  = {{-2,  1,  1}};
-      const Vec<int32, 3> toj0  = {{ 1, -2,  1}};
-      const Vec<int32, 3> tomu0 = {{ 1,  1, -2}};
-
-      for (int32 j = 1; j < oP; ++j)
-        for (int32 i = 1; i < oP-j; ++i)
-        {
-          const int32 mu = oP-j-i;
-          const Float u = (Float(i)/Float(oP));
-          const Float v = (Float(j)/Float(oP));
-          const Float t = (Float(mu)/Float(oP));
-
-          // Initially, linear part.
-          Vec<Float, 3> outval = vp00 * u + v0p0 * v + v00p * t;
-
-          Vec<int32, 3> bc = {{i, j, mu}};    // Store barycentric coords near edges.
-          Vec<Float, 3> nl;                   // Calculate nonlinear part on edge.
-          Float e;                            // Edge coordinate.
-          int32 count_prllgm;
-          Float ramp;
-
-          // Nonlinear contribution from (i=0) edge [(u=0) edge].
-          count_prllgm = i / 2;
-          bc += toi0 * count_prllgm;
-          e = (bc[0] == 0 ? Float(bc[1])/Float(oP) : Float(bc[1]+0.5f)/Float(oP)); //+:t->v
-          nl = out[cartesian_to_tri_idx(0, bc[1], oP+1)];
-          if (bc[0] > 0)
-            nl = nl * 0.5 + out[cartesian_to_tri_idx(0, bc[1]+1, oP+1)] * 0.5; //TODO
-          nl -= v0p0 * e + v00p * (1.0f-e);       // Subtract edge linear part.
-          ramp = ((v*t) / (e*(1.0f-e)));
-          outval += nl * ramp;
-          bc -= toi0 * count_prllgm;
-
-          // Nonlinear contribution from (j=0) edge [(v=0) edge].
-          count_prllgm = j / 2;
-          bc += toj0 * count_prllgm;
-          e = (bc[1] == 0 ? Float(bc[0])/Float(oP) : Float(bc[0]+0.5f)/Float(oP)); //+:t->u
-          nl = out[cartesian_to_tri_idx(bc[0], 0, oP+1)];
-          if (bc[1] > 0)
-            nl = nl * 0.5 + out[cartesian_to_tri_idx(bc[0]+1, 0, oP+1)] * 0.5; //TODO
-          nl -= vp00 * e + v00p * (1.0f-e);       // Subtract edge linear part.
-          ramp = ((u*t) / (e*(1.0f-e)));
-          outval += nl * ramp;
-          bc -= toj0 * count_prllgm;
-
-          // Nonlinear contribution from (mu=0) edge [(t=0) edge].
-          count_prllgm = mu / 2;
-          bc += tomu0 * count_prllgm;
-          e = (bc[2] == 0 ? Float(bc[1])/Float(oP) : Float(bc[1]+0.5f)/Float(oP)); //+:u->v
-          nl = out[cartesian_to_tri_idx(oP-bc[1], bc[1], oP+1)];
-          if (bc[2] > 0)
-            nl = nl * 0.5 + out[cartesian_to_tri_idx(oP-(bc[1]+1), bc[1]+1, oP+1)] * 0.5; //TODO
-          nl -= v0p0 * e + vp00 * (1.0f-e);       // Subtract edge linear part.
-          ramp = ((u*v) / (e*(1.0f-e)));
-          outval += nl * ramp;
-          bc -= tomu0 * count_prllgm;
-
-          out[cartesian_to_tri_idx(i, j, oP+1)] = outval;
-        }
-    }
+    isopatch_tri_interior_guess(out, oP);
 
     // Solve for patch interior.
     // TODO coordination for optimal spacing.
@@ -683,26 +1022,8 @@ namespace dray
     for (int32 j = 1; j < oP; ++j)
       for (int32 i = 1; i < oP-j; ++i)
       {
-        // Get initial guess.
-        Vec<Float, 3> pt3 = out[cartesian_to_tri_idx(i, j, (oP+1))];
-
-        Vec<Vec<Float, 1>, 3> deriv;
-        Vec<Float, 1> scalar = eval_d(ShapeHex(), in_order_p, in, pt3, deriv);
-
-        // For the search direction, use initial gradient direction.
-        const Vec<Float, 3> search_dir =
-            (Vec<Float, 3>{{deriv[0][0], deriv[1][0], deriv[2][0]}}).normalized();
-
-        // Do a few iterations.
-        constexpr int32 num_iter = 5;
-        for (int32 t = 0; t < num_iter; ++t)
-        {
-          scalar = eval_d(ShapeHex(), in_order_p, in, pt3, deriv);
-          pt3 += search_dir * ((iota-scalar[0]) * rcp_safe(dot(deriv, search_dir)[0]));
-        }
-
-        // Store the updated point.
-        pt3 = out[cartesian_to_tri_idx(i, j, (oP+1))] = pt3;
+        const int32 nidx = cartesian_to_tri_idx(i, j, (oP+1));
+        out[nidx] = volume_isopoint(ShapeHex(), in, out[nidx], iota, in_order_p);
       }
 
     /// switch (cut_faces)
@@ -846,43 +1167,7 @@ namespace dray
     }
 
     // Initial guess for patch interior.
-    // Follows paper appendix formula for quads.
-
-    // The paper (transformed to the unit square [0,1]^2) does this:
-    //
-    //  out(i,j) =  corners[0]*(1-xi)*(1-yj) + corners[1]*( xi )*(1-yj)   // Lerp corners
-    //            + corners[2]*(1-xi)*( yj ) + corners[3]*( xi )*( yj )
-    //
-    //            + (out(i,0) - corners[0]*(1-xi) - corners[1]*( xi ))*(1-yj) // Eval deviation on x edges
-    //            + (out(i,p) - corners[2]*(1-xi) - corners[3]*( xi ))*( yj ) //  and lerp the deviation
-    //
-    //            + (out(0,j) - corners[0]*(1-yj) - corners[2]*( yj ))*(1-xi) // Eval deviation on y edges
-    //            + (out(p,j) - corners[1]*(1-yj) - corners[3]*( yj ))*( xi ) //  and lerp the deviation
-    //
-    // Many of the terms cancel, making this equivalent:
-    //
-    for (int32 j = 1; j < oP; ++j)
-    {
-      const Vec<Float, 3> dof_e2 = out[(oP+1)*j + 0];
-      const Vec<Float, 3> dof_e3 = out[(oP+1)*j + oP];
-      const Float yj = Float(j)/Float(oP);
-      const Float _yj = 1.0f - yj;
-
-      for (int32 i = 1; i < oP; ++i)
-      {
-        const Vec<Float, 3> dof_e0 = out[(oP+1)*0 + i];
-        const Vec<Float, 3> dof_e1 = out[(oP+1)*oP + i];
-        const Float xi = Float(i)/Float(oP);
-        const Float _xi = 1.0f - xi;
-
-        out[(oP+1)*j + i] =  dof_e0 * _yj + dof_e1 * yj
-                          + dof_e2 * _xi + dof_e3 * xi
-                          - corners[0] * (_xi * _yj)
-                          - corners[1] * ( xi * _yj)
-                          - corners[2] * (_xi *  yj)
-                          - corners[3] * ( xi *  yj);
-      }
-    }
+    isopatch_quad_interior_guess(out, corners, oP);
 
     // Solve for patch interior.
     // TODO coordination for optimal spacing.
@@ -890,26 +1175,7 @@ namespace dray
     for (int32 j = 1; j < oP; ++j)
       for (int32 i = 1; i < oP; ++i)
       {
-        // Get initial guess.
-        Vec<Float, 3> pt3 = out[(oP+1)*j + i];
-
-        Vec<Vec<Float, 1>, 3> deriv;
-        Vec<Float, 1> scalar = eval_d(ShapeHex(), in_order_p, in, pt3, deriv);
-
-        // For the search direction, use initial gradient direction.
-        const Vec<Float, 3> search_dir =
-            (Vec<Float, 3>{{deriv[0][0], deriv[1][0], deriv[2][0]}}).normalized();
-
-        // Do a few iterations.
-        constexpr int32 num_iter = 5;
-        for (int32 t = 0; t < num_iter; ++t)
-        {
-          scalar = eval_d(ShapeHex(), in_order_p, in, pt3, deriv);
-          pt3 += search_dir * ((iota-scalar[0]) * rcp_safe(dot(deriv, search_dir)[0]));
-        }
-
-        // Store the updated point.
-        out[(oP+1)*j + i] = pt3;
+        out[(oP+1)*j + i] = volume_isopoint(ShapeHex(), in, out[(oP+1)*j + i], iota, in_order_p);
       }
 
 
@@ -931,13 +1197,95 @@ namespace dray
    */
   template <int32 IP, int32 OP>
   DRAY_EXEC void reconstruct_isopatch(ShapeTet, ShapeTri,
-      const ScalarDP & dofs_in,
-      WriteDofPtr<Vec<Float, 3>> & lagrange_pts_out,
+      const ScalarDP & in,
+      WriteDofPtr<Vec<Float, 3>> & out,
       Float iota,
       OrderPolicy<IP> in_order_p,
       OrderPolicy<OP> out_order_p)
   {
-    THROW_LOGIC_ERROR("Not implemented in " __FILE__ " reconstruct_isopatch(ShapeTet, ShapeTri)")
+    // Since the isocut is 'simple,' it separates one cell vertex from the other three.
+    // The 3 cut edges are incident to that vertex, and each pair of them
+    // spans one of the 3 cut faces: Cell faces -> patch edges.
+
+    const int32 iP = eattr::get_order(in_order_p);
+    const int32 oP = eattr::get_order(out_order_p);
+
+    const uint32 cut_edges = get_cut_edges(ShapeTet(), in, iota, iP).cut_edges;
+
+    using ::dray::detail::cartesian_to_tri_idx;
+
+    uint8 edge_ids[3];
+    uint8 split_counter = 0;
+    for (uint8 e = 0; e < 6 && split_counter < 3; ++e)
+      if ((cut_edges & (1u<<e)))
+        edge_ids[split_counter++] = e;
+
+    if (split_counter < 3)
+      THROW_LOGIC_ERROR("Tet->Tri: Fewer than 3 cut edges (" __FILE__ ")")
+
+    // For each cell edge, solve for isovalue intercept along the edge.
+    // This is univariate root finding for an isolated single root.
+    // --> Vertices of the isopatch.
+    // triW:edge_ids[0]  triX:edge_ids[1]  triY:edge_ids[2]
+    const Vec<Float, 3> vW = tet_edge_point(edge_ids[0], cut_edge_tet(edge_ids[0], in, iota, in_order_p));
+    const Vec<Float, 3> vX = tet_edge_point(edge_ids[1], cut_edge_tet(edge_ids[1], in, iota, in_order_p));
+    const Vec<Float, 3> vY = tet_edge_point(edge_ids[2], cut_edge_tet(edge_ids[2], in, iota, in_order_p));
+
+    out[cartesian_to_tri_idx(0,0,oP+1)] = vW;
+    out[cartesian_to_tri_idx(oP,0,oP+1)] = vX;
+    out[cartesian_to_tri_idx(0,oP,oP+1)] = vY;
+
+
+    // For each cell face, solve for points in middle of isocontour within the face.
+    // --> Boundary edges the isopatch.
+
+    // Set initial guesses for patch edges (linear).
+    for (uint8 i = 1; i < oP; ++i)
+    {
+      out[cartesian_to_tri_idx(i, 0, oP+1)]    = (vW*(oP-i) + vX*i)/oP;   // Tri edge W-->0
+    }
+    for (uint8 i = 1; i < oP; ++i)
+    {
+      out[cartesian_to_tri_idx(0, i, oP+1)]    = (vW*(oP-i) + vY*i)/oP;   // Tri edge W-->1
+      out[cartesian_to_tri_idx(oP-i, i, oP+1)] = (vX*(oP-i) + vY*i)/oP;   // Tri edge 0-->1
+    }
+
+    // Solve for edge interiors.
+    for (uint8 patch_edge_idx = 0; patch_edge_idx < 3; ++patch_edge_idx)
+    {
+      constexpr tri_props::EdgeIds edge_list[3] = { tri_props::edgeW0,
+                                                    tri_props::edgeW1,
+                                                    tri_props::edge01 };
+      const uint8 patch_edge = edge_list[patch_edge_idx];
+
+      constexpr uint8 te_end0[3] = {0, 0, 1};
+      constexpr uint8 te_end1[3] = {1, 2, 2};
+
+      const uint8 fid = tet_props::tet_common_face(
+          edge_ids[te_end0[patch_edge_idx]], edge_ids[te_end1[patch_edge_idx]] );
+      const TriEdgeWalker<OP> patch_ew(out_order_p, patch_edge);
+
+      // For now, move each point individually.
+      for (int32 i = 1; i < oP; ++i)
+      {
+        const int32 nidx = patch_ew.edge2tri(i);
+        out[nidx] = tet_face_isopoint(fid, in, out[nidx], iota, in_order_p);
+      }
+    }
+
+
+    // For the cell volume, solve for points in middle of isopatch.
+
+    // Initial guess for patch interior.
+    isopatch_tri_interior_guess(out, oP);
+
+    // Solve for patch interior.
+    for (int32 j = 1; j < oP; ++j)
+      for (int32 i = 1; i < oP-j; ++i)
+      {
+        const int32 nidx = cartesian_to_tri_idx(i, j, (oP+1));
+        out[nidx] = volume_isopoint(ShapeTet(), in, out[nidx], iota, in_order_p);
+      }
   }
 
   /**
@@ -945,13 +1293,84 @@ namespace dray
    */
   template <int32 IP, int32 OP>
   DRAY_EXEC void reconstruct_isopatch(ShapeTet, ShapeQuad,
-      const ScalarDP & dofs_in,
-      WriteDofPtr<Vec<Float, 3>> & lagrange_pts_out,
+      const ScalarDP & in,
+      WriteDofPtr<Vec<Float, 3>> & out,
       Float iota,
       OrderPolicy<IP> in_order_p,
       OrderPolicy<OP> out_order_p)
   {
-    THROW_LOGIC_ERROR("Not implemented in " __FILE__ " reconstruct_isopatch(ShapeTet, ShapeQuad)")
+    // Since the isocut is 'simple,' it separates two cell vertices from the other two.
+    // All 4 faces are cut, and the 4 cut edges form a cycle around the tet.
+    // The opposite edges (e, 5-e) share no face, so they go on opposite patch corners.
+
+    const int32 iP = eattr::get_order(in_order_p);
+    const int32 oP = eattr::get_order(out_order_p);
+
+    const uint32 cut_edges = get_cut_edges(ShapeTet(), in, iota, iP).cut_edges;
+
+    uint8 edge_ids[4];
+    uint8 split_counter = 1;
+    edge_ids[0] = (cut_edges & (1u<<0)) ? 0 : (cut_edges & (1u<<1)) ? 1 : 2;
+    edge_ids[3] = 5 - edge_ids[0];
+    for (uint8 e = edge_ids[0] + 1; e < 6; ++e)
+      if ((cut_edges & (1u<<e)) && e != edge_ids[3] && split_counter < 3)
+        edge_ids[split_counter++] = e;
+
+    if (!(cut_edges & (1u<<edge_ids[3])) || split_counter < 3)
+      THROW_LOGIC_ERROR("Tet->Quad: Cut edges do not form a cycle (" __FILE__ ")")
+
+    // Corners of the patch live on cell edges.
+    Vec<Float, 3> corners[4];
+    for (uint8 s = 0; s < 4; ++s)
+      corners[s] = tet_edge_point(edge_ids[s], cut_edge_tet(edge_ids[s], in, iota, in_order_p));
+
+    out[(oP+1)*0 + 0]   = corners[0];
+    out[(oP+1)*0 + oP]  = corners[1];
+    out[(oP+1)*oP + 0]  = corners[2];
+    out[(oP+1)*oP + oP] = corners[3];
+
+    // Set initial guesses for patch edges (linear).
+    for (uint8 i = 1; i < oP; ++i)
+    {
+      out[(oP+1)*0 + i] = (corners[0]*(oP-i) + corners[1]*i)/oP;  // Quad edge 0
+    }
+    for (uint8 i = 1; i < oP; ++i)
+    {
+      out[(oP+1)*i + 0]  = (corners[0]*(oP-i) + corners[2]*i)/oP;  // Quad edge 2
+      out[(oP+1)*i + oP] = (corners[1]*(oP-i) + corners[3]*i)/oP;  // Quad edge 3
+    }
+    for (uint8 i = 1; i < oP; ++i)
+    {
+      out[(oP+1)*oP + i] = (corners[2]*(oP-i) + corners[3]*i)/oP;  // Quad edge 1
+    }
+
+    // Solve for edge interiors.
+    for (uint8 patch_edge = 0; patch_edge < 4; ++patch_edge)
+    {
+      constexpr uint8 qe_end0[4] = {0, 2, 0, 1};
+      constexpr uint8 qe_end1[4] = {1, 3, 2, 3};
+
+      const uint8 fid = tet_props::tet_common_face(
+          edge_ids[qe_end0[patch_edge]], edge_ids[qe_end1[patch_edge]] );
+      const QuadEdgeWalker<OP> patch_ew(out_order_p, patch_edge);
+
+      // For now, move each point individually.
+      for (int32 i = 1; i < oP; ++i)
+      {
+        const int32 nidx = patch_ew.edge2quad(i);
+        out[nidx] = tet_face_isopoint(fid, in, out[nidx], iota, in_order_p);
+      }
+    }
+
+    // Initial guess for patch interior.
+    isopatch_quad_interior_guess(out, corners, oP);
+
+    // Solve for patch interior.
+    for (int32 j = 1; j < oP; ++j)
+      for (int32 i = 1; i < oP; ++i)
+      {
+        out[(oP+1)*j + i] = volume_isopoint(ShapeTet(), in, out[(oP+1)*j + i], iota, in_order_p);
+      }
   }
 
 
@@ -0,0 +1,429 @@
+// Copyright 2019 Lawrence Livermore National Security, LLC and other
+// Devil Ray Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (BSD-3-Clause)
+
+#include <dray/data_model/lazy_collection.hpp>
+#include <dray/dray.hpp>
+#include <dray/error.hpp>
+#include <dray/utils/data_logger.hpp>
+
+#include <algorithm>
+
+#ifdef DRAY_MPI_ENABLED
+#include <mpi.h>
+#endif
+
+namespace dray
+{
+
+namespace detail
+{
+
+Range global_range(const Range &local)
+{
+  Range res = local;
+#ifdef DRAY_MPI_ENABLED
+  MPI_Comm mpi_comm = MPI_Comm_f2c(dray::mpi_comm());
+
+  // empty ranges are +inf/-inf and drop out of the reduction
+  float64 local_min = (float64) res.min();
+  float64 local_max = (float64) res.max();
+  float64 global_min = 0;
+  float64 global_max = 0;
+
+  MPI_Allreduce((void *)(&local_min),
+                (void *)(&global_min),
+                1,
+                MPI_DOUBLE,
+                MPI_MIN,
+                mpi_comm);
+
+  MPI_Allreduce((void *)(&local_max),
+                (void *)(&global_max),
+                1,
+                MPI_DOUBLE,
+                MPI_MAX,
+                mpi_comm);
+  res.reset();
+  if(global_min <= global_max)
+  {
+    res.include(Float(global_min));
+    res.include(Float(global_max));
+  }
+#endif
+  return res;
+}
+
+} // namespace detail
+
+LazyCollection::LazyCollection()
+  : m_budget(0),
+    m_resident(0),
+    m_loads(0),
+    m_pinned_bytes(0)
+{
+}
+
+void
+LazyCollection::loader(Loader loader)
+{
+  m_loader = loader;
+}
+
+void
+LazyCollection::memory_budget(const size_t bytes)
+{
+  m_budget = bytes;
+  evict(0);
+}
+
+size_t
+LazyCollection::memory_budget() const
+{
+  return m_budget;
+}
+
+void
+LazyCollection::add_domain(const DomainInfo &info)
+{
+  m_infos.push_back(info);
+  m_bounds.reset();
+}
+
+void
+LazyCollection::add_domain(const DomainInfo &info, const DataSet &domain)
+{
+  add_domain(info);
+  const int32 index = local_size() - 1;
+  if(m_budget == 0 || m_resident + info.m_bytes <= m_budget)
+  {
+    m_cache[index] = domain;
+    m_resident += info.m_bytes;
+    touch(index);
+  }
+}
+
+LazyCollection::DomainInfo
+LazyCollection::describe(DataSet &domain, const size_t bytes)
+{
+  DomainInfo info;
+  info.m_domain_id = domain.domain_id();
+  info.m_bounds = domain.bounds();
+  info.m_cells = domain.mesh()->cells();
+  info.m_bytes = bytes;
+
+  const int32 num_fields = domain.number_of_fields();
+  for(int32 i = 0; i < num_fields; ++i)
+  {
+    Field *field = domain.field(i);
+    info.m_ranges[field->name()] = field->range()[0];
+  }
+  return info;
+}
+
+const LazyCollection::DomainInfo &
+LazyCollection::info(const int32 index) const
+{
+  if(index < 0 || index  > local_size() - 1)
+  {
+    DRAY_ERROR("Invalid domain index");
+  }
+  return m_infos[index];
+}
+
+void
+LazyCollection::touch(const int32 index)
+{
+  auto it = std::find(m_lru.begin(), m_lru.end(), index);
+  if(it != m_lru.end())
+  {
+    m_lru.erase(it);
+  }
+  m_lru.push_front(index);
+}
+
+void
+LazyCollection::release_pinned()
+{
+  m_pinned_bytes = 0;
+  auto it = m_pinned.begin();
+  while(it != m_pinned.end())
+  {
+    if(it->second.expired())
+    {
+      it = m_pinned.erase(it);
+    }
+    else
+    {
+      m_pinned_bytes += m_infos[it->first].m_bytes;
+      ++it;
+    }
+  }
+}
+
+void
+LazyCollection::evict(const size_t needed)
+{
+  if(m_budget == 0)
+  {
+    return;
+  }
+
+  release_pinned();
+  // always keep room for the domain that is about to be loaded, even
+  // when it alone is bigger than the budget
+  while(!m_lru.empty() && m_resident + m_pinned_bytes + needed > m_budget)
+  {
+    const int32 index = m_lru.back();
+    m_lru.pop_back();
+    const size_t bytes = m_infos[index].m_bytes;
+    std::shared_ptr<Mesh> mesh = m_cache[index].mesh_shared();
+    m_cache.erase(index);
+    m_resident -= bytes;
+    // the local reference is the last one unless a selection holds it
+    if(mesh.use_count() > 1)
+    {
+      m_pinned.push_back(std::make_pair(index, std::weak_ptr<Mesh>(mesh)));
+      m_pinned_bytes += bytes;
+    }
+    DRAY_INFO("Evicting domain "<<m_infos[index].m_domain_id);
+  }
+
+  if(m_resident + m_pinned_bytes + needed > m_budget && m_pinned_bytes > 0)
+  {
+    DRAY_INFO("Selected domains hold "<<m_pinned_bytes<<" bytes, the budget of "
+              <<m_budget<<" bytes is exceeded");
+  }
+}
+
+DataSet
+LazyCollection::domain(const int32 index)
+{
+  const DomainInfo &dinfo = info(index);
+
+  auto it = m_cache.find(index);
+  if(it != m_cache.end())
+  {
+    touch(index);
+    return it->second;
+  }
+
+  if(!m_loader)
+  {
+    DRAY_ERROR("Lazy collection has no loader");
+  }
+
+  evict(dinfo.m_bytes);
+
+  DRAY_LOG_OPEN("lazy_load");
+  DRAY_LOG_ENTRY("domain_id", dinfo.m_domain_id);
+  DRAY_LOG_ENTRY("bytes", dinfo.m_bytes);
+  DataSet dataset = m_loader(index);
+  DRAY_LOG_CLOSE();
+
+  m_loads++;
+  m_cache[index] = dataset;
+  m_resident += dinfo.m_bytes;
+  touch(index);
+  return dataset;
+}
+
+std::vector<int32>
+LazyCollection::overlapping(const AABB<3> &region) const
+{
+  std::vector<int32> res;
+  const int32 num_domains = local_size();
+  for(int32 i = 0; i < num_domains; ++i)
+  {
+    // AABB::is_empty only reports boxes empty along every axis
+    const AABB<3> overlap = m_infos[i].m_bounds.intersect(region);
+    bool overlaps = true;
+    for(int32 d = 0; d < 3; ++d)
+    {
+      overlaps &= !overlap.m_ranges[d].is_empty();
+    }
+    if(overlaps)
+    {
+      res.push_back(i);
+    }
+  }
+  return res;
+}
+
+Collection
+LazyCollection::select(const std::vector<int32> &indices)
+{
+  Collection res;
+  for(const int32 index : indices)
+  {
+    res.add_domain(domain(index));
+  }
+  return res;
+}
+
+Collection
+LazyCollection::select(const AABB<3> &region)
+{
+  return select(overlapping(region));
+}
+
+Collection
+LazyCollection::materialize()
+{
+  std::vector<int32> indices(local_size());
+  for(int32 i = 0; i < local_size(); ++i)
+  {
+    indices[i] = i;
+  }
+  return select(indices);
+}
+
+Range
+LazyCollection::local_range(const std::string field_name)
+{
+  Range res;
+  for(const DomainInfo &dinfo : m_infos)
+  {
+    auto it = dinfo.m_ranges.find(field_name);
+    if(it != dinfo.m_ranges.end())
+    {
+      res.include(it->second);
+    }
+  }
+  return res;
+}
+
+Range
+LazyCollection::range(const std::string field_name)
+{
+  return detail::global_range(local_range(field_name));
+}
+
+bool
+LazyCollection::local_has_field(const std::string field_name)
+{
+  bool res = true;
+  for(const DomainInfo &dinfo : m_infos)
+  {
+    res &= dinfo.m_ranges.find(field_name) != dinfo.m_ranges.end();
+  }
+  return res;
+}
+
+bool
+LazyCollection::has_field(const std::string field_name)
+{
+  bool exists = local_has_field(field_name);
+#ifdef DRAY_MPI_ENABLED
+  int local_boolean = exists ? 1 : 0;
+  int global_boolean;
+
+  MPI_Comm mpi_comm = MPI_Comm_f2c(dray::mpi_comm());
+  MPI_Allreduce((void *)(&local_boolean),
+                (void *)(&global_boolean),
+                1,
+                MPI_INT,
+                MPI_SUM,
+                mpi_comm);
+
+  exists = global_boolean == dray::mpi_size();
+#endif
+  return exists;
+}
+
+AABB<3>
+LazyCollection::local_bounds()
+{
+  AABB<3> res;
+  for(const DomainInfo &dinfo : m_infos)
+  {
+    res.include(dinfo.m_bounds);
+  }
+  return res;
+}
+
+AABB<3>
+LazyCollection::bounds()
+{
+  if(!m_bounds.is_empty())
+  {
+    return m_bounds;
+  }
+
+  AABB<3> local = local_bounds();
+  AABB<3> res;
+  for(int32 i = 0; i < 3; ++i)
+  {
+    res.m_ranges[i] = detail::global_range(local.m_ranges[i]);
+  }
+  m_bounds = res;
+  return res;
+}
+
+int32
+LazyCollection::size()
+{
+  int32 size = local_size();
+
+  int32 global_size = size;
+#ifdef DRAY_MPI_ENABLED
+  MPI_Comm mpi_comm = MPI_Comm_f2c(dray::mpi_comm());
+
+  MPI_Allreduce((void *)(&size),
+                (void *)(&global_size),
+                1,
+                MPI_INT,
+                MPI_SUM,
+                mpi_comm);
+
+#endif
+  return global_size;
+}
+
+int32
+LazyCollection::local_size() const
+{
+  return (int32)m_infos.size();
+}
+
+size_t
+LazyCollection::resident_bytes() const
+{
+  return m_resident;
+}
+
+size_t
+LazyCollection::pinned_bytes()
+{
+  release_pinned();
+  return m_pinned_bytes;
+}
+
+bool
+LazyCollection::is_resident(const int32 index) const
+{
+  return m_cache.find(index) != m_cache.end();
+}
+
+int32
+LazyCollection::loads() const
+{
+  return m_loads;
+}
+
+void
+LazyCollection::clear_cache()
+{
+  for(auto &cached : m_cache)
+  {
+    m_pinned.push_back(std::make_pair(cached.first,
+                                      std::weak_ptr<Mesh>(cached.second.mesh_shared())));
+  }
+  m_cache.clear();
+  release_pinned();
+  m_lru.clear();
+  m_resident = 0;
+}
+
+} // namespace dray
@@ -0,0 +1,116 @@
+// Copyright 2019 Lawrence Livermore National Security, LLC and other
+// Devil Ray Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (BSD-3-Clause)
+
+#ifndef DRAY_LAZY_COLLECTION_HPP
+#define DRAY_LAZY_COLLECTION_HPP
+
+#include <dray/data_model/collection.hpp>
+#include <dray/types.hpp>
+
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+
+namespace dray
+{
+
+/**
+ * \class LazyCollection
+ * \brief Domains described by metadata and loaded on demand
+ *
+ * Only the per domain metadata (bounds, cell counts, field ranges) is
+ * kept for every domain. The domains themselves are produced by a
+ * loader when they are asked for and cached in least recently used
+ * order under a memory budget. Consumers pick the domains they need
+ * with select() and get back a regular Collection.
+ *
+ * Evicting a domain only drops the cache's reference, so a domain
+ * stays alive as long as a selected Collection still holds it. Those
+ * pinned domains keep counting against the budget until they are
+ * released, but they cannot be freed by the cache: the budget is a
+ * soft bound when the selections alone exceed it.
+ */
+class LazyCollection
+{
+public:
+  struct DomainInfo
+  {
+    int32 m_domain_id;
+    AABB<3> m_bounds;
+    int32 m_cells;
+    // estimated size of the loaded domain
+    size_t m_bytes;
+    std::map<std::string, Range> m_ranges;
+  };
+
+  // produces the domain with the given local index
+  typedef std::function<DataSet(const int32 index)> Loader;
+protected:
+  std::vector<DomainInfo> m_infos;
+  Loader m_loader;
+  size_t m_budget;
+  size_t m_resident;
+  int32 m_loads;
+  // most recently used first
+  std::list<int32> m_lru;
+  std::map<int32, DataSet> m_cache;
+  // evicted domains that are still held outside of the cache
+  std::list<std::pair<int32, std::weak_ptr<Mesh>>> m_pinned;
+  size_t m_pinned_bytes;
+  AABB<3> m_bounds;
+
+  void touch(const int32 index);
+  void evict(const size_t needed);
+  void release_pinned();
+public:
+  LazyCollection();
+
+  void loader(Loader loader);
+  // 0 means no limit
+  void memory_budget(const size_t bytes);
+  size_t memory_budget() const;
+
+  // register a domain. If the loaded data set is given and it fits into
+  // the budget it seeds the cache.
+  void add_domain(const DomainInfo &info);
+  void add_domain(const DomainInfo &info, const DataSet &domain);
+
+  // extract the metadata of a loaded domain
+  static DomainInfo describe(DataSet &domain, const size_t bytes);
+
+  const DomainInfo &info(const int32 index) const;
+  // load the domain on demand
+  DataSet domain(const int32 index);
+
+  // local indices of the domains overlapping the region
+  std::vector<int32> overlapping(const AABB<3> &region) const;
+  Collection select(const std::vector<int32> &indices);
+  Collection select(const AABB<3> &region);
+  // every domain, only for data that fits into memory
+  Collection materialize();
+
+  Range range(const std::string field_name);
+  Range local_range(const std::string field_name);
+  bool has_field(const std::string field_name);
+  bool local_has_field(const std::string field_name);
+  AABB<3> bounds();
+  AABB<3> local_bounds();
+  int32 size();
+  int32 local_size() const;
+
+  // bytes of domains currently in the cache
+  size_t resident_bytes() const;
+  // bytes of evicted domains that selections still hold
+  size_t pinned_bytes();
+  bool is_resident(const int32 index) const;
+  // number of domains loaded through the loader
+  int32 loads() const;
+  void clear_cache();
+};
+
+} //namespace dray
+
+#endif
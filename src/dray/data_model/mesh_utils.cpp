@@ -187,6 +187,150 @@ void unique_faces (Array<Vec<int32, 4>> &faces, Array<int32> &orig_ids)
   orig_ids = index_flags (unique_flags, orig_ids);
 }
 
+DRAY_EXEC uint32 hash_face (const Vec<int32, 4> &face)
+{
+  // fnv-1a over the corner ids followed by a final mix so
+  // neighboring ids do not end up in neighboring slots
+  uint32 hash = 2166136261u;
+  for (int32 i = 0; i < 4; ++i)
+  {
+    hash ^= static_cast<uint32> (face[i]);
+    hash *= 16777619u;
+  }
+  hash ^= hash >> 16;
+  hash *= 0x85ebca6bu;
+  hash ^= hash >> 13;
+  return hash;
+}
+
+Array<int32> match_faces (const Array<Vec<int32, 4>> &faces)
+{
+  DRAY_LOG_OPEN ("match_faces");
+  const int32 size = faces.size ();
+
+  // open addressing with linear probing and a load factor <= 0.5
+  int32 capacity = 1;
+  while (capacity < 2 * size)
+  {
+    capacity <<= 1;
+  }
+  const uint32 mask = static_cast<uint32> (capacity - 1);
+
+  Array<int32> table;
+  table.resize (capacity);
+  array_memset (table, -1);
+
+  Array<int32> neighbors;
+  neighbors.resize (size);
+  array_memset (neighbors, -1);
+
+  const Vec<int32, 4> *faces_ptr = faces.get_device_ptr_const ();
+  int32 *table_ptr = table.get_device_ptr ();
+  int32 *neighbors_ptr = neighbors.get_device_ptr ();
+
+  RAJA::forall<for_policy> (RAJA::RangeSegment (0, size), [=] DRAY_LAMBDA (int32 i) {
+    // we assume that there can be at most two faces that are shared.
+    // The first face claims an empty slot and the second one finds it
+    // and links both sides, so no two threads write the same neighbor
+    const Vec<int32, 4> me = faces_ptr[i];
+    uint32 slot = hash_face (me) & mask;
+    while (true)
+    {
+      const int32 other = RAJA::atomicCAS<atomic_policy> (&table_ptr[slot], -1, i);
+      if (other == -1)
+      {
+        break;
+      }
+      if (is_same (me, faces_ptr[other]))
+      {
+        neighbors_ptr[i] = other;
+        neighbors_ptr[other] = i;
+        break;
+      }
+      slot = (slot + 1) & mask;
+    }
+  });
+  DRAY_ERROR_CHECK();
+
+  DRAY_LOG_ENTRY ("faces", size);
+  DRAY_LOG_ENTRY ("table_size", capacity);
+  DRAY_LOG_CLOSE ();
+  return neighbors;
+}
+
+struct IsExternal
+{
+  DRAY_EXEC bool operator() (const int32 &neighbor) const
+  {
+    return neighbor == -1;
+  }
+};
+
+Array<int32> external_faces (Array<int32> &face_neighbors)
+{
+  return array_where_true (face_neighbors, IsExternal ());
+}
+
+Topology construct_topology (Array<int32> &face_neighbors, const int32 faces_per_elem)
+{
+  DRAY_LOG_OPEN ("construct_topology");
+  const int32 num_els = face_neighbors.size () / faces_per_elem;
+
+  Topology topo;
+  topo.m_faces_per_elem = faces_per_elem;
+  topo.m_face_neighbors = face_neighbors;
+
+  // one extra entry so the scan also gives us the end of the last element
+  Array<int32> counts;
+  counts.resize (num_els + 1);
+  int32 *counts_ptr = counts.get_device_ptr ();
+  const int32 *neighbors_ptr = face_neighbors.get_device_ptr_const ();
+
+  RAJA::forall<for_policy> (RAJA::RangeSegment (0, num_els + 1), [=] DRAY_LAMBDA (int32 el_id) {
+    int32 count = 0;
+    if (el_id < num_els)
+    {
+      for (int32 f = 0; f < faces_per_elem; ++f)
+      {
+        if (neighbors_ptr[el_id * faces_per_elem + f] != -1)
+        {
+          count++;
+        }
+      }
+    }
+    counts_ptr[el_id] = count;
+  });
+  DRAY_ERROR_CHECK();
+
+  int32 total = 0;
+  topo.m_offsets = array_exc_scan_plus (counts, total);
+  topo.m_neighbors.resize (total);
+
+  const int32 *offsets_ptr = topo.m_offsets.get_device_ptr_const ();
+  int32 *adj_ptr = topo.m_neighbors.get_device_ptr ();
+
+  RAJA::forall<for_policy> (RAJA::RangeSegment (0, num_els), [=] DRAY_LAMBDA (int32 el_id) {
+    int32 offset = offsets_ptr[el_id];
+    for (int32 f = 0; f < faces_per_elem; ++f)
+    {
+      const int32 other = neighbors_ptr[el_id * faces_per_elem + f];
+      if (other != -1)
+      {
+        adj_ptr[offset] = other / faces_per_elem;
+        offset++;
+      }
+    }
+  });
+  DRAY_ERROR_CHECK();
+
+  topo.m_external_faces = external_faces (face_neighbors);
+
+  DRAY_LOG_ENTRY ("elements", num_els);
+  DRAY_LOG_ENTRY ("bytes", topo.bytes ());
+  DRAY_LOG_CLOSE ();
+  return topo;
+}
+
 // extract_faces (Hex -> Tensor)
 template <int32 ncomp, int32 P>
 Array<Vec<int32, 4>> extract_faces(UnstructuredMesh<Element<3, ncomp, ElemType::Tensor, P>> &mesh)
@@ -207,7 +351,7 @@ Array<Vec<int32, 4>> extract_faces(UnstructuredMesh<Element<3, ncomp, ElemType::
     const int32 p = device_mesh.m_poly_order;
     const int32 stride_y = p + 1;
     const int32 stride_z = stride_y * stride_y;
-    const int32 el_offset = stride_z * stride_y * el_id;
+    const index_int el_offset = index_int (stride_z * stride_y) * el_id;
     const int32 *el_ptr = device_mesh.m_idx_ptr + el_offset;
     int32 corners[8];
     corners[0] = el_ptr[0];
@@ -298,7 +442,7 @@ Array<Vec<int32, 4>> extract_faces(UnstructuredMesh<Element<3, ncomp, ElemType::
     // if this is not the case this is a much harder problem
     auto order_p = device_mesh.get_order_policy();
     const int32 p = eattr::get_order(order_p);
-    const int32 el_offset = el_id * eattr::get_num_dofs(ShapeTet{}, order_p);
+    const index_int el_offset = index_int (el_id) * eattr::get_num_dofs(ShapeTet{}, order_p);
     const int32 *el_ptr = device_mesh.m_idx_ptr + el_offset;
 
     int32 corners[4];
@@ -513,6 +657,14 @@ namespace detail
 
 template <class ElemT>
 BVH construct_bvh (UnstructuredMesh<ElemT> &mesh, Array<typename get_subref<ElemT>::type> &ref_aabbs)
+{
+  return construct_bvh (mesh, ref_aabbs, array_counting (mesh.cells (), 0, 1));
+}
+
+template <class ElemT>
+BVH construct_bvh (UnstructuredMesh<ElemT> &mesh,
+                   Array<typename get_subref<ElemT>::type> &ref_aabbs,
+                   const Array<int32> &elem_ids)
 {
   DRAY_LOG_OPEN ("construct_bvh");
 
@@ -523,7 +675,9 @@ BVH construct_bvh (UnstructuredMesh<ElemT> &mesh, Array<typename get_subref<Elem
   constexpr uint32 dim_outside = ElemT::get_dim ();
   constexpr auto etype_outside = ElemT::get_etype ();
 
-  const int num_els = mesh.cells();
+  const int num_els = elem_ids.size();
+  const int32 *elem_ids_ptr = elem_ids.get_device_ptr_const ();
+  DRAY_LOG_ENTRY ("num_elems", num_els);
 
   constexpr int splits = 2 * (2 << dim_outside);
   const int32 num_scratch_els = num_els * (splits + 1);
@@ -554,8 +708,9 @@ BVH construct_bvh (UnstructuredMesh<ElemT> &mesh, Array<typename get_subref<Elem
   const int32 * split_scratch_idx_ptr = split_scratch_gf.m_ctrl_idx.get_device_ptr_const();
   Vec<Float, 3> * split_scratch_val_ptr = split_scratch_gf.m_values.get_device_ptr();
 
-  RAJA::forall<for_policy> (RAJA::RangeSegment (0, num_els), [=] DRAY_LAMBDA (int32 el_id) {
+  RAJA::forall<for_policy> (RAJA::RangeSegment (0, num_els), [=] DRAY_LAMBDA (int32 slot) {
 
+    const int32 el_id = elem_ids_ptr[slot];
     constexpr uint32 dim = ElemT::get_dim ();
     constexpr uint32 ncomp = ElemT::get_ncomp();
     constexpr auto etype = ElemT::get_etype ();
@@ -566,7 +721,7 @@ BVH construct_bvh (UnstructuredMesh<ElemT> &mesh, Array<typename get_subref<Elem
 
     AABB<> boxs[splits + 1];
     SubRef<dim, etype> ref_boxs[splits + 1];
-    const int32 * el_split_scratch_idx = split_scratch_idx_ptr + el_id * (splits+1) * nodes_per_elem;
+    const int32 * el_split_scratch_idx = split_scratch_idx_ptr + slot * (splits+1) * nodes_per_elem;
     AABB<> tot;
 
     device_mesh.get_elem (el_id).get_bounds (boxs[0]);
@@ -643,9 +798,9 @@ BVH construct_bvh (UnstructuredMesh<ElemT> &mesh, Array<typename get_subref<Elem
     {
       boxs[i].scale (bbox_scale);
       res.include (boxs[i]);
-      aabb_ptr[el_id * (splits + 1) + i] = boxs[i];
-      prim_ids_ptr[el_id * (splits + 1) + i] = el_id;
-      ref_aabbs_ptr[el_id * (splits + 1) + i] = ref_boxs[i];
+      aabb_ptr[slot * (splits + 1) + i] = boxs[i];
+      prim_ids_ptr[slot * (splits + 1) + i] = el_id;
+      ref_aabbs_ptr[slot * (splits + 1) + i] = ref_boxs[i];
     }
 
     // if(el_id > 100 && el_id < 200)
@@ -722,34 +877,70 @@ extract_faces(UnstructuredMesh<Element<3, 3, ElemType::Simplex, Order::Quadratic
 //
 template BVH construct_bvh (UnstructuredMesh<MeshElem<2, ElemType::Tensor, Order::General>> &mesh,
                             Array<SubRef<2, ElemType::Tensor>> &ref_aabbs);
+template BVH construct_bvh (UnstructuredMesh<MeshElem<2, ElemType::Tensor, Order::General>> &mesh,
+                            Array<SubRef<2, ElemType::Tensor>> &ref_aabbs,
+                            const Array<int32> &elem_ids);
 template BVH construct_bvh (UnstructuredMesh<MeshElem<2, ElemType::Tensor, Order::Linear>> &mesh,
                             Array<SubRef<2, ElemType::Tensor>> &ref_aabbs);
+template BVH construct_bvh (UnstructuredMesh<MeshElem<2, ElemType::Tensor, Order::Linear>> &mesh,
+                            Array<SubRef<2, ElemType::Tensor>> &ref_aabbs,
+                            const Array<int32> &elem_ids);
 template BVH construct_bvh (UnstructuredMesh<MeshElem<2, ElemType::Tensor, Order::Quadratic>> &mesh,
                             Array<SubRef<2, ElemType::Tensor>> &ref_aabbs);
+template BVH construct_bvh (UnstructuredMesh<MeshElem<2, ElemType::Tensor, Order::Quadratic>> &mesh,
+                            Array<SubRef<2, ElemType::Tensor>> &ref_aabbs,
+                            const Array<int32> &elem_ids);
 
 template BVH construct_bvh (UnstructuredMesh<MeshElem<3, ElemType::Tensor, Order::General>> &mesh,
                             Array<SubRef<3, ElemType::Tensor>> &ref_aabbs);
+template BVH construct_bvh (UnstructuredMesh<MeshElem<3, ElemType::Tensor, Order::General>> &mesh,
+                            Array<SubRef<3, ElemType::Tensor>> &ref_aabbs,
+                            const Array<int32> &elem_ids);
 template BVH construct_bvh (UnstructuredMesh<MeshElem<3, ElemType::Tensor, Order::Linear>> &mesh,
                             Array<SubRef<3, ElemType::Tensor>> &ref_aabbs);
+template BVH construct_bvh (UnstructuredMesh<MeshElem<3, ElemType::Tensor, Order::Linear>> &mesh,
+                            Array<SubRef<3, ElemType::Tensor>> &ref_aabbs,
+                            const Array<int32> &elem_ids);
 template BVH construct_bvh (UnstructuredMesh<MeshElem<3, ElemType::Tensor, Order::Quadratic>> &mesh,
                             Array<SubRef<3, ElemType::Tensor>> &ref_aabbs);
+template BVH construct_bvh (UnstructuredMesh<MeshElem<3, ElemType::Tensor, Order::Quadratic>> &mesh,
+                            Array<SubRef<3, ElemType::Tensor>> &ref_aabbs,
+                            const Array<int32> &elem_ids);
 
 //
 // construct_bvh();   // Simplex
 //
 template BVH construct_bvh (UnstructuredMesh<MeshElem<2, ElemType::Simplex, Order::General>> &mesh,
                             Array<SubRef<2, ElemType::Simplex>> &ref_aabbs);
+template BVH construct_bvh (UnstructuredMesh<MeshElem<2, ElemType::Simplex, Order::General>> &mesh,
+                            Array<SubRef<2, ElemType::Simplex>> &ref_aabbs,
+                            const Array<int32> &elem_ids);
 template BVH construct_bvh (UnstructuredMesh<MeshElem<2, ElemType::Simplex, Order::Linear>> &mesh,
                             Array<SubRef<2, ElemType::Simplex>> &ref_aabbs);
+template BVH construct_bvh (UnstructuredMesh<MeshElem<2, ElemType::Simplex, Order::Linear>> &mesh,
+                            Array<SubRef<2, ElemType::Simplex>> &ref_aabbs,
+                            const Array<int32> &elem_ids);
 template BVH construct_bvh (UnstructuredMesh<MeshElem<2, ElemType::Simplex, Order::Quadratic>> &mesh,
                             Array<SubRef<2, ElemType::Simplex>> &ref_aabbs);
+template BVH construct_bvh (UnstructuredMesh<MeshElem<2, ElemType::Simplex, Order::Quadratic>> &mesh,
+                            Array<SubRef<2, ElemType::Simplex>> &ref_aabbs,
+                            const Array<int32> &elem_ids);
 
 template BVH construct_bvh (UnstructuredMesh<MeshElem<3, ElemType::Simplex, Order::General>> &mesh,
                             Array<SubRef<3, ElemType::Simplex>> &ref_aabbs);
+template BVH construct_bvh (UnstructuredMesh<MeshElem<3, ElemType::Simplex, Order::General>> &mesh,
+                            Array<SubRef<3, ElemType::Simplex>> &ref_aabbs,
+                            const Array<int32> &elem_ids);
 template BVH construct_bvh (UnstructuredMesh<MeshElem<3, ElemType::Simplex, Order::Linear>> &mesh,
                             Array<SubRef<3, ElemType::Simplex>> &ref_aabbs);
+template BVH construct_bvh (UnstructuredMesh<MeshElem<3, ElemType::Simplex, Order::Linear>> &mesh,
+                            Array<SubRef<3, ElemType::Simplex>> &ref_aabbs,
+                            const Array<int32> &elem_ids);
 template BVH construct_bvh (UnstructuredMesh<MeshElem<3, ElemType::Simplex, Order::Quadratic>> &mesh,
                             Array<SubRef<3, ElemType::Simplex>> &ref_aabbs);
+template BVH construct_bvh (UnstructuredMesh<MeshElem<3, ElemType::Simplex, Order::Quadratic>> &mesh,
+                            Array<SubRef<3, ElemType::Simplex>> &ref_aabbs,
+                            const Array<int32> &elem_ids);
 
 } // namespace detail
 } // namespace dray
@@ -9,6 +9,7 @@
 #include <dray/data_model/mesh.hpp>
 #include <dray/data_model/subref.hpp>
 #include <dray/data_model/elem_ops.hpp>
+#include <dray/data_model/topology.hpp>
 
 namespace dray
 {
@@ -28,6 +29,18 @@ DRAY_EXEC bool is_same (const Vec<int32, 4> &a, const Vec<int32, 4> &b);
 
 void unique_faces (Array<Vec<int32, 4>> &faces, Array<int32> &orig_ids);
 
+// Matches the faces that are shared by two elements using a concurrent
+// hash table keyed on the sorted corner ids. Returns, for each face,
+// the index of the face on the other side or -1 for external faces.
+Array<int32> match_faces (const Array<Vec<int32, 4>> &faces);
+
+// Returns the indices of the faces without a neighbor
+Array<int32> external_faces (Array<int32> &face_neighbors);
+
+// Builds the element adjacency (CSR) and external face list
+// from the output of match_faces
+Topology construct_topology (Array<int32> &face_neighbors, const int32 faces_per_elem);
+
 // Returns 6 (4) faces for each hex (tet) element, each face
 // represented by the ids of the corner dofs.
 template <int32 ncomp, int32 P>
@@ -54,6 +67,13 @@ Array<Vec<int32, 2>> reconstruct (Array<int32> &orig_ids);
 template <class ElemT>
 BVH construct_bvh (UnstructuredMesh<ElemT> &mesh, Array<typename get_subref<ElemT>::type> &ref_aabbs);
 
+// BVH over a subset of the elements. ref_aabbs is indexed by the aabb ids
+// of the returned BVH and the leaves still refer to the original element ids.
+template <class ElemT>
+BVH construct_bvh (UnstructuredMesh<ElemT> &mesh,
+                   Array<typename get_subref<ElemT>::type> &ref_aabbs,
+                   const Array<int32> &elem_ids);
+
 } // namespace detail
 
 } // namespace dray
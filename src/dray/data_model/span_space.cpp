@@ -0,0 +1,145 @@
+// Copyright 2019 Lawrence Livermore National Security, LLC and other
+// Devil Ray Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (BSD-3-Clause)
+
+#include <dray/data_model/span_space.hpp>
+#include <dray/array_utils.hpp>
+#include <dray/error_check.hpp>
+#include <dray/policies.hpp>
+#include <dray/utils/data_logger.hpp>
+
+#include <algorithm>
+
+namespace dray
+{
+
+namespace detail
+{
+
+// element ids sorted by one end of their range
+void sort_by_end (const Array<Vec<Float, 2>> &elem_ranges,
+                  const int32 end,
+                  Array<int32> &order,
+                  Array<Float> &sorted)
+{
+  const int32 size = elem_ranges.size ();
+  order = array_counting (size, 0, 1);
+  sorted.resize (size);
+
+  // sorted once per field on the host, every iso value reuses the order
+  int32 *order_ptr = order.get_host_ptr ();
+  const Vec<Float, 2> *ranges_ptr = elem_ranges.get_host_ptr_const ();
+  std::sort (order_ptr, order_ptr + size, [=] (int32 i1, int32 i2) {
+    return ranges_ptr[i1][end] < ranges_ptr[i2][end];
+  });
+
+  Float *sorted_ptr = sorted.get_host_ptr ();
+  for (int32 i = 0; i < size; ++i)
+  {
+    sorted_ptr[i] = ranges_ptr[order_ptr[i]][end];
+  }
+}
+
+} // namespace detail
+
+SpanSpace::SpanSpace ()
+{
+}
+
+SpanSpace::SpanSpace (const Array<Vec<Float, 2>> &elem_ranges)
+  : m_elem_ranges (elem_ranges)
+{
+  DRAY_LOG_OPEN ("span_space");
+  detail::sort_by_end (m_elem_ranges, 0, m_min_order, m_sorted_min);
+  detail::sort_by_end (m_elem_ranges, 1, m_max_order, m_sorted_max);
+  DRAY_LOG_ENTRY ("size", size ());
+  DRAY_LOG_CLOSE ();
+}
+
+int32 SpanSpace::size () const
+{
+  return m_elem_ranges.size ();
+}
+
+const Array<Vec<Float, 2>> &SpanSpace::elem_ranges () const
+{
+  return m_elem_ranges;
+}
+
+void SpanSpace::candidates (const Float value,
+                            Array<int32> &candidates,
+                            Array<int32> &inside) const
+{
+  const int32 size = this->size ();
+
+  // elements with min <= value are a prefix of the min order and
+  // elements with max >= value are a suffix of the max order
+  const Float *min_ptr = m_sorted_min.get_host_ptr_const ();
+  const Float *max_ptr = m_sorted_max.get_host_ptr_const ();
+  const int32 num_below =
+    int32 (std::upper_bound (min_ptr, min_ptr + size, value) - min_ptr);
+  const int32 num_above =
+    size - int32 (std::lower_bound (max_ptr, max_ptr + size, value) - max_ptr);
+
+  // walk the smaller set and test the other end of the range
+  const bool use_min = num_below <= num_above;
+  const int32 num_candidates = use_min ? num_below : num_above;
+  const int32 *order_ptr = use_min
+                           ? m_min_order.get_device_ptr_const ()
+                           : m_max_order.get_device_ptr_const () + size - num_above;
+  const Vec<Float, 2> *ranges_ptr = m_elem_ranges.get_device_ptr_const ();
+
+  candidates.resize (num_candidates);
+  inside.resize (num_candidates);
+  int32 *candidates_ptr = candidates.get_device_ptr ();
+  int32 *inside_ptr = inside.get_device_ptr ();
+
+  RAJA::forall<for_policy> (RAJA::RangeSegment (0, num_candidates), [=] DRAY_LAMBDA (int32 i) {
+    const int32 el_id = order_ptr[i];
+    const Vec<Float, 2> range = ranges_ptr[el_id];
+    candidates_ptr[i] = el_id;
+    inside_ptr[i] = range[0] <= value && value <= range[1];
+  });
+  DRAY_ERROR_CHECK ();
+}
+
+Array<int32> SpanSpace::active (const Float value) const
+{
+  Array<int32> candidates, inside;
+  this->candidates (value, candidates, inside);
+  return index_flags (inside, candidates);
+}
+
+Array<int32> SpanSpace::active (const std::vector<Float> &values) const
+{
+  Array<int32> flags;
+  flags.resize (size ());
+  array_memset_zero (flags);
+  int32 *flags_ptr = flags.get_device_ptr ();
+
+  for (const Float value : values)
+  {
+    Array<int32> candidates, inside;
+    this->candidates (value, candidates, inside);
+    const int32 *candidates_ptr = candidates.get_device_ptr_const ();
+    const int32 *inside_ptr = inside.get_device_ptr_const ();
+    RAJA::forall<for_policy> (RAJA::RangeSegment (0, candidates.size ()), [=] DRAY_LAMBDA (int32 i) {
+      if (inside_ptr[i])
+      {
+        flags_ptr[candidates_ptr[i]] = 1;
+      }
+    });
+    DRAY_ERROR_CHECK ();
+  }
+  return index_flags (flags);
+}
+
+size_t SpanSpace::bytes () const
+{
+  return m_elem_ranges.size () * sizeof (Vec<Float, 2>) +
+         (m_min_order.size () + m_max_order.size ()) * sizeof (int32) +
+         (m_sorted_min.size () + m_sorted_max.size ()) * sizeof (Float);
+}
+
+} // namespace dray
@@ -0,0 +1,61 @@
+// Copyright 2019 Lawrence Livermore National Security, LLC and other
+// Devil Ray Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (BSD-3-Clause)
+
+#ifndef DRAY_SPAN_SPACE_HPP
+#define DRAY_SPAN_SPACE_HPP
+
+#include <dray/array.hpp>
+#include <dray/exports.hpp>
+#include <dray/types.hpp>
+#include <dray/vec.hpp>
+
+#include <vector>
+
+namespace dray
+{
+
+/**
+ * \class SpanSpace
+ * \brief Sorted span space index of per element field ranges
+ *
+ * Each element is a point (min, max) of its scalar field coefficients.
+ * By the convex hull property of the Bernstein basis the field inside an
+ * element never leaves this range, so only elements whose range contains
+ * an isovalue can be cut by the isosurface. The element ids are kept
+ * sorted by min and by max. A query binary searches both orders and only
+ * visits the smaller of the two candidate sets.
+ */
+class SpanSpace
+{
+protected:
+  Array<Vec<Float, 2>> m_elem_ranges;
+  Array<int32> m_min_order;
+  Array<Float> m_sorted_min;
+  Array<int32> m_max_order;
+  Array<Float> m_sorted_max;
+
+  // the smaller candidate set of a query and whether each
+  // candidate really contains value
+  void candidates (const Float value,
+                   Array<int32> &candidates,
+                   Array<int32> &inside) const;
+public:
+  SpanSpace ();
+  SpanSpace (const Array<Vec<Float, 2>> &elem_ranges);
+
+  int32 size () const;
+  const Array<Vec<Float, 2>> &elem_ranges () const;
+
+  // ids of the elements whose range contains value (unordered)
+  Array<int32> active (const Float value) const;
+  // ids of the elements whose range contains any of the values
+  // (increasing order)
+  Array<int32> active (const std::vector<Float> &values) const;
+
+  size_t bytes () const;
+};
+
+} // namespace dray
+#endif
@@ -0,0 +1,69 @@
+// Copyright 2019 Lawrence Livermore National Security, LLC and other
+// Devil Ray Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (BSD-3-Clause)
+
+#ifndef DRAY_TOPOLOGY_HPP
+#define DRAY_TOPOLOGY_HPP
+
+#include <dray/array.hpp>
+#include <dray/exports.hpp>
+#include <dray/types.hpp>
+
+namespace dray
+{
+
+struct Topology
+{
+  int32 m_faces_per_elem = 0;
+  // for each face (el_id * m_faces_per_elem + face_id) the matching
+  // face of the neighboring element or -1 if the face is external
+  Array<int32> m_face_neighbors;
+  // element adjacency in CSR layout. The neighbors of element i are
+  // m_neighbors[m_offsets[i]] ... m_neighbors[m_offsets[i+1] - 1]
+  // in local face order
+  Array<int32> m_offsets;
+  Array<int32> m_neighbors;
+  // flat ids of all faces without a neighbor
+  Array<int32> m_external_faces;
+
+  // All members are dray Arrays, so the memory shows up
+  // in the ArrayRegistry usage like any other mesh data
+  size_t bytes () const
+  {
+    return sizeof (int32) * (m_face_neighbors.size () + m_offsets.size () +
+                             m_neighbors.size () + m_external_faces.size ());
+  }
+};
+
+struct DeviceTopology
+{
+  const int32 *m_face_neighbors;
+  const int32 *m_offsets;
+  const int32 *m_neighbors;
+  int32 m_faces_per_elem;
+
+  DeviceTopology () = delete;
+  DeviceTopology (const Topology &topo)
+  : m_face_neighbors (topo.m_face_neighbors.get_device_ptr_const ()),
+    m_offsets (topo.m_offsets.get_device_ptr_const ()),
+    m_neighbors (topo.m_neighbors.get_device_ptr_const ()),
+    m_faces_per_elem (topo.m_faces_per_elem)
+  {
+  }
+
+  // element on the other side of a face or -1
+  DRAY_EXEC int32 neighbor (const int32 el_id, const int32 face_id) const
+  {
+    const int32 face = m_face_neighbors[el_id * m_faces_per_elem + face_id];
+    return face == -1 ? -1 : face / m_faces_per_elem;
+  }
+
+  DRAY_EXEC int32 num_neighbors (const int32 el_id) const
+  {
+    return m_offsets[el_id + 1] - m_offsets[el_id];
+  }
+};
+
+} // namespace dray
+#endif
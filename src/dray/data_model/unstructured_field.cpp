@@ -117,6 +117,36 @@ template <class ElemT> std::vector<Range> get_range (const UnstructuredField<Ele
   return ranges;
 }
 
+template <class ElemT>
+Array<Vec<Float,2>> get_elem_ranges (UnstructuredField<ElemT> &field)
+{
+  DeviceField<ElemT> device_field(field);
+  const int32 num_elems = field.get_num_elem();
+
+  Array<Vec<Float,2>> elem_ranges;
+  elem_ranges.resize(num_elems);
+  Vec<Float,2> *ranges_ptr = elem_ranges.get_device_ptr();
+
+  RAJA::forall<for_policy> (RAJA::RangeSegment (0, num_elems), [=] DRAY_LAMBDA (int32 el_id) {
+    const ElemT elem = device_field.get_elem(el_id);
+    const int32 npe = eattr::get_num_dofs(adapt_get_shape(ElemT{}),
+                                          device_field.get_order_policy());
+    const auto dofs = elem.read_dof_ptr();
+    Vec<Float,2> range;
+    range[0] = dofs[0][0];
+    range[1] = dofs[0][0];
+    for(int32 i = 1; i < npe; ++i)
+    {
+      range[0] = fmin(range[0], dofs[i][0]);
+      range[1] = fmax(range[1], dofs[i][0]);
+    }
+    ranges_ptr[el_id] = range;
+  });
+  DRAY_ERROR_CHECK();
+
+  return elem_ranges;
+}
+
 } // namespace detail
 
 template <class ElemT>
@@ -125,7 +155,8 @@ UnstructuredField<ElemT>::UnstructuredField (const GridFunction<ElemT::get_ncomp
                      const std::string name)
 : m_dof_data (dof_data),
   m_poly_order (poly_order),
-  m_range_calculated(false)
+  m_range_calculated(false),
+  m_has_span_space(false)
 {
   this->name(name);
 
@@ -160,7 +191,9 @@ UnstructuredField<ElemT>::UnstructuredField(const UnstructuredField &other)
   : m_dof_data(other.m_dof_data),
     m_poly_order(other.m_poly_order),
     m_range_calculated(other.m_range_calculated),
-    m_ranges(other.m_ranges)
+    m_ranges(other.m_ranges),
+    m_has_span_space(other.m_has_span_space),
+    m_span_space(other.m_span_space)
 {
   this->name(other.name());
 }
@@ -170,7 +203,9 @@ UnstructuredField<ElemT>::UnstructuredField(UnstructuredField &&other)
   : m_dof_data(other.m_dof_data),
     m_poly_order(other.m_poly_order),
     m_range_calculated(other.m_range_calculated),
-    m_ranges(other.m_ranges)
+    m_ranges(other.m_ranges),
+    m_has_span_space(other.m_has_span_space),
+    m_span_space(other.m_span_space)
 {
   this->name(other.name());
 }
@@ -190,6 +225,7 @@ void UnstructuredField<ElemT>::to_node(conduit::Node &n_field)
 
 template <class ElemT> std::vector<Range> UnstructuredField<ElemT>::range () const
 {
+  std::lock_guard<std::mutex> lock(m_lazy_mutex);
   if(!m_range_calculated)
   {
     m_ranges = detail::get_range (*this);
@@ -198,6 +234,21 @@ template <class ElemT> std::vector<Range> UnstructuredField<ElemT>::range () con
   return m_ranges;
 }
 
+template <class ElemT> const SpanSpace UnstructuredField<ElemT>::get_span_space ()
+{
+  if(ElemT::get_ncomp() != 1)
+  {
+    DRAY_ERROR("Span space requires a scalar field");
+  }
+  std::lock_guard<std::mutex> lock(m_lazy_mutex);
+  if(!m_has_span_space)
+  {
+    m_span_space = SpanSpace(detail::get_elem_ranges(*this));
+    m_has_span_space = true;
+  }
+  return m_span_space;
+}
+
 template <class ElemT>
 int32 UnstructuredField<ElemT>::order() const
 {
@@ -9,10 +9,13 @@
 #include <dray/data_model/element.hpp>
 #include <dray/data_model/grid_function.hpp>
 #include <dray/data_model/field.hpp>
+#include <dray/data_model/span_space.hpp>
 #include <dray/exports.hpp>
 #include <dray/vec.hpp>
 #include <dray/error.hpp>
 
+#include <mutex>
+
 namespace dray
 {
 
@@ -34,6 +37,11 @@ template <class ElemT> class UnstructuredField : public Field
   int32 m_poly_order;
   mutable bool m_range_calculated;
   mutable std::vector<Range> m_ranges;
+  bool m_has_span_space;
+  SpanSpace m_span_space;
+  // guards the lazy ranges and span space, domains that share this
+  // field can be traced at the same time
+  mutable std::mutex m_lazy_mutex;
 
   public:
   UnstructuredField () = delete; // For now, probably need later.
@@ -79,6 +87,9 @@ template <class ElemT> class UnstructuredField : public Field
 
   virtual std::vector<Range> range () const override;
 
+  // per element coefficient ranges of a scalar field, built on first use
+  const SpanSpace get_span_space ();
+
   virtual std::string type_name() const override;
 
   static UnstructuredField uniform_field(int32 num_els,
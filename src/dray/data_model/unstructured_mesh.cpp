@@ -20,8 +20,30 @@
 namespace dray
 {
 
+namespace detail
+{
+
+template <int32 ncomp, ElemType etype, int32 P>
+Topology build_topology(UnstructuredMesh<Element<3, ncomp, etype, P>> &mesh)
+{
+  constexpr int32 faces_per_elem = etype == ElemType::Tensor ? 6 : 4;
+  Array<Vec<int32,4>> faces = extract_faces(mesh);
+  Array<int32> face_neighbors = match_faces(faces);
+  return construct_topology(face_neighbors, faces_per_elem);
+}
+
+template <int32 ncomp, ElemType etype, int32 P>
+Topology build_topology(UnstructuredMesh<Element<2, ncomp, etype, P>> &mesh)
+{
+  DRAY_ERROR("Topology is only defined for 3D meshes");
+  return Topology();
+}
+
+} // namespace detail
+
 template <class Element> const BVH UnstructuredMesh<Element>::get_bvh ()
 {
+  std::lock_guard<std::mutex> lock(m_lazy_mutex);
   if(!m_is_constructed)
   {
     m_bvh = detail::construct_bvh (*this, m_ref_aabbs);
@@ -30,11 +52,23 @@ template <class Element> const BVH UnstructuredMesh<Element>::get_bvh ()
   return m_bvh;
 }
 
+template <class Element> const Topology UnstructuredMesh<Element>::get_topology ()
+{
+  std::lock_guard<std::mutex> lock(m_lazy_mutex);
+  if(!m_has_topology)
+  {
+    m_topology = detail::build_topology (*this);
+    m_has_topology = true;
+  }
+  return m_topology;
+}
+
 template <class Element>
 UnstructuredMesh<Element>::UnstructuredMesh (const GridFunction<3u> &dof_data, int32 poly_order)
 : m_dof_data (dof_data),
   m_poly_order (poly_order),
-  m_is_constructed(false)
+  m_is_constructed(false),
+  m_has_topology(false)
 {
   // check to see if this is a valid construction
   if(Element::get_P() != Order::General)
@@ -68,7 +102,9 @@ UnstructuredMesh<Element>::UnstructuredMesh(const UnstructuredMesh &other)
     m_poly_order(other.m_poly_order),
     m_is_constructed(other.m_is_constructed),
     m_bvh(other.m_bvh),
-    m_ref_aabbs(other.m_ref_aabbs)
+    m_ref_aabbs(other.m_ref_aabbs),
+    m_has_topology(other.m_has_topology),
+    m_topology(other.m_topology)
 {
   // check to see if this is a valid construction
   if(Element::get_P() != Order::General)
@@ -97,7 +133,9 @@ UnstructuredMesh<Element>::UnstructuredMesh(UnstructuredMesh &&other)
     m_poly_order(other.m_poly_order),
     m_is_constructed(other.m_is_constructed),
     m_bvh(other.m_bvh),
-    m_ref_aabbs(other.m_ref_aabbs)
+    m_ref_aabbs(other.m_ref_aabbs),
+    m_has_topology(other.m_has_topology),
+    m_topology(other.m_topology)
 {
   // check to see if this is a valid construction
   if(Element::get_P() != Order::General)
@@ -9,6 +9,7 @@
 #include <dray/data_model/mesh.hpp>
 #include <dray/data_model/element.hpp>
 #include <dray/data_model/grid_function.hpp>
+#include <dray/data_model/topology.hpp>
 #include <dray/aabb.hpp>
 #include <dray/exports.hpp>
 #include <dray/linear_bvh_builder.hpp>
@@ -20,6 +21,8 @@
 
 #include <dray/utils/appstats.hpp>
 
+#include <mutex>
+
 namespace dray
 {
 
@@ -50,6 +53,11 @@ protected:
   // we are lazy constructing these
   BVH m_bvh;
   Array<SubRef<dim, etype>> m_ref_aabbs;
+  bool m_has_topology;
+  Topology m_topology;
+  // guards the lazy construction, domains that share this mesh
+  // can be traced at the same time
+  std::mutex m_lazy_mutex;
 
   //// Accept input data (as shared).
   //// Useful for keeping same data but changing class template arguments.
@@ -96,6 +104,10 @@ public:
 
   const BVH get_bvh ();
 
+  // face and element adjacency. Built on first use
+  // and only defined for 3D meshes.
+  const Topology get_topology ();
+
   GridFunction<3u> get_dof_data ()
   {
     return m_dof_data;
@@ -20,6 +20,7 @@
 #include <dray/data_model/elem_attr.hpp>
 #include <dray/data_model/iso_ops.hpp>
 #include <dray/data_model/detached_element.hpp>
+#include <dray/utils/data_logger.hpp>
 
 #include <sstream>
 
@@ -53,9 +54,24 @@
 
 namespace dray
 {
+  ExtractIsosurface::ExtractIsosurface()
+    : m_count_then_emit(false)
+  {
+  }
+
   // -----------------------
   // Getter/setters
   // -----------------------
+  void ExtractIsosurface::count_then_emit(const bool on)
+  {
+    m_count_then_emit = on;
+  }
+
+  bool ExtractIsosurface::count_then_emit() const
+  {
+    return m_count_then_emit;
+  }
+
   void ExtractIsosurface::iso_field(const std::string field_name)
   {
     m_iso_field_name = field_name;
@@ -68,12 +84,27 @@ namespace dray
 
   void ExtractIsosurface::iso_value(const float32 iso_value)
   {
-    m_iso_value = iso_value;
+    m_iso_values.clear();
+    m_iso_values.push_back(iso_value);
   }
 
   Float ExtractIsosurface::iso_value() const
   {
-    return m_iso_value;
+    if (m_iso_values.size() == 0)
+    {
+      DRAY_ERROR("No iso values set");
+    }
+    return m_iso_values[0];
+  }
+
+  void ExtractIsosurface::iso_values(const std::vector<Float> &iso_values)
+  {
+    m_iso_values = iso_values;
+  }
+
+  std::vector<Float> ExtractIsosurface::iso_values() const
+  {
+    return m_iso_values;
   }
   // -----------------------
 
@@ -195,6 +226,14 @@ namespace dray
     y = tmp;
   }
 
+  // my_swap_n()
+  template <typename T>
+  DRAY_EXEC void my_swap_n(T *elemA, T *elemB, const int32 n)
+  {
+    for (int32 i = 0; i < n; ++i)
+      my_swap(elemA[i], elemB[i]);
+  }
+
   // my_swap_n()
   template <typename DofT>
   DRAY_EXEC void my_swap_n(WriteDofPtr<DofT> elemA, WriteDofPtr<DofT> elemB, const int32 npe)
@@ -239,9 +278,44 @@ namespace dray
     return bool(info.m_cut_type_flag & (IsocutInfo::CutSimpleTri | IsocutInfo::CutSimpleQuad));
   }
 
+  /** is_empty() for all isovalues */
+  DRAY_EXEC bool is_empty(const eops::IsocutInfo * infos, const int32 n_vals)
+  {
+    for (int32 v = 0; v < n_vals; ++v)
+      if (!is_empty(infos[v]))
+        return false;
+    return true;
+  }
+
+  /** first_complex() : first isovalue whose cut is neither empty nor simple, or -1. */
+  DRAY_EXEC int32 first_complex(const eops::IsocutInfo * infos, const int32 n_vals)
+  {
+    for (int32 v = 0; v < n_vals; ++v)
+      if (!is_empty(infos[v]) && !is_simple(infos[v]))
+        return v;
+    return -1;
+  }
+
+  /** measure_isocuts() : one info per isovalue. */
+  template <typename ShapeT, typename DofPtrT>
+  DRAY_EXEC void measure_isocuts(const ShapeT,
+                                 const DofPtrT &dofs,
+                                 const Float * isovals,
+                                 const int32 n_vals,
+                                 const int32 p,
+                                 eops::IsocutInfo * infos)
+  {
+    for (int32 v = 0; v < n_vals; ++v)
+      infos[v] = eops::measure_isocut(ShapeT(), dofs, isovals[v], p);
+  }
+
   /**
    * subdivide_host_elem()
    *
+   * Subdivides until every kept subelement is cut simply (or not at all)
+   * by each of the n_vals isovalues, so the subdivision is shared by all
+   * isovalues. infos holds n_vals entries per subelement.
+   *
    * @pre out_dofs[0] .. out_dofs[npe*budget - 1] is available to be overwritten.
    * @post The first out_size subelements in the budget are valid.
    * @post budget_insufficient is true or the entire element was subdivided into simple cuts.
@@ -251,7 +325,8 @@ namespace dray
                                       const OrderPolicy<P> order_p,
                                       const int32 budget,
                                       const ReadDofPtr<Vec<Float, 1>> & in_elem,
-                                      const Float isoval,
+                                      const Float * isovals,
+                                      const int32 n_vals,
                                       WriteDofPtr<Vec<Float, 1>> out_dofs,
                                       SubRef<3, eattr::get_etype(ShapeT())> * subrefs,
                                       eops::IsocutInfo * infos,
@@ -268,7 +343,6 @@ namespace dray
     constexpr ElemType etype = eattr::get_etype(ShapeT());
     using eops::IsocutInfo;
     using SubRefT = SubRef<3, etype>;
-    using eops::measure_isocut;
 
     const int32 p = eattr::get_order(order_p);
     const int32 npe = eattr::get_num_dofs(ShapeT(), order_p);
@@ -277,7 +351,7 @@ namespace dray
 
     my_copy_n(view_2d(out_dofs, npe)[0], in_elem, npe);
     subrefs[0] = ref_universe(RefSpaceTag<3, etype>());
-    infos[0] = measure_isocut(ShapeT(), view_2d(out_dofs_read, npe)[0], isoval, p);
+    measure_isocuts(ShapeT(), view_2d(out_dofs_read, npe)[0], isovals, n_vals, p, infos);
 
     int32 q_sz = 1;
     int32 kept_sz = 0;
@@ -287,7 +361,7 @@ namespace dray
     while (q_sz > 0 && budget > q_sz + kept_sz)
     {
       const int32 picked = kept_sz + pick_candidate(subrefs + kept_sz,
-                                                    infos + kept_sz,
+                                                    infos + kept_sz * n_vals,
                                                     q_sz);
       const int32 candidate = kept_sz;
       const int32 q_end = kept_sz + q_sz;
@@ -298,29 +372,32 @@ namespace dray
       {
         my_swap_n(view_2d(out_dofs, npe)[candidate], view_2d(out_dofs, npe)[picked], npe);
         my_swap(subrefs[candidate], subrefs[picked]);
-        my_swap(infos[candidate], infos[picked]);
+        my_swap_n(view_2d(infos, n_vals)[candidate], view_2d(infos, n_vals)[picked], n_vals);
       }
       q_sz--;
 
       // The pre-loop invariant (budget > q_sz + kept_sz)
       // ensures there is enough room to perform a binary split.
 
-      if (is_simple(infos[candidate]))
+      const int32 complex_val = first_complex(view_2d(infos, n_vals)[candidate], n_vals);
+
+      if (complex_val == -1 && !is_empty(view_2d(infos, n_vals)[candidate], n_vals))
       {
         kept_sz++;
       }
-      else if (is_empty(infos[candidate]))
+      else if (complex_val == -1)
       {
         if (q_sz > 0)
         {
           my_copy_n(view_2d(out_dofs, npe)[candidate], view_2d(out_dofs_read, npe)[q_end-1], npe);
           subrefs[candidate] = subrefs[q_end-1];
-          infos[candidate] = infos[q_end-1];
+          my_copy_n(view_2d(infos, n_vals)[candidate], view_2d(infos, n_vals)[q_end-1], n_vals);
         }
       }
       else
       {
-        const Split<etype> binary_split = pick_iso_simple_split(ShapeT(), infos[candidate]);
+        const Split<etype> binary_split =
+            pick_iso_simple_split(ShapeT(), view_2d(infos, n_vals)[candidate][complex_val], subrefs[candidate]);
 
         // Prepare for in-place splits.
         my_copy_n(view_2d(out_dofs, npe)[q_end], view_2d(out_dofs_read, npe)[candidate], npe);
@@ -334,8 +411,10 @@ namespace dray
         split_inplace(ShapeT(), order_p, view_2d(out_dofs, npe)[q_end], binary_split.get_complement());
 
         // Update infos after split.
-        infos[candidate] = measure_isocut(ShapeT(), view_2d(out_dofs_read, npe)[candidate], isoval, p);
-        infos[q_end]     = measure_isocut(ShapeT(), view_2d(out_dofs_read, npe)[q_end], isoval, p);
+        measure_isocuts(ShapeT(), view_2d(out_dofs_read, npe)[candidate], isovals, n_vals, p,
+                        view_2d(infos, n_vals)[candidate]);
+        measure_isocuts(ShapeT(), view_2d(out_dofs_read, npe)[q_end], isovals, n_vals, p,
+                        view_2d(infos, n_vals)[q_end]);
 
         q_sz += 2;
       }
@@ -348,6 +427,48 @@ namespace dray
   }
 
 
+  /** iso_value_field() : constant per patch field holding the isovalue of each patch. */
+  template <class PatchElemT>
+  std::shared_ptr<Field> iso_value_field(const Array<int32> &levels,
+                                         const Array<Float> &iso_values)
+  {
+    using TagElemT = Element<2, 1, PatchElemT::get_etype(), Order::General>;
+    const int32 size = levels.size();
+
+    GridFunction<1> tag_gf;
+    tag_gf.resize_counting(size, 1);
+
+    const int32 * level_ptr = levels.get_device_ptr_const();
+    const Float * iso_ptr = iso_values.get_device_ptr_const();
+    Vec<Float, 1> * tag_ptr = tag_gf.m_values.get_device_ptr();
+    RAJA::forall<for_policy>(RAJA::RangeSegment(0, size), [=] DRAY_LAMBDA (int32 i) {
+      tag_ptr[i][0] = iso_ptr[level_ptr[i]];
+    });
+    DRAY_ERROR_CHECK();
+
+    return std::make_shared<UnstructuredField<TagElemT>>(tag_gf, 0, "iso_value");
+  }
+
+  /** split_patch_index() : patch index -> (subelement, level). */
+  inline void split_patch_index(const Array<int32> &patch_idx,
+                                const int32 n_vals,
+                                Array<int32> &sub_idx,
+                                Array<int32> &levels)
+  {
+    const int32 size = patch_idx.size();
+    sub_idx.resize(size);
+    levels.resize(size);
+    const int32 * patch_ptr = patch_idx.get_device_ptr_const();
+    int32 * sub_ptr = sub_idx.get_device_ptr();
+    int32 * level_ptr = levels.get_device_ptr();
+    RAJA::forall<for_policy>(RAJA::RangeSegment(0, size), [=] DRAY_LAMBDA (int32 i) {
+      sub_ptr[i] = patch_ptr[i] / n_vals;
+      level_ptr[i] = patch_ptr[i] % n_vals;
+    });
+    DRAY_ERROR_CHECK();
+  }
+
+
 
 
 
@@ -360,11 +481,15 @@ namespace dray
   template <class MElemT, class FElemT>
   std::pair<DataSet,DataSet> ExtractIsosurface_execute( UnstructuredMesh<MElemT> &mesh,
                                                         UnstructuredField<FElemT> &field,
-                                                        Float iso_value,
+                                                        const Array<Float> &iso_values,
+                                                        const bool count_then_emit,
                                                         DataSet *input_dataset)
   {
     // Overview:
-    //   - Subdivide field elements until isocut is simple. Yields sub-ref and sub-coeffs.
+    //   - Query the field span space for elements whose coefficient range
+    //     brackets one of the isovalues. No other element is touched.
+    //   - Subdivide field elements until isocuts are simple for all isovalues.
+    //     Yields sub-ref and sub-coeffs.
     //   - Extract isopatch coordinates relative to the coord-system of sub-ref.
     //   - Transform isopatch coordinates to reference space via (sub-ref)^{-1}.
     //   - Transform isopatch coordinates to world space via mesh element.
@@ -374,7 +499,10 @@ namespace dray
 
     using eops::IsocutInfo;
 
-    const Float isoval = iso_value;  // Local for capture
+    DRAY_LOG_OPEN("extract_isosurface");
+
+    const Float * isovals = iso_values.get_device_ptr_const();
+    const int32 n_vals = iso_values.size();
     const int32 n_el_in = field.get_num_elem();
     DeviceField<FElemT> dfield(field);
 
@@ -382,14 +510,28 @@ namespace dray
     constexpr int32 budget_factor = 2;
     constexpr int32 pass_limit = 4;
 
-    // host_elem_budgets[]
+    const auto field_order_p = dfield.get_order_policy();
+    constexpr auto shape3d = adapt_get_shape<FElemT>();
+    const int32 field3d_npe = eattr::get_num_dofs(shape3d, field_order_p);
+
+    // By the convex hull property only elements whose Bernstein coefficients
+    // straddle an isovalue can be cut.
+    const std::vector<Float> host_isovals(iso_values.get_host_ptr_const(),
+                                          iso_values.get_host_ptr_const() + n_vals);
+    Array<int32> active_host_elems = field.get_span_space().active(host_isovals);
+    const int32 n_active = active_host_elems.size();
+    DRAY_LOG_ENTRY("active_elems", n_active);
+    const int32 * active_ptr = active_host_elems.get_device_ptr_const();
+
+    // host_elem_budgets[], zero for elements that cannot be cut.
     Array<int32> host_elem_budgets;
     host_elem_budgets.resize(n_el_in);
-    array_memset(host_elem_budgets, init_budget);
+    array_memset_zero(host_elem_budgets);
     int32 * host_elem_budget_ptr = host_elem_budgets.get_device_ptr();
 
-    int32 total_budgeted_subelems;
-    Array<int32> offsets_array = array_exc_scan_plus(host_elem_budgets, total_budgeted_subelems);
+    RAJA::forall<for_policy>(RAJA::RangeSegment(0, n_active), [=] DRAY_LAMBDA (int32 i) {
+      host_elem_budget_ptr[active_ptr[i]] = init_budget;
+    });
 
     Array<int32> budget_exceeded;
     budget_exceeded.resize(n_el_in);
@@ -398,33 +540,109 @@ namespace dray
 
     Array<int32> out_sizes_array;
     out_sizes_array.resize(n_el_in);
+    array_memset_zero(out_sizes_array);
     int32 * out_sizes_ptr = out_sizes_array.get_device_ptr();
 
-    const auto field_order_p = dfield.get_order_policy();
-    constexpr auto shape3d = adapt_get_shape<FElemT>();
-    const int32 field3d_npe = eattr::get_num_dofs(shape3d, field_order_p);
+    using SubRefT = typename get_subref<FElemT>::type;
+
+    int32 num_passes = 0;
+
+    if (count_then_emit)
+    {
+      // Count: find a budget that fits each element. Only out sizes and
+      // budgets survive a pass, so the scratch space covers just the
+      // elements pending in that pass.
+      Array<int32> pending_host_elems = active_host_elems;
+      while (pending_host_elems.size() > 0 && num_passes < pass_limit)
+      {
+        DRAY_LOG_OPEN("count_pass");
+        const int32 num_pending = pending_host_elems.size();
+        // Keep the budget of the last attempt so the emit pass
+        // reproduces its partial output.
+        const bool grow_budgets = num_passes + 1 < pass_limit;
+
+        Array<int32> pending_budgets = gather(host_elem_budgets, pending_host_elems);
+        int32 scratch_subelems;
+        Array<int32> scratch_offsets = array_exc_scan_plus(pending_budgets, scratch_subelems);
+        DRAY_LOG_ENTRY("pending", num_pending);
+        DRAY_LOG_ENTRY("scratch_subelems", scratch_subelems);
+
+        GridFunction<1> scratch_sub_elems;
+        scratch_sub_elems.resize_counting(scratch_subelems, field3d_npe);
+        Array<SubRefT> scratch_subrefs;
+        scratch_subrefs.resize(scratch_subelems);
+        Array<IsocutInfo> scratch_infos;
+        scratch_infos.resize(scratch_subelems * n_vals);
+
+        Array<int32> pending_exceeded;
+        pending_exceeded.resize(num_pending);
+
+        const int32 * pending_host_elem_ptr = pending_host_elems.get_device_ptr_const();
+        const int32 * scratch_offset_ptr = scratch_offsets.get_device_ptr_const();
+        int32 * pending_exceeded_ptr = pending_exceeded.get_device_ptr();
+        DeviceGridFunction<1> scratch_dgf(scratch_sub_elems);
+        SubRefT * subref_ptr = scratch_subrefs.get_device_ptr();
+        IsocutInfo * info_ptr = scratch_infos.get_device_ptr();
+
+        RAJA::forall<for_policy>(RAJA::RangeSegment(0, num_pending), [=] DRAY_LAMBDA (int32 pend_host_idx) {
+          const int32 host_elem_id = pending_host_elem_ptr[pend_host_idx];
+
+          const ReadDofPtr<Vec<Float, 1>> rdp = dfield.get_elem(host_elem_id).read_dof_ptr();
+
+          const int32 budget = host_elem_budget_ptr[host_elem_id];
+          int32 out_sz;
+          bool exceeded;
+
+          constexpr auto shape = adapt_get_shape<FElemT>();
+          const auto forder_p = dfield.get_order_policy();
+
+          const int32 offset = scratch_offset_ptr[pend_host_idx];
+          WriteDofPtr<Vec<Float, 1>> out_dofs = scratch_dgf.get_wdp(offset);
+
+          subdivide_host_elem(shape, forder_p, budget, rdp, isovals, n_vals,
+                              out_dofs, subref_ptr + offset, info_ptr + offset * n_vals,
+                              exceeded, out_sz);
+
+          if (exceeded && grow_budgets)
+            host_elem_budget_ptr[host_elem_id] *= budget_factor;
+          out_sizes_ptr[host_elem_id] = out_sz;
+          budget_exceeded_ptr[host_elem_id] = exceeded;
+          pending_exceeded_ptr[pend_host_idx] = exceeded;
+        });
+
+        pending_host_elems = index_flags(pending_exceeded, pending_host_elems);
+        num_passes++;
+        DRAY_LOG_CLOSE();
+      }
+    }
+
+    // Offsets of each element's sub-elements.
+    int32 total_budgeted_subelems;
+    Array<int32> offsets_array = array_exc_scan_plus(host_elem_budgets, total_budgeted_subelems);
 
     // Allocate and get ptrs to sub-element field dofs.
     GridFunction<1> field_sub_elems;
     field_sub_elems.resize_counting(total_budgeted_subelems, field3d_npe);
 
     // Allocate and get ptrs to sub-element coords within host elements.
-    using SubRefT = typename get_subref<FElemT>::type;
     Array<SubRefT> subref_array;
     subref_array.resize(total_budgeted_subelems);
 
-    // Allocate and get ptrs to sub-element isocut metrics.
+    // Allocate and get ptrs to sub-element isocut metrics, one per isovalue.
     Array<IsocutInfo> info_array;
-    info_array.resize(total_budgeted_subelems);
-
-    Array<int32> pending_host_elems = array_counting(n_el_in, 0, 1);
-
-    int32 num_passes = 0;
-    while (pending_host_elems.size() > 0 && num_passes < pass_limit)
+    info_array.resize(total_budgeted_subelems * n_vals);
+
+    // With count_then_emit the budgets are final and a single pass over
+    // the active elements emits everything into the arrays sized above.
+    // Otherwise, subdivide and re-budget until every element fits.
+    Array<int32> pending_host_elems = active_host_elems;
+    const int32 emit_pass_limit = count_then_emit ? 1 : pass_limit;
+    int32 emit_passes = 0;
+    while (pending_host_elems.size() > 0 && emit_passes < emit_pass_limit)
     {
-      printf("------------------------------------------\n"
-             "Pass #%d\n"
-             "------------------------------------------\n", num_passes);
+      DRAY_LOG_OPEN("subdivide_pass");
+      DRAY_LOG_ENTRY("pending", pending_host_elems.size());
+      DRAY_LOG_ENTRY("total_budgeted_subelems", total_budgeted_subelems);
 
       const int32 * pending_host_elem_ptr = pending_host_elems.get_device_ptr_const();
       const int32 * offset_ptr = offsets_array.get_device_ptr_const();
@@ -433,6 +651,7 @@ namespace dray
       SubRefT * subref_ptr = subref_array.get_device_ptr();
       IsocutInfo * info_ptr = info_array.get_device_ptr();
 
+      const bool rebudget = !count_then_emit;
       const int32 num_pending = pending_host_elems.size();
       RAJA::forall<for_policy>(RAJA::RangeSegment(0, num_pending), [=] DRAY_LAMBDA (int32 pend_host_idx) {
         const int32 host_elem_id = pending_host_elem_ptr[pend_host_idx];
@@ -450,14 +669,18 @@ namespace dray
         WriteDofPtr<Vec<Float, 1>> out_dofs = out_field_dgf.get_wdp(offset);
 
         SubRefT * subrefs = subref_ptr + offset;
-        IsocutInfo * infos = info_ptr + offset;
+        IsocutInfo * infos = info_ptr + offset * n_vals;
 
-        subdivide_host_elem(shape, forder_p, budget, rdp, isoval, out_dofs, subrefs, infos, exceeded, out_sz);
+        subdivide_host_elem(shape, forder_p, budget, rdp, isovals, n_vals,
+                            out_dofs, subrefs, infos, exceeded, out_sz);
 
-        if (exceeded)
-          host_elem_budget_ptr[host_elem_id] *= budget_factor;
-        else
-          host_elem_budget_ptr[host_elem_id] = out_sz;
+        if (rebudget)
+        {
+          if (exceeded)
+            host_elem_budget_ptr[host_elem_id] *= budget_factor;
+          else
+            host_elem_budget_ptr[host_elem_id] = out_sz;
+        }
         out_sizes_ptr[host_elem_id] = out_sz;
         budget_exceeded_ptr[host_elem_id] = exceeded;
       });
@@ -465,12 +688,11 @@ namespace dray
       // Update list of pending host elements.
       pending_host_elems = index_flags(budget_exceeded);
 
-      if (pending_host_elems.size() > 0)
+      if (rebudget && pending_host_elems.size() > 0)
       {
         Array<int32> new_offsets_array = array_exc_scan_plus(host_elem_budgets, total_budgeted_subelems);
         const int32 * new_offset_ptr = new_offsets_array.get_device_ptr_const();
-
-        printf("Re-budgeting with total_budgeted_sublems==%d\n", total_budgeted_subelems);
+        DRAY_LOG_ENTRY("rebudget_subelems", total_budgeted_subelems);
 
         // Move finished outputs to make room for unfinished outputs.
 
@@ -486,28 +708,29 @@ namespace dray
 
         // new_info_array
         Array<IsocutInfo> new_info_array;
-        new_info_array.resize(total_budgeted_subelems);
+        new_info_array.resize(total_budgeted_subelems * n_vals);
         IsocutInfo * new_info_ptr = new_info_array.get_device_ptr();
 
         const Vec<Float, 1> * out_dof_ptr = field_sub_elems.m_values.get_device_ptr();
-        RAJA::forall<for_policy>(RAJA::RangeSegment(0, n_el_in), [=] DRAY_LAMBDA (int32 host_elem_id) {
+        RAJA::forall<for_policy>(RAJA::RangeSegment(0, n_active), [=] DRAY_LAMBDA (int32 active_idx) {
+          const int32 host_elem_id = active_ptr[active_idx];
           const int32 old_offset = offset_ptr[host_elem_id];
           const int32 new_offset = new_offset_ptr[host_elem_id];
 
           const Vec<Float, 1> * old_out_dofs = out_dof_ptr + old_offset * field3d_npe;
           const SubRefT * old_subrefs = subref_ptr + old_offset;
-          const IsocutInfo * old_infos = info_ptr + old_offset;
+          const IsocutInfo * old_infos = info_ptr + old_offset * n_vals;
 
           Vec<Float, 1> * new_out_dofs = new_out_dof_ptr + new_offset * field3d_npe;
           SubRefT * new_subrefs = new_subref_ptr + new_offset;
-          IsocutInfo * new_infos = new_info_ptr + new_offset;
+          IsocutInfo * new_infos = new_info_ptr + new_offset * n_vals;
 
           const int32 out_sz = out_sizes_ptr[host_elem_id];
           for (int32 i = 0; i < out_sz; ++i)
           {
             my_copy_n(view_2d(new_out_dofs, field3d_npe)[i], view_2d(old_out_dofs, field3d_npe)[i], field3d_npe);
             new_subrefs[i] = old_subrefs[i];
-            new_infos[i] = old_infos[i];
+            my_copy_n(view_2d(new_infos, n_vals)[i], view_2d(old_infos, n_vals)[i], n_vals);
           }
         });
         field_sub_elems = new_field_sub_elems;
@@ -517,17 +740,18 @@ namespace dray
         offsets_array = new_offsets_array;
       }
 
-      num_passes++;
-
-      printf("\n");
+      emit_passes++;
+      DRAY_LOG_CLOSE();
     }
+    num_passes += emit_passes;
+    DRAY_LOG_ENTRY("passes", num_passes);
 
-    // Record tri-shaped and quad-shaped cuts.
+    // Record tri-shaped and quad-shaped cuts, one per sub-element and isovalue.
 
     // Allocate and get ptrs to sub-element output activations.
     Array<int32> keepme_tri, keepme_quad;
-    keepme_tri.resize(total_budgeted_subelems);
-    keepme_quad.resize(total_budgeted_subelems);
+    keepme_tri.resize(total_budgeted_subelems * n_vals);
+    keepme_quad.resize(total_budgeted_subelems * n_vals);
     array_memset_zero(keepme_tri);
     array_memset_zero(keepme_quad);
     int32 *keepme_tri_ptr = keepme_tri.get_device_ptr();
@@ -539,29 +763,39 @@ namespace dray
 
     const IsocutInfo * info_ptr = info_array.get_device_ptr_const();
     const int32 * offset_ptr = offsets_array.get_device_ptr_const();
-    RAJA::forall<for_policy>(RAJA::RangeSegment(0, n_el_in), [=] DRAY_LAMBDA (int32 host_elem_id) {
+    RAJA::ReduceSum<reduce_policy, int32> complex_cells(0);
+    RAJA::forall<for_policy>(RAJA::RangeSegment(0, n_active), [=] DRAY_LAMBDA (int32 active_idx) {
+      const int32 host_elem_id = active_ptr[active_idx];
       const bool exceeded = budget_exceeded_ptr[host_elem_id];
       const int32 out_sz = out_sizes_ptr[host_elem_id];
       const int32 offset = offset_ptr[host_elem_id];
 
       for (int32 sub_i = 0; sub_i < out_sz; ++sub_i)
       {
-        const IsocutInfo info = info_ptr[offset + sub_i];
         host_cell_ptr[offset + sub_i] = host_elem_id;
-        if (info.m_cut_type_flag & IsocutInfo::CutSimpleTri)
-          keepme_tri_ptr[offset + sub_i] = true;
-        if (info.m_cut_type_flag & IsocutInfo::CutSimpleQuad)
-          keepme_quad_ptr[offset + sub_i] = true;
+        for (int32 v = 0; v < n_vals; ++v)
+        {
+          const int32 patch_i = (offset + sub_i) * n_vals + v;
+          const IsocutInfo info = info_ptr[patch_i];
+          if (info.m_cut_type_flag & IsocutInfo::CutSimpleTri)
+            keepme_tri_ptr[patch_i] = true;
+          if (info.m_cut_type_flag & IsocutInfo::CutSimpleQuad)
+            keepme_quad_ptr[patch_i] = true;
+        }
       }
 
+      // Geometry too complex for the last budget keeps only its simple cuts.
       if (exceeded)
       {
-        printf("(num_passes==%d) Very complex geometry in host cell %d.\n", num_passes, host_elem_id);
+        complex_cells += 1;
       }
     });
+    DRAY_LOG_ENTRY("complex_cells", complex_cells.get());
 
     GridFunction<1> field_sub_elems_tri;
-    Array<int32> kept_indices_tri = index_flags(keepme_tri);
+    Array<int32> kept_indices_tri;
+    Array<int32> levels_tri;
+    split_patch_index(index_flags(keepme_tri), n_vals, kept_indices_tri, levels_tri);
     Array<SubRefT> subrefs_tri = gather(subref_array, kept_indices_tri);
     Array<int32> host_cells_tri = gather(host_cell_array, kept_indices_tri);
     field_sub_elems_tri.m_values = gather(field_sub_elems.m_values, field3d_npe, kept_indices_tri);
@@ -571,7 +805,9 @@ namespace dray
     field_sub_elems_tri.m_size_ctrl = field_sub_elems_tri.m_values.size();
 
     GridFunction<1> field_sub_elems_quad;
-    Array<int32> kept_indices_quad = index_flags(keepme_quad);
+    Array<int32> kept_indices_quad;
+    Array<int32> levels_quad;
+    split_patch_index(index_flags(keepme_quad), n_vals, kept_indices_quad, levels_quad);
     Array<SubRefT> subrefs_quad = gather(subref_array, kept_indices_quad);
     Array<int32> host_cells_quad = gather(host_cell_array, kept_indices_quad);
     field_sub_elems_quad.m_values = gather(field_sub_elems.m_values, field3d_npe, kept_indices_quad);
@@ -610,7 +846,6 @@ namespace dray
     locset_quad.m_host_cell_id = host_cells_quad;
 
     DeviceMesh<MElemT> dmesh(mesh);
-    const Float iota = iso_value;
 
     // Extract triangle isopatches.
     {
@@ -618,6 +853,7 @@ namespace dray
       DeviceGridFunction<1> field_subel_dgf(field_sub_elems_tri);
       DeviceGridFunction<3> isopatch_dgf(isopatch_coords_tri);
       const int32 * host_cell_id_ptr = host_cells_tri.get_device_ptr_const();
+      const int32 * level_ptr = levels_tri.get_device_ptr_const();
 
       DeviceGridFunction<3> isopatch_r_dgf(locset_tri.m_rcoords);
 
@@ -625,6 +861,7 @@ namespace dray
 
         ReadDofPtr<Vec<Float, 1>> field_vals = field_subel_dgf.get_rdp(neid);
         WriteDofPtr<Vec<Float, 3>> coords = isopatch_dgf.get_wdp(neid);
+        const Float iota = isovals[level_ptr[neid]];
         eops::reconstruct_isopatch(shape3d, ShapeTri(), field_vals, coords, iota, field_order_p, out_order_p);
 
         WriteDofPtr<Vec<Float, 3>> rcoords = isopatch_r_dgf.get_wdp(neid);
@@ -646,6 +883,7 @@ namespace dray
       DeviceGridFunction<1> field_subel_dgf(field_sub_elems_quad);
       DeviceGridFunction<3> isopatch_dgf(isopatch_coords_quad);
       const int32 * host_cell_id_ptr = host_cells_quad.get_device_ptr_const();
+      const int32 * level_ptr = levels_quad.get_device_ptr_const();
 
       int32 *host_cell_id_quad_ptr = locset_quad.m_host_cell_id.get_device_ptr();
       DeviceGridFunction<3> isopatch_r_dgf(locset_quad.m_rcoords);
@@ -654,6 +892,7 @@ namespace dray
 
         ReadDofPtr<Vec<Float, 1>> field_vals = field_subel_dgf.get_rdp(neid);
         WriteDofPtr<Vec<Float, 3>> coords = isopatch_dgf.get_wdp(neid);
+        const Float iota = isovals[level_ptr[neid]];
         eops::reconstruct_isopatch(shape3d, ShapeQuad(), field_vals, coords, iota, field_order_p, out_order_p);
 
         WriteDofPtr<Vec<Float, 3>> rcoords = isopatch_r_dgf.get_wdp(neid);
@@ -690,11 +929,21 @@ namespace dray
       isosurface_quad_ds.add_field(rmff_quad.m_out_field_ptr);
     }
 
+    // Tag the patches with their isovalue when several were extracted.
+    if (n_vals > 1)
+    {
+      isosurface_tri_ds.add_field(iso_value_field<IsoPatchTriT>(levels_tri, iso_values));
+      isosurface_quad_ds.add_field(iso_value_field<IsoPatchQuadT>(levels_quad, iso_values));
+    }
+
+    DRAY_LOG_CLOSE();
     return {isosurface_tri_ds, isosurface_quad_ds};
   }
 
 
-  /** remap_element() (Hex, Quad) */
+  /** remap_element() (Hex, Quad)
+   *  @pre mesh and out orders match, so the out nodes are the mesh nodes.
+   */
   template <int32 IP, int32 MP, int32 OP, int32 ncomp>
   DRAY_EXEC void remap_element(const ShapeHex,
                                OrderPolicy<IP> in_order_p,
@@ -706,17 +955,13 @@ namespace dray
                                WriteDofPtr<Vec<Float, ncomp>> out_field_wdp)
   {
     const int32 ip = eattr::get_order(in_order_p);
-    const int32 mp = eattr::get_order(mesh_order_p);
     const int32 op = eattr::get_order(out_order_p);
 
-    //TODO use eval and don't assert equal.
-    assert(mp == op);
-
     for (int32 j = 0; j <= op; ++j)
       for (int32 i = 0; i <= op; ++i)
       {
         Vec<Vec<Float, ncomp>, 3> UN_d = {{ {{0}}, {{0}}, {{0}} }};  // unused derivative.
-        const Vec<Float, 3> host_ref_pt = mesh_rdp[j*(op+1) + i];  //TODO eval()
+        const Vec<Float, 3> host_ref_pt = mesh_rdp[j*(op+1) + i];
         const Vec<Float, ncomp> field_val =
             eops::eval_d(ShapeHex(), in_order_p, in_field_rdp, host_ref_pt, UN_d);
 
@@ -724,7 +969,9 @@ namespace dray
       }
   }
 
-  /** remap_element() (Hex, Tri) */
+  /** remap_element() (Hex, Tri)
+   *  @pre mesh and out orders match, so the out nodes are the mesh nodes.
+   */
   template <int32 IP, int32 MP, int32 OP, int32 ncomp>
   DRAY_EXEC void remap_element(const ShapeHex,
                                OrderPolicy<IP> in_order_p,
@@ -736,19 +983,15 @@ namespace dray
                                WriteDofPtr<Vec<Float, ncomp>> out_field_wdp)
   {
     const int32 ip = eattr::get_order(in_order_p);
-    const int32 mp = eattr::get_order(mesh_order_p);
     const int32 op = eattr::get_order(out_order_p);
 
-    //TODO use eval and don't assert equal.
-    assert(mp == op);
-
     for (int32 j = 0; j <= op; ++j)
       for (int32 i = 0; i <= op-j; ++i)
       {
         const int32 nidx = detail::cartesian_to_tri_idx(i, j, op+1);
 
         Vec<Vec<Float, ncomp>, 3> UN_d = {{ {{0}}, {{0}}, {{0}} }};  // unused derivative.
-        const Vec<Float, 3> host_ref_pt = mesh_rdp[nidx];  //TODO eval()
+        const Vec<Float, 3> host_ref_pt = mesh_rdp[nidx];
         const Vec<Float, ncomp> field_val =
             eops::eval_d(ShapeHex(), in_order_p, in_field_rdp, host_ref_pt, UN_d);
 
@@ -756,7 +999,9 @@ namespace dray
       }
   }
 
-  /** remap_element() (Tet, Quad) */
+  /** remap_element() (Tet, Quad)
+   *  @pre mesh and out orders match, so the out nodes are the mesh nodes.
+   */
   template <int32 IP, int32 MP, int32 OP, int32 ncomp>
   DRAY_EXEC void remap_element(const ShapeTet,
                                OrderPolicy<IP> in_order_p,
@@ -767,11 +1012,23 @@ namespace dray
                                OrderPolicy<OP> out_order_p,
                                WriteDofPtr<Vec<Float, ncomp>> out_field_wdp)
   {
-        // TODO this is where we should evaluate instead of merely lookup.
-    THROW_LOGIC_ERROR("Not implemented in " __FILE__ " remap_element<ShapeTet, ShapeQuad>")
+    const int32 op = eattr::get_order(out_order_p);
+
+    for (int32 j = 0; j <= op; ++j)
+      for (int32 i = 0; i <= op; ++i)
+      {
+        Vec<Vec<Float, ncomp>, 3> UN_d = {{ {{0}}, {{0}}, {{0}} }};  // unused derivative.
+        const Vec<Float, 3> host_ref_pt = mesh_rdp[j*(op+1) + i];
+        const Vec<Float, ncomp> field_val =
+            eops::eval_d(ShapeTet(), in_order_p, in_field_rdp, host_ref_pt, UN_d);
+
+        out_field_wdp[j*(op+1) + i] = field_val;
+      }
   }
 
-  /** remap_element() (Tet, Tri) */
+  /** remap_element() (Tet, Tri)
+   *  @pre mesh and out orders match, so the out nodes are the mesh nodes.
+   */
   template <int32 IP, int32 MP, int32 OP, int32 ncomp>
   DRAY_EXEC void remap_element(const ShapeTet,
                                OrderPolicy<IP> in_order_p,
@@ -782,8 +1039,20 @@ namespace dray
                                OrderPolicy<OP> out_order_p,
                                WriteDofPtr<Vec<Float, ncomp>> out_field_wdp)
   {
-        // TODO this is where we should evaluate instead of merely lookup.
-    THROW_LOGIC_ERROR("Not implemented in " __FILE__ " remap_element<ShapeTet, ShapeTri>")
+    const int32 op = eattr::get_order(out_order_p);
+
+    for (int32 j = 0; j <= op; ++j)
+      for (int32 i = 0; i <= op-j; ++i)
+      {
+        const int32 nidx = detail::cartesian_to_tri_idx(i, j, op+1);
+
+        Vec<Vec<Float, ncomp>, 3> UN_d = {{ {{0}}, {{0}}, {{0}} }};  // unused derivative.
+        const Vec<Float, 3> host_ref_pt = mesh_rdp[nidx];
+        const Vec<Float, ncomp> field_val =
+            eops::eval_d(ShapeTet(), in_order_p, in_field_rdp, host_ref_pt, UN_d);
+
+        out_field_wdp[nidx] = field_val;
+      }
   }
 
 
@@ -815,6 +1084,13 @@ namespace dray
     const int32 out_order = eattr::get_order(out_order_p);
     const int32 out_npe = eattr::get_num_dofs(OutShape(), out_order_p);
 
+    // remap_element() evaluates the field at the mesh nodes only.
+    if (out_order != eattr::get_order(mesh_order_p))
+    {
+      DRAY_ERROR("ReMapField: output order "<<out_order<<
+                 " must match the mesh order "<<eattr::get_order(mesh_order_p));
+    }
+
     constexpr int32 ncomp = FElemT::get_ncomp();
 
     using OutFElemT = Element<2,
@@ -862,14 +1138,18 @@ namespace dray
   // ExtractIsosurfaceFunctor
   struct ExtractIsosurfaceFunctor
   {
-    Float m_iso_value;
+    Array<Float> m_iso_values;
+    bool m_count_then_emit;
     DataSet *m_input_dataset;
 
     DataSet m_output_tris;
     DataSet m_output_quads;
 
-    ExtractIsosurfaceFunctor(Float iso_value, DataSet *input_dataset)
-      : m_iso_value(iso_value),
+    ExtractIsosurfaceFunctor(const std::vector<Float> &iso_values,
+                             const bool count_then_emit,
+                             DataSet *input_dataset)
+      : m_iso_values(iso_values.data(), iso_values.size()),
+        m_count_then_emit(count_then_emit),
         m_input_dataset(input_dataset)
     { }
 
@@ -878,7 +1158,8 @@ namespace dray
     {
       auto output = ExtractIsosurface_execute(mesh,
                                               field,
-                                              m_iso_value,
+                                              m_iso_values,
+                                              m_count_then_emit,
                                               m_input_dataset);
       m_output_tris = output.first;
       m_output_quads = output.second;
@@ -890,7 +1171,7 @@ namespace dray
   std::pair<DataSet, DataSet> ExtractIsosurface::execute(DataSet &data_set)
   {
     // Extract isosurface mesh.
-    ExtractIsosurfaceFunctor func(m_iso_value, &data_set);
+    ExtractIsosurfaceFunctor func(m_iso_values, m_count_then_emit, &data_set);
 
     dispatch_3d_min_linear(data_set.mesh(),
                            data_set.field(m_iso_field_name),
@@ -902,6 +1183,11 @@ namespace dray
 
   std::pair<Collection, Collection> ExtractIsosurface::execute(Collection &collxn)
   {
+    if (m_iso_values.size() == 0)
+    {
+      DRAY_ERROR("No iso values set");
+    }
+
     Collection out_collxn_first;
     Collection out_collxn_second;
     for (DataSet ds : collxn.domains())
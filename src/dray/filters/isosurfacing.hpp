@@ -10,6 +10,7 @@
 #include <dray/data_model/collection.hpp>
 
 #include <utility>
+#include <vector>
 
 namespace dray
 {
@@ -19,9 +20,11 @@ class ExtractIsosurface
 {
 protected:
   std::string m_iso_field_name;
-  Float m_iso_value;
+  std::vector<Float> m_iso_values;
+  bool m_count_then_emit;
   std::pair<DataSet, DataSet> execute(DataSet &data_set);
 public:
+  ExtractIsosurface();
   std::pair<Collection, Collection> execute(Collection &collxn);
 
   void iso_field(const std::string field_name);
@@ -29,6 +32,21 @@ public:
 
   void iso_value(const float32 iso_value);
   Float iso_value() const;
+
+  // extract several isovalues in a single pass. The subdivision of each
+  // element is shared by all values and the patches of every value go
+  // into the same output, tagged with a constant "iso_value" field.
+  void iso_values(const std::vector<Float> &iso_values);
+  std::vector<Float> iso_values() const;
+
+  // find the subdivision budget of every element first, using scratch
+  // space for the pending elements only, then subdivide once into
+  // arrays sized by the final budgets. A budget is also the work queue
+  // of the subdivision, so it can exceed the number of kept
+  // sub-elements. Costs a second subdivision of each active element
+  // but never reallocates or copies the sub-element arrays.
+  void count_then_emit(const bool on);
+  bool count_then_emit() const;
 };
 
 };//namespace dray
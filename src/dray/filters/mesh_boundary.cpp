@@ -76,8 +76,8 @@ GridFunction<ndof> extract_face_dofs(const ShapeHex,
       const int32 axis_strides[3] = {eldofs0, eldofs1, eldofs2};
 
       const int32 faceid      = elid_faceid_ptr[face_idx][1];
-      const int32 orig_offset = elid_faceid_ptr[face_idx][0] * eldofs3;
-      const int32 new_offset  = face_idx * eldofs2;
+      const index_int orig_offset = index_int (elid_faceid_ptr[face_idx][0]) * eldofs3;
+      const index_int new_offset  = index_int (face_idx) * eldofs2;
 
       const int32 face_axis = (faceid == 0 || faceid == 3 ? 0    // Conditional
                              : faceid == 1 || faceid == 4 ? 1    // instead of
@@ -164,8 +164,8 @@ GridFunction<ndof> extract_face_dofs(const ShapeTet,
       //
 
       const int32 faceid      = elid_faceid_ptr[face_idx][1];
-      const int32 orig_offset = elid_faceid_ptr[face_idx][0] * eldofs3;
-      const int32 new_offset  = face_idx * eldofs2;
+      const index_int orig_offset = index_int (elid_faceid_ptr[face_idx][0]) * eldofs3;
+      const index_int new_offset  = index_int (face_idx) * eldofs2;
 
       const uint8 p = (uint8) poly_order;
       uint8 b[4];      // barycentric indexing
@@ -217,10 +217,10 @@ boundary_execute(UnstructuredMesh<MElemT> &mesh, Array<Vec<int32, 2>> &elid_face
   // Step 1: Extract the boundary mesh: Matt's external_faces() algorithm.
   //
 
-  // Identify unique/external faces.
-  Array<Vec<int32,4>> face_corner_ids = detail::extract_faces(orig_mesh);
-  Array<int32> orig_face_idx = detail::sort_faces(face_corner_ids);
-  detail::unique_faces(face_corner_ids, orig_face_idx);
+  // Identify external faces, i.e., faces without a neighbor. The
+  // topology is cached on the input mesh, so ask the mesh and not
+  // the copy.
+  Array<int32> orig_face_idx = mesh.get_topology().m_external_faces;
   elid_faceid_state = detail::reconstruct<etype>(orig_face_idx);
 
   // Copy the dofs for each face.
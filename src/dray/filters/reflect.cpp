@@ -6,6 +6,7 @@
 #include <dray/data_model/device_mesh.hpp>
 #include <dray/data_model/mesh_utils.hpp>
 #include <dray/utils/data_logger.hpp>
+#include <dray/transform_3d.hpp>
 
 #include <dray/policies.hpp>
 #include <dray/error_check.hpp>
@@ -89,10 +90,17 @@ struct ReflectFunctor
 
 Reflect::Reflect()
   : m_point({0.f,0.f,0.f}),
-    m_normal({0.f, 1.f, 0.f})
+    m_normal({0.f, 1.f, 0.f}),
+    m_instanced(false)
 {
 }
 
+void
+Reflect::instanced(bool on)
+{
+  m_instanced = on;
+}
+
 void
 Reflect::plane(const Vec<float32,3> &point, const Vec<float32,3> &normal)
 {
@@ -104,11 +112,59 @@ Collection
 Reflect::execute(Collection &collection)
 {
   Collection res;
+
+  if(m_instanced)
+  {
+    Vec<Float,3> point, normal;
+    for(int32 i = 0; i < 3; ++i)
+    {
+      point[i] = static_cast<Float>(m_point[i]);
+      normal[i] = static_cast<Float>(m_normal[i]);
+    }
+    normal.normalize();
+    const Matrix<Float,4,4> reflection = reflect(point, normal);
+
+    for(int32 i = 0; i < collection.local_size(); ++i)
+    {
+      // shallow copy: meshes and fields are shared with the input
+      DataSet data_set = collection.domain(i);
+      data_set.transform(reflection * data_set.transform());
+      res.add_domain(data_set);
+    }
+    return res;
+  }
+
   for(int32 i = 0; i < collection.local_size(); ++i)
   {
     DataSet data_set = collection.domain(i);
-    detail::ReflectFunctor func(m_point, m_normal);
+    Vec<float32,3> point = m_point;
+    Vec<float32,3> normal = m_normal;
+    if(data_set.has_transform())
+    {
+      // instanced input: mirror the coordinates in object space
+      // across the plane moved there, and keep the instance transform
+      const Matrix<Float,4,4> inverse = data_set.inverse_transform();
+      Vec<Float,3> t_point, t_normal;
+      for(int32 c = 0; c < 3; ++c)
+      {
+        t_point[c] = m_point[c];
+        t_normal[c] = m_normal[c];
+      }
+      t_point = transform_point(inverse, t_point);
+      t_normal = transform_vector(inverse, t_normal);
+      for(int32 c = 0; c < 3; ++c)
+      {
+        point[c] = static_cast<float32>(t_point[c]);
+        normal[c] = static_cast<float32>(t_normal[c]);
+      }
+    }
+
+    detail::ReflectFunctor func(point, normal);
     dispatch(data_set.mesh(), func);
+    if(data_set.has_transform())
+    {
+      func.m_res.transform(data_set.transform());
+    }
 
     // pass through all in the input fields
     const int num_fields = data_set.number_of_fields();
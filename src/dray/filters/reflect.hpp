@@ -11,9 +11,15 @@ class Reflect
 protected:
   Vec<float32,3> m_point;
   Vec<float32,3> m_normal;
+  bool m_instanced;
 public:
   Reflect();
   void plane(const Vec<float32,3> &point, const Vec<float32,3> &normal);
+  // if on, the output domains share the input meshes and fields and
+  // only carry a reflection transform. Rendering traces them in object
+  // space and reuses the input BVHs. Filters that read the mesh
+  // geometry directly still see the unreflected coordinates.
+  void instanced(bool on);
   Collection execute(Collection &collection);
 };
 
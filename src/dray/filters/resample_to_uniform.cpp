@@ -0,0 +1,488 @@
+// Copyright 2019 Lawrence Livermore National Security, LLC and other
+// Devil Ray Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (BSD-3-Clause)
+
+#include <dray/filters/resample_to_uniform.hpp>
+
+#include <dray/array_utils.hpp>
+#include <dray/dispatcher.hpp>
+#include <dray/dray.hpp>
+#include <dray/error.hpp>
+#include <dray/warning.hpp>
+#include <dray/data_model/device_mesh.hpp>
+#include <dray/transform_3d.hpp>
+#include <dray/utils/data_logger.hpp>
+
+#include <dray/policies.hpp>
+#include <dray/error_check.hpp>
+#include <RAJA/RAJA.hpp>
+
+#ifdef DRAY_MPI_ENABLED
+#include <mpi.h>
+#endif
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace dray
+{
+
+namespace detail
+{
+
+struct UniformLattice
+{
+  Vec<Float,3> m_origin;
+  Vec<Float,3> m_spacing;
+  Vec<int32,3> m_dims;
+};
+
+// lattice indices [begin, end) along one axis that fall inside
+// [min, max], clipped to [lower, upper)
+DRAY_EXEC bool lattice_span(const Float min,
+                            const Float max,
+                            const Float origin,
+                            const Float spacing,
+                            const int32 lower,
+                            const int32 upper,
+                            int32 &begin,
+                            int32 &end)
+{
+  Float f_begin = 0;
+  Float f_end = 0;
+  if(spacing > 0)
+  {
+    f_begin = ceil((min - origin) / spacing);
+    f_end = floor((max - origin) / spacing) + 1;
+  }
+  else if(origin >= min && origin <= max)
+  {
+    // single point along this axis
+    f_end = 1;
+  }
+
+  begin = f_begin < lower ? lower : (f_begin > upper ? upper : int32(f_begin));
+  end = f_end < lower ? lower : (f_end > upper ? upper : int32(f_end));
+  return begin < end;
+}
+
+template<typename MeshElem>
+void locate_slab(UnstructuredMesh<MeshElem> &mesh,
+                 const UniformLattice &lattice,
+                 const int32 z_begin,
+                 const int32 z_end,
+                 const bool has_transform,
+                 const Matrix<Float,4,4> &transform,
+                 const Matrix<Float,4,4> &inverse,
+                 Array<Location> &locations)
+{
+  constexpr auto etype = MeshElem::get_etype ();
+  const RefSpaceTag<3, etype> ref_space_tag;
+  const Vec<Float, 3> ref_center = subref_center(ref_universe(ref_space_tag));
+
+  const UniformLattice l_lattice = lattice;
+  const Matrix<Float,4,4> l_transform = transform;
+  const Matrix<Float,4,4> l_inverse = inverse;
+
+  Location *loc_ptr = locations.get_device_ptr();
+  DeviceMesh<MeshElem> device_mesh(mesh, false);
+  const int32 num_elems = mesh.cells();
+
+  // points on shared faces are claimed by the lowest element id. The
+  // second pass replays the same warm started solves, so the owner
+  // writes exactly the reference point it claimed with.
+  Array<int32> owners;
+  owners.resize(locations.size());
+  array_memset(owners, num_elems);
+  int32 *owner_ptr = owners.get_device_ptr();
+
+  for(int32 pass = 0; pass < 2; ++pass)
+  {
+    const bool claim = pass == 0;
+    RAJA::forall<for_policy> (RAJA::RangeSegment (0, num_elems), [=] DRAY_LAMBDA (int32 el_id)
+    {
+      const MeshElem elem = device_mesh.get_elem(el_id);
+      AABB<3> box;
+      elem.get_bounds(box);
+
+      // instanced domains live in object space
+      if(has_transform)
+      {
+        AABB<3> world_box;
+        for(int32 c = 0; c < 8; ++c)
+        {
+          Vec<Float, 3> corner;
+          corner[0] = (c & 1) ? box.m_ranges[0].max() : box.m_ranges[0].min();
+          corner[1] = (c & 2) ? box.m_ranges[1].max() : box.m_ranges[1].min();
+          corner[2] = (c & 4) ? box.m_ranges[2].max() : box.m_ranges[2].min();
+          world_box.include(transform_point(l_transform, corner));
+        }
+        box = world_box;
+      }
+
+      int32 begin[3];
+      int32 end[3];
+      const int32 lower[3] = {0, 0, z_begin};
+      const int32 upper[3] = {l_lattice.m_dims[0], l_lattice.m_dims[1], z_end};
+      for(int32 d = 0; d < 3; ++d)
+      {
+        if(!lattice_span(box.m_ranges[d].min(),
+                         box.m_ranges[d].max(),
+                         l_lattice.m_origin[d],
+                         l_lattice.m_spacing[d],
+                         lower[d],
+                         upper[d],
+                         begin[d],
+                         end[d]))
+        {
+          return;
+        }
+      }
+
+      const index_int nx = l_lattice.m_dims[0];
+      const index_int ny = l_lattice.m_dims[1];
+      Vec<Float, 3> guess = ref_center;
+      for(int32 k = begin[2]; k < end[2]; ++k)
+      {
+        for(int32 j = begin[1]; j < end[1]; ++j)
+        {
+          for(int32 i = begin[0]; i < end[0]; ++i)
+          {
+            Vec<Float, 3> point;
+            point[0] = l_lattice.m_origin[0] + Float(i) * l_lattice.m_spacing[0];
+            point[1] = l_lattice.m_origin[1] + Float(j) * l_lattice.m_spacing[1];
+            point[2] = l_lattice.m_origin[2] + Float(k) * l_lattice.m_spacing[2];
+            if(has_transform)
+            {
+              point = transform_point(l_inverse, point);
+            }
+
+            Vec<Float, 3> ref = guess;
+            if(elem.eval_inverse_local(point, ref))
+            {
+              const index_int index = (index_int(k - z_begin) * ny + j) * nx + i;
+              if(claim)
+              {
+                RAJA::atomicMin<atomic_policy> (&owner_ptr[index], el_id);
+              }
+              else if(owner_ptr[index] == el_id)
+              {
+                Location loc;
+                loc.m_cell_id = el_id;
+                loc.m_ref_pt = ref;
+                loc_ptr[index] = loc;
+              }
+              guess = ref;
+            }
+          }
+        }
+      }
+    });
+    DRAY_ERROR_CHECK();
+  }
+}
+
+struct LocateSlabFunctor
+{
+  UniformLattice m_lattice;
+  int32 m_z_begin;
+  int32 m_z_end;
+  bool m_has_transform;
+  Matrix<Float,4,4> m_transform;
+  Matrix<Float,4,4> m_inverse;
+  Array<Location> m_locations;
+
+  template<typename MeshType>
+  void operator()(MeshType &mesh)
+  {
+    locate_slab(mesh,
+                m_lattice,
+                m_z_begin,
+                m_z_end,
+                m_has_transform,
+                m_transform,
+                m_inverse,
+                m_locations);
+  }
+};
+
+// accumulates the located samples of one domain into the slab
+// sums. Points shared by several domains are averaged at the end.
+void accumulate_slab(const Array<Location> &locations,
+                     const Array<Float> &slab_values,
+                     Array<Float> &sums,
+                     Array<int32> &counts)
+{
+  const Location *loc_ptr = locations.get_device_ptr_const();
+  const Float *slab_ptr = slab_values.get_device_ptr_const();
+  Float *sums_ptr = sums.get_device_ptr();
+  int32 *counts_ptr = counts.get_device_ptr();
+
+  RAJA::forall<for_policy> (RAJA::RangeSegment (0, locations.size()), [=] DRAY_LAMBDA (index_int i)
+  {
+    if(loc_ptr[i].m_cell_id > -1)
+    {
+      sums_ptr[i] += slab_ptr[i];
+      counts_ptr[i] += 1;
+    }
+  });
+  DRAY_ERROR_CHECK();
+}
+
+// combines one slab from all ranks on rank 0
+void reduce_slab(Array<Float> &sums, Array<int32> &counts)
+{
+#ifdef DRAY_MPI_ENABLED
+  MPI_Comm comm = MPI_Comm_f2c(dray::mpi_comm());
+  MPI_Datatype float_type = sizeof(Float) == sizeof(float32) ? MPI_FLOAT : MPI_DOUBLE;
+  const int count = static_cast<int>(sums.size());
+  if(dray::mpi_rank() == 0)
+  {
+    MPI_Reduce(MPI_IN_PLACE, sums.get_host_ptr(), count, float_type, MPI_SUM, 0, comm);
+    MPI_Reduce(MPI_IN_PLACE, counts.get_host_ptr(), count, MPI_INT, MPI_SUM, 0, comm);
+  }
+  else
+  {
+    MPI_Reduce(sums.get_host_ptr(), nullptr, count, float_type, MPI_SUM, 0, comm);
+    MPI_Reduce(counts.get_host_ptr(), nullptr, count, MPI_INT, MPI_SUM, 0, comm);
+  }
+#endif
+}
+
+void finalize_samples(Array<Float> &sums, const Array<int32> &counts, const Float empty_val)
+{
+  Float *sums_ptr = sums.get_device_ptr();
+  const int32 *counts_ptr = counts.get_device_ptr_const();
+
+  RAJA::forall<for_policy> (RAJA::RangeSegment (0, sums.size()), [=] DRAY_LAMBDA (index_int i)
+  {
+    const int32 count = counts_ptr[i];
+    sums_ptr[i] = count > 0 ? sums_ptr[i] / Float(count) : empty_val;
+  });
+  DRAY_ERROR_CHECK();
+}
+
+}//namespace detail
+
+ResampleToUniform::ResampleToUniform()
+  : m_empty_val(0),
+    m_slab_size(0)
+{
+  m_dims = {{32, 32, 32}};
+}
+
+void
+ResampleToUniform::bounds(const AABB<3> &bounds)
+{
+  m_bounds = bounds;
+}
+
+void
+ResampleToUniform::dims(const int32 x, const int32 y, const int32 z)
+{
+  if(x < 1 || y < 1 || z < 1)
+  {
+    DRAY_ERROR("ResampleToUniform: dims must be positive, got "
+               <<x<<" "<<y<<" "<<z);
+  }
+  m_dims = {{x, y, z}};
+}
+
+void
+ResampleToUniform::empty_val(const Float val)
+{
+  m_empty_val = val;
+}
+
+void
+ResampleToUniform::slab_size(const int32 planes)
+{
+  m_slab_size = planes;
+}
+
+void
+ResampleToUniform::add_var(const std::string var)
+{
+  m_vars.push_back(var);
+}
+
+void
+ResampleToUniform::execute(Collection &collection, conduit::Node &output)
+{
+  DRAY_LOG_OPEN("resample_to_uniform");
+  if(m_vars.size() == 0)
+  {
+    DRAY_ERROR("ResampleToUniform: must specify at least 1 variable.");
+  }
+
+  if(collection.topo_dims() != 3)
+  {
+    DRAY_ERROR("ResampleToUniform: only 3d meshes are supported.");
+  }
+
+  std::vector<std::string> vars;
+  for(auto &var : m_vars)
+  {
+    if(!collection.has_field(var))
+    {
+      DRAY_WARNING("ResampleToUniform: skipping unknown field '"<<var
+                   <<"'. Known fields "<<collection.field_list());
+    }
+    else
+    {
+      vars.push_back(var);
+    }
+  }
+
+  AABB<3> bounds = m_bounds;
+  if(bounds.is_empty())
+  {
+    bounds = collection.bounds();
+  }
+
+  detail::UniformLattice lattice;
+  lattice.m_dims = m_dims;
+  for(int32 d = 0; d < 3; ++d)
+  {
+    lattice.m_origin[d] = bounds.m_ranges[d].min();
+    lattice.m_spacing[d] = m_dims[d] > 1
+                           ? bounds.m_ranges[d].length() / Float(m_dims[d] - 1)
+                           : Float(0);
+  }
+
+  // a slab is indexed (and reduced over MPI) with int32 counts, so
+  // one plane has to fit. The whole grid only has to be addressable.
+  const index_int plane_size = index_int(m_dims[0]) * index_int(m_dims[1]);
+  if(plane_size > index_int(std::numeric_limits<int32>::max()))
+  {
+    DRAY_ERROR("ResampleToUniform: a plane of "<<m_dims[0]<<" x "<<m_dims[1]
+               <<" points exceeds the int32 range");
+  }
+  if(plane_size > std::numeric_limits<index_int>::max() / index_int(m_dims[2]))
+  {
+    DRAY_ERROR("ResampleToUniform: "<<m_dims[0]<<" x "<<m_dims[1]<<" x "<<m_dims[2]
+               <<" points exceed the index range. Build with DRAY_INDEX_INT64");
+  }
+  const index_int total_size = plane_size * index_int(m_dims[2]);
+
+  int32 slab_planes = m_slab_size;
+  if(slab_planes < 1)
+  {
+    slab_planes = int32(std::max(index_int(1), index_int(1 << 24) / plane_size));
+  }
+  slab_planes = std::min(slab_planes, m_dims[2]);
+  slab_planes = int32(std::min(index_int(slab_planes),
+                               index_int(std::numeric_limits<int32>::max()) / plane_size));
+  DRAY_LOG_ENTRY("points", total_size);
+  DRAY_LOG_ENTRY("slab_planes", slab_planes);
+
+  output.reset();
+  output["coordsets/coords/type"] = "uniform";
+  output["coordsets/coords/dims/i"] = m_dims[0];
+  output["coordsets/coords/dims/j"] = m_dims[1];
+  output["coordsets/coords/dims/k"] = m_dims[2];
+  output["coordsets/coords/origin/x"] = lattice.m_origin[0];
+  output["coordsets/coords/origin/y"] = lattice.m_origin[1];
+  output["coordsets/coords/origin/z"] = lattice.m_origin[2];
+  output["coordsets/coords/spacing/dx"] = lattice.m_spacing[0];
+  output["coordsets/coords/spacing/dy"] = lattice.m_spacing[1];
+  output["coordsets/coords/spacing/dz"] = lattice.m_spacing[2];
+
+  output["topologies/topo/coordset"] = "coords";
+  output["topologies/topo/type"] = "uniform";
+
+  // finished slabs are written straight into the output, so only
+  // one slab of sums is ever held on each rank
+  const bool is_root = dray::mpi_rank() == 0;
+  const int32 num_vars = vars.size();
+  std::vector<Float*> out_values(num_vars, nullptr);
+  if(is_root)
+  {
+    for(int32 f = 0; f < num_vars; ++f)
+    {
+      conduit::Node &field = output["fields/"+vars[f]];
+      field["association"] = "vertex";
+      field["topology"] = "topo";
+      if(sizeof(Float) == sizeof(float32))
+      {
+        field["values"].set(conduit::DataType::c_float(total_size));
+      }
+      else
+      {
+        field["values"].set(conduit::DataType::c_double(total_size));
+      }
+      out_values[f] = static_cast<Float*>(field["values"].data_ptr());
+    }
+  }
+
+  std::vector<Array<Float>> sums(num_vars);
+  std::vector<Array<int32>> counts(num_vars);
+  Array<Location> locations;
+  Array<Float> slab_values;
+  for(int32 z_begin = 0; z_begin < m_dims[2]; z_begin += slab_planes)
+  {
+    const int32 z_end = std::min(z_begin + slab_planes, m_dims[2]);
+    const index_int slab_size = index_int(z_end - z_begin) * plane_size;
+    const index_int offset = index_int(z_begin) * plane_size;
+
+    for(int32 f = 0; f < num_vars; ++f)
+    {
+      sums[f].resize(slab_size);
+      array_memset(sums[f], Float(0));
+      counts[f].resize(slab_size);
+      array_memset(counts[f], 0);
+    }
+
+    for(int32 i = 0; i < collection.local_size(); ++i)
+    {
+      DataSet data_set = collection.domain(i);
+
+      locations.resize(slab_size);
+      Location *loc_ptr = locations.get_device_ptr();
+      RAJA::forall<for_policy> (RAJA::RangeSegment (0, slab_size), [=] DRAY_LAMBDA (index_int ii)
+      {
+        Location loc;
+        loc.m_cell_id = -1;
+        loc_ptr[ii] = loc;
+      });
+      DRAY_ERROR_CHECK();
+
+      detail::LocateSlabFunctor func;
+      func.m_lattice = lattice;
+      func.m_z_begin = z_begin;
+      func.m_z_end = z_end;
+      func.m_has_transform = data_set.has_transform();
+      func.m_transform = data_set.transform();
+      func.m_inverse = data_set.inverse_transform();
+      func.m_locations = locations;
+      dispatch_3d(data_set.mesh(), func);
+
+      for(int32 f = 0; f < num_vars; ++f)
+      {
+        if(!data_set.has_field(vars[f]))
+        {
+          continue;
+        }
+        data_set.field(vars[f])->eval(locations, slab_values);
+        detail::accumulate_slab(locations, slab_values, sums[f], counts[f]);
+      }
+    }
+
+    for(int32 f = 0; f < num_vars; ++f)
+    {
+      detail::reduce_slab(sums[f], counts[f]);
+      if(is_root)
+      {
+        detail::finalize_samples(sums[f], counts[f], m_empty_val);
+        memcpy(out_values[f] + offset,
+               sums[f].get_host_ptr_const(),
+               sizeof(Float) * slab_size);
+      }
+    }
+  }
+  DRAY_LOG_CLOSE();
+}
+
+}//namespace dray
@@ -0,0 +1,55 @@
+// Copyright 2019 Lawrence Livermore National Security, LLC and other
+// Devil Ray Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (BSD-3-Clause)
+
+#ifndef DRAY_RESAMPLE_TO_UNIFORM_HPP
+#define DRAY_RESAMPLE_TO_UNIFORM_HPP
+
+#include <dray/aabb.hpp>
+#include <dray/data_model/collection.hpp>
+
+#include <conduit.hpp>
+
+namespace dray
+{
+
+/**
+ * \class ResampleToUniform
+ * \brief Samples scalar fields onto the vertices of a uniform grid
+ *
+ * Works element by element: every element enumerates the lattice
+ * points inside its bounding box and Newton solves for them locally,
+ * warm starting from the previous point. The grid is processed in
+ * slabs of z planes so the temporary locations and sums never exceed
+ * one slab. Each finished slab is reduced to rank 0 and written out.
+ */
+class ResampleToUniform
+{
+protected:
+  AABB<3> m_bounds;
+  Vec<int32,3> m_dims;
+  Float m_empty_val;
+  int32 m_slab_size;
+  std::vector<std::string> m_vars;
+public:
+  ResampleToUniform();
+
+  // region to sample. Defaults to the bounds of the collection
+  void bounds(const AABB<3> &bounds);
+  // number of lattice points along each axis
+  void dims(const int32 x, const int32 y, const int32 z);
+  // value for points outside of the data
+  void empty_val(const Float val);
+  // z planes per slab. 0 (default) picks about 16M points per slab
+  void slab_size(const int32 planes);
+  void add_var(const std::string var);
+
+  // output is a blueprint uniform mesh with vertex associated fields.
+  // With MPI the fields are only present on rank 0.
+  void execute(Collection &collection, conduit::Node &output);
+};
+
+};//namespace dray
+
+#endif//DRAY_RESAMPLE_TO_UNIFORM_HPP
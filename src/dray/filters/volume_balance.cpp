@@ -303,10 +303,161 @@ void split(std::vector<float32> &pieces,
 VolumeBalance::VolumeBalance()
   : m_use_prefix(true),
     m_piece_factor(0.9f),
-    m_threshold(2.0)
+    m_threshold(2.0),
+    m_persistent(false),
+    m_has_plan(false),
+    m_plan_input_size(0),
+    m_moved(0)
 {
 }
 
+bool
+VolumeBalance::plan_matches(Collection &collection)
+{
+  int32 match = 1;
+  if(!m_has_plan || collection.size() != m_plan_input_size)
+  {
+    match = 0;
+  }
+  else
+  {
+    AABB<3> bounds = collection.local_bounds();
+    if(!(bounds.min() == m_plan_input_bounds.min()) ||
+       !(bounds.max() == m_plan_input_bounds.max()) ||
+       collection.local_size() != int32(m_plan_input_cells.size()))
+    {
+      match = 0;
+    }
+    for(int32 i = 0; match == 1 && i < collection.local_size(); ++i)
+    {
+      DataSet domain = collection.domain(i);
+      const int32 num_fields = domain.number_of_fields();
+      if(domain.mesh()->cells() != m_plan_input_cells[i] ||
+         num_fields != int32(m_plan_input_fields[i].size()))
+      {
+        match = 0;
+        break;
+      }
+      for(int32 f = 0; f < num_fields; ++f)
+      {
+        if(domain.field_shared(f) != m_plan_input_fields[i][f].lock())
+        {
+          match = 0;
+          break;
+        }
+      }
+    }
+  }
+#ifdef DRAY_MPI_ENABLED
+  // every rank has to agree or we would deadlock in the redistribute
+  MPI_Comm mpi_comm = MPI_Comm_f2c(dray::mpi_comm());
+  int32 global_match = 0;
+  MPI_Allreduce(&match, &global_match, 1, MPI_INT, MPI_MIN, mpi_comm);
+  match = global_match;
+#endif
+  return match == 1;
+}
+
+void
+VolumeBalance::record_plan_input(Collection &collection, const int32 global_size)
+{
+  m_plan_input_size = global_size;
+  m_plan_input_bounds = collection.local_bounds();
+  m_plan_input_cells.clear();
+  m_plan_input_fields.clear();
+  for(int32 i = 0; i < collection.local_size(); ++i)
+  {
+    DataSet domain = collection.domain(i);
+    m_plan_input_cells.push_back(domain.mesh()->cells());
+    std::vector<std::weak_ptr<Field>> fields;
+    for(int32 f = 0; f < domain.number_of_fields(); ++f)
+    {
+      fields.push_back(domain.field_shared(f));
+    }
+    m_plan_input_fields.push_back(fields);
+  }
+  m_has_plan = true;
+}
+
+Collection
+VolumeBalance::update_plan(Camera &camera, int32 samples)
+{
+  DRAY_LOG_OPEN("volume_balance_update");
+  m_moved = 0;
+#ifdef DRAY_MPI_ENABLED
+  // re-evaluate the cached pieces for the current view. The pieces
+  // themselves stay where they are, so the global layout of the cached
+  // collection is the layout we schedule against.
+  std::vector<float32> local_volumes;
+  volumes(m_plan, camera, samples, local_volumes);
+
+  const int32 global_size = m_plan.size();
+  std::vector<float32> rank_volumes;
+  std::vector<int32> global_counts;
+  std::vector<int32> global_offsets;
+  std::vector<float32> global_volumes;
+
+  allgather(local_volumes,
+            global_size,
+            rank_volumes,
+            global_counts,
+            global_offsets,
+            global_volumes);
+
+  const int32 comm_size = rank_volumes.size();
+  float32 sum = 0.f;
+  float32 max_val = 0.f;
+  for(int32 i = 0; i < comm_size; ++i)
+  {
+    sum += rank_volumes[i];
+    max_val = std::max(max_val, rank_volumes[i]);
+  }
+
+  const float32 ave = sum / float32(comm_size);
+  const float32 imbalance = ave > 0.f ? max_val / ave : 1.f;
+  DRAY_LOG_ENTRY("plan_imbalance", imbalance);
+
+  if(imbalance < m_threshold)
+  {
+    DRAY_LOG_ENTRY("plan_reused", 1);
+    DRAY_LOG_CLOSE();
+    return m_plan;
+  }
+
+  std::vector<int32> src_list;
+  std::vector<int32> dest_list;
+  src_list.resize(global_size);
+  dest_list.resize(global_size);
+
+  // block scheduling starts with every piece in place and only
+  // moves what it has to, which is exactly the delta we want
+  float32 ratio = schedule_blocks(rank_volumes,
+                                  global_counts,
+                                  global_offsets,
+                                  global_volumes,
+                                  src_list,
+                                  dest_list);
+  DRAY_LOG_ENTRY("ratio", ratio);
+
+  for(int32 i = 0; i < global_size; ++i)
+  {
+    if(src_list[i] != dest_list[i])
+    {
+      m_moved++;
+    }
+  }
+  DRAY_LOG_ENTRY("plan_moved", m_moved);
+
+  if(m_moved > 0)
+  {
+    Redistribute redist;
+    m_plan = redist.execute(m_plan, src_list, dest_list);
+  }
+#endif
+  DRAY_LOG_CLOSE();
+  return m_plan;
+}
+
 float32
 VolumeBalance::schedule_prefix(std::vector<float32> &rank_volumes,
                                std::vector<int32> &global_counts,
@@ -666,6 +817,17 @@ VolumeBalance::execute(Collection &collection, Camera &camera, int32 samples)
 
   const int32 local_doms = collection.local_size();
 
+  if(m_persistent)
+  {
+    if(plan_matches(collection))
+    {
+      DRAY_LOG_CLOSE();
+      return update_plan(camera, samples);
+    }
+    m_has_plan = false;
+  }
+  m_moved = 0;
+
   std::vector<float32> local_volumes;
 
   float32 total_volume = volumes(collection, camera, samples, local_volumes);
@@ -690,6 +852,12 @@ VolumeBalance::execute(Collection &collection, Camera &camera, int32 samples)
 
   if(max_imbalance < m_threshold)
   {
+    if(m_persistent)
+    {
+      m_plan = collection;
+      record_plan_input(collection, global_size);
+    }
+    DRAY_LOG_CLOSE();
     return collection;
   }
 
@@ -747,9 +915,23 @@ VolumeBalance::execute(Collection &collection, Camera &camera, int32 samples)
 
   DRAY_LOG_ENTRY("ratio",ratio);
 
+  for(int32 i = 0; i < chopped_size; ++i)
+  {
+    if(src_list[i] != dest_list[i])
+    {
+      m_moved++;
+    }
+  }
+
   Redistribute redist;
   res = redist.execute(pre_chopped, src_list, dest_list);
   DRAY_LOG_ENTRY("result_local_domains", res.local_size());
+
+  if(m_persistent)
+  {
+    m_plan = res;
+    record_plan_input(collection, global_size);
+  }
 #endif
 
   std::vector<float32> res_local;
@@ -782,4 +964,28 @@ void VolumeBalance::threshold(float32 value)
   m_threshold = value;
 }
 
+void VolumeBalance::persistent(bool on)
+{
+  m_persistent = on;
+  if(!on)
+  {
+    reset();
+  }
+}
+
+void VolumeBalance::reset()
+{
+  m_plan = Collection();
+  m_has_plan = false;
+  m_plan_input_size = 0;
+  m_plan_input_bounds.reset();
+  m_plan_input_cells.clear();
+  m_plan_input_fields.clear();
+}
+
+int32 VolumeBalance::last_moved() const
+{
+  return m_moved;
+}
+
 }//namespace dray
@@ -4,6 +4,8 @@
 #include <dray/data_model/collection.hpp>
 #include <dray/rendering/camera.hpp>
 
+#include <memory>
+
 namespace dray
 {
 
@@ -13,6 +15,21 @@ protected:
   bool m_use_prefix;
   float32 m_piece_factor;
   float32 m_threshold;
+  // persistent plan state
+  bool m_persistent;
+  bool m_has_plan;
+  Collection m_plan;
+  int32 m_plan_input_size;
+  AABB<3> m_plan_input_bounds;
+  // per local input domain. The fields are only observed, so a field
+  // that was replaced or freed no longer matches.
+  std::vector<int32> m_plan_input_cells;
+  std::vector<std::vector<std::weak_ptr<Field>>> m_plan_input_fields;
+  int32 m_moved;
+
+  bool plan_matches(Collection &collection);
+  void record_plan_input(Collection &collection, const int32 global_size);
+  Collection update_plan(Camera &camera, int32 samples);
 public:
   VolumeBalance();
 
@@ -22,6 +39,18 @@ public:
   void piece_factor(float32 size);
   // only load balance if the ratio of the max load / average load > value
   void threshold(float32 value);
+  // keep the chopped and redistributed collection between calls to execute.
+  // As long as the imbalance for the current camera stays under the
+  // threshold the cached result is returned as is, otherwise only the
+  // pieces that change owners are migrated. The plan is tied to the
+  // input collection (global domain count, local bounds, element
+  // counts and field objects), so passing in different data, e.g. a
+  // new time step, triggers a full re-balance.
+  void persistent(bool on);
+  // drop any cached plan
+  void reset();
+  // number of domains (globally) migrated during the last call to execute
+  int32 last_moved() const;
 
   Collection execute(Collection &collection, Camera &camera, int32 samples);
 
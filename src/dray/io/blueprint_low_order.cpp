@@ -46,13 +46,13 @@ convert_conn(const conduit::Node &n_conn,
              const std::string shape,
              int32 &num_elems)
 {
-  const int conn_size = n_conn.dtype().number_of_elements();
+  const index_int conn_size = n_conn.dtype().number_of_elements();
   Array<int32> conn;
   conn.resize(conn_size);
   int32 *conn_ptr = conn.get_host_ptr();
 
   const int num_dofs = dofs_per_elem(shape);
-  num_elems = conn_size / num_dofs;
+  num_elems = int32(conn_size / num_dofs);
 
   conduit::DataArray<int32> conn_array = n_conn.value();
 
@@ -61,7 +61,7 @@ convert_conn(const conduit::Node &n_conn,
                      shape == "tri" ? tri_conn_map : tet_conn_map;
   for(int32 i = 0; i < num_elems; ++i)
   {
-    const int32 offset = i * num_dofs;
+    const index_int offset = index_int(i) * num_dofs;
     for(int32 dof = 0; dof < num_dofs; ++dof)
     {
       conn_ptr[offset + dof] = conn_array[offset + map[dof]];
@@ -74,7 +74,7 @@ convert_conn(const conduit::Node &n_conn,
 Array<Vec<Float,1>>
 copy_conduit_scalar_array(const conduit::Node &n_vals)
 {
-  int num_vals = n_vals.dtype().number_of_elements();
+  const index_int num_vals = n_vals.dtype().number_of_elements();
   Array<Vec<Float,1>> values;
   values.resize(num_vals);
 
@@ -83,7 +83,7 @@ copy_conduit_scalar_array(const conduit::Node &n_vals)
   if(n_vals.dtype().is_float32())
   {
     const float *n_values_ptr = n_vals.value();
-    for(int32 i = 0; i < num_vals; ++i)
+    for(index_int i = 0; i < num_vals; ++i)
     {
       values_ptr[i][0] = n_values_ptr[i];
     }
@@ -91,7 +91,7 @@ copy_conduit_scalar_array(const conduit::Node &n_vals)
   else if(n_vals.dtype().is_float64())
   {
     const double *n_values_ptr = n_vals.value();
-    for(int32 i = 0; i < num_vals; ++i)
+    for(index_int i = 0; i < num_vals; ++i)
     {
       values_ptr[i][0] = n_values_ptr[i];
     }
@@ -106,7 +106,7 @@ copy_conduit_scalar_array(const conduit::Node &n_vals)
 Array<Vec<Float,3>>
 import_explicit_coords(const conduit::Node &n_coords)
 {
-    int32 nverts = n_coords["values/x"].dtype().number_of_elements();
+    const index_int nverts = n_coords["values/x"].dtype().number_of_elements();
 
     Array<Vec<Float,3>> coords;
     coords.resize(nverts);
@@ -131,7 +131,7 @@ import_explicit_coords(const conduit::Node &n_coords)
         z_array = n_coords["values/z"].value();
       }
 
-      for(int32 i = 0; i < nverts; ++i)
+      for(index_int i = 0; i < nverts; ++i)
       {
         Vec<Float,3> point;
         point[0] = x_array[i];
@@ -155,7 +155,7 @@ import_explicit_coords(const conduit::Node &n_coords)
         z_array = n_coords["values/z"].value();
       }
 
-      for(int32 i = 0; i < nverts; ++i)
+      for(index_int i = 0; i < nverts; ++i)
       {
         Vec<Float,3> point;
         point[0] = x_array[i];
@@ -167,7 +167,10 @@ class BlueprintTreePathGenerator
   Node m_mesh_index;
 };
 
-void relay_blueprint_mesh_read (const Node &options, Node &data)
+// the data files and protocol of the domains this rank reads
+void relay_blueprint_domain_files (const Node &options,
+                                   std::vector<std::string> &domain_files,
+                                   std::string &data_protocol)
 {
   std::string full_root_fname = options["root_file"].as_string ();
 
@@ -219,7 +222,7 @@ void relay_blueprint_mesh_read (const Node &options, Node &data)
               << verify_info.to_json () << "\n";
   }
 
-  std::string data_protocol = "hdf5";
+  data_protocol = "hdf5";
 
   if (root_node.has_child ("protocol"))
   {
@@ -272,6 +275,18 @@ void relay_blueprint_mesh_read (const Node &options, Node &data)
     std::string current, next;
     utils::rsplit_file_path (full_root_fname, current, next);
     std::string domain_file = utils::join_path (next, gen.GenerateFilePath (domain_id));
+    domain_files.push_back(domain_file);
+  }
+}
+
+void relay_blueprint_mesh_read (const Node &options, Node &data)
+{
+  std::vector<std::string> domain_files;
+  std::string data_protocol;
+  relay_blueprint_domain_files (options, domain_files, data_protocol);
+
+  for(const std::string &domain_file : domain_files)
+  {
     conduit::Node &domain = data.append();
     relay::io::load (domain_file, data_protocol, domain);
   }
@@ -436,6 +451,180 @@ Collection load_bp(const std::string &root_file)
   return collection;
 }
 
+// min and max of a numeric array of any type
+Range values_range(const conduit::Node &n_values)
+{
+  Range res;
+  conduit::Node n_float64;
+  n_values.to_float64_array(n_float64);
+  conduit::float64_array values = n_float64.value();
+  const index_int size = values.number_of_elements();
+  for(index_int i = 0; i < size; ++i)
+  {
+    res.include(Float(values[i]));
+  }
+  return res;
+}
+
+// vertices of the blueprint shapes dray imports
+int32 shape_vertices(const std::string &shape)
+{
+  if(shape == "tri") return 3;
+  if(shape == "quad") return 4;
+  if(shape == "tet") return 4;
+  if(shape == "hex") return 8;
+  DRAY_ERROR("Unsupported shape '"<<shape<<"'");
+  return 0;
+}
+
+// Metadata of a blueprint domain straight from the conduit arrays,
+// without building the dray data set. High order bounds and ranges
+// come from the stored degrees of freedom, so they can be slightly
+// tighter than the Bernstein bounds of the imported domain.
+LazyCollection::DomainInfo describe_bp(const conduit::Node &n_domain)
+{
+  LazyCollection::DomainInfo info;
+  info.m_domain_id = n_domain.has_path("state/domain_id")
+                     ? n_domain["state/domain_id"].to_int32() : 0;
+  info.m_bytes = n_domain.total_bytes_compact();
+
+  if(n_domain["topologies"].number_of_children() == 0)
+  {
+    DRAY_ERROR("Blueprint dataset has no topologies");
+  }
+  // the data set bounds and cells come from the first topology
+  const conduit::Node &n_topo = n_domain["topologies"].child(0);
+  const conduit::Node &n_coords = n_domain["coordsets/"+n_topo["coordset"].as_string()];
+  const std::string topo_type = n_topo["type"].as_string();
+  const std::string axes[3] = {"x", "y", "z"};
+  const std::string dims[3] = {"i", "j", "k"};
+
+  std::string nodes_gf_name = "";
+  if(n_topo.has_child("grid_function"))
+  {
+    nodes_gf_name = n_topo["grid_function"].as_string();
+  }
+
+  if(nodes_gf_name != "")
+  {
+    // high order: the mesh nodes are a grid function
+    const conduit::Node &n_nodes = n_domain["fields/"+nodes_gf_name+"/values"];
+    for(int32 d = 0; d < 3; ++d)
+    {
+      info.m_bounds.m_ranges[d] = d < n_nodes.number_of_children()
+                                  ? values_range(n_nodes.child(d)) : Range();
+    }
+  }
+  else if(n_coords["type"].as_string() == "uniform")
+  {
+    const std::string spacing[3] = {"dx", "dy", "dz"};
+    for(int32 d = 0; d < 3; ++d)
+    {
+      const Float origin = n_coords.has_path("origin/"+axes[d])
+                           ? n_coords["origin/"+axes[d]].to_float64() : 0.;
+      const Float delta = n_coords.has_path("spacing/"+spacing[d])
+                          ? n_coords["spacing/"+spacing[d]].to_float64() : 1.;
+      const int32 points = n_coords.has_path("dims/"+dims[d])
+                           ? n_coords["dims/"+dims[d]].to_int32() : 1;
+      info.m_bounds.m_ranges[d].include(origin);
+      info.m_bounds.m_ranges[d].include(origin + delta * Float(points - 1));
+    }
+  }
+  else
+  {
+    // explicit and rectilinear coordsets both store values per axis
+    for(int32 d = 0; d < 3; ++d)
+    {
+      info.m_bounds.m_ranges[d] = n_coords.has_path("values/"+axes[d])
+                                  ? values_range(n_coords["values/"+axes[d]]) : Range();
+    }
+  }
+  // 2d meshes live in the z = 0 plane
+  if(info.m_bounds.m_ranges[2].is_empty())
+  {
+    info.m_bounds.m_ranges[2].include(Float(0));
+  }
+
+  if(topo_type == "uniform")
+  {
+    info.m_cells = 1;
+    for(int32 d = 0; d < 3; ++d)
+    {
+      if(n_coords.has_path("dims/"+dims[d]))
+      {
+        info.m_cells *= n_coords["dims/"+dims[d]].to_int32() - 1;
+      }
+    }
+  }
+  else if(topo_type == "structured")
+  {
+    info.m_cells = 1;
+    for(int32 d = 0; d < 3; ++d)
+    {
+      if(n_topo.has_path("elements/dims/"+dims[d]))
+      {
+        info.m_cells *= n_topo["elements/dims/"+dims[d]].to_int32();
+      }
+    }
+  }
+  else
+  {
+    const int32 verts = shape_vertices(n_topo["elements/shape"].as_string());
+    info.m_cells = n_topo["elements/connectivity"].dtype().number_of_elements() / verts;
+  }
+
+  // the fields the importers turn into dray fields
+  const conduit::Node &n_fields = n_domain["fields"];
+  const int32 num_fields = n_fields.number_of_children();
+  for(int32 i = 0; i < num_fields; ++i)
+  {
+    const conduit::Node &n_field = n_fields.child(i);
+    const std::string field_name = n_field.name();
+    if(nodes_gf_name != "" &&
+       (field_name == nodes_gf_name || field_name.find("_attribute") != std::string::npos))
+    {
+      continue;
+    }
+    const conduit::Node &n_values = n_field["values"].number_of_children() == 0
+                                    ? n_field["values"] : n_field["values"].child(0);
+    info.m_ranges[field_name] = values_range(n_values);
+  }
+  return info;
+}
+
+LazyCollection load_bp_lazy(const std::string &root_file, const size_t budget)
+{
+  DRAY_LOG_OPEN("load_bp_lazy");
+  Node options;
+  options["root_file"] = root_file;
+  std::vector<std::string> domain_files;
+  std::string data_protocol;
+  detail::relay_blueprint_domain_files (options, domain_files, data_protocol);
+
+  LazyCollection collection;
+  collection.memory_budget(budget);
+  // the metadata pass reads one domain file at a time and only scans
+  // its arrays. Domains are imported on first use.
+  for(const std::string &domain_file : domain_files)
+  {
+    conduit::Node domain;
+    relay::io::load (domain_file, data_protocol, domain);
+    DRAY_INFO("Describing domain "<<domain_file);
+    collection.add_domain(describe_bp(domain));
+  }
+
+  collection.loader([domain_files, data_protocol](const int32 index)
+  {
+    conduit::Node domain;
+    relay::io::load (domain_files[index], data_protocol, domain);
+    return bp2dray<Float> (domain);
+  });
+
+  DRAY_LOG_ENTRY("domains", (int32)domain_files.size());
+  DRAY_LOG_CLOSE();
+  return collection;
+}
+
 } // namespace detail
 
 void
@@ -640,6 +829,12 @@ Collection BlueprintReader::load (const std::string &root_file, const int cycle)
   return detail::load_bp (full_root);
 }
 
+LazyCollection
+BlueprintReader::load_lazy (const std::string &root_file, const size_t budget)
+{
+  return detail::load_bp_lazy (root_file, budget);
+}
+
 DataSet
 BlueprintReader::blueprint_to_dray (const conduit::Node &n_dataset)
 {
@@ -8,6 +8,7 @@
 
 #include <conduit.hpp>
 #include <dray/data_model/collection.hpp>
+#include <dray/data_model/lazy_collection.hpp>
 
 namespace dray
 {
@@ -19,6 +20,11 @@ class BlueprintReader
 
   static Collection load (const std::string &root_file);
 
+  // reads only the domain metadata up front. Domains are loaded again
+  // on demand and cached up to budget bytes (0 means no limit).
+  static LazyCollection load_lazy (const std::string &root_file,
+                                   const size_t budget = 0);
+
   static void load_blueprint(const std::string &root_file,
                              conduit::Node &dataset);
 
@@ -7,6 +7,7 @@
 #include <dray/policies.hpp>
 #include <dray/error_check.hpp>
 #include <dray/ray.hpp>
+#include <dray/transform_3d.hpp>
 
 namespace dray
 {
@@ -258,4 +259,25 @@ void ray_max(Array<Ray> &rays, const Array<RayHit> &hits)
   DRAY_ERROR_CHECK();
 }
 
+Array<Ray> transform_rays(const Array<Ray> &rays, const Matrix<Float, 4, 4> &transform)
+{
+  const int32 size = rays.size();
+  Array<Ray> res;
+  res.resize(size);
+
+  const Ray *in_ptr = rays.get_device_ptr_const();
+  Ray *out_ptr = res.get_device_ptr();
+  const Matrix<Float, 4, 4> mat = transform;
+
+  RAJA::forall<for_policy>(RAJA::RangeSegment(0, size), [=] DRAY_LAMBDA (int32 i)
+  {
+    Ray ray = in_ptr[i];
+    ray.m_orig = transform_point(mat, ray.m_orig);
+    ray.m_dir = transform_vector(mat, ray.m_dir);
+    out_ptr[i] = ray;
+  });
+  DRAY_ERROR_CHECK();
+  return res;
+}
+
 } // namespace dray
@@ -8,6 +8,7 @@
 
 #include <dray/array.hpp>
 #include <dray/exports.hpp>
+#include <dray/matrix.hpp>
 #include <dray/ray_hit.hpp>
 #include <dray/types.hpp>
 #include <dray/vec.hpp>
@@ -67,5 +68,10 @@ Array<Ray> remove_missed_rays (Array<Ray> &rays, AABB<> bounds);
 // set ray max distance to hit distances
 void ray_max(Array<Ray> &rays, const Array<RayHit> &hits);
 
+// returns a copy of the rays moved by the transform. Directions are
+// not re-normalized, so for rigid transforms all distances along the
+// rays stay valid
+Array<Ray> transform_rays(const Array<Ray> &rays, const Matrix<Float, 4, 4> &transform);
+
 } // namespace dray
 #endif
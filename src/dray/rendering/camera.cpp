@@ -12,6 +12,7 @@
 #include <dray/error_check.hpp>
 #include <dray/transform_3d.hpp>
 
+#include <algorithm>
 #include <random>
 #include <sstream>
 
@@ -96,6 +97,11 @@ void Camera::set_zoom(const float32 zoom)
   m_zoom = zoom;
 }
 
+float32 Camera::get_zoom() const
+{
+  return m_zoom;
+}
+
 
 void Camera::set_width (const int32 &width)
 {
@@ -208,23 +214,68 @@ void Camera::create_rays (Array<Ray> &rays, AABB<> bounds)
   create_rays_imp (rays, bounds);
 }
 
+void Camera::create_rays (Array<Ray> &rays, const AABB<2> &pixels)
+{
+  // the rectangle is only used for these rays, keep the caller's subset
+  const int32 subset[4] = {m_subset_width, m_subset_height, m_subset_min_x, m_subset_min_y};
+  set_subset (pixels);
+  m_look = m_look_at - m_position;
+  rays.resize (m_subset_width * m_subset_height);
+  gen_perspective (rays);
+  m_subset_width = subset[0];
+  m_subset_height = subset[1];
+  m_subset_min_x = subset[2];
+  m_subset_min_y = subset[3];
+}
+
 
 void Camera::create_rays_jitter (Array<Ray> &rays, AABB<> bounds)
 {
   create_rays_jitter_imp (rays, bounds);
 }
 
+void Camera::create_rays_jitter (Array<Ray> &rays, const AABB<2> &pixels)
+{
+  // the rectangle is only used for these rays, keep the caller's subset
+  const int32 subset[4] = {m_subset_width, m_subset_height, m_subset_min_x, m_subset_min_y};
+  set_subset (pixels);
+  m_look = m_look_at - m_position;
+  rays.resize (m_subset_width * m_subset_height);
+  gen_perspective_jitter (rays);
+  m_subset_width = subset[0];
+  m_subset_height = subset[1];
+  m_subset_min_x = subset[2];
+  m_subset_min_y = subset[3];
+}
+
+int32 Camera::get_sample () const
+{
+  return m_sample;
+}
+
+void Camera::set_sample (const int32 sample)
+{
+  m_sample = sample;
+}
+
 void Camera::create_rays_imp (Array<Ray> &rays, AABB<> bounds)
 {
-  int32 num_rays = m_width * m_height;
-  // TODO: find subset
-  // for now just set
-  m_subset_width = m_width;
-  m_subset_height = m_height;
-  m_subset_min_x = 0;
-  m_subset_min_y = 0;
+  // empty bounds mean the whole image
+  AABB<2> pixels;
+  if (bounds.is_empty ())
+  {
+    pixels.m_ranges[0].include (0.f);
+    pixels.m_ranges[0].include (float32 (m_width));
+    pixels.m_ranges[1].include (0.f);
+    pixels.m_ranges[1].include (float32 (m_height));
+  }
+  else
+  {
+    pixels = screen_bounds (bounds);
+  }
+  set_subset (pixels);
 
-  rays.resize (num_rays);
+  rays.resize (m_subset_width * m_subset_height);
 
   Vec<Float, 3> pos;
   pos[0] = m_position[0];
@@ -242,15 +293,22 @@ void Camera::create_rays_imp (Array<Ray> &rays, AABB<> bounds)
 
 void Camera::create_rays_jitter_imp (Array<Ray> &rays, AABB<> bounds)
 {
-  int32 num_rays = m_width * m_height;
-  // TODO: find subset
-  // for now just set
-  m_subset_width = m_width;
-  m_subset_height = m_height;
-  m_subset_min_x = 0;
-  m_subset_min_y = 0;
+  // empty bounds mean the whole image
+  AABB<2> pixels;
+  if (bounds.is_empty ())
+  {
+    pixels.m_ranges[0].include (0.f);
+    pixels.m_ranges[0].include (float32 (m_width));
+    pixels.m_ranges[1].include (0.f);
+    pixels.m_ranges[1].include (float32 (m_height));
+  }
+  else
+  {
+    pixels = screen_bounds (bounds);
+  }
+  set_subset (pixels);
 
-  rays.resize (num_rays);
+  rays.resize (m_subset_width * m_subset_height);
 
   Vec<Float, 3> pos;
   pos[0] = m_position[0];
@@ -267,6 +325,26 @@ void Camera::create_rays_jitter_imp (Array<Ray> &rays, AABB<> bounds)
 }
 
 
+void Camera::set_subset (const AABB<2> &pixels)
+{
+  if (pixels.m_ranges[0].is_empty () || pixels.m_ranges[1].is_empty ())
+  {
+    m_subset_width = 0;
+    m_subset_height = 0;
+    m_subset_min_x = 0;
+    m_subset_min_y = 0;
+    return;
+  }
+  const int32 x_min = std::max (0, int32 (pixels.m_ranges[0].min ()));
+  const int32 y_min = std::max (0, int32 (pixels.m_ranges[1].min ()));
+  const int32 x_max = std::min (m_width, int32 (pixels.m_ranges[0].max ()));
+  const int32 y_max = std::min (m_height, int32 (pixels.m_ranges[1].max ()));
+  m_subset_min_x = x_min;
+  m_subset_min_y = y_min;
+  m_subset_width = std::max (0, x_max - x_min);
+  m_subset_height = std::max (0, y_max - y_min);
+}
+
 std::string Camera::print () const
 {
   std::stringstream sstream;
@@ -333,9 +411,10 @@ void Camera::gen_perspective_jitter (Array<Ray> &rays)
   pos[2] = m_position[2];
 
   const int size = rays.size ();
-  if (m_random.size () != size)
+  // one random offset per pixel so subsets jitter like the full image
+  if (m_random.size () != m_width * m_height)
   {
-    m_random.resize (size);
+    m_random.resize (m_width * m_height);
     detail::init_random (m_random);
   }
 
@@ -358,18 +437,19 @@ void Camera::gen_perspective_jitter (Array<Ray> &rays)
     ray.m_near = Float (0.f);
     ray.m_far = infinity<Float> ();
 
-    Vec<Float, 2> xy;
-    int32 sample_index = sample + random_ptr[idx];
-    Halton2D<Float, 3> (sample_index, xy);
-    xy[0] -= 0.5f;
-    xy[1] -= 0.5f;
-
     int32 i = int32 (idx) % sub_w;
     int32 j = int32 (idx) / sub_w;
     i += sub_min_x;
     j += sub_min_y;
     // Write out the global pixelId
     ray.m_pixel_id = static_cast<int32> (j * w + i);
+
+    Vec<Float, 2> xy;
+    int32 sample_index = sample + random_ptr[ray.m_pixel_id];
+    Halton2D<Float, 3> (sample_index, xy);
+    xy[0] -= 0.5f;
+    xy[1] -= 0.5f;
+
     ray.m_dir = nlook + delta_x * ((2.f * (Float (i) + xy[0]) - Float (w)) / 2.0f) +
                 delta_y * ((2.f * (Float (j) + xy[1]) - Float (w)) / 2.0f);
     // avoid some numerical issues
@@ -737,18 +817,17 @@ void Camera::gl_to_world_depth(Array<float32> &gl_depth,
   });
 }
 
-int32 Camera::subset_size(AABB<3> bounds)
+AABB<2> Camera::screen_bounds(const AABB<3> &bounds)
 {
-  int32 res = 0;
+  // pixel space rectangle [xmin,xmax) x [ymin,ymax) covered
+  // by the projection of the bounds. Empty if nothing is visible
+  AABB<2> res;
+  if(bounds.is_empty())
+  {
+    return res;
+  }
   // we need a clipping range to create a perspective projection,
   // so just construct one that wont clip anything
-  int32 max_comp = bounds.max_dim();
-  float32 max_dim = bounds.m_ranges[max_comp].length();
-  max_dim *= 100.f;
-
-  Matrix<float32,4,4> view_proj =
-    this->projection_matrix(0.001f, max_dim) * this->view_matrix();
-
   float32 x[2], y[2], z[2];
   x[0] = static_cast<float32>(bounds.m_ranges[0].min());
   x[1] = static_cast<float32>(bounds.m_ranges[0].max());
@@ -757,15 +836,36 @@ int32 Camera::subset_size(AABB<3> bounds)
   z[0] = static_cast<float32>(bounds.m_ranges[2].min());
   z[1] = static_cast<float32>(bounds.m_ranges[2].max());
 
+  int32 max_comp = bounds.max_dim();
+  float32 max_dim = bounds.m_ranges[max_comp].length();
+  max_dim *= 100.f;
+  // small boxes far away from the camera must not be clipped either
+  for (int32 c = 0; c < 8; ++c)
+  {
+    Vec<float32,3> corner;
+    corner[0] = x[c & 1];
+    corner[1] = y[(c >> 1) & 1];
+    corner[2] = z[(c >> 2) & 1];
+    max_dim = std::max(max_dim, 2.f * (corner - m_position).magnitude());
+  }
+
+  Matrix<float32,4,4> view_proj =
+    this->projection_matrix(0.001f, max_dim) * this->view_matrix();
+
   Vec<Float, 3> pos;
   pos[0] = m_position[0];
   pos[1] = m_position[1];
   pos[2] = m_position[2];
 
   //Inside the data bounds
-  if (bounds.contains(pos))
+  AABB<3> test_bounds = bounds;
+  if (test_bounds.contains(pos))
   {
-    return m_width * m_height;
+    res.m_ranges[0].include(0.f);
+    res.m_ranges[0].include(float32(m_width));
+    res.m_ranges[1].include(0.f);
+    res.m_ranges[1].include(float32(m_height));
+    return res;
   }
 
   float32 xmin, ymin, xmax, ymax, zmin, zmax;
@@ -775,6 +875,7 @@ int32 Camera::subset_size(AABB<3> bounds)
   xmax = neg_infinity32();
   ymax = neg_infinity32();
   zmax = neg_infinity32();
+  int32 clipped = 0;
   Vec<float32,4> extent_point;
   for (int32 i = 0; i < 2; ++i)
     for (int32 j = 0; j < 2; ++j)
@@ -798,6 +899,7 @@ int32 Camera::subset_size(AABB<3> bounds)
         zmax = std::max(zmax, transformed[2]);
         if (transformed[2] < 0 || transformed[2] > 1)
         {
+          clipped++;
           continue;
         }
         xmin = std::min(xmin, transformed[0]);
@@ -806,6 +908,17 @@ int32 Camera::subset_size(AABB<3> bounds)
         ymax = std::max(ymax, transformed[1]);
       }
 
+  // the box crosses the near plane, so the projection of the corners
+  // in front of the camera says nothing about the rest of it
+  if (clipped > 0 && clipped < 8)
+  {
+    res.m_ranges[0].include(0.f);
+    res.m_ranges[0].include(float32(m_width));
+    res.m_ranges[1].include(0.f);
+    res.m_ranges[1].include(float32(m_height));
+    return res;
+  }
+
   xmin -= .001f;
   xmax += .001f;
   ymin -= .001f;
@@ -815,21 +928,30 @@ int32 Camera::subset_size(AABB<3> bounds)
   ymin = std::floor(std::min(std::max(0.f, ymin), float32(m_height)));
   ymax = std::ceil(std::min(std::max(0.f, ymax), float32(m_height)));
 
-  int32 dx = int32(xmax) - int32(xmin);
-  int32 dy = int32(ymax) - int32(ymin);
   //
   //  scene is behind the camera
   //
-  if (zmax < 0 || xmin >= xmax || ymin >= ymax)
+  if (!(zmax < 0 || xmin >= xmax || ymin >= ymax))
   {
-    res = 0;
-  }
-  else
-  {
-    res = dx * dy;
+    res.m_ranges[0].include(xmin);
+    res.m_ranges[0].include(xmax);
+    res.m_ranges[1].include(ymin);
+    res.m_ranges[1].include(ymax);
   }
 
   return res;
 }
 
+int32 Camera::subset_size(AABB<3> bounds)
+{
+  AABB<2> screen = screen_bounds(bounds);
+  if(screen.is_empty())
+  {
+    return 0;
+  }
+  int32 dx = int32(screen.m_ranges[0].max()) - int32(screen.m_ranges[0].min());
+  int32 dy = int32(screen.m_ranges[1].max()) - int32(screen.m_ranges[1].min());
+  return dx * dy;
+}
+
 } // namespace dray
@@ -41,6 +41,9 @@ class Camera
 
   void create_rays_jitter_imp (Array<Ray> &rays, AABB<> bounds);
 
+  // clamp the pixel rectangle to the image and make it the ray subset
+  void set_subset (const AABB<2> &pixels);
+
   public:
   Camera ();
 
@@ -81,12 +84,27 @@ class Camera
 
   void set_zoom(const float32 zoom);
 
+  float32 get_zoom() const;
+
   Vec<float32, 3> get_look_at () const;
 
+  // rays for the pixels covered by the bounds, or the whole image if
+  // the bounds are empty. Pixel ids always refer to the whole image.
   void create_rays (Array<Ray> &rays, AABB<> bounds = AABB<> ());
 
+  // rays for the pixel rectangle [min,max), see screen_bounds.
+  // The subset of the camera is left unchanged.
+  void create_rays (Array<Ray> &rays, const AABB<2> &pixels);
+
   void create_rays_jitter (Array<Ray> &rays, AABB<> bounds = AABB<> ());
 
+  void create_rays_jitter (Array<Ray> &rays, const AABB<2> &pixels);
+
+  // index of the next jitter sample. Every jittered ray generation
+  // advances it by one.
+  int32 get_sample () const;
+  void set_sample (const int32 sample);
+
   void trackball_rotate (float32 startX, float32 startY, float32 endX, float32 endY);
 
   void elevate (const float32 degrees);
@@ -98,6 +116,9 @@ class Camera
   void gen_perspective (Array<Ray> &rays);
 
   int32 subset_size(AABB<3> bounds);
+  // pixel rectangle [min,max) in x and y covered by the bounds.
+  // the result is empty if the bounds are not visible
+  AABB<2> screen_bounds(const AABB<3> &bounds);
 
   void gen_perspective_jitter (Array<Ray> &rays);
 
@@ -8,6 +8,7 @@
 #include <dray/isosurface_intersection.hpp>
 #include <dray/data_model/device_mesh.hpp>
 #include <dray/data_model/device_field.hpp>
+#include <dray/data_model/mesh_utils.hpp>
 #include <dray/utils/data_logger.hpp>
 
 #include <assert.h>
@@ -140,6 +141,8 @@ intersect_isosurface(const Array<Ray> &rays,
                      const float32 &iso_val,
                      UnstructuredField<Element<3, 1, eshape, field_P>> &field,
                      UnstructuredMesh<Element<3, 3, eshape, mesh_P>> &mesh,
+                     const BVH &bvh,
+                     const Array<SubRef<3, eshape>> &ref_aabbs,
                      Array<RayHit> &hits)
 {
   // This method intersects rays with the isosurface using the Newton-Raphson method.
@@ -167,11 +170,10 @@ intersect_isosurface(const Array<Ray> &rays,
   using FElemT = Element<3, 1, eshape, field_P>;
 
   // things we need fromt the bvh
-  BVH bvh = mesh.get_bvh();
   const int32 *leaf_ptr = bvh.m_leaf_nodes.get_device_ptr_const();
   const Vec<float32, 4> *inner_ptr = bvh.m_inner_nodes.get_device_ptr_const();
   const int32 *aabb_ids_ptr = bvh.m_aabb_ids.get_device_ptr_const();
-  const SubRef<3, eshape> *ref_aabb_ptr = mesh.get_ref_aabbs().get_device_ptr_const();
+  const SubRef<3, eshape> *ref_aabb_ptr = ref_aabbs.get_device_ptr_const();
 
   const int32 size = rays.size();
 
@@ -299,12 +301,32 @@ intersect_isosurface(const Array<Ray> &rays,
   stats::StatStore::add_ray_stats(rays, mstats);
 }
 
+// the ref boxes of the cached active BVH for a mesh element type
+template <ElemType etype>
+Array<SubRef<3, etype>> &cached_ref_aabbs(Contour::ActiveBVH &active_bvh);
+
+template <>
+Array<SubRef<3, ElemType::Tensor>> &
+cached_ref_aabbs<ElemType::Tensor>(Contour::ActiveBVH &active_bvh)
+{
+  return active_bvh.m_tensor_aabbs;
+}
+
+template <>
+Array<SubRef<3, ElemType::Simplex>> &
+cached_ref_aabbs<ElemType::Simplex>(Contour::ActiveBVH &active_bvh)
+{
+  return active_bvh.m_simplex_aabbs;
+}
+
 template<class MeshElement, class FieldElement>
 Array<RayHit>
 contour_execute(UnstructuredMesh<MeshElement> &mesh,
                 UnstructuredField<FieldElement> &field,
                 Array<Ray> &rays,
-                Float iso_val)
+                Float iso_val,
+                Contour::ActiveBVH &active_bvh,
+                const bool reuse_bvh)
 {
   DRAY_LOG_OPEN("isosuface");
 
@@ -316,11 +338,56 @@ contour_execute(UnstructuredMesh<MeshElement> &mesh,
   Array<RayHit> hits;
   hits.resize(rays.size());
 
+  constexpr ElemType etype = MeshElement::get_etype();
+  using SubRefT = typename get_subref<MeshElement>::type;
+
+  if(!reuse_bvh)
+  {
+    // Only elements whose field coefficients straddle the iso value
+    // can contain the isosurface. Trace against a BVH over the active
+    // elements. When most elements are active the cached BVH of the
+    // mesh is cheaper than a rebuild.
+    constexpr Float full_bvh_fraction = 0.5f;
+    Array<int32> active = field.get_span_space().active(iso_val);
+    active_bvh.m_active_size = active.size();
+    active_bvh.m_full_mesh = active.size() > full_bvh_fraction * mesh.cells();
+    if(active.size() > 0 && !active_bvh.m_full_mesh)
+    {
+      active_bvh.m_bvh = detail::construct_bvh(mesh,
+                                               cached_ref_aabbs<etype>(active_bvh),
+                                               active);
+    }
+  }
+  DRAY_LOG_ENTRY("active_elems", active_bvh.m_active_size);
+  DRAY_LOG_ENTRY("reused_bvh", reuse_bvh ? 1 : 0);
+
+  if(active_bvh.m_active_size == 0)
+  {
+    init_hits(hits);
+    DRAY_LOG_CLOSE();
+    return hits;
+  }
+
+  BVH bvh;
+  Array<SubRefT> ref_aabbs;
+  if(active_bvh.m_full_mesh)
+  {
+    bvh = mesh.get_bvh();
+    ref_aabbs = mesh.get_ref_aabbs();
+  }
+  else
+  {
+    bvh = active_bvh.m_bvh;
+    ref_aabbs = cached_ref_aabbs<etype>(active_bvh);
+  }
+
   // Intersect rays with isosurface.
   detail::intersect_isosurface(rays,
                                iso_val,
                                field,
                                mesh,
+                               bvh,
+                               ref_aabbs,
                                hits);
 
   DRAY_LOG_CLOSE();
@@ -332,18 +399,29 @@ struct ContourFunctor
   Array<Ray> *m_rays;
   Array<RayHit> m_hits;
   Float m_iso_val;
+  Contour::ActiveBVH *m_active_bvh;
+  bool m_reuse_bvh;
 
   ContourFunctor(Array<Ray> *rays,
-                 Float iso_val)
+                 Float iso_val,
+                 Contour::ActiveBVH *active_bvh,
+                 const bool reuse_bvh)
     : m_rays(rays),
-      m_iso_val(iso_val)
+      m_iso_val(iso_val),
+      m_active_bvh(active_bvh),
+      m_reuse_bvh(reuse_bvh)
   {
   }
 
   template<typename MeshType, typename FieldType>
   void operator()(MeshType &mesh, FieldType &field)
   {
-    m_hits = contour_execute(mesh, field, *m_rays, m_iso_val);
+    m_hits = contour_execute(mesh,
+                             field,
+                             *m_rays,
+                             m_iso_val,
+                             *m_active_bvh,
+                             m_reuse_bvh);
   }
 };
 
@@ -360,16 +438,48 @@ Contour::~Contour()
 }
 
 Array<RayHit>
-Contour::nearest_hit(Array<Ray> &rays)
+Contour::nearest_hit(Array<Ray> &rays, const int32 domain)
 {
   assert(m_iso_field_name != "");
 
-  DataSet data_set = m_collection.domain(m_active_domain);
+  DataSet data_set = m_collection.domain(domain);
   Mesh *topo = data_set.mesh();
-  Field *field = data_set.field(m_iso_field_name);
+  std::shared_ptr<Field> field = data_set.field_shared(m_iso_field_name);
+
+  // reuse the active element BVH of the last trace of this domain
+  ActiveBVH active_bvh;
+  bool reuse_bvh = false;
+  {
+    std::lock_guard<std::mutex> lock(m_bvh_mutex);
+    auto cached = m_active_bvhs.find(domain);
+    if(cached != m_active_bvhs.end() &&
+       cached->second.m_mesh == topo &&
+       cached->second.m_field.lock() == field &&
+       cached->second.m_iso_value == m_iso_value)
+    {
+      active_bvh = cached->second;
+      reuse_bvh = true;
+    }
+  }
+
+  // instanced domains are traced in object space
+  Array<Ray> obj_rays = rays;
+  if(data_set.has_transform())
+  {
+    obj_rays = transform_rays(rays, data_set.inverse_transform());
+  }
+
+  detail::ContourFunctor func( &obj_rays, m_iso_value, &active_bvh, reuse_bvh);
+  dispatch_3d(topo, field.get(), func);
 
-  detail::ContourFunctor func( &rays, m_iso_value);
-  dispatch_3d(topo, field, func);
+  if(!reuse_bvh)
+  {
+    active_bvh.m_mesh = topo;
+    active_bvh.m_field = field;
+    active_bvh.m_iso_value = m_iso_value;
+    std::lock_guard<std::mutex> lock(m_bvh_mutex);
+    m_active_bvhs[domain] = active_bvh;
+  }
   return func.m_hits;
 }
 
@@ -7,21 +7,45 @@
 #define DRAY_CONTOUR_HPP
 
 #include <dray/rendering/traceable.hpp>
+#include <dray/bvh.hpp>
+#include <dray/data_model/subref.hpp>
+
+#include <map>
+#include <memory>
+#include <mutex>
 
 namespace dray
 {
 
 class Contour : public Traceable
 {
+public:
+  // BVH over the elements of a domain that straddle the iso value.
+  // Valid while the domain keeps the same mesh, field and iso value.
+  struct ActiveBVH
+  {
+    const Mesh *m_mesh;
+    std::weak_ptr<Field> m_field;
+    float32 m_iso_value;
+    int32 m_active_size;
+    bool m_full_mesh; // the cached mesh BVH is used instead
+    BVH m_bvh;
+    Array<SubRef<3, ElemType::Tensor>> m_tensor_aabbs;
+    Array<SubRef<3, ElemType::Simplex>> m_simplex_aabbs;
+  };
 protected:
   std::string m_iso_field_name;
   float32 m_iso_value;
+  // per domain, guarded by m_bvh_mutex since domains trace concurrently
+  std::map<int32, ActiveBVH> m_active_bvhs;
+  std::mutex m_bvh_mutex;
 public:
   Contour() = delete;
   Contour(Collection &collection);
   virtual ~Contour();
 
-  virtual Array<RayHit> nearest_hit(Array<Ray> &rays) override;
+  using Traceable::nearest_hit;
+  virtual Array<RayHit> nearest_hit(Array<Ray> &rays, const int32 domain) override;
 
   void iso_field(const std::string field_name);
   void iso_value(const float32 iso_value);
@@ -0,0 +1,212 @@
+// Copyright 2019 Lawrence Livermore National Security, LLC and other
+// Devil Ray Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (BSD-3-Clause)
+
+#include <dray/rendering/domain_culling.hpp>
+#include <dray/array_utils.hpp>
+#include <dray/error_check.hpp>
+#include <dray/policies.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace dray
+{
+
+namespace detail
+{
+
+// distance from the point to the closest point of the box
+Float box_distance(const AABB<3> &bounds, const Vec<float32,3> &point)
+{
+  Float dist2 = 0.f;
+  for(int32 d = 0; d < 3; ++d)
+  {
+    const Float below = bounds.m_ranges[d].min() - Float(point[d]);
+    const Float above = Float(point[d]) - bounds.m_ranges[d].max();
+    const Float gap = std::max(Float(0.f), std::max(below, above));
+    dist2 += gap * gap;
+  }
+  return std::sqrt(dist2);
+}
+
+} // namespace detail
+
+std::vector<DomainView> visible_domains(Collection &collection, Camera &camera)
+{
+  std::vector<DomainView> views;
+  const Vec<float32,3> pos = camera.get_pos();
+  const int32 domains = collection.local_size();
+  for(int32 d = 0; d < domains; ++d)
+  {
+    AABB<3> bounds = collection.domain(d).bounds();
+    DomainView view;
+    view.m_domain = d;
+    view.m_rect = camera.screen_bounds(bounds);
+    if(view.m_rect.is_empty())
+    {
+      continue;
+    }
+    // pulled in a bit so neighbors sharing a face are never culled
+    view.m_near = detail::box_distance(bounds, pos) * 0.999f;
+    views.push_back(view);
+  }
+
+  // near domains first so they shorten the rays of the far ones
+  std::stable_sort(views.begin(), views.end(),
+                   [](const DomainView &a, const DomainView &b)
+                   {
+                     return a.m_near < b.m_near;
+                   });
+  return views;
+}
+
+std::vector<DomainView> all_domains(Collection &collection,
+                                    const int32 width,
+                                    const int32 height)
+{
+  std::vector<DomainView> views;
+  const int32 domains = collection.local_size();
+  for(int32 d = 0; d < domains; ++d)
+  {
+    DomainView view;
+    view.m_domain = d;
+    view.m_rect.m_ranges[0].include(0.f);
+    view.m_rect.m_ranges[0].include(Float(width));
+    view.m_rect.m_ranges[1].include(0.f);
+    view.m_rect.m_ranges[1].include(Float(height));
+    view.m_near = 0.f;
+    views.push_back(view);
+  }
+  return views;
+}
+
+Array<int32> rays_in_view(const Array<Ray> &rays,
+                          const DomainView &view,
+                          const int32 width,
+                          const int32 pixel_offset)
+{
+  const int32 size = rays.size();
+  Array<int32> flags;
+  flags.resize(size);
+
+  const int32 x_min = int32(view.m_rect.m_ranges[0].min());
+  const int32 x_max = int32(view.m_rect.m_ranges[0].max());
+  const int32 y_min = int32(view.m_rect.m_ranges[1].min());
+  const int32 y_max = int32(view.m_rect.m_ranges[1].max());
+  const Float near = view.m_near;
+  const int32 w = width;
+  const int32 offset = pixel_offset;
+
+  const Ray *ray_ptr = rays.get_device_ptr_const();
+  int32 *flags_ptr = flags.get_device_ptr();
+
+  RAJA::forall<for_policy>(RAJA::RangeSegment(0, size), [=] DRAY_LAMBDA (int32 i)
+  {
+    const Ray ray = ray_ptr[i];
+    const int32 x = (ray.m_pixel_id - offset) % w;
+    const int32 y = (ray.m_pixel_id - offset) / w;
+    const bool inside = x >= x_min && x < x_max && y >= y_min && y < y_max;
+    flags_ptr[i] = (inside && ray.m_far >= near) ? 1 : 0;
+  });
+  DRAY_ERROR_CHECK();
+
+  return index_flags(flags);
+}
+
+Array<Ray> view_rays(Camera &camera,
+                     const DomainView &view,
+                     Framebuffer &framebuffer,
+                     const bool jitter,
+                     const int32 pixel_offset)
+{
+  Array<Ray> rays;
+  if(jitter)
+  {
+    const int32 sample = camera.get_sample();
+    camera.create_rays_jitter(rays, view.m_rect);
+    camera.set_sample(sample);
+  }
+  else
+  {
+    camera.create_rays(rays, view.m_rect);
+  }
+  if(rays.size() == 0)
+  {
+    return rays;
+  }
+  if(pixel_offset != 0)
+  {
+    offset_pixels(rays, pixel_offset);
+  }
+  clip_to_depths(rays, framebuffer);
+
+  const int32 size = rays.size();
+  Array<int32> flags;
+  flags.resize(size);
+  const Float near = view.m_near;
+  const Ray *ray_ptr = rays.get_device_ptr_const();
+  int32 *flags_ptr = flags.get_device_ptr();
+
+  RAJA::forall<for_policy>(RAJA::RangeSegment(0, size), [=] DRAY_LAMBDA (int32 i)
+  {
+    flags_ptr[i] = ray_ptr[i].m_far >= near ? 1 : 0;
+  });
+  DRAY_ERROR_CHECK();
+
+  Array<int32> ids = index_flags(flags);
+  if(ids.size() == size)
+  {
+    return rays;
+  }
+  return gather(rays, ids);
+}
+
+void offset_pixels(Array<Ray> &rays, const int32 pixel_offset)
+{
+  const int32 size = rays.size();
+  const int32 offset = pixel_offset;
+  Ray *ray_ptr = rays.get_device_ptr();
+
+  RAJA::forall<for_policy>(RAJA::RangeSegment(0, size), [=] DRAY_LAMBDA (int32 i)
+  {
+    ray_ptr[i].m_pixel_id += offset;
+  });
+  DRAY_ERROR_CHECK();
+}
+
+void clip_to_depths(Array<Ray> &rays, Framebuffer &framebuffer)
+{
+  const int32 size = rays.size();
+  const float32 *depth_ptr = framebuffer.depths().get_device_ptr_const();
+  Ray *ray_ptr = rays.get_device_ptr();
+
+  RAJA::forall<for_policy>(RAJA::RangeSegment(0, size), [=] DRAY_LAMBDA (int32 i)
+  {
+    const Float depth = depth_ptr[ray_ptr[i].m_pixel_id];
+    if(depth < ray_ptr[i].m_far)
+    {
+      ray_ptr[i].m_far = depth;
+    }
+  });
+  DRAY_ERROR_CHECK();
+}
+
+void scatter_far(const Array<Ray> &subset,
+                 const Array<int32> &indices,
+                 Array<Ray> &rays)
+{
+  const int32 size = subset.size();
+  const Ray *subset_ptr = subset.get_device_ptr_const();
+  const int32 *index_ptr = indices.get_device_ptr_const();
+  Ray *ray_ptr = rays.get_device_ptr();
+
+  RAJA::forall<for_policy>(RAJA::RangeSegment(0, size), [=] DRAY_LAMBDA (int32 i)
+  {
+    ray_ptr[index_ptr[i]].m_far = subset_ptr[i].m_far;
+  });
+  DRAY_ERROR_CHECK();
+}
+
+} // namespace dray
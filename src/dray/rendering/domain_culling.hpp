@@ -0,0 +1,69 @@
+// Copyright 2019 Lawrence Livermore National Security, LLC and other
+// Devil Ray Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (BSD-3-Clause)
+
+#ifndef DRAY_DOMAIN_CULLING_HPP
+#define DRAY_DOMAIN_CULLING_HPP
+
+#include <dray/aabb.hpp>
+#include <dray/array.hpp>
+#include <dray/ray.hpp>
+#include <dray/data_model/collection.hpp>
+#include <dray/rendering/camera.hpp>
+#include <dray/rendering/framebuffer.hpp>
+
+#include <vector>
+
+namespace dray
+{
+
+// what the camera sees of one local domain
+struct DomainView
+{
+  int32 m_domain;  // local domain index
+  AABB<2> m_rect;  // pixel rectangle [min,max) covered by the domain
+  Float m_near;    // distance from the camera to the domain bounds
+};
+
+// the domains whose bounds project onto the image, front to back
+std::vector<DomainView> visible_domains(Collection &collection, Camera &camera);
+
+// every domain over the full image, in index order
+std::vector<DomainView> all_domains(Collection &collection,
+                                    const int32 width,
+                                    const int32 height);
+
+// indices of the rays inside the view's rectangle that can still reach
+// the domain, i.e. no closer surface has already been found. Pixel ids
+// are taken relative to pixel_offset.
+Array<int32> rays_in_view(const Array<Ray> &rays,
+                          const DomainView &view,
+                          const int32 width,
+                          const int32 pixel_offset = 0);
+
+// generates rays only for the view's pixel rectangle. Far distances are
+// clipped to the depths already in the framebuffer and rays that end
+// before the domain are dropped, so the cost follows the footprint.
+// Jittered rays use the camera's current sample without advancing it.
+// Pixel ids are shifted by pixel_offset, which places the image inside
+// a larger framebuffer holding several views.
+Array<Ray> view_rays(Camera &camera,
+                     const DomainView &view,
+                     Framebuffer &framebuffer,
+                     const bool jitter = false,
+                     const int32 pixel_offset = 0);
+
+// shift the pixel ids of the rays
+void offset_pixels(Array<Ray> &rays, const int32 pixel_offset);
+
+// pull the far distance of every ray in to the framebuffer depth
+void clip_to_depths(Array<Ray> &rays, Framebuffer &framebuffer);
+
+// copy the far distances of a gathered ray subset back to the full set
+void scatter_far(const Array<Ray> &subset,
+                 const Array<int32> &indices,
+                 Array<Ray> &rays);
+
+} // namespace dray
+#endif
@@ -14,7 +14,7 @@ namespace dray
 
 Framebuffer::Framebuffer ()
 : m_width (1024), m_height (1024), m_bg_color ({ 1.f, 1.f, 1.f, 1.f }),
-  m_fg_color ({ 0.f, 0.f, 0.f, 1.f })
+  m_fg_color ({ 0.f, 0.f, 0.f, 1.f }), m_format (RGBA32F)
 {
   m_colors.resize (m_width * m_height);
   m_depths.resize (m_width * m_height);
@@ -23,7 +23,7 @@ Framebuffer::Framebuffer ()
 
 Framebuffer::Framebuffer (const int32 width, const int32 height)
 : m_width (width), m_height (height), m_bg_color ({ 1.f, 1.f, 1.f, 1.f }),
-  m_fg_color ({ 0.f, 0.f, 0.f, 1.f })
+  m_fg_color ({ 0.f, 0.f, 0.f, 1.f }), m_format (RGBA32F)
 {
   assert (m_width > 0);
   assert (m_height > 0);
@@ -103,6 +103,38 @@ void Framebuffer::save_depth (const std::string name)
   png_encoder.save (name + ".png");
 }
 
+void Framebuffer::format (const PixelFormat format)
+{
+  m_format = format;
+}
+
+PixelFormat Framebuffer::format () const
+{
+  return m_format;
+}
+
+void Framebuffer::quantize ()
+{
+  if (m_format == RGBA32F)
+  {
+    return;
+  }
+
+  const PixelFormat format = m_format;
+  const int32 size = m_colors.size ();
+  Vec<float32, 4> *color_ptr = m_colors.get_device_ptr ();
+  float32 *depth_ptr = m_depths.get_device_ptr ();
+
+  RAJA::forall<for_policy> (RAJA::RangeSegment (0, size), [=] DRAY_LAMBDA (int32 i) {
+    Vec<float32, 4> color = color_ptr[i];
+    float32 depth = depth_ptr[i];
+    detail::quantize_pixel (format, color, depth);
+    color_ptr[i] = color;
+    depth_ptr[i] = depth;
+  });
+  DRAY_ERROR_CHECK();
+}
+
 void Framebuffer::background_color (const Vec<float32, 4> &color)
 {
   m_bg_color = color;
@@ -149,12 +181,16 @@ void Framebuffer::composite_background ()
   Vec4f background = m_bg_color;
   Vec4f *img_ptr = m_colors.get_device_ptr ();
   const int32 size = m_colors.size ();
+  const PixelFormat format = m_format;
 
   RAJA::forall<for_policy> (RAJA::RangeSegment (0, size), [=] DRAY_LAMBDA (int32 i) {
     Vec4f color = img_ptr[i];
     if (color[3] < 1.f)
     {
       blend_pre_alpha(color, background);
+      // stay at the precision of the format
+      float32 depth = 0.f;
+      detail::quantize_pixel (format, color, depth);
       img_ptr[i] = color;
     }
   });
@@ -9,6 +9,7 @@
 #include <dray/aabb.hpp>
 #include <dray/array.hpp>
 #include <dray/exports.hpp>
+#include <dray/rendering/pixel_format.hpp>
 #include <dray/types.hpp>
 #include <dray/vec.hpp>
 
@@ -25,6 +26,7 @@ class Framebuffer
   int32 m_height;
   Vec<float32, 4> m_bg_color;
   Vec<float32, 4> m_fg_color;
+  PixelFormat m_format;
 
   public:
   Framebuffer ();
@@ -39,6 +41,14 @@ class Framebuffer
   void save (const std::string name);
   void save_depth (const std::string name);
 
+  // wire format image compositing sends the pixels in (default
+  // RGBA32F). Storage is float in every format; quantize rounds the
+  // pixels to the precision of the wire format.
+  void format (const PixelFormat format);
+  PixelFormat format () const;
+  // round all pixels to the precision of the format
+  void quantize ();
+
   void background_color (const Vec<float32, 4> &color);
   void foreground_color (const Vec<float32, 4> &color);
 
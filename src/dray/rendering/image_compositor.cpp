@@ -0,0 +1,523 @@
+// Copyright 2019 Lawrence Livermore National Security, LLC and other
+// Devil Ray Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (BSD-3-Clause)
+
+#include <dray/rendering/image_compositor.hpp>
+#include <dray/utils/data_logger.hpp>
+#include <dray/dray.hpp>
+#include <dray/error.hpp>
+#include <dray/error_check.hpp>
+#include <dray/policies.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+#ifdef DRAY_MPI_ENABLED
+#include <mpi.h>
+#endif
+
+namespace dray
+{
+
+namespace detail
+{
+
+// split [begin, end) into k near equal pieces and return piece 'piece'
+void split_range(const int32 begin,
+                 const int32 end,
+                 const int32 k,
+                 const int32 piece,
+                 int32 &piece_begin,
+                 int32 &piece_end)
+{
+  const int64 length = end - begin;
+  piece_begin = begin + static_cast<int32>((length * piece) / k);
+  piece_end = begin + static_cast<int32>((length * (piece + 1)) / k);
+}
+
+std::vector<int32> factor_ranks(const int32 size)
+{
+  std::vector<int32> res;
+  int32 rem = size;
+  while(rem > 1)
+  {
+    if(rem % 4 == 0)
+    {
+      res.push_back(4);
+      rem /= 4;
+    }
+    else if(rem % 2 == 0)
+    {
+      res.push_back(2);
+      rem /= 2;
+    }
+    else
+    {
+      // smallest remaining prime factor gets composited by direct send
+      int32 factor = 3;
+      while(rem % factor != 0)
+      {
+        factor += 2;
+      }
+      res.push_back(factor);
+      rem /= factor;
+    }
+  }
+  return res;
+}
+
+// convert a pixel space box into integer [min,max) bounds
+void rect_bounds(const AABB<2> &rect,
+                 int32 &x_min,
+                 int32 &y_min,
+                 int32 &x_max,
+                 int32 &y_max)
+{
+  if(rect.is_empty() ||
+     rect.m_ranges[0].is_empty() ||
+     rect.m_ranges[1].is_empty())
+  {
+    x_min = y_min = x_max = y_max = 0;
+    return;
+  }
+  x_min = static_cast<int32>(rect.m_ranges[0].min());
+  x_max = static_cast<int32>(rect.m_ranges[0].max());
+  y_min = static_cast<int32>(rect.m_ranges[1].min());
+  y_max = static_cast<int32>(rect.m_ranges[1].max());
+}
+
+// calls func(pixel_begin, linear_begin, count) for every row segment of the
+// linear range [begin, end) of the composite rectangle that lies inside
+// the box [x_min, x_max) x [y_min, y_max). Segments are visited in order.
+template<typename Func>
+void visit_overlap(const int32 begin,
+                   const int32 end,
+                   const int32 rect_x_min,
+                   const int32 rect_y_min,
+                   const int32 rect_width,
+                   const int32 image_width,
+                   const int32 *box,
+                   Func func)
+{
+  if(begin >= end || rect_width == 0)
+  {
+    return;
+  }
+  const int32 first_row = begin / rect_width;
+  const int32 last_row = (end - 1) / rect_width;
+  for(int32 row = first_row; row <= last_row; ++row)
+  {
+    const int32 y = rect_y_min + row;
+    if(y < box[1] || y >= box[3])
+    {
+      continue;
+    }
+    int32 seg_begin = std::max(begin, row * rect_width);
+    int32 seg_end = std::min(end, (row + 1) * rect_width);
+    // clip the row segment to the box in x
+    const int32 row_start = row * rect_width;
+    seg_begin = std::max(seg_begin, row_start + box[0] - rect_x_min);
+    seg_end = std::min(seg_end, row_start + box[2] - rect_x_min);
+    if(seg_begin >= seg_end)
+    {
+      continue;
+    }
+    const int32 x = rect_x_min + seg_begin - row_start;
+    func(y * image_width + x, seg_begin, seg_end - seg_begin);
+  }
+}
+
+} // namespace detail
+
+ImageCompositor::ImageCompositor()
+  : m_x_min(0),
+    m_y_min(0),
+    m_rect_width(0),
+    m_rect_height(0),
+    m_image_width(0)
+{
+}
+
+void ImageCompositor::radices(const std::vector<int32> &k)
+{
+  m_radices = k;
+}
+
+void ImageCompositor::region(const int32 rank, int32 &begin, int32 &end) const
+{
+  begin = 0;
+  end = m_rect_width * m_rect_height;
+  int32 stride = 1;
+  const int32 rounds = m_schedule.size();
+  for(int32 r = 0; r < rounds; ++r)
+  {
+    const int32 k = m_schedule[r];
+    const int32 piece = (rank / stride) % k;
+    int32 piece_begin, piece_end;
+    detail::split_range(begin, end, k, piece, piece_begin, piece_end);
+    begin = piece_begin;
+    end = piece_end;
+    stride *= k;
+  }
+}
+
+void ImageCompositor::composite(Framebuffer &framebuffer, const AABB<2> &rect)
+{
+  DRAY_LOG_OPEN("image_composite");
+  int32 x_min, y_min, x_max, y_max;
+  detail::rect_bounds(rect, x_min, y_min, x_max, y_max);
+  m_x_min = x_min;
+  m_y_min = y_min;
+  m_rect_width = x_max - x_min;
+  m_rect_height = y_max - y_min;
+  m_image_width = framebuffer.width();
+  DRAY_LOG_ENTRY("rect_width", m_rect_width);
+  DRAY_LOG_ENTRY("rect_height", m_rect_height);
+
+#ifdef DRAY_MPI_ENABLED
+  Timer timer;
+  MPI_Comm mpi_comm = MPI_Comm_f2c(dray::mpi_comm());
+  const int32 rank = dray::mpi_rank();
+  const int32 size = dray::mpi_size();
+
+  if(m_radices.size() > 0)
+  {
+    int32 product = 1;
+    for(int32 i = 0; i < m_radices.size(); ++i)
+    {
+      product *= m_radices[i];
+    }
+    if(product != size)
+    {
+      DRAY_ERROR("Product of compositing radices ("<<product<<") must "
+                 <<"equal the number of ranks ("<<size<<")");
+    }
+    m_schedule = m_radices;
+  }
+  else
+  {
+    m_schedule = detail::factor_ranks(size);
+  }
+
+  const int32 rect_width = m_rect_width;
+  const int32 rect_x_min = m_x_min;
+  const int32 rect_y_min = m_y_min;
+  const int32 image_width = m_image_width;
+
+  // pixels travel in the framebuffer's format. Rounding our own pixels
+  // first makes the depth test see the same precision on both sides.
+  const PixelFormat format = framebuffer.format();
+  const int32 pixel_bytes = detail::pixel_bytes(format);
+  framebuffer.quantize();
+  DRAY_LOG_ENTRY("pixel_bytes", pixel_bytes);
+
+  Vec<float32,4> *color_ptr = framebuffer.colors().get_host_ptr();
+  float32 *depth_ptr = framebuffer.depths().get_host_ptr();
+
+  size_t bytes_sent = 0;
+  int32 begin = 0;
+  int32 end = m_rect_width * m_rect_height;
+  int32 stride = 1;
+  const int32 rounds = m_schedule.size();
+
+  for(int32 r = 0; r < rounds; ++r)
+  {
+    const int32 k = m_schedule[r];
+    const int32 piece = (rank / stride) % k;
+    const int32 group_base = rank - piece * stride;
+
+    std::vector<std::vector<uint8>> send_bufs(k);
+    std::vector<std::vector<uint8>> recv_bufs(k);
+    std::vector<MPI_Request> requests;
+
+    int32 my_begin, my_end;
+    detail::split_range(begin, end, k, piece, my_begin, my_end);
+    const int32 my_size = my_end - my_begin;
+
+    for(int32 m = 0; m < k; ++m)
+    {
+      if(m == piece)
+      {
+        continue;
+      }
+      const int32 partner = group_base + m * stride;
+
+      int32 send_begin, send_end;
+      detail::split_range(begin, end, k, m, send_begin, send_end);
+      const int32 send_size = send_end - send_begin;
+      send_bufs[m].resize(send_size * pixel_bytes);
+      uint8 *send_ptr = send_bufs[m].data();
+
+      RAJA::forall<for_cpu_policy>(RAJA::RangeSegment(0, send_size),
+        [=] DRAY_CPU_LAMBDA (int32 i)
+      {
+        const int32 l = send_begin + i;
+        const int32 pixel = (rect_y_min + l / rect_width) * image_width
+                            + rect_x_min + l % rect_width;
+        detail::pack_pixel(format,
+                           color_ptr[pixel],
+                           depth_ptr[pixel],
+                           send_ptr + i * pixel_bytes);
+      });
+
+      MPI_Request send_req;
+      MPI_Isend(send_ptr,
+                send_size * pixel_bytes,
+                MPI_BYTE,
+                partner,
+                r,
+                mpi_comm,
+                &send_req);
+      requests.push_back(send_req);
+      bytes_sent += send_bufs[m].size();
+
+      recv_bufs[m].resize(my_size * pixel_bytes);
+      MPI_Request recv_req;
+      MPI_Irecv(recv_bufs[m].data(),
+                my_size * pixel_bytes,
+                MPI_BYTE,
+                partner,
+                r,
+                mpi_comm,
+                &recv_req);
+      requests.push_back(recv_req);
+    }
+
+    if(requests.size() > 0)
+    {
+      std::vector<MPI_Status> status(requests.size());
+      MPI_Waitall(requests.size(), &requests[0], &status[0]);
+    }
+
+    // z-buffer blend everything we received into our piece
+    for(int32 m = 0; m < k; ++m)
+    {
+      if(m == piece)
+      {
+        continue;
+      }
+      const uint8 *recv_ptr = recv_bufs[m].data();
+      RAJA::forall<for_cpu_policy>(RAJA::RangeSegment(0, my_size),
+        [=] DRAY_CPU_LAMBDA (int32 i)
+      {
+        const int32 l = my_begin + i;
+        const int32 pixel = (rect_y_min + l / rect_width) * image_width
+                            + rect_x_min + l % rect_width;
+        Vec<float32,4> color;
+        float32 depth;
+        detail::unpack_pixel(format, recv_ptr + i * pixel_bytes, color, depth);
+        if(depth < depth_ptr[pixel])
+        {
+          color_ptr[pixel] = color;
+          depth_ptr[pixel] = depth;
+        }
+      });
+    }
+
+    begin = my_begin;
+    end = my_end;
+    stride *= k;
+  }
+  DRAY_LOG_ENTRY("swap", timer.elapsed());
+  timer.reset();
+
+  // gather the final stripes on rank 0
+  const int32 my_size = end - begin;
+  std::vector<uint8> stripe(my_size * pixel_bytes);
+  uint8 *stripe_ptr = stripe.data();
+  const int32 stripe_begin = begin;
+  RAJA::forall<for_cpu_policy>(RAJA::RangeSegment(0, my_size),
+    [=] DRAY_CPU_LAMBDA (int32 i)
+  {
+    const int32 l = stripe_begin + i;
+    const int32 pixel = (rect_y_min + l / rect_width) * image_width
+                        + rect_x_min + l % rect_width;
+    detail::pack_pixel(format,
+                       color_ptr[pixel],
+                       depth_ptr[pixel],
+                       stripe_ptr + i * pixel_bytes);
+  });
+
+  std::vector<int32> counts;
+  std::vector<int32> offsets;
+  std::vector<uint8> gathered;
+  if(rank == 0)
+  {
+    counts.resize(size);
+    offsets.resize(size);
+    int32 total = 0;
+    for(int32 i = 0; i < size; ++i)
+    {
+      int32 r_begin, r_end;
+      region(i, r_begin, r_end);
+      counts[i] = (r_end - r_begin) * pixel_bytes;
+      offsets[i] = total;
+      total += counts[i];
+    }
+    gathered.resize(total);
+  }
+
+  MPI_Gatherv(stripe_ptr,
+              my_size * pixel_bytes,
+              MPI_BYTE,
+              rank == 0 ? gathered.data() : nullptr,
+              rank == 0 ? &counts[0] : nullptr,
+              rank == 0 ? &offsets[0] : nullptr,
+              MPI_BYTE,
+              0,
+              mpi_comm);
+  bytes_sent += stripe.size();
+
+  if(rank == 0)
+  {
+    // stripes are ordered by rank and each one is a contiguous
+    // range of the rectangle, so just walk them in order
+    for(int32 i = 0; i < size; ++i)
+    {
+      int32 r_begin, r_end;
+      region(i, r_begin, r_end);
+      const uint8 *in_ptr = gathered.data() + offsets[i];
+      RAJA::forall<for_cpu_policy>(RAJA::RangeSegment(0, r_end - r_begin),
+        [=] DRAY_CPU_LAMBDA (int32 p)
+      {
+        const int32 l = r_begin + p;
+        const int32 pixel = (rect_y_min + l / rect_width) * image_width
+                            + rect_x_min + l % rect_width;
+        detail::unpack_pixel(format,
+                             in_ptr + p * pixel_bytes,
+                             color_ptr[pixel],
+                             depth_ptr[pixel]);
+      });
+    }
+  }
+  DRAY_LOG_ENTRY("gather", timer.elapsed());
+  DRAY_LOG_ENTRY("bytes_sent", bytes_sent);
+#endif
+  DRAY_LOG_CLOSE();
+}
+
+void ImageCompositor::synch_depths(Framebuffer &framebuffer,
+                                   const AABB<2> &interest,
+                                   Array<Ray> &rays)
+{
+#ifdef DRAY_MPI_ENABLED
+  DRAY_LOG_OPEN("synch_depths");
+  Timer timer;
+  MPI_Comm mpi_comm = MPI_Comm_f2c(dray::mpi_comm());
+  const int32 rank = dray::mpi_rank();
+  const int32 size = dray::mpi_size();
+
+  int32 my_box[4];
+  detail::rect_bounds(interest, my_box[0], my_box[1], my_box[2], my_box[3]);
+
+  std::vector<int32> boxes(size * 4);
+  MPI_Allgather(my_box, 4, MPI_INT, &boxes[0], 4, MPI_INT, mpi_comm);
+
+  float32 *depth_ptr = framebuffer.depths().get_host_ptr();
+
+  int32 begin, end;
+  region(rank, begin, end);
+
+  // pack the parts of our stripe everyone else cares about
+  std::vector<int32> send_counts(size, 0);
+  std::vector<int32> send_offsets(size, 0);
+  std::vector<float32> send_buf;
+  for(int32 q = 0; q < size; ++q)
+  {
+    send_offsets[q] = send_buf.size();
+    if(q == rank)
+    {
+      continue;
+    }
+    detail::visit_overlap(begin, end, m_x_min, m_y_min, m_rect_width,
+                          m_image_width, &boxes[q * 4],
+                          [&](int32 pixel, int32, int32 count)
+    {
+      send_buf.insert(send_buf.end(), depth_ptr + pixel, depth_ptr + pixel + count);
+    });
+    send_counts[q] = send_buf.size() - send_offsets[q];
+  }
+
+  // and figure out what we get from everyone else
+  std::vector<int32> recv_counts(size, 0);
+  std::vector<int32> recv_offsets(size, 0);
+  int32 recv_total = 0;
+  for(int32 p = 0; p < size; ++p)
+  {
+    recv_offsets[p] = recv_total;
+    if(p == rank)
+    {
+      continue;
+    }
+    int32 p_begin, p_end;
+    region(p, p_begin, p_end);
+    detail::visit_overlap(p_begin, p_end, m_x_min, m_y_min, m_rect_width,
+                          m_image_width, my_box,
+                          [&](int32, int32, int32 count)
+    {
+      recv_counts[p] += count;
+    });
+    recv_total += recv_counts[p];
+  }
+
+  std::vector<float32> recv_buf(recv_total);
+  MPI_Alltoallv(send_buf.data(),
+                &send_counts[0],
+                &send_offsets[0],
+                MPI_FLOAT,
+                recv_buf.data(),
+                &recv_counts[0],
+                &recv_offsets[0],
+                MPI_FLOAT,
+                mpi_comm);
+
+  DRAY_LOG_ENTRY("depth_bytes_sent", send_buf.size() * sizeof(float32));
+
+  for(int32 p = 0; p < size; ++p)
+  {
+    if(p == rank)
+    {
+      continue;
+    }
+    int32 p_begin, p_end;
+    region(p, p_begin, p_end);
+    const float32 *in_ptr = recv_buf.data() + recv_offsets[p];
+    detail::visit_overlap(p_begin, p_end, m_x_min, m_y_min, m_rect_width,
+                          m_image_width, my_box,
+                          [&](int32 pixel, int32, int32 count)
+    {
+      memcpy(depth_ptr + pixel, in_ptr, count * sizeof(float32));
+      in_ptr += count;
+    });
+  }
+
+  // everyone now needs to update the rays max depth to the updated
+  // depth values, but only inside the area we care about
+  const int32 ray_size = rays.size();
+  Ray *ray_ptr = rays.get_device_ptr();
+  const float32 *d_depth_ptr = framebuffer.depths().get_device_ptr_const();
+  const int32 image_width = m_image_width;
+  const int32 box_x_min = my_box[0];
+  const int32 box_y_min = my_box[1];
+  const int32 box_x_max = my_box[2];
+  const int32 box_y_max = my_box[3];
+
+  RAJA::forall<for_policy>(RAJA::RangeSegment(0, ray_size), [=] DRAY_LAMBDA (int32 i)
+  {
+    const int32 pixel = ray_ptr[i].m_pixel_id;
+    const int32 x = pixel % image_width;
+    const int32 y = pixel / image_width;
+    if(x >= box_x_min && x < box_x_max && y >= box_y_min && y < box_y_max)
+    {
+      ray_ptr[i].m_far = d_depth_ptr[pixel];
+    }
+  });
+  DRAY_ERROR_CHECK();
+
+  DRAY_LOG_ENTRY("time", timer.elapsed());
+  DRAY_LOG_CLOSE();
+#endif
+}
+
+} // namespace dray
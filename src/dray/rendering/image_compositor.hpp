@@ -0,0 +1,66 @@
+// Copyright 2019 Lawrence Livermore National Security, LLC and other
+// Devil Ray Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (BSD-3-Clause)
+
+#ifndef DRAY_IMAGE_COMPOSITOR_HPP
+#define DRAY_IMAGE_COMPOSITOR_HPP
+
+#include <dray/aabb.hpp>
+#include <dray/array.hpp>
+#include <dray/ray.hpp>
+#include <dray/rendering/framebuffer.hpp>
+
+#include <vector>
+
+namespace dray
+{
+/**
+ * \class ImageCompositor
+ * \brief Sort-last z-buffer compositing of surface images
+ *
+ * Composites the pixels inside a screen space rectangle using radix-k
+ * scheduling (binary swap when all radices are 2). After compositing,
+ * every rank owns a contiguous stripe of the rectangle. Rank 0 receives
+ * the final image, and depths can be pushed back to the ranks that need
+ * them through a sparse all-to-all instead of a full image broadcast.
+ */
+class ImageCompositor
+{
+protected:
+  std::vector<int32> m_radices;
+  // the radices used for the last composite
+  std::vector<int32> m_schedule;
+  // active pixel rectangle of the last composite
+  int32 m_x_min;
+  int32 m_y_min;
+  int32 m_rect_width;
+  int32 m_rect_height;
+  int32 m_image_width;
+
+  void region(const int32 rank, int32 &begin, int32 &end) const;
+public:
+  ImageCompositor();
+
+  // radix for each round. Their product must equal the number
+  // of ranks. If empty (the default) the rank count is factored
+  // into rounds of 4 and 2 with any remaining prime factors
+  // composited by direct send.
+  void radices(const std::vector<int32> &k);
+
+  // z-buffer composite all pixels of the framebuffer inside rect.
+  // Pixels outside the rectangle are left untouched. Only rank 0
+  // holds the full composited result afterwards.
+  void composite(Framebuffer &framebuffer, const AABB<2> &rect);
+
+  // must be called after composite. Each rank sends the composited
+  // depths of its stripe to every rank whose interest rectangle
+  // overlaps it. The received depths are written into the framebuffer
+  // and clamp the m_far of all rays inside the interest rectangle.
+  void synch_depths(Framebuffer &framebuffer,
+                    const AABB<2> &interest,
+                    Array<Ray> &rays);
+};
+
+} // namespace dray
+#endif
@@ -0,0 +1,573 @@
+// Copyright 2019 Lawrence Livermore National Security, LLC and other
+// Devil Ray Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (BSD-3-Clause)
+
+#include <dray/rendering/partial_compositor.hpp>
+#include <dray/rendering/colors.hpp>
+#include <dray/rendering/pixel_format.hpp>
+#include <dray/utils/data_logger.hpp>
+#include <dray/array_utils.hpp>
+#include <dray/dray.hpp>
+#include <dray/error.hpp>
+#include <dray/error_check.hpp>
+#include <dray/policies.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+#ifdef DRAY_MPI_ENABLED
+#include <mpi.h>
+#endif
+
+namespace dray
+{
+
+namespace detail
+{
+
+// device side encoding of the partials of one domain
+struct EncodedPartials
+{
+  Array<VolumePartial> m_partials; // sorted by pixel id
+  Array<int32> m_runs;             // (first pixel id, length) pairs
+  Array<uint16> m_depths;
+  Array<uint16> m_half;
+  Array<uint8> m_rgba8;
+  int32 m_num_runs;
+};
+
+Array<VolumePartial> sort_by_pixel(Array<VolumePartial> &partials)
+{
+  const int32 size = partials.size();
+  if(size < 2)
+  {
+    return partials;
+  }
+
+  const VolumePartial *partial_ptr = partials.get_device_ptr_const();
+  RAJA::ReduceSum<reduce_policy, int32> unsorted(0);
+  RAJA::forall<for_policy>(RAJA::RangeSegment(1, size), [=] DRAY_LAMBDA (int32 i)
+  {
+    if(partial_ptr[i].m_pixel_id < partial_ptr[i-1].m_pixel_id)
+    {
+      unsorted += 1;
+    }
+  });
+  DRAY_ERROR_CHECK();
+
+  if(unsorted.get() == 0)
+  {
+    return partials;
+  }
+
+  // rays are generated in pixel order, so this should be rare
+  Array<VolumePartial> sorted = partials.copy();
+  VolumePartial *sorted_ptr = sorted.get_host_ptr();
+  std::stable_sort(sorted_ptr, sorted_ptr + size,
+                   [](const VolumePartial &a, const VolumePartial &b)
+                   {
+                     return a.m_pixel_id < b.m_pixel_id;
+                   });
+  return sorted;
+}
+
+void encode(Array<VolumePartial> &input,
+            const int32 stripe,
+            const float32 depth_min,
+            const float32 depth_scale,
+            const PartialCompositor::WireFormat format,
+            EncodedPartials &output)
+{
+  output.m_partials = sort_by_pixel(input);
+  const int32 size = output.m_partials.size();
+  const VolumePartial *partial_ptr = output.m_partials.get_device_ptr_const();
+
+  // a run is a sequence of consecutive pixel ids going to the same rank
+  Array<int32> run_flags;
+  run_flags.resize(size);
+  int32 *flags_ptr = run_flags.get_device_ptr();
+  RAJA::forall<for_policy>(RAJA::RangeSegment(0, size), [=] DRAY_LAMBDA (int32 i)
+  {
+    int32 flag = 1;
+    if(i > 0)
+    {
+      const int32 pixel = partial_ptr[i].m_pixel_id;
+      const int32 prev = partial_ptr[i-1].m_pixel_id;
+      flag = (pixel != prev + 1 || pixel / stripe != prev / stripe) ? 1 : 0;
+    }
+    flags_ptr[i] = flag;
+  });
+  DRAY_ERROR_CHECK();
+
+  Array<int32> run_starts = index_flags(run_flags);
+  const int32 num_runs = run_starts.size();
+  output.m_num_runs = num_runs;
+  output.m_runs.resize(num_runs * 2);
+  const int32 *starts_ptr = run_starts.get_device_ptr_const();
+  int32 *runs_ptr = output.m_runs.get_device_ptr();
+
+  RAJA::forall<for_policy>(RAJA::RangeSegment(0, num_runs), [=] DRAY_LAMBDA (int32 r)
+  {
+    const int32 first = starts_ptr[r];
+    const int32 last = (r == num_runs - 1) ? size : starts_ptr[r + 1];
+    runs_ptr[2 * r + 0] = partial_ptr[first].m_pixel_id;
+    runs_ptr[2 * r + 1] = last - first;
+  });
+  DRAY_ERROR_CHECK();
+
+  if(format == PartialCompositor::Raw)
+  {
+    return;
+  }
+
+  output.m_depths.resize(size);
+  uint16 *depths_ptr = output.m_depths.get_device_ptr();
+  RAJA::forall<for_policy>(RAJA::RangeSegment(0, size), [=] DRAY_LAMBDA (int32 i)
+  {
+    float32 q = (partial_ptr[i].m_depth - depth_min) * depth_scale;
+    q = fminf(fmaxf(q, 0.f), 65535.f);
+    depths_ptr[i] = uint16(q + 0.5f);
+  });
+  DRAY_ERROR_CHECK();
+
+  if(format == PartialCompositor::Half)
+  {
+    output.m_half.resize(size * 4);
+    uint16 *half_ptr = output.m_half.get_device_ptr();
+    RAJA::forall<for_policy>(RAJA::RangeSegment(0, size), [=] DRAY_LAMBDA (int32 i)
+    {
+      const Vec<float32,4> color = partial_ptr[i].m_color;
+      for(int32 c = 0; c < 4; ++c)
+      {
+        half_ptr[4 * i + c] = float_to_half(color[c]);
+      }
+    });
+    DRAY_ERROR_CHECK();
+  }
+  else
+  {
+    output.m_rgba8.resize(size * 4);
+    uint8 *rgba_ptr = output.m_rgba8.get_device_ptr();
+    RAJA::forall<for_policy>(RAJA::RangeSegment(0, size), [=] DRAY_LAMBDA (int32 i)
+    {
+      const Vec<float32,4> color = partial_ptr[i].m_color;
+      for(int32 c = 0; c < 4; ++c)
+      {
+        const float32 value = fminf(fmaxf(color[c], 0.f), 1.f);
+        rgba_ptr[4 * i + c] = uint8(value * 255.f + 0.5f);
+      }
+    });
+    DRAY_ERROR_CHECK();
+  }
+}
+
+inline void append_bytes(std::vector<uint8> &buffer, const void *data, const size_t bytes)
+{
+  const uint8 *byte_ptr = reinterpret_cast<const uint8*>(data);
+  buffer.insert(buffer.end(), byte_ptr, byte_ptr + bytes);
+}
+
+// split the encoded domain into one chunk per destination rank. Only
+// the arrays the format needs are brought back to the host.
+void append_chunks(EncodedPartials &encoded,
+                   const int32 stripe,
+                   const PartialCompositor::WireFormat format,
+                   std::vector<std::vector<uint8>> &buffers,
+                   std::vector<size_t> &partial_counts)
+{
+  const int32 num_runs = encoded.m_num_runs;
+  if(num_runs == 0)
+  {
+    return;
+  }
+
+  const int32 *runs_ptr = encoded.m_runs.get_host_ptr_const();
+  const VolumePartial *partial_ptr = nullptr;
+  const uint16 *depths_ptr = nullptr;
+  const uint8 *color_ptr = nullptr;
+  size_t color_bytes = 0;
+
+  if(format == PartialCompositor::Raw)
+  {
+    partial_ptr = encoded.m_partials.get_host_ptr_const();
+  }
+  else
+  {
+    depths_ptr = encoded.m_depths.get_host_ptr_const();
+    if(format == PartialCompositor::Half)
+    {
+      color_ptr = reinterpret_cast<const uint8*>(encoded.m_half.get_host_ptr_const());
+      color_bytes = 4 * sizeof(uint16);
+    }
+    else
+    {
+      color_ptr = encoded.m_rgba8.get_host_ptr_const();
+      color_bytes = 4 * sizeof(uint8);
+    }
+  }
+
+  int32 run = 0;
+  int32 partial_offset = 0;
+  while(run < num_runs)
+  {
+    const int32 dest = runs_ptr[2 * run] / stripe;
+    int32 run_end = run;
+    int32 count = 0;
+    while(run_end < num_runs && runs_ptr[2 * run_end] / stripe == dest)
+    {
+      count += runs_ptr[2 * run_end + 1];
+      run_end++;
+    }
+    const int32 chunk_runs = run_end - run;
+
+    std::vector<uint8> &buffer = buffers[dest];
+    if(format == PartialCompositor::Raw)
+    {
+      append_bytes(buffer, &count, sizeof(int32));
+      append_bytes(buffer, partial_ptr + partial_offset, count * sizeof(VolumePartial));
+    }
+    else
+    {
+      append_bytes(buffer, &chunk_runs, sizeof(int32));
+      append_bytes(buffer, &count, sizeof(int32));
+      append_bytes(buffer, runs_ptr + 2 * run, chunk_runs * 2 * sizeof(int32));
+      append_bytes(buffer, depths_ptr + partial_offset, count * sizeof(uint16));
+      append_bytes(buffer, color_ptr + partial_offset * color_bytes, count * color_bytes);
+    }
+    partial_counts[dest] += count;
+
+    partial_offset += count;
+    run = run_end;
+  }
+}
+
+void decode(const uint8 *buffer,
+            const size_t bytes,
+            const PartialCompositor::WireFormat format,
+            const float32 depth_min,
+            const float32 inv_depth_scale,
+            std::vector<VolumePartial> &output)
+{
+  size_t pos = 0;
+  while(pos < bytes)
+  {
+    if(format == PartialCompositor::Raw)
+    {
+      int32 count;
+      memcpy(&count, buffer + pos, sizeof(int32));
+      pos += sizeof(int32);
+      const size_t offset = output.size();
+      output.resize(offset + count);
+      memcpy(&output[offset], buffer + pos, count * sizeof(VolumePartial));
+      pos += count * sizeof(VolumePartial);
+      continue;
+    }
+
+    int32 num_runs, count;
+    memcpy(&num_runs, buffer + pos, sizeof(int32));
+    pos += sizeof(int32);
+    memcpy(&count, buffer + pos, sizeof(int32));
+    pos += sizeof(int32);
+
+    const uint8 *runs_bytes = buffer + pos;
+    pos += num_runs * 2 * sizeof(int32);
+    const uint8 *depth_bytes = buffer + pos;
+    pos += count * sizeof(uint16);
+    const uint8 *color_bytes = buffer + pos;
+    const size_t pixel_color_bytes = format == PartialCompositor::Half ? 8 : 4;
+    pos += count * pixel_color_bytes;
+
+    const size_t offset = output.size();
+    output.resize(offset + count);
+
+    int32 index = 0;
+    for(int32 r = 0; r < num_runs; ++r)
+    {
+      int32 run[2];
+      memcpy(run, runs_bytes + r * 2 * sizeof(int32), 2 * sizeof(int32));
+      for(int32 j = 0; j < run[1]; ++j, ++index)
+      {
+        VolumePartial &partial = output[offset + index];
+        partial.m_pixel_id = run[0] + j;
+
+        uint16 depth;
+        memcpy(&depth, depth_bytes + index * sizeof(uint16), sizeof(uint16));
+        partial.m_depth = depth_min + float32(depth) * inv_depth_scale;
+
+        const uint8 *color = color_bytes + index * pixel_color_bytes;
+        if(format == PartialCompositor::Half)
+        {
+          uint16 half[4];
+          memcpy(half, color, 4 * sizeof(uint16));
+          for(int32 c = 0; c < 4; ++c)
+          {
+            partial.m_color[c] = half_to_float(half[c]);
+          }
+        }
+        else
+        {
+          for(int32 c = 0; c < 4; ++c)
+          {
+            partial.m_color[c] = float32(color[c]) / 255.f;
+          }
+        }
+      }
+    }
+  }
+}
+
+// sort by pixel and depth, then blend front to back. Quantized depths
+// can tie, so the sort is stable: ties keep the order of arrival, which
+// is by source rank and then by the sender's order, and every run and
+// rank count blends them the same way.
+void blend_partials(std::vector<VolumePartial> &partials,
+                    std::vector<VolumePartial> &result)
+{
+  std::stable_sort(partials.begin(), partials.end(),
+            [](const VolumePartial &a, const VolumePartial &b)
+            {
+              if(a.m_pixel_id == b.m_pixel_id)
+              {
+                return a.m_depth < b.m_depth;
+              }
+              return a.m_pixel_id < b.m_pixel_id;
+            });
+
+  result.clear();
+  const size_t size = partials.size();
+  size_t i = 0;
+  while(i < size)
+  {
+    VolumePartial res = partials[i];
+    size_t j = i + 1;
+    while(j < size && partials[j].m_pixel_id == res.m_pixel_id)
+    {
+      if(res.m_color[3] < 1.f)
+      {
+        pre_mult_alpha_blend_host(res.m_color, partials[j].m_color);
+      }
+      ++j;
+    }
+    result.push_back(res);
+    i = j;
+  }
+}
+
+} // namespace detail
+
+PartialCompositor::PartialCompositor()
+  : m_format(Raw),
+    m_bytes_sent(0),
+    m_raw_bytes(0)
+{
+}
+
+void PartialCompositor::wire_format(WireFormat format)
+{
+  m_format = format;
+}
+
+PartialCompositor::WireFormat PartialCompositor::wire_format() const
+{
+  return m_format;
+}
+
+size_t PartialCompositor::bytes_sent() const
+{
+  return m_bytes_sent;
+}
+
+size_t PartialCompositor::raw_bytes() const
+{
+  return m_raw_bytes;
+}
+
+void PartialCompositor::composite(std::vector<Array<VolumePartial>> &partials,
+                                  const int32 num_pixels,
+                                  Array<VolumePartial> &result)
+{
+  DRAY_LOG_OPEN("partial_composite");
+  Timer timer;
+  m_bytes_sent = 0;
+  m_raw_bytes = 0;
+
+  const int32 num_domains = partials.size();
+  int32 rank = 0;
+  int32 size = 1;
+#ifdef DRAY_MPI_ENABLED
+  rank = dray::mpi_rank();
+  size = dray::mpi_size();
+#endif
+
+  std::vector<VolumePartial> merged;
+
+  if(size == 1)
+  {
+    for(int32 d = 0; d < num_domains; ++d)
+    {
+      const VolumePartial *partial_ptr = partials[d].get_host_ptr_const();
+      merged.insert(merged.end(), partial_ptr, partial_ptr + partials[d].size());
+    }
+  }
+#ifdef DRAY_MPI_ENABLED
+  else
+  {
+    MPI_Comm mpi_comm = MPI_Comm_f2c(dray::mpi_comm());
+
+    // global depth range for quantization. store -max so one
+    // reduction gives us both
+    float32 local_range[2] = {infinity32(), infinity32()};
+    for(int32 d = 0; d < num_domains; ++d)
+    {
+      const int32 psize = partials[d].size();
+      const VolumePartial *partial_ptr = partials[d].get_device_ptr_const();
+      RAJA::ReduceMin<reduce_policy, float32> dmin(infinity32());
+      RAJA::ReduceMax<reduce_policy, float32> dmax(neg_infinity32());
+      RAJA::forall<for_policy>(RAJA::RangeSegment(0, psize), [=] DRAY_LAMBDA (int32 i)
+      {
+        dmin.min(partial_ptr[i].m_depth);
+        dmax.max(partial_ptr[i].m_depth);
+      });
+      DRAY_ERROR_CHECK();
+      local_range[0] = std::min(local_range[0], dmin.get());
+      local_range[1] = std::min(local_range[1], -dmax.get());
+    }
+    float32 global_range[2];
+    MPI_Allreduce(local_range, global_range, 2, MPI_FLOAT, MPI_MIN, mpi_comm);
+    const float32 depth_min = global_range[0];
+    const float32 depth_max = -global_range[1];
+    const float32 depth_scale = depth_max > depth_min
+                                ? 65535.f / (depth_max - depth_min) : 0.f;
+    const float32 inv_depth_scale = depth_scale > 0.f ? 1.f / depth_scale : 0.f;
+
+    // each rank owns a stripe of pixel ids
+    const int32 stripe = std::max((num_pixels + size - 1) / size, 1);
+
+    std::vector<std::vector<uint8>> buffers(size);
+    std::vector<size_t> partial_counts(size, 0);
+    for(int32 d = 0; d < num_domains; ++d)
+    {
+      detail::EncodedPartials encoded;
+      detail::encode(partials[d], stripe, depth_min, depth_scale, m_format, encoded);
+      detail::append_chunks(encoded, stripe, m_format, buffers, partial_counts);
+    }
+    DRAY_LOG_ENTRY("encode", timer.elapsed());
+    timer.reset();
+
+    std::vector<int32> send_counts(size);
+    std::vector<int32> send_offsets(size);
+    std::vector<uint8> send_data;
+    for(int32 q = 0; q < size; ++q)
+    {
+      send_offsets[q] = send_data.size();
+      send_counts[q] = buffers[q].size();
+      send_data.insert(send_data.end(), buffers[q].begin(), buffers[q].end());
+      if(q != rank)
+      {
+        m_bytes_sent += buffers[q].size();
+        m_raw_bytes += partial_counts[q] * sizeof(VolumePartial);
+      }
+      // free the per rank staging as we go
+      std::vector<uint8>().swap(buffers[q]);
+    }
+
+    std::vector<int32> recv_counts(size);
+    MPI_Alltoall(&send_counts[0], 1, MPI_INT, &recv_counts[0], 1, MPI_INT, mpi_comm);
+
+    std::vector<int32> recv_offsets(size);
+    int32 recv_total = 0;
+    for(int32 p = 0; p < size; ++p)
+    {
+      recv_offsets[p] = recv_total;
+      recv_total += recv_counts[p];
+    }
+    std::vector<uint8> recv_data(recv_total);
+
+    MPI_Alltoallv(send_data.data(),
+                  &send_counts[0],
+                  &send_offsets[0],
+                  MPI_BYTE,
+                  recv_data.data(),
+                  &recv_counts[0],
+                  &recv_offsets[0],
+                  MPI_BYTE,
+                  mpi_comm);
+    DRAY_LOG_ENTRY("exchange", timer.elapsed());
+    timer.reset();
+
+    for(int32 p = 0; p < size; ++p)
+    {
+      detail::decode(recv_data.data() + recv_offsets[p],
+                     recv_counts[p],
+                     m_format,
+                     depth_min,
+                     inv_depth_scale,
+                     merged);
+    }
+    DRAY_LOG_ENTRY("decode", timer.elapsed());
+    timer.reset();
+  }
+#endif
+
+  std::vector<VolumePartial> blended;
+  detail::blend_partials(merged, blended);
+  DRAY_LOG_ENTRY("blend", timer.elapsed());
+  timer.reset();
+
+  if(size == 1)
+  {
+    result.set(blended.data(), blended.size());
+  }
+#ifdef DRAY_MPI_ENABLED
+  else
+  {
+    // every pixel now has a single partial, so gather those on rank 0
+    MPI_Comm mpi_comm = MPI_Comm_f2c(dray::mpi_comm());
+    const int32 local_bytes = blended.size() * sizeof(VolumePartial);
+    std::vector<int32> counts;
+    std::vector<int32> offsets;
+    std::vector<VolumePartial> gathered;
+    if(rank == 0)
+    {
+      counts.resize(size);
+    }
+    MPI_Gather(&local_bytes, 1, MPI_INT,
+               rank == 0 ? &counts[0] : nullptr, 1, MPI_INT,
+               0, mpi_comm);
+    if(rank == 0)
+    {
+      offsets.resize(size);
+      int32 total = 0;
+      for(int32 p = 0; p < size; ++p)
+      {
+        offsets[p] = total;
+        total += counts[p];
+      }
+      gathered.resize(total / sizeof(VolumePartial));
+    }
+    MPI_Gatherv(blended.data(),
+                local_bytes,
+                MPI_BYTE,
+                rank == 0 ? gathered.data() : nullptr,
+                rank == 0 ? &counts[0] : nullptr,
+                rank == 0 ? &offsets[0] : nullptr,
+                MPI_BYTE,
+                0,
+                mpi_comm);
+    if(rank != 0)
+    {
+      m_bytes_sent += local_bytes;
+      m_raw_bytes += local_bytes;
+    }
+    result.set(gathered.data(), gathered.size());
+    DRAY_LOG_ENTRY("gather", timer.elapsed());
+  }
+#endif
+
+  DRAY_LOG_ENTRY("bytes_sent", m_bytes_sent);
+  DRAY_LOG_ENTRY("raw_bytes", m_raw_bytes);
+  DRAY_LOG_CLOSE();
+}
+
+} // namespace dray
@@ -0,0 +1,61 @@
+// Copyright 2019 Lawrence Livermore National Security, LLC and other
+// Devil Ray Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (BSD-3-Clause)
+
+#ifndef DRAY_PARTIAL_COMPOSITOR_HPP
+#define DRAY_PARTIAL_COMPOSITOR_HPP
+
+#include <dray/array.hpp>
+#include <dray/rendering/volume_partial.hpp>
+
+#include <vector>
+
+namespace dray
+{
+/**
+ * \class PartialCompositor
+ * \brief Sort-last compositing of volume partials
+ *
+ * Each rank owns a stripe of pixel ids. Partials are encoded straight
+ * from the device arrays, sent to the owning rank with a single
+ * all-to-all, sorted and blended front to back, and the per pixel
+ * results are gathered on rank 0.
+ *
+ * The compressed wire formats store depth quantized to 16 bits over the
+ * global depth range, color as half floats or RGBA8, and pixel ids as
+ * runs of consecutive ids.
+ */
+class PartialCompositor
+{
+public:
+  enum WireFormat
+  {
+    Raw,   // full VolumePartial structs (24 bytes)
+    Half,  // 16-bit depth + RGBA16F (10 bytes + runs)
+    RGBA8  // 16-bit depth + RGBA8 (6 bytes + runs)
+  };
+protected:
+  WireFormat m_format;
+  size_t m_bytes_sent;
+  size_t m_raw_bytes;
+public:
+  PartialCompositor();
+
+  void wire_format(WireFormat format);
+  WireFormat wire_format() const;
+
+  // composite the partials of all local domains. The result contains
+  // at most one partial per pixel and is only valid on rank 0.
+  void composite(std::vector<Array<VolumePartial>> &partials,
+                 const int32 num_pixels,
+                 Array<VolumePartial> &result);
+
+  // bytes this rank put on the wire during the last composite
+  size_t bytes_sent() const;
+  // bytes the same exchange would have needed with the raw format
+  size_t raw_bytes() const;
+};
+
+} // namespace dray
+#endif
@@ -0,0 +1,244 @@
+// Copyright 2019 Lawrence Livermore National Security, LLC and other
+// Devil Ray Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (BSD-3-Clause)
+
+#ifndef DRAY_PIXEL_FORMAT_HPP
+#define DRAY_PIXEL_FORMAT_HPP
+
+#include <dray/exports.hpp>
+#include <dray/types.hpp>
+#include <dray/vec.hpp>
+
+#include <cstring>
+
+namespace dray
+{
+
+// wire format of framebuffer pixels during image compositing. The
+// framebuffer itself always stores float colors and depths; the
+// compact formats only shrink what is sent between ranks and round
+// the image to that precision. They keep the top 24 bits of the float
+// depth, which preserves the ordering of the (positive) hit distances,
+// so z-compositing needs no depth range.
+enum PixelFormat
+{
+  RGBA32F, // float colors, float depth: 20 bytes
+  RGBA16F, // half colors, 24 bit depth: 11 bytes
+  RGBA8    // byte colors, 24 bit depth: 7 bytes
+};
+
+namespace detail
+{
+
+DRAY_EXEC uint32 float_bits(const float32 value)
+{
+  uint32 bits;
+  memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+DRAY_EXEC float32 bits_float(const uint32 bits)
+{
+  float32 value;
+  memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+// value >> shift rounded to nearest, ties to even
+DRAY_EXEC uint32 round_shift(const uint32 value, const int32 shift)
+{
+  const uint32 result = value >> shift;
+  const uint32 rest = value & ((1u << shift) - 1u);
+  const uint32 halfway = 1u << (shift - 1);
+  if(rest > halfway || (rest == halfway && (result & 1u)))
+  {
+    return result + 1u;
+  }
+  return result;
+}
+
+DRAY_EXEC uint16 float_to_half(const float32 value)
+{
+  const uint32 bits = float_bits(value);
+  const uint32 sign = (bits >> 16) & 0x8000u;
+  const uint32 float_exp = (bits >> 23) & 0xffu;
+  const uint32 mantissa = bits & 0x7fffffu;
+
+  if(float_exp == 0xffu)
+  {
+    // inf or nan
+    return uint16(sign | 0x7c00u | (mantissa != 0 ? 0x200u : 0u));
+  }
+
+  const int32 exp = int32(float_exp) - 127 + 15;
+  if(exp >= 31)
+  {
+    return uint16(sign | 0x7c00u);
+  }
+  if(exp <= 0)
+  {
+    // subnormal half or zero. Anything at or below half of the
+    // smallest subnormal rounds to zero.
+    if(exp < -10)
+    {
+      return uint16(sign);
+    }
+    // a carry out of the mantissa gives the smallest normal
+    return uint16(sign | round_shift(mantissa | 0x800000u, 14 - exp));
+  }
+
+  // a carry out of the mantissa bumps the exponent, up to inf
+  return uint16(sign | ((uint32(exp) << 10) + round_shift(mantissa, 13)));
+}
+
+DRAY_EXEC float32 half_to_float(const uint16 value)
+{
+  const uint32 sign = (uint32(value) & 0x8000u) << 16;
+  int32 exp = (value >> 10) & 0x1f;
+  uint32 mantissa = value & 0x3ffu;
+
+  if(exp == 0)
+  {
+    if(mantissa == 0)
+    {
+      return bits_float(sign);
+    }
+    // normalize the subnormal
+    exp = 1;
+    while((mantissa & 0x400u) == 0)
+    {
+      mantissa <<= 1;
+      exp--;
+    }
+    mantissa &= 0x3ffu;
+    return bits_float(sign | (uint32(exp + 127 - 15) << 23) | (mantissa << 13));
+  }
+  if(exp == 31)
+  {
+    return bits_float(sign | 0x7f800000u | (mantissa << 13));
+  }
+  return bits_float(sign | (uint32(exp + 127 - 15) << 23) | (mantissa << 13));
+}
+
+DRAY_EXEC uint8 float_to_unorm8(const float32 value)
+{
+  const float32 clamped = value < 0.f ? 0.f : (value > 1.f ? 1.f : value);
+  return uint8(clamped * 255.f + 0.5f);
+}
+
+// bytes of one pixel, color and depth
+DRAY_EXEC int32 pixel_bytes(const PixelFormat format)
+{
+  return format == RGBA8 ? 7 : (format == RGBA16F ? 11 : 20);
+}
+
+DRAY_EXEC void pack_pixel(const PixelFormat format,
+                          const Vec<float32,4> &color,
+                          const float32 depth,
+                          uint8 *out)
+{
+  if(format == RGBA32F)
+  {
+    for(int32 c = 0; c < 4; ++c)
+    {
+      const uint32 bits = float_bits(color[c]);
+      out[c * 4 + 0] = uint8(bits);
+      out[c * 4 + 1] = uint8(bits >> 8);
+      out[c * 4 + 2] = uint8(bits >> 16);
+      out[c * 4 + 3] = uint8(bits >> 24);
+    }
+    const uint32 bits = float_bits(depth);
+    out[16] = uint8(bits);
+    out[17] = uint8(bits >> 8);
+    out[18] = uint8(bits >> 16);
+    out[19] = uint8(bits >> 24);
+    return;
+  }
+
+  int32 offset = 0;
+  if(format == RGBA16F)
+  {
+    for(int32 c = 0; c < 4; ++c)
+    {
+      const uint16 half = float_to_half(color[c]);
+      out[offset++] = uint8(half);
+      out[offset++] = uint8(half >> 8);
+    }
+  }
+  else
+  {
+    for(int32 c = 0; c < 4; ++c)
+    {
+      out[offset++] = float_to_unorm8(color[c]);
+    }
+  }
+
+  // drop the low 8 mantissa bits
+  const uint32 bits = float_bits(depth);
+  out[offset++] = uint8(bits >> 8);
+  out[offset++] = uint8(bits >> 16);
+  out[offset++] = uint8(bits >> 24);
+}
+
+DRAY_EXEC void unpack_pixel(const PixelFormat format,
+                            const uint8 *in,
+                            Vec<float32,4> &color,
+                            float32 &depth)
+{
+  if(format == RGBA32F)
+  {
+    for(int32 c = 0; c < 4; ++c)
+    {
+      color[c] = bits_float(uint32(in[c * 4 + 0]) |
+                            (uint32(in[c * 4 + 1]) << 8) |
+                            (uint32(in[c * 4 + 2]) << 16) |
+                            (uint32(in[c * 4 + 3]) << 24));
+    }
+    depth = bits_float(uint32(in[16]) |
+                       (uint32(in[17]) << 8) |
+                       (uint32(in[18]) << 16) |
+                       (uint32(in[19]) << 24));
+    return;
+  }
+
+  int32 offset = 0;
+  if(format == RGBA16F)
+  {
+    for(int32 c = 0; c < 4; ++c)
+    {
+      const uint16 half = uint16(in[offset] | (in[offset + 1] << 8));
+      color[c] = half_to_float(half);
+      offset += 2;
+    }
+  }
+  else
+  {
+    for(int32 c = 0; c < 4; ++c)
+    {
+      color[c] = float32(in[offset++]) / 255.f;
+    }
+  }
+
+  depth = bits_float((uint32(in[offset]) << 8) |
+                     (uint32(in[offset + 1]) << 16) |
+                     (uint32(in[offset + 2]) << 24));
+}
+
+// round a pixel to the precision of the format
+DRAY_EXEC void quantize_pixel(const PixelFormat format,
+                              Vec<float32,4> &color,
+                              float32 &depth)
+{
+  if(format == RGBA32F)
+  {
+    return;
+  }
+  uint8 packed[20];
+  pack_pixel(format, color, depth, packed);
+  unpack_pixel(format, packed, color, depth);
+}
+
+} // namespace detail
+} // namespace dray
+#endif
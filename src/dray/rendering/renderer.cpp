@@ -6,22 +6,32 @@
 #include <dray/rendering/renderer.hpp>
 #include <dray/rendering/volume.hpp>
 #include <dray/rendering/annotator.hpp>
+#include <dray/rendering/image_compositor.hpp>
 #include <dray/utils/data_logger.hpp>
+#include <dray/utils/timer.hpp>
+#include <dray/array_registry.hpp>
+#include <dray/array_utils.hpp>
 #include <dray/dray.hpp>
 #include <dray/error.hpp>
 #include <dray/error_check.hpp>
+#include <dray/math.hpp>
 #include <dray/policies.hpp>
 
-#include <apcomp/compositor.hpp>
-#include <apcomp/partial_compositor.hpp>
-
+#include <exception>
 #include <memory>
+#include <string>
 #include <vector>
 
 #ifdef DRAY_MPI_ENABLED
 #include <mpi.h>
 #endif
 
+// concurrent domain traversal is only done for threaded host builds
+#if defined(DRAY_OPENMP_ENABLED) && !defined(DRAY_CUDA_ENABLED) && !defined(DRAY_HIP_ENABLED)
+#define DRAY_CONCURRENT_DOMAINS
+#include <omp.h>
+#endif
+
 namespace dray
 {
 
@@ -52,89 +62,216 @@ bool someone_agrees(bool vote)
   return agreement;
 }
 
-void convert_partials(std::vector<Array<VolumePartial>> &input,
-                      std::vector<std::vector<apcomp::VolumePartial<float>>> &output)
+void
+partials_to_framebuffer(Array<VolumePartial> &input,
+                        Framebuffer &fb,
+                        bool blend)
 {
-  size_t total_size = 0;
-  const int in_size = input.size();
-  std::vector<size_t> offsets;
-  offsets.resize(in_size);
-  output.resize(1);
+  const int32 size = input.size();
+  const VolumePartial *partial_ptr = input.get_device_ptr_const();
+  Vec<float32,4> *colors = fb.colors().get_device_ptr();
+  float32 *depths = fb.depths().get_device_ptr();
 
-  for(size_t i = 0; i< in_size; ++i)
+  if(blend)
   {
-    offsets[i] = total_size;
-    total_size += input[i].size();
+    // framebuffer is the surface and is behind the volume
+    RAJA::forall<for_policy>(RAJA::RangeSegment(0, size), [=] DRAY_LAMBDA (int32 i)
+    {
+      const VolumePartial p = partial_ptr[i];
+      const int32 id = p.m_pixel_id;
+      const float32 opacity = 1.f - p.m_color[3];
+      colors[id][0] = p.m_color[0] + opacity * colors[id][0];
+      colors[id][1] = p.m_color[1] + opacity * colors[id][1];
+      colors[id][2] = p.m_color[2] + opacity * colors[id][2];
+      colors[id][3] = p.m_color[3] + opacity * colors[id][3];
+      depths[id] = p.m_depth;
+    });
   }
-
-  output[0].resize(total_size);
-
-  for(size_t a = 0; a < in_size; ++a)
+  else
   {
-    const VolumePartial *partial_ptr = input[a].get_host_ptr_const();
-    const size_t offset = offsets[a];
-    const size_t size = input[a].size();
-#ifdef ASCENT_USE_OPENMP
-    #pragma omp parallel for
-#endif
-    for(int i = 0; i < size; ++i)
+    RAJA::forall<for_policy>(RAJA::RangeSegment(0, size), [=] DRAY_LAMBDA (int32 i)
     {
-      const size_t index = offset + i;
       const VolumePartial p = partial_ptr[i];
-      output[0][index].m_pixel_id = p.m_pixel_id;
-      output[0][index].m_depth = p.m_depth;
+      const int32 id = p.m_pixel_id;
+      colors[id] = p.m_color;
+      depths[id] = p.m_depth;
+    });
+  }
+  DRAY_ERROR_CHECK();
+}
 
-      output[0][index].m_pixel[0] = p.m_color[0];
-      output[0][index].m_pixel[1] = p.m_color[1];
-      output[0][index].m_pixel[2] = p.m_color[2];
+// turns every hit that is not the closest hit of its ray over all
+// domains into a miss, so each pixel is only shaded by one domain
+void keep_nearest_hits(std::vector<Array<RayHit>> &domain_hits)
+{
+  const int32 domains = domain_hits.size();
+  const int32 size = domain_hits[0].size();
 
-      output[0][index].m_alpha = p.m_color[3];
-    }
+  Array<Float> nearest;
+  nearest.resize(size);
+  array_memset(nearest, infinity<Float>());
+  Array<int32> owners;
+  owners.resize(size);
+  array_memset(owners, -1);
+
+  Float *nearest_ptr = nearest.get_device_ptr();
+  int32 *owner_ptr = owners.get_device_ptr();
+
+  for(int32 d = 0; d < domains; ++d)
+  {
+    const RayHit *hit_ptr = domain_hits[d].get_device_ptr_const();
+    RAJA::forall<for_policy>(RAJA::RangeSegment(0, size), [=] DRAY_LAMBDA (int32 i)
+    {
+      const RayHit hit = hit_ptr[i];
+      if(hit.m_hit_idx != -1 && hit.m_dist < nearest_ptr[i])
+      {
+        nearest_ptr[i] = hit.m_dist;
+        owner_ptr[i] = d;
+      }
+    });
   }
 
+  for(int32 d = 0; d < domains; ++d)
+  {
+    RayHit *hit_ptr = domain_hits[d].get_device_ptr();
+    RAJA::forall<for_policy>(RAJA::RangeSegment(0, size), [=] DRAY_LAMBDA (int32 i)
+    {
+      if(owner_ptr[i] != d)
+      {
+        hit_ptr[i].m_hit_idx = -1;
+      }
+    });
+  }
+  DRAY_ERROR_CHECK();
 }
 
-void
-partials_to_framebuffer(const std::vector<apcomp::VolumePartial<float>> &input,
-                        Framebuffer &fb,
-                        bool blend)
+Array<Ray> concat_rays(const std::vector<Array<Ray>> &rays)
 {
-  const int32 size = input.size();
-  Vec<float32,4> *colors = fb.colors().get_host_ptr();
-  float32 *depths = fb.depths().get_host_ptr();
+  if(rays.size() == 1)
+  {
+    return rays[0];
+  }
 
-  if(blend)
+  int32 total = 0;
+  for(const Array<Ray> &part : rays)
   {
-    // framebuffer is the surface and is behind the volume
-#ifdef DRAY_OPENMP_ENABLED
-    #pragma omp parallel for
-#endif
-    for(int i = 0; i < size; ++i)
+    total += part.size();
+  }
+
+  Array<Ray> res;
+  res.resize(total);
+  Ray *res_ptr = res.get_device_ptr();
+  int32 offset = 0;
+  for(const Array<Ray> &part : rays)
+  {
+    const int32 size = part.size();
+    const Ray *part_ptr = part.get_device_ptr_const();
+    Ray *out_ptr = res_ptr + offset;
+    RAJA::forall<for_policy>(RAJA::RangeSegment(0, size), [=] DRAY_LAMBDA (int32 i)
     {
-      const int id = input[i].m_pixel_id;
-      float32 opacity = 1.f - input[i].m_alpha;
-      colors[id][0] = input[i].m_pixel[0] + opacity * colors[id][0];
-      colors[id][1] = input[i].m_pixel[1] + opacity * colors[id][1];
-      colors[id][2] = input[i].m_pixel[2] + opacity * colors[id][2];
-      colors[id][3] = input[i].m_alpha + opacity * colors[id][3];
-      depths[id] = input[i].m_depth;
-    }
+      out_ptr[i] = part_ptr[i];
+    });
+    offset += size;
   }
-  else
+  DRAY_ERROR_CHECK();
+  return res;
+}
+
+// copy one image out of a framebuffer holding several
+void copy_pixels(Framebuffer &input, const int32 offset, Framebuffer &output)
+{
+  const int32 size = output.width() * output.height();
+  const Vec<float32,4> *in_colors = input.colors().get_device_ptr_const() + offset;
+  const float32 *in_depths = input.depths().get_device_ptr_const() + offset;
+  Vec<float32,4> *out_colors = output.colors().get_device_ptr();
+  float32 *out_depths = output.depths().get_device_ptr();
+
+  RAJA::forall<for_policy>(RAJA::RangeSegment(0, size), [=] DRAY_LAMBDA (int32 i)
   {
-#ifdef DRAY_OPENMP_ENABLED
-    #pragma omp parallel for
-#endif
-    for(int i = 0; i < size; ++i)
+    out_colors[i] = in_colors[i];
+    out_depths[i] = in_depths[i];
+  });
+  DRAY_ERROR_CHECK();
+}
+
+// nearest neighbor upsampling of a coarse pass into the full image
+void upsample(Framebuffer &coarse,
+              const int32 width,
+              const int32 height,
+              Array<Vec<float32,4>> &colors,
+              Array<float32> &depths)
+{
+  const int32 size = width * height;
+  const int32 coarse_width = coarse.width();
+  const int32 coarse_height = coarse.height();
+  const int32 stride_x = (width + coarse_width - 1) / coarse_width;
+  const int32 stride_y = (height + coarse_height - 1) / coarse_height;
+  const int32 w = width;
+
+  const Vec<float32,4> *in_colors = coarse.colors().get_device_ptr_const();
+  const float32 *in_depths = coarse.depths().get_device_ptr_const();
+  Vec<float32,4> *out_colors = colors.get_device_ptr();
+  float32 *out_depths = depths.get_device_ptr();
+
+  RAJA::forall<for_policy>(RAJA::RangeSegment(0, size), [=] DRAY_LAMBDA (int32 i)
+  {
+    int32 x = (i % w) / stride_x;
+    int32 y = (i / w) / stride_y;
+    x = x < coarse_width ? x : coarse_width - 1;
+    y = y < coarse_height ? y : coarse_height - 1;
+    const int32 index = y * coarse_width + x;
+    out_colors[i] = in_colors[index];
+    out_depths[i] = in_depths[index];
+  });
+  DRAY_ERROR_CHECK();
+}
+
+// add a full resolution pass to the sum, or start the sum with it
+void accumulate(Framebuffer &pass,
+                Array<Vec<float32,4>> &colors,
+                Array<float32> &depths,
+                const bool replace)
+{
+  const int32 size = colors.size();
+  const Vec<float32,4> *in_colors = pass.colors().get_device_ptr_const();
+  const float32 *in_depths = pass.depths().get_device_ptr_const();
+  Vec<float32,4> *out_colors = colors.get_device_ptr();
+  float32 *out_depths = depths.get_device_ptr();
+
+  RAJA::forall<for_policy>(RAJA::RangeSegment(0, size), [=] DRAY_LAMBDA (int32 i)
+  {
+    if(replace)
     {
-      const int id = input[i].m_pixel_id;
-      colors[id][0] = input[i].m_pixel[0];
-      colors[id][1] = input[i].m_pixel[1];
-      colors[id][2] = input[i].m_pixel[2];
-      colors[id][3] = input[i].m_alpha;
-      depths[id] = input[i].m_depth;
+      out_colors[i] = in_colors[i];
+      out_depths[i] = in_depths[i];
     }
-  }
+    else
+    {
+      out_colors[i] += in_colors[i];
+    }
+  });
+  DRAY_ERROR_CHECK();
+}
+
+// the average of the accumulated passes
+void resolve(const Array<Vec<float32,4>> &colors,
+             const Array<float32> &depths,
+             const int32 samples,
+             Framebuffer &framebuffer)
+{
+  const int32 size = colors.size();
+  const float32 scale = 1.f / float32(samples);
+  const Vec<float32,4> *in_colors = colors.get_device_ptr_const();
+  const float32 *in_depths = depths.get_device_ptr_const();
+  Vec<float32,4> *out_colors = framebuffer.colors().get_device_ptr();
+  float32 *out_depths = framebuffer.depths().get_device_ptr();
+
+  RAJA::forall<for_policy>(RAJA::RangeSegment(0, size), [=] DRAY_LAMBDA (int32 i)
+  {
+    out_colors[i] = in_colors[i] * scale;
+    out_depths[i] = in_depths[i];
+  });
+  DRAY_ERROR_CHECK();
 }
 
 PointLight default_light(Camera &camera)
@@ -163,8 +300,15 @@ Renderer::Renderer()
   : m_volume(nullptr),
     m_use_lighting(true),
     m_screen_annotations(true),
-    m_max_color_bars(2)
+    m_max_color_bars(2),
+    m_concurrent_domains(false),
+    m_cull_domains(true),
+    m_jitter(false),
+    m_batch_size(8),
+    m_format(RGBA32F)
 {
+  m_progressive.m_max_samples = 8;
+  reset_progressive();
 }
 
 void Renderer::clear()
@@ -192,6 +336,26 @@ void Renderer::use_lighting(bool use_it)
   m_use_lighting = use_it;
 }
 
+void Renderer::concurrent_domains(bool on)
+{
+  m_concurrent_domains = on;
+}
+
+void Renderer::cull_domains(bool on)
+{
+  m_cull_domains = on;
+}
+
+std::vector<DomainView> Renderer::domain_views(Collection &collection,
+                                               Camera &camera) const
+{
+  if(m_cull_domains)
+  {
+    return visible_domains(collection, camera);
+  }
+  return all_domains(collection, camera.get_width(), camera.get_height());
+}
+
 void Renderer::add(std::shared_ptr<Traceable> traceable)
 {
   m_traceables.push_back(traceable);
@@ -206,15 +370,150 @@ void Renderer::volume(std::shared_ptr<Volume> volume)
 Framebuffer Renderer::render(Camera &camera)
 {
   DRAY_LOG_OPEN("render");
-  Array<Ray> rays;
-  camera.create_rays (rays);
+  Framebuffer framebuffer;
+  {
+    // closes after every transient of the frame is gone, and
+    // logs its pool statistics into this render
+    FrameArena frame_arena;
+    framebuffer = render_frame(camera);
+  }
+  DRAY_LOG_CLOSE();
+  return framebuffer;
+}
 
-  std::vector<std::string> field_names;
-  std::vector<ColorMap> color_maps;
+Framebuffer Renderer::render_frame(Camera &camera)
+{
+  Array<Ray> rays;
+  // every ray of a jittered image uses the same sample
+  const int32 sample = camera.get_sample();
+  if(m_jitter)
+  {
+    camera.create_rays_jitter (rays);
+    camera.set_sample (sample);
+  }
+  else
+  {
+    camera.create_rays (rays);
+  }
 
   Framebuffer framebuffer (camera.get_width(), camera.get_height());
+  framebuffer.format (m_format);
   framebuffer.clear ();
 
+  Array<PointLight> lights = make_lights(camera);
+
+  const int32 size = m_traceables.size();
+
+  bool need_composite = false;
+  for(int i = 0; i < size; ++i)
+  {
+    DRAY_LOG_OPEN("traceable");
+    std::vector<DomainView> views =
+      domain_views(m_traceables[i]->collection(), camera);
+    DRAY_LOG_ENTRY("culled_domains",
+                   m_traceables[i]->num_domains() - int32(views.size()));
+    if(m_concurrent_domains && views.size() > 1)
+    {
+      // the sequential path only clips its per domain rays, so pick up
+      // whatever earlier traceables have put into the framebuffer
+      clip_to_depths(rays, framebuffer);
+      trace_concurrent(*m_traceables[i], views, rays, lights, framebuffer);
+    }
+    else
+    {
+      for(const DomainView &view : views)
+      {
+        DRAY_LOG_OPEN("domain");
+        Timer timer;
+        // the framebuffer depths carry what earlier domains have hit
+        Array<Ray> domain_rays = view_rays(camera, view, framebuffer, m_jitter);
+        DRAY_LOG_ENTRY("rays", domain_rays.size());
+        if(domain_rays.size() == 0)
+        {
+          // off screen or hidden behind what was already traced
+          DRAY_LOG_CLOSE();
+          continue;
+        }
+        DRAY_LOG_ENTRY("ray_gen", timer.elapsed());
+        timer.reset();
+
+        m_traceables[i]->active_domain(view.m_domain);
+        Array<RayHit> hits = m_traceables[i]->nearest_hit(domain_rays);
+        DRAY_LOG_ENTRY("hits", timer.elapsed());
+        timer.reset();
+
+        shade(*m_traceables[i], domain_rays, hits, lights, framebuffer);
+        DRAY_LOG_ENTRY("shade", timer.elapsed());
+        DRAY_LOG_CLOSE();
+      }
+    }
+    DRAY_LOG_CLOSE();
+    // we just did some rendering so we need to composite
+    need_composite = true;
+  }
+
+  // the full image rays are only traced by the concurrent path, so
+  // bring them up to date for the volume
+  clip_to_depths(rays, framebuffer);
+
+  // we only need to synch depths if we are going to
+  // perform volume rendering
+  bool synch_depths = m_volume != nullptr;
+
+  // not all ranks might have data so we need to
+  // all agree to do things that might involve mpi
+  if(detail::someone_agrees(need_composite))
+  {
+    composite(rays, camera, framebuffer, synch_depths);
+  }
+
+  if(m_volume != nullptr)
+  {
+    Timer timer;
+    std::vector<DomainView> views =
+      domain_views(m_volume->collection(), camera);
+    std::vector<Array<VolumePartial>> domain_partials;
+    for(const DomainView &view : views)
+    {
+      Array<int32> ray_ids = rays_in_view(rays, view, camera.get_width());
+      if(ray_ids.size() == 0)
+      {
+        continue;
+      }
+      Array<Ray> domain_rays = gather(rays, ray_ids);
+      m_volume->active_domain(view.m_domain);
+      Array<VolumePartial> partials = m_volume->integrate(domain_rays, lights);
+      domain_partials.push_back(partials);
+    }
+    DRAY_LOG_ENTRY("volume_total",timer.elapsed());
+
+    Array<VolumePartial> result;
+    m_partial_compositor.composite(domain_partials,
+                                   camera.get_width() * camera.get_height(),
+                                   result);
+    if(dray::mpi_rank() == 0)
+    {
+      detail::partials_to_framebuffer(result,
+                                      framebuffer,
+                                      need_composite);
+    }
+  }
+
+  if(m_screen_annotations)
+  {
+    annotate(framebuffer);
+  }
+  framebuffer.quantize();
+  if(m_jitter)
+  {
+    camera.set_sample (sample + 1);
+  }
+
+  return framebuffer;
+}
+
+Array<PointLight> Renderer::make_lights(Camera &camera) const
+{
   Array<PointLight> lights;
   if(m_lights.size() > 0)
   {
@@ -232,155 +531,546 @@ Framebuffer Renderer::render(Camera &camera)
     PointLight* light_ptr = lights.get_host_ptr();
     light_ptr[0] = light;
   }
+  return lights;
+}
 
-  const int32 size = m_traceables.size();
+void Renderer::composite_format(const PixelFormat format)
+{
+  m_format = format;
+}
+
+PixelFormat Renderer::composite_format() const
+{
+  return m_format;
+}
+
+void Renderer::batch_size(const int32 size)
+{
+  if(size < 1)
+  {
+    DRAY_ERROR("Batch size must be at least one");
+  }
+  m_batch_size = size;
+}
+
+void Renderer::render_batch(std::vector<Camera> &cameras, BatchOutput output)
+{
+  DRAY_LOG_OPEN("render_batch");
+  const int32 num_cameras = cameras.size();
+  if(num_cameras == 0)
+  {
+    DRAY_LOG_CLOSE();
+    return;
+  }
+
+  const int32 width = cameras[0].get_width();
+  const int32 height = cameras[0].get_height();
+  for(int32 i = 1; i < num_cameras; ++i)
+  {
+    if(cameras[i].get_width() != width || cameras[i].get_height() != height)
+    {
+      DRAY_ERROR("All cameras of a batch must have the same image size");
+    }
+  }
+
+  // the default light follows the camera, so views can only share a
+  // launch when the lights are given
+  const int32 batch = m_lights.size() > 0 ? m_batch_size : 1;
+  DRAY_LOG_ENTRY("batch_size", batch);
+
+  Timer timer;
+  for(int32 begin = 0; begin < num_cameras; begin += batch)
+  {
+    const int32 end = std::min(num_cameras, begin + batch);
+    std::vector<Framebuffer> framebuffers = render_views(cameras, begin, end);
+    for(int32 i = begin; i < end; ++i)
+    {
+      output(i, framebuffers[i - begin]);
+    }
+  }
+  DRAY_LOG_ENTRY("images", num_cameras);
+  DRAY_LOG_ENTRY("time", timer.elapsed());
+  DRAY_LOG_CLOSE();
+}
+
+std::vector<Framebuffer> Renderer::render_views(std::vector<Camera> &cameras,
+                                                const int32 begin,
+                                                const int32 end)
+{
+  DRAY_LOG_OPEN("render_views");
+  std::vector<Framebuffer> res;
+  {
+    FrameArena frame_arena;
+    res = trace_views(cameras, begin, end);
+  }
+  DRAY_LOG_ENTRY("views", end - begin);
+  DRAY_LOG_CLOSE();
+  return res;
+}
+
+std::vector<Framebuffer> Renderer::trace_views(std::vector<Camera> &cameras,
+                                               const int32 begin,
+                                               const int32 end)
+{
+  const int32 num_views = end - begin;
+  const int32 width = cameras[begin].get_width();
+  const int32 height = cameras[begin].get_height();
+  const int32 image_size = width * height;
+
+  // the views are stacked on top of each other in one framebuffer and
+  // the pixel ids of each view are shifted to its slot
+  Framebuffer framebuffer (width, height * num_views);
+  framebuffer.format (m_format);
+  framebuffer.clear ();
+
+  Array<PointLight> lights = make_lights(cameras[begin]);
 
   bool need_composite = false;
-  for(int i = 0; i < size; ++i)
+  for(int32 i = 0; i < m_traceables.size(); ++i)
   {
-    const int domains = m_traceables[i]->num_domains();
-    for(int d = 0; d < domains; ++d)
+    Traceable &traceable = *m_traceables[i];
+    const int32 domains = traceable.num_domains();
+
+    // which view sees which domain
+    std::vector<std::vector<int32>> view_index(num_views);
+    std::vector<std::vector<DomainView>> views(num_views);
+    for(int32 v = 0; v < num_views; ++v)
     {
-      m_traceables[i]->active_domain(d);
-      Array<RayHit> hits = m_traceables[i]->nearest_hit(rays);
-      Array<Fragment> fragments = m_traceables[i]->fragments(hits);
-      if(m_use_lighting)
+      views[v] = domain_views(traceable.collection(), cameras[begin + v]);
+      view_index[v].resize(domains, -1);
+      for(int32 k = 0; k < views[v].size(); ++k)
       {
-        m_traceables[i]->shade(rays, hits, fragments, lights, framebuffer);
+        view_index[v][views[v][k].m_domain] = k;
       }
-      else
+    }
+
+    for(int32 d = 0; d < domains; ++d)
+    {
+      std::vector<Array<Ray>> view_rays_list;
+      for(int32 v = 0; v < num_views; ++v)
       {
-        m_traceables[i]->shade(rays, hits, fragments, framebuffer);
+        if(view_index[v][d] == -1)
+        {
+          continue;
+        }
+        view_rays_list.push_back(view_rays(cameras[begin + v],
+                                           views[v][view_index[v][d]],
+                                           framebuffer,
+                                           false,
+                                           v * image_size));
       }
-
-      ray_max(rays, hits);
+      // all views trace this domain in one launch
+      Array<Ray> domain_rays = detail::concat_rays(view_rays_list);
+      if(domain_rays.size() == 0)
+      {
+        continue;
+      }
+      traceable.active_domain(d);
+      Array<RayHit> hits = traceable.nearest_hit(domain_rays);
+      shade(traceable, domain_rays, hits, lights, framebuffer);
     }
-    // we just did some rendering so we need to composite
     need_composite = true;
-
-    // get stuff for annotations
-    field_names.push_back(m_traceables[i]->field());
-    color_maps.push_back(m_traceables[i]->color_map());
   }
 
-  // we only need to synch depths if we are going to
-  // perform volume rendering
   bool synch_depths = m_volume != nullptr;
-
-  // not all ranks might have data so we need to
-  // all agree to do things that might involve mpi
   if(detail::someone_agrees(need_composite))
   {
-    composite(rays, camera, framebuffer, synch_depths);
+#ifdef DRAY_MPI_ENABLED
+    AABB<2> rect;
+    rect.m_ranges[0].include(0.f);
+    rect.m_ranges[0].include(float32(width));
+    rect.m_ranges[1].include(0.f);
+    rect.m_ranges[1].include(float32(height * num_views));
+    ImageCompositor compositor;
+    compositor.composite(framebuffer, rect);
+    if(synch_depths)
+    {
+      // the rays are clipped against the synched depths below
+      Array<Ray> no_rays;
+      compositor.synch_depths(framebuffer, rect, no_rays);
+    }
+#endif
   }
 
+  // full image rays of every view for the volume
+  std::vector<Array<Ray>> all_rays(num_views);
   if(m_volume != nullptr)
   {
-    Timer timer;
-    const int domains = m_volume->num_domains();
+    for(int32 v = 0; v < num_views; ++v)
+    {
+      cameras[begin + v].create_rays(all_rays[v]);
+      offset_pixels(all_rays[v], v * image_size);
+      clip_to_depths(all_rays[v], framebuffer);
+    }
+  }
+
+  if(m_volume != nullptr)
+  {
+    const int32 domains = m_volume->num_domains();
+    std::vector<std::vector<DomainView>> views(num_views);
+    for(int32 v = 0; v < num_views; ++v)
+    {
+      views[v] = domain_views(m_volume->collection(), cameras[begin + v]);
+    }
+
     std::vector<Array<VolumePartial>> domain_partials;
-    for(int d = 0; d < domains; ++d)
+    for(int32 d = 0; d < domains; ++d)
     {
+      std::vector<Array<Ray>> view_rays_list;
+      for(int32 v = 0; v < num_views; ++v)
+      {
+        for(const DomainView &view : views[v])
+        {
+          if(view.m_domain != d)
+          {
+            continue;
+          }
+          Array<int32> ray_ids = rays_in_view(all_rays[v],
+                                              view,
+                                              width,
+                                              v * image_size);
+          view_rays_list.push_back(gather(all_rays[v], ray_ids));
+        }
+      }
+      Array<Ray> domain_rays = detail::concat_rays(view_rays_list);
+      if(domain_rays.size() == 0)
+      {
+        continue;
+      }
       m_volume->active_domain(d);
-      Array<VolumePartial> partials = m_volume->integrate(rays, lights);
-      domain_partials.push_back(partials);
+      domain_partials.push_back(m_volume->integrate(domain_rays, lights));
     }
-    DRAY_LOG_ENTRY("volume_total",timer.elapsed());
-    field_names.push_back(m_volume->field());
-    color_maps.push_back(m_volume->color_map());
 
-    std::vector<std::vector<apcomp::VolumePartial<float>>> c_partials;
-    detail::convert_partials(domain_partials, c_partials);
-
-    std::vector<apcomp::VolumePartial<float>> result;
-    apcomp::PartialCompositor<apcomp::VolumePartial<float>> compositor;
-    compositor.composite(c_partials, result);
+    Array<VolumePartial> result;
+    m_partial_compositor.composite(domain_partials,
+                                   image_size * num_views,
+                                   result);
     if(dray::mpi_rank() == 0)
     {
-
       detail::partials_to_framebuffer(result,
                                       framebuffer,
                                       need_composite);
     }
+  }
 
+  std::vector<Framebuffer> res;
+  for(int32 v = 0; v < num_views; ++v)
+  {
+    Framebuffer view_framebuffer(width, height);
+    view_framebuffer.format(m_format);
+    detail::copy_pixels(framebuffer, v * image_size, view_framebuffer);
+    if(m_screen_annotations)
+    {
+      annotate(view_framebuffer);
+    }
+    view_framebuffer.quantize();
+    res.push_back(view_framebuffer);
   }
+  return res;
+}
+
+void Renderer::reset_progressive()
+{
+  m_progressive.m_pass = 0;
+  m_progressive.m_samples = 0;
+  m_progressive.m_pass_time = 0.f;
+  m_progressive.m_width = 0;
+  m_progressive.m_height = 0;
+}
 
-  if(m_screen_annotations && dray::mpi_rank() == 0)
+void Renderer::max_samples(const int32 samples)
+{
+  if(samples < 1)
   {
-    Annotator annot;
-    annot.max_color_bars(m_max_color_bars);
-    annot.screen_annotations(framebuffer, field_names, color_maps);
+    DRAY_ERROR("Progressive rendering needs at least one sample");
   }
-  DRAY_LOG_CLOSE();
+  m_progressive.m_max_samples = samples;
+}
 
-  return framebuffer;
+bool Renderer::converged() const
+{
+  return m_progressive.m_pass > 2 &&
+         m_progressive.m_samples >= m_progressive.m_max_samples;
 }
 
-void Renderer::composite(Array<Ray> &rays,
-                         Camera &camera,
-                         Framebuffer &framebuffer,
-                         bool synch_depths) const
+bool Renderer::same_view(const Camera &camera) const
 {
-#ifdef DRAY_MPI_ENABLED
-  apcomp::Compositor comp;
-  comp.SetCompositeMode(apcomp::Compositor::CompositeMode::Z_BUFFER_SURFACE_WORLD);
-
-  const float32 *cbuffer =
-    reinterpret_cast<const float*>(framebuffer.colors().get_host_ptr());
-  comp.AddImage(cbuffer,
-                framebuffer.depths().get_host_ptr_const(),
-                camera.get_width(),
-                camera.get_height());
-
-  // valid only on rank 0
-  apcomp::Image result = comp.Composite();
-  float32 * depth_ptr = framebuffer.depths().get_host_ptr();
-  const int image_size = camera.get_width() * camera.get_height();
-  // copy the result back to the framebuffer
-  const size_t bytes = image_size * sizeof(float32);
-  if(dray::mpi_rank() == 0)
-  {
-    // write back the result depth buffer
-    memcpy ( depth_ptr, &result.m_depths[0], bytes);
-    Vec<float32, 4> *color_ptr = framebuffer.colors().get_host_ptr();
-    // copy the result colors back to the framebuffer
-    RAJA::forall<for_cpu_policy>(RAJA::RangeSegment(0, image_size), [=] DRAY_CPU_LAMBDA (int32 i)
+  const Progressive &prog = m_progressive;
+  return prog.m_width == camera.get_width() &&
+         prog.m_height == camera.get_height() &&
+         prog.m_pos == camera.get_pos() &&
+         prog.m_look_at == camera.get_look_at() &&
+         prog.m_up == camera.get_up() &&
+         prog.m_fov == camera.get_fov() &&
+         prog.m_zoom == camera.get_zoom();
+}
+
+void Renderer::progressive_pass(Camera &camera)
+{
+  Progressive &prog = m_progressive;
+  // annotations go on top of the resolved image instead
+  const bool screen_annotations = m_screen_annotations;
+  m_screen_annotations = false;
+
+  if(prog.m_pass < 2)
+  {
+    // strided pixels and fewer volume samples
+    const int32 stride = prog.m_pass == 0 ? 4 : 2;
+    Camera coarse = camera;
+    coarse.set_width(std::max(1, prog.m_width / stride));
+    coarse.set_height(std::max(1, prog.m_height / stride));
+
+    int32 samples = 0;
+    if(m_volume != nullptr)
     {
-      const int32 offset = i * 4;
-      Vec<float32, 4> color;
-      for(int c = 0; c < 4; ++c)
+      samples = m_volume->samples();
+      m_volume->samples(std::max(1, samples / stride));
+    }
+
+    Framebuffer framebuffer = render(coarse);
+
+    if(m_volume != nullptr)
+    {
+      m_volume->samples(samples);
+    }
+    detail::upsample(framebuffer,
+                     prog.m_width,
+                     prog.m_height,
+                     prog.m_colors,
+                     prog.m_depths);
+    prog.m_samples = 1;
+  }
+  else
+  {
+    // the first full resolution pass is exact, the rest are jittered
+    const bool first = prog.m_pass == 2;
+    m_jitter = !first;
+    Framebuffer framebuffer = render(camera);
+    m_jitter = false;
+    detail::accumulate(framebuffer, prog.m_colors, prog.m_depths, first);
+    prog.m_samples = first ? 1 : prog.m_samples + 1;
+  }
+
+  m_screen_annotations = screen_annotations;
+  prog.m_pass++;
+}
+
+Framebuffer Renderer::render_progressive(Camera &camera, const float32 budget)
+{
+  DRAY_LOG_OPEN("render_progressive");
+  Progressive &prog = m_progressive;
+  if(!same_view(camera))
+  {
+    reset_progressive();
+    prog.m_width = camera.get_width();
+    prog.m_height = camera.get_height();
+    prog.m_pos = camera.get_pos();
+    prog.m_look_at = camera.get_look_at();
+    prog.m_up = camera.get_up();
+    prog.m_fov = camera.get_fov();
+    prog.m_zoom = camera.get_zoom();
+    prog.m_colors.resize(prog.m_width * prog.m_height);
+    prog.m_depths.resize(prog.m_width * prog.m_height);
+  }
+
+  Timer timer;
+  int32 passes = 0;
+  while(!converged())
+  {
+    // a view always gets its first pass. After that, only start passes
+    // that should finish in time. Every rank has to agree since the
+    // passes composite.
+    if(prog.m_pass > 0)
+    {
+      // each refinement step has four times the pixels
+      const float32 estimate = prog.m_pass_time * (prog.m_pass <= 2 ? 4.f : 1.f);
+      const bool stop = timer.elapsed() + estimate > budget;
+      if(detail::someone_agrees(stop))
       {
-        color[c] = float32(result.m_pixels[offset + c]) / 255.f;
+        break;
       }
-      color_ptr[i] = color;
-    });
+    }
+    Timer pass_timer;
+    progressive_pass(camera);
+    prog.m_pass_time = pass_timer.elapsed();
+    passes++;
   }
+  DRAY_LOG_ENTRY("passes", passes);
+  DRAY_LOG_ENTRY("samples", prog.m_samples);
+  DRAY_LOG_ENTRY("time", timer.elapsed());
 
-  if(synch_depths)
+  Framebuffer framebuffer(prog.m_width, prog.m_height);
+  framebuffer.format(m_format);
+  detail::resolve(prog.m_colors, prog.m_depths, prog.m_samples, framebuffer);
+  if(m_screen_annotations)
   {
-    // tell everyone else about the current depth
-    // this will write direcly back to the framebuffer
-    MPI_Comm mpi_comm = MPI_Comm_f2c(dray::mpi_comm());
+    annotate(framebuffer);
+  }
+  framebuffer.quantize();
+  DRAY_LOG_CLOSE();
+  return framebuffer;
+}
+
+void Renderer::annotate(Framebuffer &framebuffer)
+{
+  if(dray::mpi_rank() != 0)
+  {
+    return;
+  }
 
-    MPI_Bcast( depth_ptr, image_size, MPI_FLOAT, 0, mpi_comm);
+  std::vector<std::string> field_names;
+  std::vector<ColorMap> color_maps;
+  for(int32 i = 0; i < m_traceables.size(); ++i)
+  {
+    field_names.push_back(m_traceables[i]->field());
+    color_maps.push_back(m_traceables[i]->color_map());
+  }
+  if(m_volume != nullptr)
+  {
+    field_names.push_back(m_volume->field());
+    color_maps.push_back(m_volume->color_map());
+  }
 
-    // everyone now needs to update the rays max depth to the updated
-    // depth values
-    const int32 size = rays.size();
-    Ray *ray_ptr = rays.get_device_ptr();
-    float32 *d_depth_ptr = framebuffer.depths().get_device_ptr();
+  Annotator annot;
+  annot.max_color_bars(m_max_color_bars);
+  annot.screen_annotations(framebuffer, field_names, color_maps);
+}
 
-    RAJA::forall<for_policy>(RAJA::RangeSegment(0, size), [=] DRAY_LAMBDA (int32 i)
+void Renderer::shade(Traceable &traceable,
+                     Array<Ray> &rays,
+                     Array<RayHit> &hits,
+                     Array<PointLight> &lights,
+                     Framebuffer &framebuffer)
+{
+  Array<Fragment> fragments = traceable.fragments(hits);
+  if(m_use_lighting)
+  {
+    traceable.shade(rays, hits, fragments, lights, framebuffer);
+  }
+  else
+  {
+    traceable.shade(rays, hits, fragments, framebuffer);
+  }
+}
+
+void Renderer::trace_concurrent(Traceable &traceable,
+                                const std::vector<DomainView> &views,
+                                Array<Ray> &rays,
+                                Array<PointLight> &lights,
+                                Framebuffer &framebuffer)
+{
+  DRAY_LOG_OPEN("concurrent_domains");
+  // every visible domain traces the full ray set so the hits line up
+  // for keep_nearest_hits. Domain d here is the view index.
+  const int32 domains = views.size();
+  std::vector<Array<RayHit>> domain_hits(domains);
+  std::vector<float32> hit_times(domains, 0.f);
+
+  Timer timer;
+#ifdef DRAY_CONCURRENT_DOMAINS
+  std::exception_ptr error = nullptr;
+  // each task runs its kernels serially on the thread that owns it
+  const int max_levels = omp_get_max_active_levels();
+  omp_set_max_active_levels(1);
+  #pragma omp parallel
+  {
+    #pragma omp single
     {
-      ray_ptr[i].m_far = d_depth_ptr[ray_ptr[i].m_pixel_id];
-    });
+      for(int32 d = 0; d < domains; ++d)
+      {
+        #pragma omp task firstprivate(d) shared(domain_hits, hit_times, error)
+        {
+          try
+          {
+            Timer domain_timer;
+            domain_hits[d] = traceable.nearest_hit(rays, views[d].m_domain);
+            hit_times[d] = domain_timer.elapsed();
+          }
+          catch(...)
+          {
+            #pragma omp critical (dray_concurrent_domains)
+            error = std::current_exception();
+          }
+        }
+      }
+    }
+  }
+  omp_set_max_active_levels(max_levels);
+
+  if(error)
+  {
+    std::rethrow_exception(error);
+  }
+#else
+  for(int32 d = 0; d < domains; ++d)
+  {
+    Timer domain_timer;
+    domain_hits[d] = traceable.nearest_hit(rays, views[d].m_domain);
+    hit_times[d] = domain_timer.elapsed();
+  }
+#endif
+  DRAY_LOG_ENTRY("hits", timer.elapsed());
+  for(int32 d = 0; d < domains; ++d)
+  {
+    DRAY_LOG_ENTRY("domain_" + std::to_string(views[d].m_domain) + "_hits",
+                   hit_times[d]);
+  }
+
+  timer.reset();
+  detail::keep_nearest_hits(domain_hits);
+  DRAY_LOG_ENTRY("merge", timer.elapsed());
 
+  // the remaining hits of the domains do not overlap, so only
+  // the visible fragments get shaded
+  timer.reset();
+  for(int32 d = 0; d < domains; ++d)
+  {
+    traceable.active_domain(views[d].m_domain);
+    shade(traceable, rays, domain_hits[d], lights, framebuffer);
+    ray_max(rays, domain_hits[d]);
+  }
+  DRAY_LOG_ENTRY("shade", timer.elapsed());
+  DRAY_LOG_CLOSE();
+}
+
+void Renderer::composite(Array<Ray> &rays,
+                         Camera &camera,
+                         Framebuffer &framebuffer,
+                         bool synch_depths) const
+{
+#ifdef DRAY_MPI_ENABLED
+  // only pixels covered by some surface can change during compositing
+  AABB<3> bounds;
+  for(int32 i = 0; i < m_traceables.size(); ++i)
+  {
+    bounds.include(m_traceables[i]->collection().bounds());
+  }
+  AABB<2> rect = camera.screen_bounds(bounds);
+
+  ImageCompositor compositor;
+  compositor.composite(framebuffer, rect);
+
+  if(synch_depths)
+  {
+    // ranks only need the depths where their part of the volume
+    // can show up
+    AABB<2> interest;
+    if(m_volume != nullptr)
+    {
+      interest = camera.screen_bounds(m_volume->collection().local_bounds());
+    }
+    compositor.synch_depths(framebuffer, interest, rays);
   }
 #else
   // nothing to do. We have already composited via ray_max
 #endif
 }
 
+PartialCompositor& Renderer::partial_compositor()
+{
+  return m_partial_compositor;
+}
+
 void Renderer::max_color_bars(const int32 max_bars)
 {
   // limits will be enforced in the annotator
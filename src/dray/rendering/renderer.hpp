@@ -7,11 +7,14 @@
 #define DRAY_RENDERER_HPP
 
 #include <dray/rendering/camera.hpp>
+#include <dray/rendering/domain_culling.hpp>
 #include <dray/rendering/framebuffer.hpp>
+#include <dray/rendering/partial_compositor.hpp>
 #include <dray/rendering/point_light.hpp>
 #include <dray/rendering/traceable.hpp>
 #include <dray/rendering/volume.hpp>
 
+#include <functional>
 #include <memory>
 #include <vector>
 
@@ -27,6 +30,62 @@ protected:
   bool m_use_lighting;
   bool m_screen_annotations;
   int32 m_max_color_bars;
+  PartialCompositor m_partial_compositor;
+  bool m_concurrent_domains;
+  bool m_cull_domains;
+  // render jittered rays, used by the progressive passes
+  bool m_jitter;
+  int32 m_batch_size;
+  PixelFormat m_format;
+
+  // progressive rendering of one view, see render_progressive
+  struct Progressive
+  {
+    Array<Vec<float32,4>> m_colors; // sum of the accumulated passes
+    Array<float32> m_depths;
+    int32 m_width;
+    int32 m_height;
+    int32 m_pass;             // next pass to run
+    int32 m_samples;          // passes summed into m_colors
+    int32 m_max_samples;
+    float32 m_pass_time;      // seconds the last pass took
+    Vec<float32,3> m_pos;     // the view being refined
+    Vec<float32,3> m_look_at;
+    Vec<float32,3> m_up;
+    float32 m_fov;
+    float32 m_zoom;
+  } m_progressive;
+
+  bool same_view(const Camera &camera) const;
+  // one coarse, full or jittered pass into the accumulation buffer
+  void progressive_pass(Camera &camera);
+  void annotate(Framebuffer &framebuffer);
+  Array<PointLight> make_lights(Camera &camera) const;
+  // render() and render_views() without their frame arena and log
+  Framebuffer render_frame(Camera &camera);
+  std::vector<Framebuffer> trace_views(std::vector<Camera> &cameras,
+                                       const int32 begin,
+                                       const int32 end);
+  // renders cameras [begin,end) together
+  std::vector<Framebuffer> render_views(std::vector<Camera> &cameras,
+                                        const int32 begin,
+                                        const int32 end);
+
+  // the domains to trace, culled and sorted when culling is on
+  std::vector<DomainView> domain_views(Collection &collection,
+                                       Camera &camera) const;
+  void shade(Traceable &traceable,
+             Array<Ray> &rays,
+             Array<RayHit> &hits,
+             Array<PointLight> &lights,
+             Framebuffer &framebuffer);
+  // traces all domains of the traceable at the same time, keeps the
+  // nearest hit of each ray, and shades every pixel once
+  void trace_concurrent(Traceable &traceable,
+                        const std::vector<DomainView> &views,
+                        Array<Ray> &rays,
+                        Array<PointLight> &lights,
+                        Framebuffer &framebuffer);
 public:
   Renderer();
   void clear();
@@ -43,6 +102,43 @@ public:
 
   void screen_annotations(bool on);
   void max_color_bars(const int32 max_bars);
+  // trace the domains of a traceable concurrently. Pays off with
+  // many small domains per rank. Only threaded host builds
+  // (OpenMP) run the domains in parallel.
+  void concurrent_domains(bool on);
+  // skip domains outside of the view, trace the others front to back
+  // with only the rays that cover them (default on)
+  void cull_domains(bool on);
+  // receives each image of a batch with the index of its camera
+  typedef std::function<void(const int32 index, Framebuffer &framebuffer)> BatchOutput;
+  // renders the scene from many cameras of the same image size. Groups
+  // of batch_size views are traced together, so each domain is set up
+  // and launched once per group instead of once per view. Views only
+  // share launches when lights are set, since the default light
+  // follows the camera.
+  void render_batch(std::vector<Camera> &cameras, BatchOutput output);
+  // views traced together by render_batch (default 8)
+  void batch_size(const int32 size);
+  // wire format of image compositing (default RGBA32F). Framebuffers
+  // stay float in every format: the compact ones shrink what is sent
+  // between ranks and round the rendered images to that precision.
+  void composite_format(const PixelFormat format);
+  PixelFormat composite_format() const;
+  // progressive rendering for interactive use. The first call for a
+  // view renders at reduced resolution and volume samples, later calls
+  // refine it and then add jittered full resolution samples. Passes
+  // are only started if they are expected to end within the budget
+  // (seconds), except for the first pass of a view. Changing the camera
+  // position, look at, up, fov or zoom starts over.
+  Framebuffer render_progressive(Camera &camera, const float32 budget);
+  // true once no pass is left to improve the current view
+  bool converged() const;
+  // jittered full resolution samples to stop at (default 8)
+  void max_samples(const int32 samples);
+  // start over, e.g. after the data, zoom or color maps changed
+  void reset_progressive();
+  // controls how volume partials are exchanged between ranks
+  PartialCompositor& partial_compositor();
 };
 
 
@@ -5,13 +5,18 @@
 
 #include <dray/rendering/scalar_renderer.hpp>
 
+#include <dray/array_utils.hpp>
 #include <dray/dray.hpp>
+#include <dray/dispatcher.hpp>
 #include <dray/error.hpp>
 #include <dray/error_check.hpp>
+#include <dray/data_model/device_field.hpp>
+#include <dray/data_model/device_mesh.hpp>
 #include <dray/filters/vector_component.hpp>
 #include <dray/rendering/volume.hpp>
 #include <dray/utils/data_logger.hpp>
 #include <dray/policies.hpp>
+#include <dray/transform_3d.hpp>
 #include <dray/utils/string_utils.hpp>
 #include <dray/utils/mpi_utils.hpp>
 
@@ -197,19 +202,296 @@ convert(ScalarBuffer &result, const std::vector<std::string> &names)
 }
 
 
+// pixel (i,j) of the detector sits at origin + i * dx * rx + j * dy * ry
+struct DetectorFrame
+{
+  Vec<Float, 3> m_origin;
+  Vec<Float, 3> m_rx;
+  Vec<Float, 3> m_ry;
+  Vec<Float, 3> m_normal;
+  Float m_dx;
+  Float m_dy;
+  int32 m_width;
+  int32 m_height;
+};
+
+DetectorFrame detector_frame(PlaneDetector &detector)
+{
+  DetectorFrame frame;
+  frame.m_width = detector.m_x_res;
+  frame.m_height = detector.m_y_res;
+  const Float width = detector.m_plane_width;
+  const Float height = detector.m_plane_height;
+
+  frame.m_dx = width / Float(frame.m_width);
+  frame.m_dy = height / Float(frame.m_height);
+
+  Vec<Float, 3> view = detector.m_view;
+  Vec<Float, 3> up = detector.m_up;
+
+  view.normalize();
+  up.normalize();
+
+  // create the orthogal basis vectors
+  frame.m_rx = cross(view, up);
+  frame.m_ry = cross (frame.m_rx, view);
+  frame.m_normal = view;
+
+  const Vec<Float, 3> center = detector.m_center;
+  // bottom left pixel origin
+  frame.m_origin = center - frame.m_rx * (width + frame.m_dx) * 0.5
+                          - frame.m_ry * (height + frame.m_dy) * 0.5;
+  return frame;
+}
+
+// index of the last entry of the sorted offsets that is <= value
+DRAY_EXEC int32 find_offset(const index_int *offsets,
+                            const int32 size,
+                            const index_int value)
+{
+  int32 lo = 0;
+  int32 hi = size;
+  while(hi - lo > 1)
+  {
+    const int32 mid = lo + (hi - lo) / 2;
+    if(offsets[mid] <= value)
+    {
+      lo = mid;
+    }
+    else
+    {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+// Finds the element and reference coordinates under every pixel of
+// the detector plane. Each element clips its bounding box against the
+// plane, and the covered (element, pixel) pairs are flattened so large
+// elements are spread over many threads. Every solve starts from the
+// element center. The first element to contain a pixel writes it. Pixels
+// contained by several elements (shared faces) go to the lowest element
+// id through an atomic min, and only those are solved again by the owner.
+template<typename MeshElem>
+void plane_locate(UnstructuredMesh<MeshElem> &mesh,
+                  const DetectorFrame &frame,
+                  Array<Location> &locations)
+{
+  DRAY_LOG_OPEN("plane_locate");
+  constexpr auto etype = MeshElem::get_etype ();
+  const RefSpaceTag<3, etype> ref_space_tag;
+  const Vec<Float, 3> ref_center = subref_center(ref_universe(ref_space_tag));
+
+  DeviceMesh<MeshElem> device_mesh(mesh, false);
+  const int32 num_elems = mesh.cells();
+
+  // pixel rectangle (i_begin, j_begin, width) covered by each element
+  Array<Vec<int32, 3>> rects;
+  rects.resize(num_elems);
+  Array<index_int> counts;
+  counts.resize(num_elems);
+  Vec<int32, 3> *rect_ptr = rects.get_device_ptr();
+  index_int *count_ptr = counts.get_device_ptr();
+
+  RAJA::forall<for_policy> (RAJA::RangeSegment (0, num_elems), [=] DRAY_LAMBDA (int32 el_id)
+  {
+    const MeshElem elem = device_mesh.get_elem(el_id);
+    AABB<3> box;
+    elem.get_bounds(box);
+
+    Float d_min = infinity<Float>();
+    Float d_max = -infinity<Float>();
+    Float u_min = infinity<Float>();
+    Float u_max = -infinity<Float>();
+    Float v_min = infinity<Float>();
+    Float v_max = -infinity<Float>();
+    for(int32 c = 0; c < 8; ++c)
+    {
+      Vec<Float, 3> corner;
+      corner[0] = (c & 1) ? box.m_ranges[0].max() : box.m_ranges[0].min();
+      corner[1] = (c & 2) ? box.m_ranges[1].max() : box.m_ranges[1].min();
+      corner[2] = (c & 4) ? box.m_ranges[2].max() : box.m_ranges[2].min();
+      const Vec<Float, 3> rel = corner - frame.m_origin;
+      const Float d = dot(rel, frame.m_normal);
+      const Float u = dot(rel, frame.m_rx) / frame.m_dx;
+      const Float v = dot(rel, frame.m_ry) / frame.m_dy;
+      d_min = fminf(d_min, d);
+      d_max = fmaxf(d_max, d);
+      u_min = fminf(u_min, u);
+      u_max = fmaxf(u_max, u);
+      v_min = fminf(v_min, v);
+      v_max = fmaxf(v_max, v);
+    }
+
+    Vec<int32, 3> rect = {{0, 0, 0}};
+    index_int count = 0;
+    // skip elements that do not cross the plane or miss the image
+    if(!(d_min > 0 || d_max < 0 ||
+         u_max < 0 || u_min > frame.m_width - 1 ||
+         v_max < 0 || v_min > frame.m_height - 1))
+    {
+      const int32 i_begin = u_min > 0 ? int32(ceil(u_min)) : 0;
+      const int32 i_end = u_max < frame.m_width - 1 ? int32(floor(u_max)) : frame.m_width - 1;
+      const int32 j_begin = v_min > 0 ? int32(ceil(v_min)) : 0;
+      const int32 j_end = v_max < frame.m_height - 1 ? int32(floor(v_max)) : frame.m_height - 1;
+      if(i_end >= i_begin && j_end >= j_begin)
+      {
+        rect[0] = i_begin;
+        rect[1] = j_begin;
+        rect[2] = i_end - i_begin + 1;
+        count = index_int(rect[2]) * index_int(j_end - j_begin + 1);
+      }
+    }
+    rect_ptr[el_id] = rect;
+    count_ptr[el_id] = count;
+  });
+  DRAY_ERROR_CHECK();
+
+  index_int total_pairs = 0;
+  Array<index_int> offsets = array_exc_scan_plus(counts, total_pairs);
+  const index_int *offset_ptr = offsets.get_device_ptr_const();
+  const Vec<int32, 3> *crect_ptr = rects.get_device_ptr_const();
+  DRAY_LOG_ENTRY("pairs", total_pairs);
+
+  const int32 size = frame.m_width * frame.m_height;
+  Array<int32> owners;
+  owners.resize(size);
+  array_memset(owners, num_elems);
+  int32 *owner_ptr = owners.get_device_ptr();
+  // elements that contain each pixel
+  Array<int32> claims;
+  claims.resize(size);
+  array_memset_zero(claims);
+  int32 *claims_ptr = claims.get_device_ptr();
+  Location *loc_ptr = locations.get_device_ptr();
+
+  // claim every pixel an element contains
+  RAJA::forall<for_policy> (RAJA::RangeSegment (0, total_pairs), [=] DRAY_LAMBDA (index_int pair)
+  {
+    const int32 el_id = find_offset(offset_ptr, num_elems, pair);
+    const Vec<int32, 3> rect = crect_ptr[el_id];
+    const index_int local = pair - offset_ptr[el_id];
+    const int32 i = rect[0] + int32(local % rect[2]);
+    const int32 j = rect[1] + int32(local / rect[2]);
+    const Vec<Float, 3> point = frame.m_origin
+                                + frame.m_rx * (Float(i) * frame.m_dx)
+                                + frame.m_ry * (Float(j) * frame.m_dy);
+    const MeshElem elem = device_mesh.get_elem(el_id);
+    Vec<Float, 3> ref = ref_center;
+    if(elem.eval_inverse_local(point, ref))
+    {
+      const int32 pixel = j * frame.m_width + i;
+      RAJA::atomicMin<atomic_policy> (&owner_ptr[pixel], el_id);
+      // only the first claim writes, so the write never races
+      if(RAJA::atomicAdd<atomic_policy> (&claims_ptr[pixel], 1) == 0)
+      {
+        Location loc;
+        loc.m_cell_id = el_id;
+        loc.m_ref_pt = ref;
+        loc_ptr[pixel] = loc;
+      }
+    }
+  });
+  DRAY_ERROR_CHECK();
+
+  // the first claim of a contested pixel may not be the owner. The owner
+  // solves it again from the same guess, which reproduces the reference
+  // point it claimed with
+  const int32 *cowner_ptr = owners.get_device_ptr_const();
+  const int32 *cclaims_ptr = claims.get_device_ptr_const();
+  RAJA::forall<for_policy> (RAJA::RangeSegment (0, size), [=] DRAY_LAMBDA (int32 ii)
+  {
+    const int32 el_id = cowner_ptr[ii];
+    if(cclaims_ptr[ii] < 2 || loc_ptr[ii].m_cell_id == el_id)
+    {
+      return;
+    }
+    const int32 i = ii % frame.m_width;
+    const int32 j = ii / frame.m_width;
+    const Vec<Float, 3> point = frame.m_origin
+                                + frame.m_rx * (Float(i) * frame.m_dx)
+                                + frame.m_ry * (Float(j) * frame.m_dy);
+    const MeshElem elem = device_mesh.get_elem(el_id);
+    Vec<Float, 3> ref = ref_center;
+    if(elem.eval_inverse_local(point, ref))
+    {
+      Location loc;
+      loc.m_cell_id = el_id;
+      loc.m_ref_pt = ref;
+      loc_ptr[ii] = loc;
+    }
+  });
+  DRAY_ERROR_CHECK();
+  DRAY_LOG_CLOSE();
+}
+
+struct PlaneLocateFunctor
+{
+  DetectorFrame m_frame;
+  Array<Location> m_locations;
+  PlaneLocateFunctor(const DetectorFrame &frame, Array<Location> &locations)
+    : m_frame(frame),
+      m_locations(locations)
+  {
+  }
+
+  template<typename MeshType>
+  void operator()(MeshType &mesh)
+  {
+    plane_locate(mesh, m_frame, m_locations);
+  }
+};
+
+struct PlaneEvalFunctor
+{
+  Array<Location> m_locations;
+  Array<Float> m_buffer;
+  PlaneEvalFunctor(Array<Location> &locations, Array<Float> &buffer)
+    : m_locations(locations),
+      m_buffer(buffer)
+  {
+  }
+
+  template<typename FieldElem>
+  void operator()(UnstructuredField<FieldElem> &field)
+  {
+    const Location *loc_ptr = m_locations.get_device_ptr_const();
+    Float *buffer_ptr = m_buffer.get_device_ptr();
+    DeviceField<FieldElem> device_field(field);
+
+    RAJA::forall<for_policy> (RAJA::RangeSegment (0, m_locations.size ()), [=] DRAY_LAMBDA (int32 ii)
+    {
+      const Location loc = loc_ptr[ii];
+      if(loc.m_cell_id > -1)
+      {
+        buffer_ptr[ii] = device_field.get_elem(loc.m_cell_id).eval(loc.m_ref_pt)[0];
+      }
+    });
+    DRAY_ERROR_CHECK();
+  }
+};
+
 } // namespace
 
 
 ScalarRenderer::ScalarRenderer()
-  : m_traceable(nullptr)
+  : m_traceable(nullptr),
+    m_cull_domains(true)
 {
 }
 
 ScalarRenderer::ScalarRenderer(std::shared_ptr<Traceable> traceable)
+  : m_cull_domains(true)
 {
   set(traceable);
 }
 
+void ScalarRenderer::cull_domains(bool on)
+{
+  m_cull_domains = on;
+}
+
 void ScalarRenderer::set(std::shared_ptr<Traceable> traceable)
 {
   m_traceable = traceable;
@@ -281,20 +563,34 @@ ScalarRenderer::decompose_vectors()
 
 void
 ScalarRenderer::render(Array<Ray> &rays, ScalarBuffer &scalar_buffer)
+{
+  std::vector<DomainView> views = all_domains(m_traceable->collection(),
+                                              scalar_buffer.m_width,
+                                              scalar_buffer.m_height);
+  trace(rays, views, scalar_buffer);
+}
+
+void
+ScalarRenderer::trace(Array<Ray> &all_rays,
+                      const std::vector<DomainView> &views,
+                      ScalarBuffer &scalar_buffer)
 {
   // we only handle scalars so if they asked for a vector field
   // then we have to decompose them
   decompose_vectors();
 
-  const int32 buffer_size = scalar_buffer.size();
   const int32 field_size = m_actual_field_names.size();
 
-  //scalar_buffer.m_depths.resize(buffer_size);
-
-  const int domains = m_traceable->num_domains();
-
-  for(int d = 0; d < domains; ++d)
+  for(const DomainView &view : views)
   {
+    const int32 d = view.m_domain;
+    Array<int32> ray_ids = rays_in_view(all_rays, view, scalar_buffer.m_width);
+    if(ray_ids.size() == 0)
+    {
+      continue;
+    }
+    Array<Ray> rays = gather(all_rays, ray_ids);
+
     DRAY_INFO("Tracing scalar domain "<<d);
     m_traceable->active_domain(d);
     const int domain_offset = m_offsets[d];
@@ -348,9 +644,16 @@ ScalarRenderer::render(Array<Ray> &rays, ScalarBuffer &scalar_buffer)
     }
 
     ray_max(rays, hits);
+    scatter_far(rays, ray_ids, all_rays);
   }
 
 
+  composite(scalar_buffer);
+}
+
+void
+ScalarRenderer::composite(ScalarBuffer &scalar_buffer)
+{
 #ifdef DRAY_MPI_ENABLED
   apcomp::PayloadCompositor compositor;
   apcomp::ScalarImage *pimage = convert(scalar_buffer, m_actual_field_names);
@@ -373,37 +676,22 @@ ScalarRenderer::render(Array<Ray> &rays, ScalarBuffer &scalar_buffer)
 ScalarBuffer
 ScalarRenderer::render(PlaneDetector &detector)
 {
-  const int32 p_width = detector.m_x_res;
-  const int32 p_height = detector.m_y_res;
-  const Float width = detector.m_plane_width;
-  const Float height = detector.m_plane_height;
-
-  const Float dx = width / Float(p_width);
-  const Float dy = height / Float(p_height);
-
+  const DetectorFrame frame = detector_frame(detector);
+  const int32 p_width = frame.m_width;
+  const Float dx = frame.m_dx;
+  const Float dy = frame.m_dy;
+  const Vec<Float, 3> view = frame.m_normal;
+  const Vec<Float, 3> rx = frame.m_rx;
+  const Vec<Float, 3> ry = frame.m_ry;
+  const Vec<Float, 3> origin = frame.m_origin;
 
   // TODO: Float
-  ScalarBuffer scalar_buffer(p_width,
-                             p_height,
+  ScalarBuffer scalar_buffer(frame.m_width,
+                             frame.m_height,
                              nan<Float>());
 
-  Vec<Float, 3> view = detector.m_view;
-  Vec<Float, 3> up = detector.m_up;
-
-  view.normalize();
-  up.normalize();
-
-  // create the orthogal basis vectors
-  Vec<Float, 3> rx = cross(view, up);
-  Vec<Float, 3> ry = cross (rx, view);
-
-  const Vec<Float, 3> center = detector.m_center;
-  // bottom left pixel origin
-  const Vec<Float, 3> origin
-    = center - rx * (width + dx) * 0.5 - ry * (height + dy) * 0.5;
-
   Array<Ray> rays;
-  rays.resize(p_width * p_height);
+  rays.resize(frame.m_width * frame.m_height);
 
   Ray * ray_ptr = rays.get_device_ptr();
 
@@ -428,6 +716,96 @@ ScalarRenderer::render(PlaneDetector &detector)
   return scalar_buffer;
 }
 
+ScalarBuffer
+ScalarRenderer::sample(PlaneDetector &detector)
+{
+  if(m_traceable == nullptr)
+  {
+    DRAY_ERROR("ScalarRenderer: traceable never set");
+  }
+  DRAY_LOG_OPEN("plane_sample");
+
+  decompose_vectors();
+
+  const DetectorFrame frame = detector_frame(detector);
+  ScalarBuffer scalar_buffer(frame.m_width,
+                             frame.m_height,
+                             nan<Float>());
+  const int32 size = scalar_buffer.size();
+
+  Collection collection = m_traceable->collection();
+  const int32 domains = collection.local_size();
+  for(int32 d = 0; d < domains; ++d)
+  {
+    DataSet data_set = collection.domain(d);
+    if(data_set.mesh()->dims() != 3)
+    {
+      continue;
+    }
+
+    Array<Location> locations;
+    locations.resize(size);
+    Location *loc_ptr = locations.get_device_ptr();
+    RAJA::forall<for_policy> (RAJA::RangeSegment (0, size), [=] DRAY_LAMBDA (int32 ii)
+    {
+      Location loc;
+      loc.m_cell_id = -1;
+      loc_ptr[ii] = loc;
+    });
+    DRAY_ERROR_CHECK();
+
+    // instanced domains are sampled in object space. The transform is
+    // rigid, so the pixel spacing carries over unchanged.
+    DetectorFrame obj_frame = frame;
+    if(data_set.has_transform())
+    {
+      const Matrix<Float, 4, 4> inverse = data_set.inverse_transform();
+      obj_frame.m_origin = transform_point(inverse, frame.m_origin);
+      obj_frame.m_rx = transform_vector(inverse, frame.m_rx);
+      obj_frame.m_ry = transform_vector(inverse, frame.m_ry);
+      obj_frame.m_normal = transform_vector(inverse, frame.m_normal);
+    }
+
+    PlaneLocateFunctor locate_func(obj_frame, locations);
+    dispatch_3d(data_set.mesh(), locate_func);
+
+    const int32 domain_offset = m_offsets[d];
+    Float *depth_ptr = scalar_buffer.m_depths.get_device_ptr();
+    int32 *zone_id_ptr = scalar_buffer.m_zone_ids.get_device_ptr();
+    const Location *cloc_ptr = locations.get_device_ptr_const();
+    RAJA::forall<for_policy> (RAJA::RangeSegment (0, size), [=] DRAY_LAMBDA (int32 ii)
+    {
+      const Location loc = cloc_ptr[ii];
+      if(loc.m_cell_id > -1)
+      {
+        // samples lie on the detector plane
+        depth_ptr[ii] = 0.f;
+        zone_id_ptr[ii] = loc.m_cell_id + domain_offset;
+      }
+    });
+    DRAY_ERROR_CHECK();
+
+    for(auto &field : m_actual_field_names)
+    {
+      if(!data_set.has_field(field))
+      {
+        continue;
+      }
+      if(!scalar_buffer.has_field(field))
+      {
+        scalar_buffer.add_field(field);
+      }
+      Array<Float> buffer = scalar_buffer.m_scalars[field];
+      PlaneEvalFunctor eval_func(locations, buffer);
+      dispatch_3d_scalar(data_set.field(field), eval_func);
+    }
+  }
+
+  composite(scalar_buffer);
+  DRAY_LOG_CLOSE();
+  return scalar_buffer;
+}
+
 ScalarBuffer
 ScalarRenderer::render(Camera &camera)
 {
@@ -443,7 +821,18 @@ ScalarRenderer::render(Camera &camera)
                              camera.get_height(),
                              nan<Float>());
 
-  render(rays, scalar_buffer);
+  std::vector<DomainView> views;
+  if(m_cull_domains)
+  {
+    views = visible_domains(m_traceable->collection(), camera);
+  }
+  else
+  {
+    views = all_domains(m_traceable->collection(),
+                        camera.get_width(),
+                        camera.get_height());
+  }
+  trace(rays, views, scalar_buffer);
   return scalar_buffer;
 }
 
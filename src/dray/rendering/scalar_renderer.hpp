@@ -9,6 +9,7 @@
 #include <dray/ray.hpp>
 #include <dray/plane_detector.hpp>
 #include <dray/rendering/camera.hpp>
+#include <dray/rendering/domain_culling.hpp>
 #include <dray/rendering/scalar_buffer.hpp>
 #include <dray/rendering/traceable.hpp>
 
@@ -25,15 +26,28 @@ protected:
   std::vector<std::string> m_field_names;
   std::vector<int32> m_offsets;
   std::vector<std::string> m_actual_field_names;
+  bool m_cull_domains;
   void decompose_vectors();
+  void composite(ScalarBuffer &scalar_buffer);
+  // traces the domains in view order with the rays that cover them
+  void trace(Array<Ray> &rays,
+             const std::vector<DomainView> &views,
+             ScalarBuffer &scalar_buffer);
 public:
   ScalarRenderer();
   ScalarRenderer(std::shared_ptr<Traceable> tracable);
 
   void set(std::shared_ptr<Traceable> traceable);
+  // skip domains outside of the camera view (default on)
+  void cull_domains(bool on);
   void field_names(const std::vector<std::string> &field_names);
   ScalarBuffer render(Camera &camera);
   ScalarBuffer render(PlaneDetector &detector);
+  // samples the fields on the detector plane itself without tracing
+  // rays. Each element that crosses the plane scatters into the
+  // pixels under its footprint, so the traceable is only used for
+  // its collection.
+  ScalarBuffer sample(PlaneDetector &detector);
   void render(Array<Ray> &rays, ScalarBuffer &scalar_buffer);
 };
 
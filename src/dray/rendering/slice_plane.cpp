@@ -8,6 +8,8 @@
 #include <dray/array_utils.hpp>
 #include <dray/utils/data_logger.hpp>
 #include <dray/data_model/device_field.hpp>
+#include <dray/data_model/device_mesh.hpp>
+#include <dray/transform_3d.hpp>
 
 #include <assert.h>
 
@@ -17,40 +19,6 @@ namespace dray
 namespace detail
 {
 
-Array<RayHit>
-get_hits(const Array<Ray> &rays,
-         const Array<Location> &locations,
-         const Array<Vec<Float,3>> &points)
-{
-  Array<RayHit> hits;
-  hits.resize(rays.size());
-
-  const Ray *ray_ptr = rays.get_device_ptr_const();
-  const Location *loc_ptr = locations.get_device_ptr_const();
-  const Vec<Float,3> *points_ptr = points.get_device_ptr_const();
-  RayHit *hit_ptr = hits.get_device_ptr();
-
-  RAJA::forall<for_policy>(RAJA::RangeSegment(0, rays.size()), [=] DRAY_LAMBDA (int32 i)
-  {
-    RayHit hit;
-    const Location loc = loc_ptr[i];
-    const Ray ray = ray_ptr[i];
-    const Vec<Float,3> point = points_ptr[i];
-    hit.m_hit_idx = loc.m_cell_id;
-    hit.m_ref_pt  = loc.m_ref_pt;
-
-    if(hit.m_hit_idx > -1)
-    {
-      hit.m_dist = (point - ray.m_orig).magnitude();
-    }
-
-    hit_ptr[i] = hit;
-
-  });
-  DRAY_ERROR_CHECK();
-  return hits;
-}
-
 template<typename ElementType>
 Array<Fragment>
 get_fragments(UnstructuredField<ElementType> &field,
@@ -97,72 +65,182 @@ get_fragments(UnstructuredField<ElementType> &field,
   return fragments;
 }
 
+// Moves every active ray on to its next plane intersection, ordered
+// by distance and then by plane index so coincident planes are not
+// skipped. Returns the rays that still have a plane to try.
+Array<int32>
+next_planes(Array<Ray> &rays,
+            Array<int32> &active,
+            const Array<Vec<Float,3>> &points,
+            const Array<Vec<Float,3>> &normals,
+            Array<Float> &ray_dist,
+            Array<int32> &ray_plane)
+{
+  const int32 size = active.size();
+  const int32 num_planes = points.size();
+
+  const Ray *ray_ptr = rays.get_device_ptr_const();
+  const int32 *active_ptr = active.get_device_ptr_const();
+  const Vec<Float,3> *points_ptr = points.get_device_ptr_const();
+  const Vec<Float,3> *normals_ptr = normals.get_device_ptr_const();
+  Float *dist_ptr = ray_dist.get_device_ptr();
+  int32 *plane_ptr = ray_plane.get_device_ptr();
+
+  Array<int32> flags;
+  flags.resize(size);
+  int32 *flags_ptr = flags.get_device_ptr();
+
+  RAJA::forall<for_policy>(RAJA::RangeSegment(0, size), [=] DRAY_LAMBDA (int32 i)
+  {
+    const int32 ray_idx = active_ptr[i];
+    const Ray ray = ray_ptr[ray_idx];
+    const Float prev_dist = dist_ptr[ray_idx];
+    const int32 prev_plane = plane_ptr[ray_idx];
+
+    Float best_dist = infinity<Float>();
+    int32 best_plane = -1;
+    for(int32 p = 0; p < num_planes; ++p)
+    {
+      const Float denom = dot(ray.m_dir, normals_ptr[p]);
+      if(abs(denom) > 1e-6)
+      {
+        const Float t = dot(points_ptr[p] - ray.m_orig, normals_ptr[p]) / denom;
+        const bool after = t > prev_dist || (t == prev_dist && p > prev_plane);
+        if(after && t > 0 && t < ray.m_far && t > ray.m_near && t < best_dist)
+        {
+          best_dist = t;
+          best_plane = p;
+        }
+      }
+    }
+
+    dist_ptr[ray_idx] = best_dist;
+    plane_ptr[ray_idx] = best_plane;
+    flags_ptr[i] = best_plane == -1 ? 0 : 1;
+  });
+  DRAY_ERROR_CHECK();
+
+  return index_flags<int32>(flags, active);
+}
+
 Array<Vec<Float,3>>
 calc_sample_points(Array<Ray> &rays,
-                   const Vec<float32,3> &point,
-                   const Vec<float32,3> &normal)
+                   Array<int32> &active,
+                   Array<Float> &ray_dist)
 {
-  const int32 size = rays.size();
+  const int32 size = active.size();
 
   Array<Vec<Float,3>> points;
   points.resize(size);
 
-  Vec<Float,3> t_normal;
-  t_normal[0] = normal[0];
-  t_normal[1] = normal[1];
-  t_normal[2] = normal[2];
-
-  Vec<Float,3> t_point;
-  t_point[0] = point[0];
-  t_point[1] = point[1];
-  t_point[2] = point[2];
-
   Vec<Float,3> *points_ptr = points.get_device_ptr();
-
   const Ray *ray_ptr = rays.get_device_ptr_const();
+  const int32 *active_ptr = active.get_device_ptr_const();
+  const Float *dist_ptr = ray_dist.get_device_ptr_const();
 
   RAJA::forall<for_policy>(RAJA::RangeSegment(0, size), [=] DRAY_LAMBDA (int32 i)
   {
+    const int32 ray_idx = active_ptr[i];
+    const Ray &ray = ray_ptr[ray_idx];
+    points_ptr[i] = ray.m_dir * dist_ptr[ray_idx] + ray.m_orig;
+  });
+  DRAY_ERROR_CHECK();
 
-    const Ray &ray = ray_ptr[i];
-    const Float denom = dot(ray.m_dir, t_normal);
-    Float dist = infinity<Float>();
-    if(abs(denom) > 1e-6)
-    {
-      Vec<Float,3> p = t_point - ray.m_orig;
-      const Float t = dot(p, t_normal) / denom;
-      if(t > 0 && t < ray.m_far && t > ray.m_near)
-      {
-        dist = t;
-      }
-    }
+  return points;
+}
 
-    Vec<Float,3> sample = ray.m_dir * dist + ray.m_orig;
+// records the rays whose sample landed inside the mesh and
+// returns the ones that have to try their next plane
+Array<int32>
+record_hits(Array<int32> &active,
+            const Array<Location> &locations,
+            const Array<Vec<Float,3>> &samples,
+            Array<Ray> &rays,
+            Array<RayHit> &hits)
+{
+  const int32 size = active.size();
 
-    points_ptr[i] = sample;
+  const Ray *ray_ptr = rays.get_device_ptr_const();
+  const int32 *active_ptr = active.get_device_ptr_const();
+  const Location *loc_ptr = locations.get_device_ptr_const();
+  const Vec<Float,3> *samples_ptr = samples.get_device_ptr_const();
+  RayHit *hit_ptr = hits.get_device_ptr();
 
+  Array<int32> flags;
+  flags.resize(size);
+  int32 *flags_ptr = flags.get_device_ptr();
+
+  RAJA::forall<for_policy>(RAJA::RangeSegment(0, size), [=] DRAY_LAMBDA (int32 i)
+  {
+    const int32 ray_idx = active_ptr[i];
+    const Location loc = loc_ptr[i];
+    int32 missed = 1;
+    if(loc.m_cell_id > -1)
+    {
+      RayHit hit;
+      hit.m_hit_idx = loc.m_cell_id;
+      hit.m_ref_pt  = loc.m_ref_pt;
+      hit.m_dist = (samples_ptr[i] - ray_ptr[ray_idx].m_orig).magnitude();
+      hit_ptr[ray_idx] = hit;
+      missed = 0;
+    }
+    flags_ptr[i] = missed;
   });
   DRAY_ERROR_CHECK();
 
-  return points;
+  return index_flags<int32>(flags, active);
 }
 
 template<class Element>
 Array<RayHit>
 slice_execute(UnstructuredMesh<Element> &mesh,
               Array<Ray> &rays,
-              const Vec<float32,3> point,
-              const Vec<float32,3> normal)
+              const Array<Vec<Float,3>> &points,
+              const Array<Vec<Float,3>> &normals)
 {
   DRAY_LOG_OPEN("slice_plane");
 
-  Array<Vec<Float,3>> samples = detail::calc_sample_points(rays, point, normal);
+  const int32 size = rays.size();
 
-  // Find elements and reference coordinates for the points.
-  Array<Location> locations = mesh.locate(samples);
+  Array<RayHit> hits;
+  hits.resize(size);
+  RayHit *hit_ptr = hits.get_device_ptr();
+  RAJA::forall<for_policy>(RAJA::RangeSegment(0, size), [=] DRAY_LAMBDA (int32 i)
+  {
+    RayHit hit;
+    hit.init();
+    hit_ptr[i] = hit;
+  });
+  DRAY_ERROR_CHECK();
 
-  Array<RayHit> hits = detail::get_hits(rays, locations, samples);
+  // distance and index of the plane each ray currently samples
+  Array<Float> ray_dist;
+  ray_dist.resize(size);
+  array_memset(ray_dist, -infinity<Float>());
+  Array<int32> ray_plane;
+  ray_plane.resize(size);
+  array_memset(ray_plane, -1);
+
+  Array<int32> active = array_counting(size, 0, 1);
+  int32 rounds = 0;
+  // each round every unresolved ray steps to its next plane, so
+  // the loop ends after at most one round per plane
+  while(active.size() > 0)
+  {
+    active = detail::next_planes(rays, active, points, normals, ray_dist, ray_plane);
+    if(active.size() == 0)
+    {
+      break;
+    }
+
+    Array<Vec<Float,3>> samples = detail::calc_sample_points(rays, active, ray_dist);
+    // Find elements and reference coordinates for the points.
+    Array<Location> locations = mesh.locate(samples);
+    active = detail::record_hits(active, locations, samples, rays, hits);
+    rounds++;
+  }
 
+  DRAY_LOG_ENTRY("rounds", rounds);
   DRAY_LOG_CLOSE();
   return hits;
 }
@@ -172,24 +250,152 @@ struct SliceFunctor
 {
   Array<Ray> *m_rays;
   Array<RayHit> m_hits;
-  Vec<float32,3> m_point;
-  Vec<float32,3> m_normal;
+  Array<Vec<Float,3>> m_points;
+  Array<Vec<Float,3>> m_normals;
   SliceFunctor(Array<Ray> *rays,
-               const Vec<float32,3> point,
-               const Vec<float32,3> normal )
+               const Array<Vec<Float,3>> &points,
+               const Array<Vec<Float,3>> &normals)
     : m_rays(rays),
-      m_point(point),
-      m_normal(normal)
+      m_points(points),
+      m_normals(normals)
   {
   }
 
   template<typename MeshType>
   void operator()(MeshType &mesh)
   {
-    m_hits = slice_execute(mesh, *m_rays, m_point, m_normal);
+    m_hits = slice_execute(mesh, *m_rays, m_points, m_normals);
+  }
+};
+
+// Fragments for several planes. The hit does not know which plane
+// produced it, so the plane closest to the hit point gives the normal.
+template<typename MeshElem, typename FieldElem>
+Array<Fragment>
+get_fragments(UnstructuredMesh<MeshElem> &mesh,
+              UnstructuredField<FieldElem> &field,
+              Array<RayHit> &hits,
+              const Array<Vec<Float,3>> &points,
+              const Array<Vec<Float,3>> &normals,
+              const Array<Vec<float32,3>> &world_normals)
+{
+  const int32 size = hits.size();
+  const int32 num_planes = points.size();
+
+  Array<Fragment> fragments;
+  fragments.resize(size);
+  Fragment *fragment_ptr = fragments.get_device_ptr();
+
+  const RayHit *hit_ptr = hits.get_device_ptr_const();
+  const Vec<Float,3> *points_ptr = points.get_device_ptr_const();
+  const Vec<Float,3> *normals_ptr = normals.get_device_ptr_const();
+  const Vec<float32,3> *world_normals_ptr = world_normals.get_device_ptr_const();
+
+  DeviceMesh<MeshElem> device_mesh(mesh);
+  DeviceField<FieldElem> device_field(field);
+  RAJA::forall<for_policy>(RAJA::RangeSegment(0, size), [=] DRAY_LAMBDA (int32 i)
+  {
+    Fragment frag;
+    frag.m_normal = world_normals_ptr[0];
+    frag.m_scalar= 3.14f;
+
+    const RayHit &hit = hit_ptr[i];
+
+    if (hit.m_hit_idx > -1)
+    {
+      const int32 el_id = hit.m_hit_idx;
+      const Vec<Float,3> x = device_mesh.get_elem(el_id).eval(hit.m_ref_pt);
+
+      Float min_dist = infinity<Float>();
+      for(int32 p = 0; p < num_planes; ++p)
+      {
+        const Float dist = abs(dot(x - points_ptr[p], normals_ptr[p]));
+        if(dist < min_dist)
+        {
+          min_dist = dist;
+          frag.m_normal = world_normals_ptr[p];
+        }
+      }
+
+      Vec<Vec<Float,1>,3> field_deriv;
+      Vec<Float,1> scalar;
+      scalar = device_field.get_elem(el_id).eval_d(hit.m_ref_pt, field_deriv);
+      frag.m_scalar = scalar[0];
+    }
+
+    fragment_ptr[i] = frag;
+
+  });
+  DRAY_ERROR_CHECK();
+
+  return fragments;
+}
+
+struct MultiSliceFragmentFunctor
+{
+  Array<RayHit> *m_hits;
+  Array<Vec<Float,3>> m_points;
+  Array<Vec<Float,3>> m_normals;
+  Array<Vec<float32,3>> m_world_normals;
+  Array<Fragment> m_fragments;
+  MultiSliceFragmentFunctor(Array<RayHit> *hits,
+                            const Array<Vec<Float,3>> &points,
+                            const Array<Vec<Float,3>> &normals,
+                            const Array<Vec<float32,3>> &world_normals)
+    : m_hits(hits),
+      m_points(points),
+      m_normals(normals),
+      m_world_normals(world_normals)
+  {
+  }
+
+  template<typename MeshType, typename FieldType>
+  void operator()(MeshType &mesh, FieldType &field)
+  {
+    m_fragments = detail::get_fragments(mesh,
+                                        field,
+                                        *m_hits,
+                                        m_points,
+                                        m_normals,
+                                        m_world_normals);
   }
 };
 
+// the planes in the object space of the data set. Normals are
+// unit length so plane distances can be compared.
+void object_planes(DataSet &data_set,
+                   const std::vector<Vec<float32,3>> &points,
+                   const std::vector<Vec<float32,3>> &normals,
+                   Array<Vec<Float,3>> &obj_points,
+                   Array<Vec<Float,3>> &obj_normals)
+{
+  const int32 num_planes = points.size();
+  obj_points.resize(num_planes);
+  obj_normals.resize(num_planes);
+  Vec<Float,3> *points_ptr = obj_points.get_host_ptr();
+  Vec<Float,3> *normals_ptr = obj_normals.get_host_ptr();
+
+  for(int32 p = 0; p < num_planes; ++p)
+  {
+    Vec<Float,3> t_point, t_normal;
+    for(int32 i = 0; i < 3; ++i)
+    {
+      t_point[i] = points[p][i];
+      t_normal[i] = normals[p][i];
+    }
+    // instanced domains are sliced in object space
+    if(data_set.has_transform())
+    {
+      const Matrix<Float,4,4> inverse = data_set.inverse_transform();
+      t_point = transform_point(inverse, t_point);
+      t_normal = transform_vector(inverse, t_normal);
+      t_normal.normalize();
+    }
+    points_ptr[p] = t_point;
+    normals_ptr[p] = t_normal;
+  }
+}
+
 struct SliceFragmentFunctor
 {
   SlicePlane *m_slicer;
@@ -214,13 +420,18 @@ struct SliceFragmentFunctor
 SlicePlane::SlicePlane(Collection &collection)
   : Traceable(collection)
 {
-  m_point[0] = 0.f;
-  m_point[1] = 0.f;
-  m_point[2] = 0.f;
-
-  m_normal[0] = 0.f;
-  m_normal[1] = 1.f;
-  m_normal[2] = 0.f;
+  Vec<float32,3> point;
+  point[0] = 0.f;
+  point[1] = 0.f;
+  point[2] = 0.f;
+
+  Vec<float32,3> normal;
+  normal[0] = 0.f;
+  normal[1] = 1.f;
+  normal[2] = 0.f;
+
+  m_points.push_back(point);
+  m_normals.push_back(normal);
 }
 
 SlicePlane::~SlicePlane()
@@ -229,12 +440,22 @@ SlicePlane::~SlicePlane()
 
 
 Array<RayHit>
-SlicePlane::nearest_hit(Array<Ray> &rays)
+SlicePlane::nearest_hit(Array<Ray> &rays, const int32 domain)
 {
-  DataSet data_set = m_collection.domain(m_active_domain);
+  DataSet data_set = m_collection.domain(domain);
   Mesh *mesh = data_set.mesh();
 
-  detail::SliceFunctor func(&rays, m_point, m_normal);
+  // instanced domains are sliced in object space, so move
+  // both the rays and the planes there
+  Array<Ray> obj_rays = rays;
+  if(data_set.has_transform())
+  {
+    obj_rays = transform_rays(rays, data_set.inverse_transform());
+  }
+  Array<Vec<Float,3>> points, normals;
+  detail::object_planes(data_set, m_points, m_normals, points, normals);
+
+  detail::SliceFunctor func(&obj_rays, points, normals);
   dispatch_3d(mesh, func);
   return func.m_hits;
 }
@@ -248,35 +469,86 @@ SlicePlane::fragments(Array<RayHit> &hits)
   DataSet data_set = m_collection.domain(m_active_domain);
   Field *field = data_set.field(m_field_name);
 
-  detail::SliceFragmentFunctor func(this,&hits);
-  dispatch_3d_scalar(field, func);
+  Array<Fragment> fragments;
+  if(m_points.size() == 1)
+  {
+    detail::SliceFragmentFunctor func(this,&hits);
+    dispatch_3d_scalar(field, func);
+    fragments = func.m_fragments;
+  }
+  else
+  {
+    Array<Vec<Float,3>> points, normals;
+    detail::object_planes(data_set, m_points, m_normals, points, normals);
+
+    Array<Vec<float32,3>> world_normals(m_normals.data(), m_normals.size());
+
+    detail::MultiSliceFragmentFunctor func(&hits, points, normals, world_normals);
+    dispatch_3d(data_set.mesh(), field, func);
+    fragments = func.m_fragments;
+  }
   DRAY_LOG_CLOSE();
-  return func.m_fragments;
+  return fragments;
 }
 
 void
 SlicePlane::point(const Vec<float32,3> &point)
 {
-  m_point = point;
+  m_points[0] = point;
 }
 
 Vec<float32,3>
 SlicePlane::point() const
 {
-  return m_point;
+  return m_points[0];
 }
 
 void
 SlicePlane::normal(const Vec<float32,3> &normal)
 {
-  m_normal = normal;
-  m_normal.normalize();
+  m_normals[0] = normal;
+  m_normals[0].normalize();
 }
 
 Vec<float32,3>
 SlicePlane::normal() const
 {
-  return m_normal;
+  return m_normals[0];
+}
+
+void
+SlicePlane::add_plane(const Vec<float32,3> &point, const Vec<float32,3> &normal)
+{
+  m_points.push_back(point);
+  m_normals.push_back(normal);
+  m_normals.back().normalize();
+}
+
+void
+SlicePlane::clear_planes()
+{
+  m_points.resize(1);
+  m_normals.resize(1);
+}
+
+int32
+SlicePlane::num_planes() const
+{
+  return static_cast<int32>(m_points.size());
+}
+
+Vec<float32,3>
+SlicePlane::point(const int32 plane) const
+{
+  assert(plane >= 0 && plane < num_planes());
+  return m_points[plane];
+}
+
+Vec<float32,3>
+SlicePlane::normal(const int32 plane) const
+{
+  assert(plane >= 0 && plane < num_planes());
+  return m_normals[plane];
 }
 
 }//namespace dray
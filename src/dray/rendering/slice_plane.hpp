@@ -8,19 +8,33 @@
 
 #include <dray/rendering/traceable.hpp>
 
+#include <vector>
+
 namespace dray
 {
 
+/**
+ * \class SlicePlane
+ * \brief Slices the domains with one or more planes
+ *
+ * All planes are handled in a single traceable. Each ray visits its
+ * plane intersections front to back and keeps the nearest one that
+ * lies inside the mesh. Every round only locates the rays that are
+ * still unresolved, so a stack of planes costs about one locate pass
+ * plus the rays that pass through empty space.
+ */
 class SlicePlane : public Traceable
 {
-  Vec<float32,3> m_point;
-  Vec<float32,3> m_normal;
+  // plane 0 is the one set through point() and normal()
+  std::vector<Vec<float32,3>> m_points;
+  std::vector<Vec<float32,3>> m_normals;
 public:
   SlicePlane() = delete;
   SlicePlane(Collection &collection);
   virtual ~SlicePlane();
 
-  virtual Array<RayHit> nearest_hit(Array<Ray> &rays) override;
+  using Traceable::nearest_hit;
+  virtual Array<RayHit> nearest_hit(Array<Ray> &rays, const int32 domain) override;
   virtual Array<Fragment> fragments(Array<RayHit> &hits) override;
 
   void point(const Vec<float32,3> &point);
@@ -28,6 +42,13 @@ public:
   Vec<float32,3> point() const;
   Vec<float32,3> normal() const;
 
+  // add another plane to slice with
+  void add_plane(const Vec<float32,3> &point, const Vec<float32,3> &normal);
+  // remove all planes but the first
+  void clear_planes();
+  int32 num_planes() const;
+  Vec<float32,3> point(const int32 plane) const;
+  Vec<float32,3> normal(const int32 plane) const;
 
 };
 
@@ -494,12 +494,19 @@ Surface::~Surface()
 }
 
 Array<RayHit>
-Surface::nearest_hit(Array<Ray> &rays)
+Surface::nearest_hit(Array<Ray> &rays, const int32 domain)
 {
-  DataSet data_set = m_collection.domain(m_active_domain);
+  DataSet data_set = m_collection.domain(domain);
   Mesh *mesh = data_set.mesh();
 
-  detail::SurfaceFunctor func(&rays);
+  // instanced domains are traced in object space
+  Array<Ray> obj_rays = rays;
+  if(data_set.has_transform())
+  {
+    obj_rays = transform_rays(rays, data_set.inverse_transform());
+  }
+
+  detail::SurfaceFunctor func(&obj_rays);
   dispatch_2d(mesh, func);
   return func.m_hits;
 }
@@ -24,7 +24,8 @@ public:
   Surface(Collection &collection);
   virtual ~Surface();
 
-  virtual Array<RayHit> nearest_hit(Array<Ray> &rays) override;
+  using Traceable::nearest_hit;
+  virtual Array<RayHit> nearest_hit(Array<Ray> &rays, const int32 domain) override;
 
   virtual void shade(const Array<Ray> &rays,
                      const Array<RayHit> &hits,
@@ -7,6 +7,7 @@
 #include <dray/dispatcher.hpp>
 #include <dray/error_check.hpp>
 #include <dray/device_color_map.hpp>
+#include <dray/transform_3d.hpp>
 
 #include <dray/utils/data_logger.hpp>
 
@@ -162,6 +163,29 @@ struct FragmentFunctor
   }
 };
 
+// move normals computed in object space into the world
+void transform_normals(Array<Fragment> &fragments, const Matrix<Float,4,4> &transform)
+{
+  const int32 size = fragments.size();
+  Fragment *fragments_ptr = fragments.get_device_ptr();
+  const Matrix<Float,4,4> mat = transform;
+
+  RAJA::forall<for_policy>(RAJA::RangeSegment(0, size), [=] DRAY_LAMBDA (int32 i)
+  {
+    Vec<Float,3> normal;
+    for(int32 c = 0; c < 3; ++c)
+    {
+      normal[c] = fragments_ptr[i].m_normal[c];
+    }
+    normal = transform_vector(mat, normal);
+    for(int32 c = 0; c < 3; ++c)
+    {
+      fragments_ptr[i].m_normal[c] = static_cast<float32>(normal[c]);
+    }
+  });
+  DRAY_ERROR_CHECK();
+}
+
 } // namespace detail
 
 // ------------------------------------------------------------------------
@@ -235,6 +259,12 @@ Traceable::fragments(Array<RayHit> &hits)
 
   detail::FragmentFunctor func(&hits);
   dispatch(mesh, field, func);
+
+  if(data_set.has_transform())
+  {
+    // rigid transforms move normals like any other direction
+    detail::transform_normals(func.m_fragments, data_set.transform());
+  }
   DRAY_LOG_CLOSE();
   return func.m_fragments;
 }
@@ -431,6 +461,12 @@ void Traceable::colors(const Array<Ray> &rays,
   DRAY_LOG_CLOSE();
 }
 
+Array<RayHit>
+Traceable::nearest_hit(Array<Ray> &rays)
+{
+  return nearest_hit(rays, m_active_domain);
+}
+
 int32
 Traceable::num_domains()
 {
@@ -36,8 +36,12 @@ public:
   Traceable() = delete;
   Traceable(Collection &collection);
   virtual ~Traceable();
-  /// returns the nearests hit along a batch of rays
-  virtual Array<RayHit> nearest_hit(Array<Ray> &rays) = 0;
+  /// returns the nearests hit along a batch of rays for the active domain
+  Array<RayHit> nearest_hit(Array<Ray> &rays);
+  /// returns the nearests hit along a batch of rays for the given domain.
+  /// Does not touch the active domain, so different domains can be
+  /// traced at the same time
+  virtual Array<RayHit> nearest_hit(Array<Ray> &rays, const int32 domain) = 0;
   /// returns the fragments for a batch of hits
   virtual Array<Fragment> fragments(Array<RayHit> &hits);
 
@@ -11,6 +11,7 @@
 #include <dray/array_utils.hpp>
 #include <dray/error_check.hpp>
 #include <dray/device_color_map.hpp>
+#include <dray/transform_3d.hpp>
 
 #include <dray/utils/data_logger.hpp>
 #include <dray/utils/timer.hpp>
@@ -18,52 +19,87 @@
 #include <dray/data_model/device_mesh.hpp>
 #include <dray/data_model/device_field.hpp>
 
+#include <algorithm>
+#include <vector>
+
 namespace dray
 {
 
 namespace detail
 {
-void init_partials(Array<VolumePartial> &partials)
+// march the ray forward from distance until it enters the mesh and
+// integrate until it leaves again (or becomes opaque). Returns false
+// if the ray did not find another segment.
+template<typename MeshElement, typename FieldElement>
+DRAY_EXEC_ONLY bool
+integrate_segment(const Ray &ray,
+                  const Float sample_dist,
+                  const DeviceMesh<MeshElement> &device_mesh,
+                  const VolumeShader<MeshElement, FieldElement> &shader,
+                  const bool use_lighting,
+                  Float &distance,
+                  VolumePartial &partial,
+                  stats::Stats &mstat)
 {
-  const int32 size = partials.size();
-  VolumePartial *partial_ptr = partials.get_device_ptr();
-
-  RAJA::forall<for_policy>(RAJA::RangeSegment(0, size), [=] DRAY_LAMBDA (int32 i)
+  constexpr Vec4f clear = {0.f, 0.f, 0.f, 0.f};
+  bool found = false;
+  // find next segment
+  Location loc;
+  while(distance < ray.m_far && !found)
   {
-    VolumePartial p;
-    p.m_pixel_id = -1;
-    p.m_depth = infinity32();
-    p.m_color = {0.f, 0.f, 0.f, 0.f};
-    partial_ptr[i] = p;
-  });
-  DRAY_ERROR_CHECK();
-}
-
-Array<VolumePartial> compact_partials(const Array<VolumePartial> &partials)
-{
-  const int32 size = partials.size();
+    Vec<Float,3> point = ray.m_orig + distance * ray.m_dir;
+    loc = device_mesh.locate(point);
+    if(loc.m_cell_id != -1)
+    {
+      found = true;
+    }
+    else
+    {
+      distance += sample_dist;
+    }
+  }
 
-  if(size == 0)
+  if(distance >= ray.m_far)
   {
-    return partials;
+    return false;
   }
 
-  Array<int32> valid_segments;
-  valid_segments.resize(size);
-  int32 * valid_ptr = valid_segments.get_device_ptr();
-
-  const VolumePartial *partial_ptr = partials.get_device_ptr_const();
+  partial.m_pixel_id = ray.m_pixel_id;
+  partial.m_depth = distance;
+  partial.m_color = clear;
 
-  RAJA::forall<for_policy>(RAJA::RangeSegment(0, size), [=] DRAY_LAMBDA (int32 i)
+  mstat.acc_candidates(1);
+  do
   {
-    const float32 depth = partial_ptr[i].m_depth;
-    valid_ptr[i] = (depth == infinity32()) ? 0 : 1;
-  });
-  DRAY_ERROR_CHECK();
+    // we know we have a valid location
+    Vec<float32, 4> sample_color;
+    // shade
+    if(use_lighting)
+    {
+      sample_color = shader.shaded_color(loc, ray);
+    }
+    else
+    {
+      sample_color = shader.color(loc);
+    }
+
+    blend(partial.m_color, sample_color);
 
-  Array<int32> compact_idxs = index_flags(valid_segments);
+    distance += sample_dist;
+    Vec<Float,3> point = ray.m_orig + distance * ray.m_dir;
+    loc = device_mesh.locate(point);
+    found = loc.m_cell_id != -1;
+  }
+  while(distance < ray.m_far && found && partial.m_color[3] < 0.95f);
+
+  return true;
+}
 
-  return gather(partials, compact_idxs);
+DRAY_EXEC bool ray_finished(const Ray &ray,
+                            const Float distance,
+                            const VolumePartial &partial)
+{
+  return distance >= ray.m_far || partial.m_color[3] > 0.95f;
 }
 
 template<typename MeshElement, typename FieldElement>
@@ -107,19 +143,9 @@ integrate_partials(UnstructuredMesh<MeshElement> &mesh,
   const int32 ray_size = active_rays.size();
   const Ray *rays_ptr = active_rays.get_device_ptr_const();
 
-  constexpr int32 max_segments = 5;
-  Array<VolumePartial> partials;
-  partials.resize(ray_size * max_segments);
-  init_partials(partials);
-  VolumePartial *partials_ptr = partials.get_device_ptr();
-
-
   // complicated device stuff
   DeviceMesh<MeshElement> device_mesh(mesh);
 
-  DeviceColorMap d_color_map(corrected);
-
-
   VolumeShader<MeshElement, FieldElement> shader(mesh,
                                                  field,
                                                  corrected,
@@ -129,99 +155,189 @@ integrate_partials(UnstructuredMesh<MeshElement> &mesh,
   mstats.resize(ray_size);
   stats::Stats *mstats_ptr = mstats.get_device_ptr();
 
-  // TODO: somehow load balance based on far - near
-  Timer timer;
+  // Every segment is integrated once. The first segment of each ray goes
+  // into a slot of its own, since most rays have zero or one. The tails of
+  // rays that re-enter the mesh are appended to a pool through an atomic
+  // counter. A ray that finds the pool full stops before the segment that
+  // did not fit and resumes there in the next round, with a bigger pool.
+  Array<VolumePartial> first_partials;
+  first_partials.resize(ray_size);
+  VolumePartial *first_ptr = first_partials.get_device_ptr();
+
+  Array<int32> segment_counts;
+  segment_counts.resize(ray_size);
+  int32 *counts_ptr = segment_counts.get_device_ptr();
+
+  // where to pick up the march in the next round
+  Array<Float> resume;
+  resume.resize(ray_size);
+  Float *resume_ptr = resume.get_device_ptr();
+
   RAJA::forall<for_policy>(RAJA::RangeSegment(0, ray_size), [=] DRAY_LAMBDA (int32 i)
   {
     const Ray ray = rays_ptr[i];
+    VolumePartial first;
+    first.m_pixel_id = ray.m_pixel_id;
+    first.m_depth = infinity32();
+    first.m_color = {0.f, 0.f, 0.f, 0.f};
+    first_ptr[i] = first;
+    counts_ptr[i] = 0;
     // advance the ray one step
-    Float distance = ray.m_near + sample_dist;
-    constexpr Vec4f clear = {0.f, 0.f, 0.f, 0.f};
-    const int32 partial_offset = max_segments * i;
-    int32 segment = 0;
-
-    VolumePartial partial;
-
-    partial.m_color = {{0.f, 0.f, 0.f, 0.f}};
-    partial.m_pixel_id = ray.m_pixel_id;
-
+    resume_ptr[i] = ray.m_near + sample_dist;
     stats::Stats mstat;
     mstat.construct();
+    mstats_ptr[i] = mstat;
+  });
+  DRAY_ERROR_CHECK();
 
-    for(int s = 0; s < max_segments; ++s)
+  // tail partials with the ray and segment index they belong to,
+  // one entry per round
+  std::vector<Array<VolumePartial>> tails;
+  std::vector<Array<int32>> tail_rays;
+  std::vector<Array<int32>> tail_segments;
+  std::vector<int32> tail_sizes;
+
+  Array<int32> todo = array_counting(ray_size, 0, 1);
+  int32 capacity = std::max(ray_size / 16, 1024);
+  int32 rounds = 0;
+
+  // TODO: somehow load balance based on far - near
+  Timer timer;
+  while(todo.size() > 0)
+  {
+    const int32 num_todo = todo.size();
+    const int32 *todo_ptr = todo.get_device_ptr_const();
+
+    Array<VolumePartial> pool;
+    pool.resize(capacity);
+    VolumePartial *pool_ptr = pool.get_device_ptr();
+    Array<int32> pool_rays;
+    pool_rays.resize(capacity);
+    int32 *pool_rays_ptr = pool_rays.get_device_ptr();
+    Array<int32> pool_segments;
+    pool_segments.resize(capacity);
+    int32 *pool_segments_ptr = pool_segments.get_device_ptr();
+
+    Array<int32> counter;
+    counter.resize(1);
+    array_memset_zero(counter);
+    int32 *counter_ptr = counter.get_device_ptr();
+
+    Array<int32> pending;
+    pending.resize(num_todo);
+    int32 *pending_ptr = pending.get_device_ptr();
+
+    const int32 pool_size = capacity;
+    RAJA::forall<for_policy>(RAJA::RangeSegment(0, num_todo), [=] DRAY_LAMBDA (int32 t)
     {
-      bool found = false;
-      // find next segment
-      Location loc;
-      while(distance < ray.m_far && !found)
+      const int32 i = todo_ptr[t];
+      const Ray ray = rays_ptr[i];
+      Float distance = resume_ptr[i];
+      int32 segments = counts_ptr[i];
+      stats::Stats mstat = mstats_ptr[i];
+      int32 full = 0;
+
+      VolumePartial partial;
+      while(true)
       {
-        Vec<Float,3> point = ray.m_orig + distance * ray.m_dir;
-        loc = device_mesh.locate(point);
-        if(loc.m_cell_id != -1)
+        const Float segment_start = distance;
+        const stats::Stats segment_stat = mstat;
+        if(!integrate_segment(ray,
+                              sample_dist,
+                              device_mesh,
+                              shader,
+                              use_lighting,
+                              distance,
+                              partial,
+                              mstat))
         {
-          found = true;
+          break;
         }
-        else
-        {
-          distance += sample_dist;
-        }
-      }
-
-      if(distance >= ray.m_far)
-      {
-        // we are done
-        break;
-      }
 
-      partial.m_depth = distance;
-      partial.m_color = clear;
-
-      int count = 0;
-      mstat.acc_candidates(1);
-      do
-      {
-        // we know we have a valid location
-
-        Vec<float32, 4> sample_color;
-        // shade
-        if(use_lighting)
+        if(segments == 0)
         {
-          sample_color = shader.shaded_color(loc, ray);
+          first_ptr[i] = partial;
         }
         else
         {
-          sample_color = shader.color(loc);
+          const int32 slot = RAJA::atomicAdd<atomic_policy>(counter_ptr, 1);
+          if(slot >= pool_size)
+          {
+            // redo this segment next round
+            distance = segment_start;
+            mstat = segment_stat;
+            full = 1;
+            break;
+          }
+          pool_ptr[slot] = partial;
+          pool_rays_ptr[slot] = i;
+          pool_segments_ptr[slot] = segments;
         }
+        segments++;
 
-        blend(partial.m_color, sample_color);
-        count++;
-
-        distance += sample_dist;
-        Vec<Float,3> point = ray.m_orig + distance * ray.m_dir;
-        loc = device_mesh.locate(point);
-        found = loc.m_cell_id != -1;
+        if(ray_finished(ray, distance, partial))
+        {
+          break;
+        }
       }
-      while(distance < ray.m_far && found && partial.m_color[3] < 0.95f);
 
-      partials_ptr[partial_offset + segment] = partial;
-      segment++;
+      counts_ptr[i] = segments;
+      resume_ptr[i] = distance;
+      mstats_ptr[i] = mstat;
+      pending_ptr[t] = full;
+    });
+    DRAY_ERROR_CHECK();
+
+    tails.push_back(pool);
+    tail_rays.push_back(pool_rays);
+    tail_segments.push_back(pool_segments);
+    tail_sizes.push_back(std::min(counter.get_value(0), capacity));
+
+    todo = index_flags(pending, todo);
+    capacity *= 2;
+    rounds++;
+  }
+  DRAY_LOG_ENTRY("integrate_partials",timer.elapsed());
+  DRAY_LOG_ENTRY("tail_rounds", rounds);
+  stats::StatStore::add_ray_stats(active_rays, mstats);
 
-      if(distance >= ray.m_far || partial.m_color[3] > 0.95f)
-      {
-        // we are done
-        break;
-      }
+  // size the output exactly and scatter the segments in ray order
+  timer.reset();
+  int32 total_segments = 0;
+  Array<int32> offsets = array_exc_scan_plus(segment_counts, total_segments);
+  const int32 *offsets_ptr = offsets.get_device_ptr_const();
+  DRAY_LOG_ENTRY("segments", total_segments);
 
-    } // for segments
-    mstats_ptr[i] = mstat;
+  Array<VolumePartial> partials;
+  partials.resize(total_segments);
+  VolumePartial *partials_ptr = partials.get_device_ptr();
+
+  RAJA::forall<for_policy>(RAJA::RangeSegment(0, ray_size), [=] DRAY_LAMBDA (int32 i)
+  {
+    if(counts_ptr[i] > 0)
+    {
+      partials_ptr[offsets_ptr[i]] = first_ptr[i];
+    }
   });
   DRAY_ERROR_CHECK();
-  DRAY_LOG_ENTRY("integrate_partials",timer.elapsed());
-  stats::StatStore::add_ray_stats(active_rays, mstats);
 
-  timer.reset();
-  partials = detail::compact_partials(partials);
-  DRAY_LOG_ENTRY("compact",timer.elapsed());
+  int32 total_tails = 0;
+  for(size_t r = 0; r < tails.size(); ++r)
+  {
+    const int32 size = tail_sizes[r];
+    const VolumePartial *pool_ptr = tails[r].get_device_ptr_const();
+    const int32 *pool_rays_ptr = tail_rays[r].get_device_ptr_const();
+    const int32 *pool_segments_ptr = tail_segments[r].get_device_ptr_const();
+    RAJA::forall<for_policy>(RAJA::RangeSegment(0, size), [=] DRAY_LAMBDA (int32 slot)
+    {
+      const int32 i = pool_rays_ptr[slot];
+      partials_ptr[offsets_ptr[i] + pool_segments_ptr[slot]] = pool_ptr[slot];
+    });
+    DRAY_ERROR_CHECK();
+    total_tails += size;
+  }
+  DRAY_LOG_ENTRY("tail_segments", total_tails);
+  DRAY_LOG_ENTRY("scatter", timer.elapsed());
 
   DRAY_LOG_CLOSE();
   return partials;
@@ -340,8 +456,39 @@ Volume::integrate(Array<Ray> &rays, Array<PointLight> &lights)
   Mesh *mesh = data_set.mesh();
   Field *field = data_set.field(m_field);
 
-  detail::IntegratePartialsFunctor func(&rays,
-                                        lights,
+  // instanced domains are integrated in object space. Moving the
+  // lights along with the rays keeps the shading the same
+  Array<Ray> obj_rays = rays;
+  Array<PointLight> obj_lights = lights;
+  if(data_set.has_transform())
+  {
+    const Matrix<Float,4,4> inverse = data_set.inverse_transform();
+    obj_rays = transform_rays(rays, inverse);
+
+    const int32 num_lights = lights.size();
+    obj_lights = Array<PointLight>();
+    obj_lights.resize(num_lights);
+    const PointLight *light_ptr = lights.get_host_ptr_const();
+    PointLight *obj_light_ptr = obj_lights.get_host_ptr();
+    for(int32 i = 0; i < num_lights; ++i)
+    {
+      PointLight light = light_ptr[i];
+      Vec<Float,3> pos;
+      for(int32 c = 0; c < 3; ++c)
+      {
+        pos[c] = light.m_pos[c];
+      }
+      pos = transform_point(inverse, pos);
+      for(int32 c = 0; c < 3; ++c)
+      {
+        light.m_pos[c] = static_cast<float32>(pos[c]);
+      }
+      obj_light_ptr[i] = light;
+    }
+  }
+
+  detail::IntegratePartialsFunctor func(&obj_rays,
+                                        obj_lights,
                                         m_color_map,
                                         m_samples,
                                         m_bounds,
@@ -356,6 +503,11 @@ void Volume::samples(int32 num_samples)
   m_samples = num_samples;
 }
 
+int32 Volume::samples() const
+{
+  return m_samples;
+}
+
 // ------------------------------------------------------------------------
 
 void Volume::use_lighting(bool do_it)
@@ -430,5 +582,10 @@ int32 Volume::num_domains()
   return m_collection.local_size();
 }
 
+Collection& Volume::collection()
+{
+  return m_collection;
+}
+
 // ------------------------------------------------------------------------
 } // namespace dray
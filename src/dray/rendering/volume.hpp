@@ -49,6 +49,7 @@ public:
 
   /// set the number of samples based on the bounds.
   void samples(int32 num_samples);
+  int32 samples() const;
 
   void field(const std::string field);
   std::string field() const;
@@ -56,6 +57,7 @@ public:
   void use_lighting(bool do_it);
 
   ColorMap& color_map();
+  Collection& collection();
 };
 
 
@@ -188,6 +188,28 @@ template <typename T> DRAY_EXEC Matrix<T, 4, 4> rotate_z (T angleDegrees)
   return rotate (angleDegrees, T (0), T (0), T (1));
 }
 
+/// \brief Returns a reflection matrix.
+///
+/// Mirrors points across the plane through \c point with the unit
+/// normal \c normal. The matrix is its own inverse.
+///
+template <typename T>
+DRAY_EXEC Matrix<T, 4, 4> reflect (const Vec<T, 3> &point, const Vec<T, 3> &normal)
+{
+  Matrix<T, 4, 4> matrix;
+  matrix.identity ();
+  const T d = dot (point, normal);
+  for (int32 i = 0; i < 3; ++i)
+  {
+    for (int32 j = 0; j < 3; ++j)
+    {
+      matrix (i, j) -= T (2) * normal[i] * normal[j];
+    }
+    matrix (i, 3) = T (2) * d * normal[i];
+  }
+  return matrix;
+}
+
 static DRAY_EXEC Matrix<float32, 4, 4>
 trackball_matrix (float32 p1x, float32 p1y, float32 p2x, float32 p2y)
 {
@@ -10,10 +10,12 @@ namespace dray
 {
 
 typedef unsigned char uint8;
+typedef unsigned short uint16;
 typedef unsigned int uint32;
 typedef unsigned long long int uint64;
 
 typedef char int8;
+typedef short int16;
 typedef int int32;
 typedef long long int int64;
 
@@ -26,6 +28,15 @@ typedef int64 combo_int;
 typedef int32 combo_int;
 #endif
 
+// Type for arithmetic on dof and connectivity offsets, e.g.,
+// element id * dofs per element. Connectivity entries themselves
+// stay int32, so only the products can exceed 2^31.
+#ifdef DRAY_INDEX_INT64
+typedef int64 index_int;
+#else
+typedef int32 index_int;
+#endif
+
 #ifdef DRAY_DOUBLE_PRECISION
 typedef double Float;
 #else
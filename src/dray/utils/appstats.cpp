@@ -232,6 +232,10 @@ StatStore::add_ray_stats(const Array<Ray> &rays, Array<Stats> &stats)
     ray_data[i] = std::make_pair(ray.m_pixel_id, mstat);
   }
 
+ // domains can be traced concurrently
+#ifdef DRAY_OPENMP_ENABLED
+ #pragma omp critical (dray_ray_stats)
+#endif
  m_ray_stats.push_back(std::move(ray_data));
 #else
  (void) rays;
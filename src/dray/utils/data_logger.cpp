@@ -4,6 +4,10 @@
 #include <fstream>
 #include <iostream>
 
+#ifdef DRAY_OPENMP_ENABLED
+#include <omp.h>
+#endif
+
 namespace dray
 {
 
@@ -81,6 +85,16 @@ DataLogger::current_block()
   return m_blocks.top();
 }
 
+bool
+DataLogger::active() const
+{
+#ifdef DRAY_OPENMP_ENABLED
+  return !omp_in_parallel();
+#else
+  return true;
+#endif
+}
+
 void
 DataLogger::set_rank(const int &rank)
 {
@@ -137,6 +151,7 @@ DataLogger::write_log()
 void
 DataLogger::open(const std::string &entryName)
 {
+    if(!active()) return;
     write_indent();
     // ensure that we have unique keys for valid yaml
     int key_count = m_key_counters.top()[entryName]++;
@@ -161,6 +176,7 @@ DataLogger::open(const std::string &entryName)
 void
 DataLogger::close()
 {
+  if(!active()) return;
   write_indent();
   this->m_stream<<"time: "<<m_timers.top().elapsed()<<"\n";
   m_timers.pop();
@@ -47,6 +47,7 @@ public:
   template<typename T>
   void add_entry(const std::string key, const T &value)
   {
+    if(!active()) return;
     write_indent();
     this->m_stream << key << ": " << value <<"\n";
     m_at_block_start = false;
@@ -60,6 +61,9 @@ protected:
   DataLogger(DataLogger const &);
 
   void write_indent();
+  // false inside of threaded regions, e.g., concurrent domain
+  // traversals, where the nesting of the log would be garbled
+  bool active() const;
   DataLogger::Block& current_block();
   std::stringstream m_stream;
   static class DataLogger m_instance;
@@ -0,0 +1,148 @@
+// Copyright 2019 Lawrence Livermore National Security, LLC and other
+// Devil Ray Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (BSD-3-Clause)
+
+#include <dray/utils/image_writer.hpp>
+#include <dray/error.hpp>
+
+namespace dray
+{
+
+ImageWriter::ImageWriter(const int32 num_threads, const int32 max_queue)
+  : m_max_queue(max_queue),
+    m_active(0),
+    m_written(0),
+    m_shutdown(false),
+    m_compression(PNGEncoder::Default)
+{
+  if(num_threads < 1 || max_queue < 1)
+  {
+    DRAY_ERROR("Image writer needs at least one thread and queue slot");
+  }
+
+  for(int32 i = 0; i < num_threads; ++i)
+  {
+    m_threads.push_back(std::thread(&ImageWriter::work, this));
+  }
+}
+
+ImageWriter::~ImageWriter()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_shutdown = true;
+  }
+  m_work.notify_all();
+  // pending images are still written before the workers exit
+  for(std::thread &thread : m_threads)
+  {
+    thread.join();
+  }
+}
+
+void ImageWriter::compression(const PNGEncoder::Compression level)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_compression = level;
+}
+
+void ImageWriter::write(Framebuffer &framebuffer, const std::string name)
+{
+  Job job;
+  job.m_width = framebuffer.width();
+  job.m_height = framebuffer.height();
+  job.m_file_name = name + ".png";
+  // the bytes are a quarter of the float colors and the framebuffer
+  // is free to be reused once this returns
+  job.m_rgba.resize(job.m_width * job.m_height * 4);
+  PNGEncoder::to_rgba8((const float32 *)framebuffer.colors().get_host_ptr_const(),
+                       job.m_width,
+                       job.m_height,
+                       false,
+                       &job.m_rgba[0]);
+
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_done.wait(lock, [this] { return int32(m_queue.size()) < m_max_queue; });
+  job.m_compression = m_compression;
+  m_queue.push_back(std::move(job));
+  lock.unlock();
+  m_work.notify_one();
+}
+
+void ImageWriter::wait()
+{
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_done.wait(lock, [this] { return m_queue.empty() && m_active == 0; });
+  std::exception_ptr error = m_error;
+  m_error = nullptr;
+  lock.unlock();
+  if(error)
+  {
+    std::rethrow_exception(error);
+  }
+}
+
+int32 ImageWriter::written()
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_written;
+}
+
+void ImageWriter::work()
+{
+  while(true)
+  {
+    Job job;
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_work.wait(lock, [this] { return m_shutdown || !m_queue.empty(); });
+      if(m_queue.empty())
+      {
+        // shutting down and nothing is left
+        return;
+      }
+      job = std::move(m_queue.front());
+      m_queue.pop_front();
+      m_active++;
+    }
+    // a slot opened up
+    m_done.notify_all();
+
+    // an exception escaping a worker would terminate the program
+    std::exception_ptr error = nullptr;
+    try
+    {
+      PNGEncoder encoder;
+      encoder.compression(job.m_compression);
+      encoder.encode(&job.m_rgba[0], job.m_width, job.m_height);
+      if(!encoder.save(job.m_file_name))
+      {
+        DRAY_ERROR("Image writer failed to save '"<<job.m_file_name<<"'");
+      }
+    }
+    catch(...)
+    {
+      error = std::current_exception();
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_active--;
+      if(error)
+      {
+        if(!m_error)
+        {
+          m_error = error;
+        }
+      }
+      else
+      {
+        m_written++;
+      }
+    }
+    m_done.notify_all();
+  }
+}
+
+} // namespace dray
@@ -0,0 +1,88 @@
+// Copyright 2019 Lawrence Livermore National Security, LLC and other
+// Devil Ray Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (BSD-3-Clause)
+
+#ifndef DRAY_IMAGE_WRITER_HPP
+#define DRAY_IMAGE_WRITER_HPP
+
+#include <dray/rendering/framebuffer.hpp>
+#include <dray/utils/png_encoder.hpp>
+#include <dray/types.hpp>
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace dray
+{
+
+/**
+ * \class ImageWriter
+ * \brief Writes framebuffers to png files in the background
+ *
+ * write() converts the colors to bytes on the calling thread and
+ * queues them. A pool of threads encodes and saves the queued images,
+ * so rendering the next frame overlaps encoding the last one. The
+ * queue is bounded: write() blocks while it is full, which limits
+ * the memory held by images that are not written yet.
+ *
+ * A failed image does not stop the workers. The first error is kept
+ * and rethrown by the next wait(); errors that no wait() collects are
+ * dropped when the writer is destroyed.
+ */
+class ImageWriter
+{
+protected:
+  struct Job
+  {
+    std::vector<uint8> m_rgba;
+    int32 m_width;
+    int32 m_height;
+    std::string m_file_name;
+    PNGEncoder::Compression m_compression;
+  };
+
+  std::deque<Job> m_queue;
+  std::vector<std::thread> m_threads;
+  std::mutex m_mutex;
+  // signals new jobs and shutdown to the workers
+  std::condition_variable m_work;
+  // signals free queue slots and finished jobs to the writers
+  std::condition_variable m_done;
+  int32 m_max_queue;
+  int32 m_active;
+  int32 m_written;
+  bool m_shutdown;
+  PNGEncoder::Compression m_compression;
+  // first failure since the last wait()
+  std::exception_ptr m_error;
+
+  void work();
+public:
+  // threads that encode and the number of images that can wait
+  // in the queue
+  ImageWriter(const int32 num_threads = 2, const int32 max_queue = 4);
+  ~ImageWriter();
+
+  ImageWriter(const ImageWriter &) = delete;
+  ImageWriter &operator=(const ImageWriter &) = delete;
+
+  // applies to images queued afterwards
+  void compression(const PNGEncoder::Compression level);
+
+  // queue the colors of the framebuffer to be saved as name.png
+  void write(Framebuffer &framebuffer, const std::string name);
+  // blocks until every queued image is written and rethrows the
+  // first error a worker hit
+  void wait();
+  // images written so far
+  int32 written();
+};
+
+} // namespace dray
+#endif
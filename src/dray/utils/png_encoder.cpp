@@ -1,7 +1,10 @@
 #include <dray/utils/png_encoder.hpp>
+#include <dray/error_check.hpp>
+#include <dray/policies.hpp>
 
 // standard includes
 #include <stdlib.h>
+#include <string.h>
 #include <iostream>
 
 // thirdparty includes
@@ -13,7 +16,8 @@ namespace dray
 //-----------------------------------------------------------------------------
 PNGEncoder::PNGEncoder()
 :m_buffer(NULL),
- m_buffer_size(0)
+ m_buffer_size(0),
+ m_compression(Default)
 {}
 
 //-----------------------------------------------------------------------------
@@ -22,6 +26,43 @@ PNGEncoder::~PNGEncoder()
     cleanup();
 }
 
+//-----------------------------------------------------------------------------
+void
+PNGEncoder::compression(const Compression level)
+{
+  m_compression = level;
+}
+
+//-----------------------------------------------------------------------------
+PNGEncoder::Compression
+PNGEncoder::compression() const
+{
+  return m_compression;
+}
+
+//-----------------------------------------------------------------------------
+void
+PNGEncoder::to_rgba8(const float32 *rgba_in,
+                     const int32 width,
+                     const int32 height,
+                     const bool flip,
+                     uint8 *rgba_out)
+{
+  RAJA::forall<for_cpu_policy>(RAJA::RangeSegment(0, width * height),
+    [=] (int32 index)
+  {
+    const int32 x = index % width;
+    const int32 y = index / width;
+    const int32 out_y = flip ? height - y - 1 : y;
+    const int32 in_offset = index * 4;
+    const int32 out_offset = (out_y * width + x) * 4;
+    rgba_out[out_offset + 0] = (uint8)(rgba_in[in_offset + 0] * 255.f);
+    rgba_out[out_offset + 1] = (uint8)(rgba_in[in_offset + 1] * 255.f);
+    rgba_out[out_offset + 2] = (uint8)(rgba_in[in_offset + 2] * 255.f);
+    rgba_out[out_offset + 3] = (uint8)(rgba_in[in_offset + 3] * 255.f);
+  });
+}
+
 //-----------------------------------------------------------------------------
 void
 PNGEncoder::encode(const uint8 *rgba_in,
@@ -40,20 +81,9 @@ PNGEncoder::encode(const uint8 *rgba_in,
            width*4);
   }
 
-   unsigned error = lodepng_encode_memory(&m_buffer,
-                                          &m_buffer_size,
-                                          &rgba_flip[0],
-                                          width,
-                                          height,
-                                          LCT_RGBA, // these settings match those for
-                                          8);       // lodepng_encode32_file
+  encode_flipped(rgba_flip, width, height);
 
   delete [] rgba_flip;
-
-  if(error)
-  {
-    std::cerr<<"lodepng_encode_memory failed\n";
-  }
 }
 
 //-----------------------------------------------------------------------------
@@ -67,48 +97,62 @@ PNGEncoder::encode(const float32 *rgba_in,
   // upside down relative to what lodepng wants
   uint8 *rgba_flip = new uint8[width * height *4];
 
+  to_rgba8(rgba_in, width, height, true, rgba_flip);
 
-  for(int32 x = 0; x < width; ++x)
-  {
+  encode_flipped(rgba_flip, width, height);
 
-#ifdef DRAY_OPENMP_ENABLED
-   #pragma omp parallel for
-#endif
-    for (int32 y = 0; y < height; ++y)
-    {
-      int32 inOffset = (y * width + x) * 4;
-      int32 outOffset = ((height - y - 1) * width + x) * 4;
-      rgba_flip[outOffset + 0] = (uint8)(rgba_in[inOffset + 0] * 255.f);
-      rgba_flip[outOffset + 1] = (uint8)(rgba_in[inOffset + 1] * 255.f);
-      rgba_flip[outOffset + 2] = (uint8)(rgba_in[inOffset + 2] * 255.f);
-      rgba_flip[outOffset + 3] = (uint8)(rgba_in[inOffset + 3] * 255.f);
-    }
+  delete [] rgba_flip;
+}
+
+//-----------------------------------------------------------------------------
+void
+PNGEncoder::encode_flipped(const uint8 *rgba,
+                           const int32 width,
+                           const int32 height)
+{
+  LodePNGState state;
+  lodepng_state_init(&state);
+  // these settings match those for lodepng_encode32_file
+  state.info_raw.colortype = LCT_RGBA;
+  state.info_raw.bitdepth = 8;
+  state.info_png.color.colortype = LCT_RGBA;
+  state.info_png.color.bitdepth = 8;
+
+  if(m_compression == Fast)
+  {
+    state.encoder.filter_strategy = LFS_ZERO;
+    state.encoder.zlibsettings.windowsize = 512;
+    state.encoder.zlibsettings.lazymatching = 0;
+  }
+  else if(m_compression == None)
+  {
+    state.encoder.filter_strategy = LFS_ZERO;
+    state.encoder.zlibsettings.btype = 0;
   }
-   unsigned error = lodepng_encode_memory(&m_buffer,
-                                          &m_buffer_size,
-                                          &rgba_flip[0],
-                                          width,
-                                          height,
-                                          LCT_RGBA, // these settings match those for
-                                          8);       // lodepng_encode32_file
 
-  delete [] rgba_flip;
+  unsigned error = lodepng_encode(&m_buffer,
+                                  &m_buffer_size,
+                                  rgba,
+                                  width,
+                                  height,
+                                  &state);
+  lodepng_state_cleanup(&state);
 
   if(error)
   {
-    std::cerr<<"lodepng_encode_memory failed\n";
+    std::cerr<<"lodepng_encode failed\n";
   }
 }
 
 //-----------------------------------------------------------------------------
-void
+bool
 PNGEncoder::save(const std::string &filename)
 {
   if(m_buffer == NULL)
   {
     std::cerr<<"Save must be called after encode()\n";
       /// we have a problem ...!
-      return;
+      return false;
   }
 
   unsigned error = lodepng_save_file(m_buffer,
@@ -117,7 +161,9 @@ PNGEncoder::save(const std::string &filename)
   if(error)
   {
     std::cerr<<"Error saving PNG buffer to file: " << filename<<"\n";
+    return false;
   }
+  return true;
 }
 
 //-----------------------------------------------------------------------------
@@ -10,9 +10,30 @@ namespace dray
 class PNGEncoder
 {
 public:
+    // Default is lodepng's full compression. Fast uses the none filter
+    // and a small LZ77 window, which is several times faster for a few
+    // percent larger files. None stores the image uncompressed.
+    enum Compression
+    {
+      Default,
+      Fast,
+      None
+    };
+
     PNGEncoder();
     ~PNGEncoder();
 
+    void           compression(const Compression level);
+    Compression    compression() const;
+
+    // converts float rgba in [0,1] to bytes, flipping the rows
+    // when flip is set. Runs in parallel on the host.
+    static void    to_rgba8(const float32 *rgba_in,
+                            const int32 width,
+                            const int32 height,
+                            const bool flip,
+                            uint8 *rgba_out);
+
     void           encode(const uint8 *rgba_in,
                           const int32 width,
                           const int32 height);
@@ -21,7 +42,8 @@ public:
                           const int32 width,
                           const int32 height);
 
-    void           save(const std::string &filename);
+    // false if the file could not be written
+    bool           save(const std::string &filename);
 
     void          *png_buffer();
     size_t         png_buffer_size();
@@ -29,8 +51,14 @@ public:
     void           cleanup();
 
 private:
+    // rgba must already be flipped
+    void           encode_flipped(const uint8 *rgba,
+                                  const int32 width,
+                                  const int32 height);
+
     unsigned char *m_buffer;
     size_t         m_buffer_size;
+    Compression    m_compression;
 };
 
 };
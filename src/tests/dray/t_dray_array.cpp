@@ -5,6 +5,11 @@
 
 #include "gtest/gtest.h"
 #include <dray/array.hpp>
+#include <dray/array_utils.hpp>
+#include <dray/error.hpp>
+#include <dray/data_model/grid_function.hpp>
+
+#include <limits>
 
 TEST (dray_array, dray_array_basic)
 {
@@ -18,3 +23,35 @@ TEST (dray_array, dray_array_basic)
   ASSERT_EQ (host2[0], 0);
   ASSERT_EQ (host2[1], 1);
 }
+
+TEST (dray_array, dray_resize_counting_overflow)
+{
+  // every dof gets its own int32 ctrl id
+  dray::GridFunction<1> gf;
+  EXPECT_THROW (gf.resize_counting (1 << 20, 1 << 12), dray::DRayError);
+
+  gf.resize_counting (4, 8);
+  EXPECT_EQ (gf.get_num_elem (), 4);
+  EXPECT_EQ (gf.m_ctrl_idx.get_value (31), 31);
+}
+
+TEST (dray_array, dray_array_utils_index_int)
+{
+  // sizes past the int32 range need 64-bit index arithmetic
+  if (sizeof (dray::index_int) < sizeof (dray::int64))
+  {
+    return;
+  }
+
+  const size_t size = size_t (std::numeric_limits<dray::int32>::max ()) + 16;
+  dray::Array<dray::uint8> bytes;
+  bytes.resize (size);
+  dray::array_memset (bytes, dray::uint8 (7));
+  EXPECT_EQ (bytes.get_value (0), 7);
+  EXPECT_EQ (bytes.get_value (size - 1), 7);
+
+  dray::Array<dray::uint8> copy;
+  dray::array_copy (copy, bytes);
+  EXPECT_EQ (copy.size (), size);
+  EXPECT_EQ (copy.get_value (size - 1), 7);
+}
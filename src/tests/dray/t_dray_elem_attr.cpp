@@ -6,7 +6,9 @@
 #include "test_config.h"
 #include "gtest/gtest.h"
 
+#include <dray/data_model/element.hpp>
 #include <dray/data_model/elem_attr.hpp>
+#include <dray/data_model/elem_ops.hpp>
 
 TEST (dray_elem_attr, dray_elem_attr)
 {
@@ -43,3 +45,22 @@ TEST (dray_elem_attr, dray_elem_attr)
   std::cout << dray::eattr::get_num_dofs(dray::ShapeHex{}, dray::OrderPolicy<General>{2}) << "\n";
 
 }
+
+TEST (dray_elem_attr, dray_tet_idx)
+{
+  // tet dofs are stored with i fastest and k slowest, so walking the
+  // lattice in that order must visit every index once, in order.
+  for (dray::int32 p = 0; p <= 5; ++p)
+  {
+    dray::int32 expected = 0;
+    for (dray::int32 k = 0; k <= p; ++k)
+      for (dray::int32 j = 0; j <= p - k; ++j)
+        for (dray::int32 i = 0; i <= p - k - j; ++i)
+        {
+          EXPECT_EQ(dray::detail::cartesian_to_tet_idx(i, j, k, p+1), expected);
+          expected++;
+        }
+    EXPECT_EQ(expected, dray::eattr::get_num_dofs(dray::ShapeTet{},
+                                                  dray::OrderPolicy<dray::General>{p}));
+  }
+}
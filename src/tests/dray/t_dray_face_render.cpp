@@ -9,6 +9,7 @@
 #include "t_utils.hpp"
 #include <dray/io/blueprint_reader.hpp>
 
+#include <dray/dispatcher.hpp>
 #include <dray/filters/mesh_boundary.hpp>
 #include <dray/rendering/surface.hpp>
 #include <dray/rendering/renderer.hpp>
@@ -167,3 +168,50 @@ TEST (dray_faces, dray_warbly_faces)
   EXPECT_TRUE (check_test_image (output_file));
   dray::stats::StatStore::write_ray_stats (c_width, c_height);
 }
+
+struct TopologyFunctor
+{
+  dray::Topology m_topo;
+  template<typename MeshType>
+  void operator()(MeshType &mesh)
+  {
+    m_topo = mesh.get_topology();
+  }
+};
+
+TEST (dray_faces, dray_topology)
+{
+  std::string root_file = std::string (DATA_DIR) + "impeller_p2_000000.root";
+  dray::Collection dataset = dray::BlueprintReader::load (root_file);
+  dray::DataSet domain = dataset.domain(0);
+
+  TopologyFunctor func;
+  dray::dispatch_3d(domain.mesh(), func);
+  dray::Topology &topo = func.m_topo;
+
+  const int32_t num_els = domain.mesh()->cells();
+  EXPECT_EQ(topo.m_face_neighbors.size(), num_els * topo.m_faces_per_elem);
+  EXPECT_EQ(topo.m_offsets.size(), num_els + 1);
+
+  // adjacency has to be symmetric
+  const int32_t *neighbors = topo.m_face_neighbors.get_host_ptr_const();
+  const int32_t num_faces = topo.m_face_neighbors.size();
+  int32_t asymmetric = 0;
+  for(int32_t i = 0; i < num_faces; ++i)
+  {
+    if(neighbors[i] != -1 && neighbors[neighbors[i]] != i)
+    {
+      asymmetric++;
+    }
+  }
+  EXPECT_EQ(asymmetric, 0);
+
+  const int32_t *offsets = topo.m_offsets.get_host_ptr_const();
+  EXPECT_EQ(offsets[num_els], topo.m_neighbors.size());
+  EXPECT_EQ(topo.m_neighbors.size() + topo.m_external_faces.size(), num_faces);
+
+  // the boundary has one face per external face
+  dray::MeshBoundary boundary;
+  dray::Collection faces = boundary.execute(dataset);
+  EXPECT_EQ(faces.domain(0).mesh()->cells(), topo.m_external_faces.size());
+}
@@ -0,0 +1,120 @@
+// Copyright 2019 Lawrence Livermore National Security, LLC and other
+// Devil Ray Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (BSD-3-Clause)
+
+#include "t_utils.hpp"
+#include "test_config.h"
+#include "gtest/gtest.h"
+
+#include <dray/rendering/framebuffer.hpp>
+#include <dray/utils/image_writer.hpp>
+#include <dray/error.hpp>
+
+#include <fstream>
+#include <iterator>
+
+namespace
+{
+
+std::string read_file(const std::string &file_name)
+{
+  std::ifstream file(file_name, std::ios::binary);
+  return std::string(std::istreambuf_iterator<char>(file),
+                     std::istreambuf_iterator<char>());
+}
+
+void fill(dray::Framebuffer &framebuffer, const int32_t frame)
+{
+  const int32_t width = framebuffer.width();
+  const int32_t size = width * framebuffer.height();
+  dray::Vec<float,4> *color_ptr = framebuffer.colors().get_host_ptr();
+  for(int32_t i = 0; i < size; ++i)
+  {
+    const float x = float(i % width) / float(width);
+    const float y = float(i / width) / float(framebuffer.height());
+    color_ptr[i] = {{ x, y, float(frame % 4) / 4.f, 1.f }};
+  }
+}
+
+} // namespace
+
+TEST (dray_image_writer, dray_async_write)
+{
+  std::string output_path = prepare_output_dir ();
+
+  const int32_t num_frames = 6;
+  dray::Framebuffer framebuffer(512, 256);
+
+  // a small queue forces write to wait for the workers
+  {
+    dray::ImageWriter writer(2, 2);
+    for(int32_t i = 0; i < num_frames; ++i)
+    {
+      fill(framebuffer, i);
+      std::string output_file =
+      conduit::utils::join_file_path (output_path, "async_" + std::to_string(i));
+      writer.write(framebuffer, output_file);
+    }
+    writer.wait();
+    EXPECT_EQ (writer.written(), num_frames);
+  }
+
+  // the images match the ones saved directly
+  for(int32_t i = 0; i < num_frames; ++i)
+  {
+    fill(framebuffer, i);
+    std::string output_file =
+    conduit::utils::join_file_path (output_path, "sync_" + std::to_string(i));
+    framebuffer.save(output_file);
+  }
+
+  for(int32_t i = 0; i < num_frames; ++i)
+  {
+    std::string async_file =
+    conduit::utils::join_file_path (output_path, "async_" + std::to_string(i) + ".png");
+    std::string sync_file =
+    conduit::utils::join_file_path (output_path, "sync_" + std::to_string(i) + ".png");
+    const std::string async_bytes = read_file(async_file);
+    EXPECT_FALSE (async_bytes.empty());
+    EXPECT_EQ (async_bytes, read_file(sync_file));
+  }
+
+  // the faster modes trade size for time
+  fill(framebuffer, 0);
+  const int32_t image_bytes = 512 * 256 * 4;
+  size_t sizes[3];
+  for(int32_t mode = 0; mode < 3; ++mode)
+  {
+    dray::ImageWriter writer(1, 1);
+    writer.compression((dray::PNGEncoder::Compression) mode);
+    std::string output_file =
+    conduit::utils::join_file_path (output_path, "compression_" + std::to_string(mode));
+    writer.write(framebuffer, output_file);
+    writer.wait();
+    sizes[mode] = read_file(output_file + ".png").size();
+  }
+  EXPECT_LE (sizes[dray::PNGEncoder::Default], sizes[dray::PNGEncoder::Fast]);
+  EXPECT_GT (sizes[dray::PNGEncoder::None], size_t(image_bytes));
+}
+
+TEST (dray_image_writer, dray_async_write_error)
+{
+  std::string output_path = prepare_output_dir ();
+
+  dray::Framebuffer framebuffer(64, 32);
+  fill(framebuffer, 0);
+
+  dray::ImageWriter writer(2, 2);
+  std::string missing_dir =
+  conduit::utils::join_file_path (output_path, "no_such_dir");
+  writer.write(framebuffer, conduit::utils::join_file_path (missing_dir, "image"));
+  writer.write(framebuffer, conduit::utils::join_file_path (output_path, "after_error"));
+
+  // the failure reaches the caller and the other image is still written
+  EXPECT_THROW (writer.wait(), dray::DRayError);
+  EXPECT_EQ (writer.written(), 1);
+
+  // the error is only reported once
+  writer.wait();
+}
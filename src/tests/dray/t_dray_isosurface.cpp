@@ -12,6 +12,10 @@
 #include <dray/filters/vector_component.hpp>
 #include <dray/rendering/renderer.hpp>
 #include <dray/io/blueprint_reader.hpp>
+#include <dray/data_model/span_space.hpp>
+
+#include <algorithm>
+#include <vector>
 
 TEST (dray_isosurface, simple)
 {
@@ -111,3 +115,56 @@ TEST (dray_isosurface, complex)
   fb.save (output_file);
   EXPECT_TRUE (check_test_image (output_file));
 }
+
+TEST (dray_isosurface, span_space)
+{
+  // a regular set of overlapping element ranges
+  const int num_elems = 1000;
+  dray::Array<dray::Vec<dray::Float,2>> ranges;
+  ranges.resize(num_elems);
+  dray::Vec<dray::Float,2> *ranges_ptr = ranges.get_host_ptr();
+  for(int i = 0; i < num_elems; ++i)
+  {
+    const dray::Float lo = dray::Float((i * 37) % 101) / 100.f;
+    const dray::Float width = dray::Float((i * 13) % 7) / 50.f;
+    ranges_ptr[i][0] = lo;
+    ranges_ptr[i][1] = lo + width;
+  }
+
+  dray::SpanSpace span_space(ranges);
+  EXPECT_EQ(span_space.size(), num_elems);
+
+  std::vector<dray::Float> values;
+  values.push_back(-1.f);
+  values.push_back(0.05f);
+  values.push_back(0.5f);
+  values.push_back(1.02f);
+
+  std::vector<int> expected_any;
+  for(const dray::Float value : values)
+  {
+    std::vector<int> expected;
+    for(int i = 0; i < num_elems; ++i)
+    {
+      if(ranges_ptr[i][0] <= value && value <= ranges_ptr[i][1])
+      {
+        expected.push_back(i);
+      }
+    }
+    expected_any.insert(expected_any.end(), expected.begin(), expected.end());
+
+    dray::Array<dray::int32> active = span_space.active(value);
+    const dray::int32 *active_ptr = active.get_host_ptr_const();
+    std::vector<int> result(active_ptr, active_ptr + active.size());
+    std::sort(result.begin(), result.end());
+    EXPECT_EQ(result, expected);
+  }
+
+  std::sort(expected_any.begin(), expected_any.end());
+  expected_any.erase(std::unique(expected_any.begin(), expected_any.end()),
+                     expected_any.end());
+  dray::Array<dray::int32> active = span_space.active(values);
+  const dray::int32 *active_ptr = active.get_host_ptr_const();
+  std::vector<int> result(active_ptr, active_ptr + active.size());
+  EXPECT_EQ(result, expected_any);
+}
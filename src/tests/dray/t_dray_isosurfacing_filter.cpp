@@ -18,6 +18,9 @@
 
 #include <dray/synthetic/affine_radial.hpp>
 #include <dray/io/blueprint_reader.hpp>
+#include <dray/io/blueprint_low_order.hpp>
+
+#include <conduit_blueprint.hpp>
 
 #include <dray/utils/data_logger.hpp>
 #include <dray/error.hpp>
@@ -224,3 +227,132 @@ TEST (dray_isosurface_filter, dray_isosurface_filter_tg_velx_density)
   fb.save (output_file);
   ///EXPECT_TRUE (check_test_image (output_file));
 }
+
+
+TEST (dray_isosurface_filter, dray_isosurface_filter_multi_value)
+{
+  using dray::Float;
+
+  const dray::Vec<int, 3> extents = {{4, 4, 4}};
+  const dray::Vec<Float, 3> origin = {{0.0f, 0.0f, 0.0f}};
+  const dray::Vec<Float, 3> radius = {{1.0f, 1.0f, 1.0f}};
+  const dray::Vec<Float, 3> range_radius = {{1.0f, 1.0f, -1.0f}};
+
+  dray::Collection collxn =
+      dray::SynthesizeAffineRadial(extents, origin, radius)
+      .equip("perfection", range_radius)
+      .synthesize();
+
+  const dray::Range field_range = collxn.range("perfection");
+  std::vector<Float> isovals;
+  isovals.push_back(field_range.min() + 0.3f * field_range.length());
+  isovals.push_back(field_range.min() + 0.5f * field_range.length());
+  isovals.push_back(field_range.min() + 0.7f * field_range.length());
+
+  dray::ExtractIsosurface iso_extractor;
+  iso_extractor.iso_field("perfection");
+  iso_extractor.iso_values(isovals);
+
+  auto isosurf_tri_quad = iso_extractor.execute(collxn);
+
+  // every level produced patches and each patch is tagged with its value
+  dray::Range tagged;
+  for (dray::DataSet &ds : isosurf_tri_quad.first.domains())
+  {
+    EXPECT_TRUE(ds.has_field("iso_value"));
+    if (ds.mesh()->cells() > 0)
+      tagged.include(ds.field("iso_value")->range()[0]);
+  }
+  for (dray::DataSet &ds : isosurf_tri_quad.second.domains())
+  {
+    EXPECT_TRUE(ds.has_field("iso_value"));
+    if (ds.mesh()->cells() > 0)
+      tagged.include(ds.field("iso_value")->range()[0]);
+  }
+  EXPECT_FLOAT_EQ(tagged.min(), isovals[0]);
+  EXPECT_FLOAT_EQ(tagged.max(), isovals[2]);
+
+  // single value output is not tagged
+  iso_extractor.iso_value(isovals[1]);
+  auto single = iso_extractor.execute(collxn);
+  for (dray::DataSet &ds : single.first.domains())
+    EXPECT_FALSE(ds.has_field("iso_value"));
+}
+
+
+TEST (dray_isosurface_filter, dray_isosurface_filter_count_then_emit)
+{
+  using dray::Float;
+
+  std::string root_file = std::string (DATA_DIR) + "taylor_green.cycle_000190.root";
+  dray::Collection collxn = dray::BlueprintReader::load (root_file);
+
+  dray::VectorComponent vc;
+  vc.field("velocity");
+  vc.output_name("velocity_x");
+  vc.component(0);
+  collxn = vc.execute(collxn);
+
+  dray::ExtractIsosurface iso_extractor;
+  iso_extractor.iso_field("velocity_x");
+  iso_extractor.iso_value(0.09);
+
+  auto rebudgeted = iso_extractor.execute(collxn);
+
+  iso_extractor.count_then_emit(true);
+  auto counted = iso_extractor.execute(collxn);
+
+  // both modes subdivide every element the same way
+  ASSERT_EQ(rebudgeted.first.local_size(), counted.first.local_size());
+  for (dray::int32 i = 0; i < counted.first.local_size(); ++i)
+  {
+    EXPECT_EQ(rebudgeted.first.domain(i).mesh()->cells(),
+              counted.first.domain(i).mesh()->cells());
+    EXPECT_EQ(rebudgeted.second.domain(i).mesh()->cells(),
+              counted.second.domain(i).mesh()->cells());
+  }
+}
+
+
+TEST (dray_isosurface_filter, dray_isosurface_filter_tets)
+{
+  using dray::Float;
+
+  conduit::Node data;
+  conduit::blueprint::mesh::examples::braid("tets", 10, 10, 10, data);
+
+  dray::Collection collxn;
+  collxn.add_domain(dray::BlueprintLowOrder::import(data));
+
+  const dray::Range braid_range = collxn.range("braid");
+  const Float isoval = braid_range.center();
+
+  dray::ExtractIsosurface iso_extractor;
+  iso_extractor.iso_field("braid");
+  iso_extractor.iso_value(isoval);
+
+  auto isosurf_tri_quad = iso_extractor.execute(collxn);
+
+  size_t count_cells = 0;
+  for (dray::DataSet &ds : isosurf_tri_quad.first.domains())
+    count_cells += ds.mesh()->cells();
+  for (dray::DataSet &ds : isosurf_tri_quad.second.domains())
+    count_cells += ds.mesh()->cells();
+  EXPECT_GT(count_cells, 0);
+
+  // The remapped iso field is sampled on the patch nodes,
+  // which all lie on the isosurface.
+  const Float tol = 1e-3f * braid_range.length();
+  for (dray::DataSet &ds : isosurf_tri_quad.first.domains())
+    if (ds.mesh()->cells() > 0)
+    {
+      EXPECT_NEAR(ds.field("braid")->range()[0].min(), isoval, tol);
+      EXPECT_NEAR(ds.field("braid")->range()[0].max(), isoval, tol);
+    }
+  for (dray::DataSet &ds : isosurf_tri_quad.second.domains())
+    if (ds.mesh()->cells() > 0)
+    {
+      EXPECT_NEAR(ds.field("braid")->range()[0].min(), isoval, tol);
+      EXPECT_NEAR(ds.field("braid")->range()[0].max(), isoval, tol);
+    }
+}
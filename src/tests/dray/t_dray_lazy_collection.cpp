@@ -0,0 +1,148 @@
+// Copyright 2019 Lawrence Livermore National Security, LLC and other
+// Devil Ray Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (BSD-3-Clause)
+
+#include "test_config.h"
+#include "gtest/gtest.h"
+
+#include "t_utils.hpp"
+#include <dray/io/blueprint_reader.hpp>
+#include <dray/data_model/lazy_collection.hpp>
+
+#include <algorithm>
+
+using namespace dray;
+
+TEST (dray_lazy_collection, dray_lazy_metadata)
+{
+  std::string root_file = std::string (DATA_DIR) + "taylor_green.cycle_001860.root";
+
+  Collection collection = BlueprintReader::load (root_file);
+  // a one byte budget keeps nothing resident
+  LazyCollection lazy = BlueprintReader::load_lazy (root_file, 1);
+
+  EXPECT_EQ (lazy.local_size(), collection.local_size());
+  EXPECT_EQ (lazy.resident_bytes(), size_t(0));
+  EXPECT_FALSE (lazy.is_resident(0));
+  EXPECT_GT (lazy.info(0).m_bytes, size_t(0));
+  EXPECT_EQ (lazy.info(0).m_cells, collection.domain(0).mesh()->cells());
+
+  AABB<3> bounds = collection.bounds();
+  AABB<3> lazy_bounds = lazy.bounds();
+  for(int32 d = 0; d < 3; ++d)
+  {
+    EXPECT_FLOAT_EQ (lazy_bounds.m_ranges[d].min(), bounds.m_ranges[d].min());
+    EXPECT_FLOAT_EQ (lazy_bounds.m_ranges[d].max(), bounds.m_ranges[d].max());
+  }
+
+  EXPECT_TRUE (lazy.has_field("density"));
+  Range range = collection.range("density");
+  Range lazy_range = lazy.range("density");
+  EXPECT_FLOAT_EQ (lazy_range.min(), range.min());
+  EXPECT_FLOAT_EQ (lazy_range.max(), range.max());
+  // nothing was loaded to answer these
+  EXPECT_EQ (lazy.loads(), 0);
+}
+
+TEST (dray_lazy_collection, dray_lazy_cache)
+{
+  std::string root_file = std::string (DATA_DIR) + "taylor_green.cycle_001860.root";
+
+  LazyCollection lazy = BlueprintReader::load_lazy (root_file, 1);
+
+  // a region away from the data selects nothing and loads nothing
+  AABB<3> away;
+  away.include(Vec<Float,3>({{10.f, 10.f, 10.f}}));
+  away.include(Vec<Float,3>({{11.f, 11.f, 11.f}}));
+  Collection empty = lazy.select(away);
+  EXPECT_EQ (empty.local_size(), 0);
+  EXPECT_EQ (lazy.loads(), 0);
+
+  Collection selected = lazy.select(lazy.bounds());
+  EXPECT_EQ (selected.local_size(), lazy.local_size());
+  EXPECT_EQ (lazy.loads(), lazy.local_size());
+  EXPECT_TRUE (selected.has_field("density"));
+
+  // a single domain larger than the budget is still kept until the
+  // next one needs the room
+  EXPECT_TRUE (lazy.is_resident(0));
+  lazy.domain(0);
+  EXPECT_EQ (lazy.loads(), lazy.local_size());
+
+  lazy.clear_cache();
+  EXPECT_EQ (lazy.resident_bytes(), size_t(0));
+  lazy.memory_budget(0);
+  lazy.domain(0);
+  EXPECT_EQ (lazy.loads(), lazy.local_size() + 1);
+  EXPECT_TRUE (lazy.is_resident(0));
+}
+
+TEST (dray_lazy_collection, dray_lazy_eviction)
+{
+  std::string root_file = std::string (DATA_DIR) + "laghos_tg.cycle_000350.root";
+
+  Collection collection = BlueprintReader::load (root_file);
+  LazyCollection lazy = BlueprintReader::load_lazy (root_file);
+  const int32 num_domains = lazy.local_size();
+  ASSERT_EQ (num_domains, collection.local_size());
+  ASSERT_GT (num_domains, 2);
+
+  // the metadata matches the imported domains without loading them
+  size_t total_bytes = 0;
+  size_t max_bytes = 0;
+  for(int32 i = 0; i < num_domains; ++i)
+  {
+    const LazyCollection::DomainInfo &dinfo = lazy.info(i);
+    DataSet domain = collection.domain(i);
+    EXPECT_EQ (dinfo.m_domain_id, domain.domain_id());
+    EXPECT_EQ (dinfo.m_cells, domain.mesh()->cells());
+    // high order bounds come from the nodes and stay inside the
+    // bounds of the Bernstein control points
+    AABB<3> bounds = domain.bounds();
+    for(int32 d = 0; d < 3; ++d)
+    {
+      EXPECT_GE (dinfo.m_bounds.m_ranges[d].min(), bounds.m_ranges[d].min() - 1e-5f);
+      EXPECT_LE (dinfo.m_bounds.m_ranges[d].max(), bounds.m_ranges[d].max() + 1e-5f);
+    }
+    total_bytes += dinfo.m_bytes;
+    max_bytes = std::max(max_bytes, dinfo.m_bytes);
+  }
+  EXPECT_EQ (lazy.loads(), 0);
+  EXPECT_EQ (lazy.resident_bytes(), size_t(0));
+
+  // room for two domains out of all of them
+  const size_t budget = 2 * max_bytes;
+  ASSERT_LT (budget, total_bytes);
+  lazy.memory_budget(budget);
+
+  for(int32 i = 0; i < num_domains; ++i)
+  {
+    lazy.domain(i);
+    EXPECT_LE (lazy.resident_bytes(), budget);
+  }
+  EXPECT_EQ (lazy.loads(), num_domains);
+  EXPECT_FALSE (lazy.is_resident(0));
+  EXPECT_TRUE (lazy.is_resident(num_domains - 1));
+  EXPECT_EQ (lazy.pinned_bytes(), size_t(0));
+
+  // the most recent domain is served from the cache, the first one
+  // was evicted and has to be loaded again
+  lazy.domain(num_domains - 1);
+  EXPECT_EQ (lazy.loads(), num_domains);
+  lazy.domain(0);
+  EXPECT_EQ (lazy.loads(), num_domains + 1);
+
+  {
+    // a selection keeps its domains alive after they are evicted
+    Collection selected = lazy.select(std::vector<int32>({0, 1}));
+    for(int32 i = 2; i < num_domains; ++i)
+    {
+      lazy.domain(i);
+    }
+    EXPECT_FALSE (lazy.is_resident(0));
+    EXPECT_GT (lazy.pinned_bytes(), size_t(0));
+    EXPECT_LE (lazy.resident_bytes() + lazy.pinned_bytes(), budget + max_bytes);
+  }
+  EXPECT_EQ (lazy.pinned_bytes(), size_t(0));
+}
@@ -78,6 +78,57 @@ TEST (dray_redistribute, redistribute)
   }
 }
 
+TEST (dray_redistribute, persistent_orbit)
+{
+  MPI_Comm comm = MPI_COMM_WORLD;
+  dray::dray::mpi_comm(MPI_Comm_c2f(comm));
+
+  std::string root_file = std::string (DATA_DIR) + "laghos_tg.cycle_000350.root";
+
+  dray::Collection dataset = dray::BlueprintReader::load (root_file);
+
+  dray::Camera camera;
+  camera.set_width (512);
+  camera.set_height (512);
+  camera.reset_to_bounds (dataset.bounds());
+
+  int32 samples = 100;
+
+  dray::VolumeBalance balancer;
+  balancer.persistent(true);
+  // force the first frame to build a plan
+  balancer.threshold(1.0f);
+  dray::Collection first = balancer.execute(dataset, camera, samples);
+  balancer.threshold(2.0f);
+
+  int32 frames = 36;
+  int32 moving_frames = 0;
+  for(int32 i = 0; i < frames; ++i)
+  {
+    camera.azimuth(10);
+    dray::Collection res = balancer.execute(dataset, camera, samples);
+    EXPECT_EQ(res.size(), first.size());
+    if(balancer.last_moved() > 0)
+    {
+      moving_frames++;
+    }
+  }
+  // small camera moves should mostly reuse the plan
+  EXPECT_LT(moving_frames, frames / 2);
+
+  // the same data loaded again has new fields on the same bounds, so
+  // the plan must not be reused. Nothing is imbalanced enough to chop
+  // now, which hands the new input back as is.
+  dray::Collection next = dray::BlueprintReader::load (root_file);
+  balancer.threshold(1e6f);
+  dray::Collection res = balancer.execute(next, camera, samples);
+  ASSERT_EQ(res.local_size(), next.local_size());
+  for(int32 i = 0; i < next.local_size(); ++i)
+  {
+    EXPECT_EQ(res.domain(i).field_shared(0), next.domain(i).field_shared(0));
+  }
+}
+
 int main(int argc, char* argv[])
 {
     int result = 0;
@@ -0,0 +1,207 @@
+// Copyright 2019 Lawrence Livermore National Security, LLC and other
+// Devil Ray Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (BSD-3-Clause)
+
+#include "test_config.h"
+#include "gtest/gtest.h"
+
+#include "t_utils.hpp"
+
+#include <dray/dray.hpp>
+#include <dray/error.hpp>
+#include <dray/math.hpp>
+#include <dray/rendering/image_compositor.hpp>
+#include <dray/rendering/pixel_format.hpp>
+
+#include <mpi.h>
+
+namespace
+{
+
+const int32_t width = 37;
+const int32_t height = 23;
+
+// every rank covers every pixel, each with a different depth
+float pixel_depth(const int32_t pixel, const int32_t rank, const int32_t size)
+{
+  return float((pixel * 7 + rank * 3) % (size * 2) + 1);
+}
+
+dray::Vec<float,4> pixel_color(const int32_t pixel, const int32_t rank, const int32_t size)
+{
+  return {{ float(rank) / float(size), 0.5f, float(pixel % 4) / 4.f, 1.f }};
+}
+
+void fill(dray::Framebuffer &framebuffer, const int32_t rank, const int32_t size)
+{
+  dray::Vec<float,4> *color_ptr = framebuffer.colors().get_host_ptr();
+  float *depth_ptr = framebuffer.depths().get_host_ptr();
+  for(int32_t i = 0; i < width * height; ++i)
+  {
+    color_ptr[i] = pixel_color(i, rank, size);
+    depth_ptr[i] = pixel_depth(i, rank, size);
+  }
+}
+
+// rank whose pixel is in front
+int32_t nearest_rank(const int32_t pixel, const int32_t size)
+{
+  int32_t res = 0;
+  for(int32_t r = 1; r < size; ++r)
+  {
+    if(pixel_depth(pixel, r, size) < pixel_depth(pixel, res, size))
+    {
+      res = r;
+    }
+  }
+  return res;
+}
+
+dray::AABB<2> make_rect(const float x0, const float y0, const float x1, const float y1)
+{
+  dray::AABB<2> rect;
+  rect.m_ranges[0].include(x0);
+  rect.m_ranges[0].include(x1);
+  rect.m_ranges[1].include(y0);
+  rect.m_ranges[1].include(y1);
+  return rect;
+}
+
+} // namespace
+
+TEST (dray_image_compositor, radix_k)
+{
+  MPI_Comm comm = MPI_COMM_WORLD;
+  dray::dray::mpi_comm(MPI_Comm_c2f(comm));
+  const int32_t rank = dray::dray::mpi_rank();
+  const int32_t size = dray::dray::mpi_size();
+
+  // the rank count is not a power of the radix, so rounds of
+  // different radices and direct sends are exercised
+  dray::Framebuffer framebuffer(width, height);
+  fill(framebuffer, rank, size);
+
+  // only a sub rectangle is composited
+  const int32_t x_min = 3, y_min = 2, x_max = 31, y_max = 20;
+  dray::ImageCompositor compositor;
+  compositor.composite(framebuffer, make_rect(x_min, y_min, x_max, y_max));
+
+  if(rank == 0)
+  {
+    const dray::Vec<float,4> *color_ptr = framebuffer.colors().get_host_ptr_const();
+    const float *depth_ptr = framebuffer.depths().get_host_ptr_const();
+    int32_t errors = 0;
+    for(int32_t y = 0; y < height; ++y)
+    {
+      for(int32_t x = 0; x < width; ++x)
+      {
+        const int32_t i = y * width + x;
+        const bool inside = x >= x_min && x < x_max && y >= y_min && y < y_max;
+        // pixels outside of the rectangle keep rank 0's values
+        const int32_t owner = inside ? nearest_rank(i, size) : 0;
+        if(depth_ptr[i] != pixel_depth(i, owner, size) ||
+           color_ptr[i][0] != float(owner) / float(size))
+        {
+          errors++;
+        }
+      }
+    }
+    EXPECT_EQ (errors, 0);
+  }
+
+  // every rank gets the composited depths inside its interest
+  // rectangle, and the rays there are clipped to them
+  const int32_t ix_min = 5 + rank, iy_min = 4, ix_max = 25, iy_max = 18 - rank;
+  dray::Array<dray::Ray> rays;
+  rays.resize(width * height);
+  dray::Ray *ray_ptr = rays.get_host_ptr();
+  for(int32_t i = 0; i < width * height; ++i)
+  {
+    ray_ptr[i].m_pixel_id = i;
+    ray_ptr[i].m_near = 0.f;
+    ray_ptr[i].m_far = dray::infinity<dray::Float>();
+  }
+  compositor.synch_depths(framebuffer,
+                          make_rect(ix_min, iy_min, ix_max, iy_max),
+                          rays);
+
+  const dray::Ray *res_ptr = rays.get_host_ptr_const();
+  const float *depth_ptr = framebuffer.depths().get_host_ptr_const();
+  int32_t errors = 0;
+  for(int32_t y = iy_min; y < iy_max; ++y)
+  {
+    for(int32_t x = ix_min; x < ix_max; ++x)
+    {
+      const int32_t i = y * width + x;
+      const float expected = pixel_depth(i, nearest_rank(i, size), size);
+      if(depth_ptr[i] != expected || res_ptr[i].m_far != expected)
+      {
+        errors++;
+      }
+    }
+  }
+  EXPECT_EQ (errors, 0);
+  // rays outside of the interest are left alone
+  EXPECT_EQ (res_ptr[0].m_far, dray::infinity<dray::Float>());
+
+  // explicit radices have to multiply to the rank count
+  dray::ImageCompositor bad_compositor;
+  bad_compositor.radices({size + 1});
+  EXPECT_THROW (bad_compositor.composite(framebuffer, make_rect(0, 0, width, height)),
+                dray::DRayError);
+}
+
+TEST (dray_image_compositor, compact_formats)
+{
+  MPI_Comm comm = MPI_COMM_WORLD;
+  dray::dray::mpi_comm(MPI_Comm_c2f(comm));
+  const int32_t rank = dray::dray::mpi_rank();
+  const int32_t size = dray::dray::mpi_size();
+
+  const dray::PixelFormat formats[2] = {dray::RGBA16F, dray::RGBA8};
+  for(int32_t f = 0; f < 2; ++f)
+  {
+    dray::Framebuffer framebuffer(width, height);
+    framebuffer.format(formats[f]);
+    fill(framebuffer, rank, size);
+
+    dray::ImageCompositor compositor;
+    compositor.composite(framebuffer, make_rect(0, 0, width, height));
+    EXPECT_EQ (framebuffer.format(), formats[f]);
+
+    if(rank == 0)
+    {
+      // the nearest pixel, at the precision of the wire format
+      const dray::Vec<float,4> *color_ptr = framebuffer.colors().get_host_ptr_const();
+      const float *depth_ptr = framebuffer.depths().get_host_ptr_const();
+      int32_t errors = 0;
+      for(int32_t i = 0; i < width * height; ++i)
+      {
+        const int32_t owner = nearest_rank(i, size);
+        dray::Vec<float,4> color = pixel_color(i, owner, size);
+        float depth = pixel_depth(i, owner, size);
+        dray::detail::quantize_pixel(formats[f], color, depth);
+        bool differs = depth_ptr[i] != depth;
+        for(int32_t c = 0; c < 4; ++c)
+        {
+          differs |= color_ptr[i][c] != color[c];
+        }
+        errors += differs ? 1 : 0;
+      }
+      EXPECT_EQ (errors, 0);
+    }
+  }
+}
+
+int main(int argc, char* argv[])
+{
+    int result = 0;
+
+    ::testing::InitGoogleTest(&argc, argv);
+    MPI_Init(&argc, &argv);
+    result = RUN_ALL_TESTS();
+    MPI_Finalize();
+
+    return result;
+}
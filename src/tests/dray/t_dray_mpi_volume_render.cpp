@@ -65,6 +65,56 @@ TEST (dray_volume_render, dray_volume_render_multidom)
   }
 }
 
+TEST (dray_volume_render, dray_volume_render_wire_bytes)
+{
+  MPI_Comm comm = MPI_COMM_WORLD;
+  dray::dray::mpi_comm(MPI_Comm_c2f(comm));
+
+  std::string root_file = std::string (DATA_DIR) + "laghos_tg.cycle_000350.root";
+  std::string output_path = prepare_output_dir ();
+  std::string output_file =
+  conduit::utils::join_file_path (output_path, "tg_mpi_volume_half");
+  remove_test_image (output_file);
+
+  dray::Collection dataset = dray::BlueprintReader::load (root_file);
+
+  dray::Camera camera;
+  camera.set_width (512);
+  camera.set_height (512);
+  camera.azimuth(20);
+  camera.elevate(10);
+  camera.reset_to_bounds (dataset.bounds());
+
+  std::shared_ptr<dray::Volume> volume
+    = std::make_shared<dray::Volume>(dataset);
+  volume->field("density");
+
+  dray::Renderer renderer;
+  renderer.volume(volume);
+
+  const dray::PartialCompositor::WireFormat formats[3] =
+    {dray::PartialCompositor::Raw,
+     dray::PartialCompositor::Half,
+     dray::PartialCompositor::RGBA8};
+  size_t bytes[3];
+
+  for(int i = 0; i < 3; ++i)
+  {
+    renderer.partial_compositor().wire_format(formats[i]);
+    dray::Framebuffer fb = renderer.render(camera);
+    bytes[i] = renderer.partial_compositor().bytes_sent();
+    EXPECT_LE(bytes[i], renderer.partial_compositor().raw_bytes());
+    if(i == 1 && dray::dray::mpi_rank() == 0)
+    {
+      fb.composite_background();
+      fb.save (output_file);
+    }
+  }
+
+  EXPECT_LE(bytes[1], bytes[0]);
+  EXPECT_LE(bytes[2], bytes[1]);
+}
+
 int main(int argc, char* argv[])
 {
     int result = 0;
@@ -9,11 +9,14 @@
 
 #include <dray/io/blueprint_reader.hpp>
 
+#include <dray/filters/reflect.hpp>
 #include <dray/filters/vector_component.hpp>
 #include <dray/rendering/renderer.hpp>
 #include <dray/rendering/slice_plane.hpp>
+#include <dray/rendering/surface.hpp>
 #include <dray/rendering/contour.hpp>
 #include <dray/rendering/volume.hpp>
+#include <dray/transform_3d.hpp>
 
 TEST (dray_multi_render, dray_simple)
 {
@@ -92,3 +95,594 @@ TEST (dray_multi_render, dray_simple)
   fb.save_depth("depth");
   EXPECT_TRUE (check_test_image (output_file));
 }
+
+TEST (dray_multi_render, dray_concurrent_domains)
+{
+  std::string output_path = prepare_output_dir ();
+  std::string output_file =
+  conduit::utils::join_file_path (output_path, "concurrent_domains");
+  remove_test_image (output_file);
+
+  std::string root_file = std::string (DATA_DIR) + "taylor_green_2d.cycle_000050.root";
+  dray::Collection input = dray::BlueprintReader::load (root_file);
+
+  dray::Vec<float,3> point = {0.f, 0.f, 0.f};
+  dray::Vec<float,3> normal = {0.f, 1.f, 0.f};
+  dray::Reflect reflector;
+  reflector.plane(point, normal);
+  dray::Collection reflected = reflector.execute(input);
+
+  // one collection holding both halves as separate domains
+  dray::Collection collection;
+  for(int32_t i = 0; i < input.local_size(); ++i)
+  {
+    collection.add_domain(input.domain(i));
+  }
+  for(int32_t i = 0; i < reflected.local_size(); ++i)
+  {
+    collection.add_domain(reflected.domain(i));
+  }
+
+  dray::Camera camera;
+  camera.set_width (512);
+  camera.set_height (512);
+  camera.reset_to_bounds (collection.bounds());
+  camera.azimuth(30);
+
+  std::shared_ptr<dray::Surface> surface
+    = std::make_shared<dray::Surface>(collection);
+  surface->field("density");
+  dray::ColorTable color_table ("Spectral");
+  surface->color_map().color_table(color_table);
+
+  dray::Renderer renderer;
+  renderer.add(surface);
+  dray::Framebuffer serial = renderer.render(camera);
+
+  renderer.concurrent_domains(true);
+  dray::Framebuffer concurrent = renderer.render(camera);
+  concurrent.save(output_file);
+
+  // the nearest hit merge has to produce the same image, up to
+  // rays that graze the shared edge of the two halves
+  const int32_t size = serial.colors().size();
+  const dray::Vec<float,4> *serial_ptr = serial.colors().get_host_ptr_const();
+  const dray::Vec<float,4> *concurrent_ptr = concurrent.colors().get_host_ptr_const();
+  int32_t differences = 0;
+  for(int32_t i = 0; i < size; ++i)
+  {
+    for(int32_t c = 0; c < 4; ++c)
+    {
+      if(serial_ptr[i][c] != concurrent_ptr[i][c])
+      {
+        differences++;
+        break;
+      }
+    }
+  }
+  EXPECT_LT(differences, size / 1000);
+}
+
+TEST (dray_multi_render, dray_concurrent_traceables)
+{
+  std::string output_path = prepare_output_dir ();
+  std::string output_file =
+  conduit::utils::join_file_path (output_path, "concurrent_traceables");
+  remove_test_image (output_file);
+
+  std::string root_file = std::string (DATA_DIR) + "taylor_green_2d.cycle_000050.root";
+  dray::Collection input = dray::BlueprintReader::load (root_file);
+
+  dray::Vec<float,3> point = {0.f, 0.f, 0.f};
+  dray::Vec<float,3> normal = {0.f, 1.f, 0.f};
+  dray::Reflect reflector;
+  reflector.plane(point, normal);
+  dray::Collection reflected = reflector.execute(input);
+
+  dray::Collection front;
+  for(int32_t i = 0; i < input.local_size(); ++i)
+  {
+    front.add_domain(input.domain(i));
+  }
+  for(int32_t i = 0; i < reflected.local_size(); ++i)
+  {
+    front.add_domain(reflected.domain(i));
+  }
+
+  dray::Camera camera;
+  camera.set_width (512);
+  camera.set_height (512);
+  camera.reset_to_bounds (front.bounds());
+  camera.azimuth(30);
+
+  // the same domains pushed back along the view, mostly hidden
+  dray::Vec<float,3> view = camera.get_look_at() - camera.get_pos();
+  view.normalize();
+  const float distance = front.bounds().max_length();
+  dray::Collection back;
+  for(int32_t i = 0; i < front.local_size(); ++i)
+  {
+    dray::DataSet domain = front.domain(i);
+    domain.transform(dray::translate<dray::Float>(view[0] * distance,
+                                                  view[1] * distance,
+                                                  view[2] * distance));
+    back.add_domain(domain);
+  }
+
+  dray::ColorTable color_table ("Spectral");
+  std::shared_ptr<dray::Surface> front_surface
+    = std::make_shared<dray::Surface>(front);
+  front_surface->field("density");
+  front_surface->color_map().color_table(color_table);
+  std::shared_ptr<dray::Surface> back_surface
+    = std::make_shared<dray::Surface>(back);
+  back_surface->field("density");
+  back_surface->color_map().color_table(color_table);
+
+  dray::Renderer renderer;
+  renderer.add(front_surface);
+  renderer.add(back_surface);
+  dray::Framebuffer serial = renderer.render(camera);
+
+  // the back surface is traced with the depths of the front one
+  renderer.concurrent_domains(true);
+  dray::Framebuffer concurrent = renderer.render(camera);
+  concurrent.save(output_file);
+
+  const int32_t size = serial.colors().size();
+  const dray::Vec<float,4> *serial_ptr = serial.colors().get_host_ptr_const();
+  const dray::Vec<float,4> *concurrent_ptr = concurrent.colors().get_host_ptr_const();
+  const float *serial_depth_ptr = serial.depths().get_host_ptr_const();
+  const float *concurrent_depth_ptr = concurrent.depths().get_host_ptr_const();
+  int32_t differences = 0;
+  for(int32_t i = 0; i < size; ++i)
+  {
+    bool differs = serial_depth_ptr[i] != concurrent_depth_ptr[i];
+    for(int32_t c = 0; c < 4; ++c)
+    {
+      differs |= serial_ptr[i][c] != concurrent_ptr[i][c];
+    }
+    differences += differs ? 1 : 0;
+  }
+  EXPECT_LT(differences, size / 1000);
+}
+
+TEST (dray_multi_render, dray_concurrent_instanced)
+{
+  std::string output_path = prepare_output_dir ();
+  std::string output_file =
+  conduit::utils::join_file_path (output_path, "concurrent_instanced");
+  remove_test_image (output_file);
+
+  std::string root_file = std::string (DATA_DIR) + "taylor_green.cycle_000190.root";
+
+  // the domains and their instanced reflections share meshes and fields
+  auto load_instanced = [&root_file]()
+  {
+    dray::Collection input = dray::BlueprintReader::load (root_file);
+    dray::VectorComponent vc;
+    vc.field("velocity");
+    vc.output_name("velocity_y");
+    vc.component(1);
+    input = vc.execute(input);
+
+    dray::Vec<float,3> point = {0.f, 0.f, 0.f};
+    dray::Vec<float,3> normal = {0.f, 1.f, 0.f};
+    dray::Reflect reflector;
+    reflector.plane(point, normal);
+    reflector.instanced(true);
+    dray::Collection reflected = reflector.execute(input);
+
+    dray::Collection collection;
+    for(int32_t i = 0; i < input.local_size(); ++i)
+    {
+      collection.add_domain(input.domain(i));
+    }
+    for(int32_t i = 0; i < reflected.local_size(); ++i)
+    {
+      collection.add_domain(reflected.domain(i));
+    }
+    return collection;
+  };
+
+  dray::Collection serial_collection = load_instanced();
+  // nothing of this one has been built yet, so the concurrent trace
+  // builds the span spaces of the shared fields
+  dray::Collection concurrent_collection = load_instanced();
+
+  dray::Camera camera;
+  camera.set_width (512);
+  camera.set_height (512);
+  camera.reset_to_bounds (serial_collection.bounds());
+  camera.azimuth(30);
+  camera.elevate(30);
+
+  dray::ColorTable color_table ("Spectral");
+  auto make_contour = [&color_table](dray::Collection &collection)
+  {
+    std::shared_ptr<dray::Contour> contour
+      = std::make_shared<dray::Contour>(collection);
+    contour->field("density");
+    contour->iso_field("velocity_y");
+    contour->iso_value(0.09);
+    contour->color_map().color_table(color_table);
+    return contour;
+  };
+
+  dray::Renderer serial_renderer;
+  serial_renderer.add(make_contour(serial_collection));
+  dray::Framebuffer serial = serial_renderer.render(camera);
+
+  dray::Renderer concurrent_renderer;
+  concurrent_renderer.add(make_contour(concurrent_collection));
+  concurrent_renderer.concurrent_domains(true);
+  dray::Framebuffer concurrent = concurrent_renderer.render(camera);
+  concurrent.save(output_file);
+
+  const int32_t size = serial.colors().size();
+  const dray::Vec<float,4> *serial_ptr = serial.colors().get_host_ptr_const();
+  const dray::Vec<float,4> *concurrent_ptr = concurrent.colors().get_host_ptr_const();
+  int32_t differences = 0;
+  for(int32_t i = 0; i < size; ++i)
+  {
+    for(int32_t c = 0; c < 4; ++c)
+    {
+      if(serial_ptr[i][c] != concurrent_ptr[i][c])
+      {
+        differences++;
+        break;
+      }
+    }
+  }
+  EXPECT_LT(differences, size / 1000);
+}
+
+TEST (dray_multi_render, dray_domain_culling)
+{
+  std::string output_path = prepare_output_dir ();
+  std::string output_file =
+  conduit::utils::join_file_path (output_path, "domain_culling");
+  remove_test_image (output_file);
+
+  std::string root_file = std::string (DATA_DIR) + "taylor_green_2d.cycle_000050.root";
+  dray::Collection input = dray::BlueprintReader::load (root_file);
+
+  dray::Vec<float,3> point = {0.f, 0.f, 0.f};
+  dray::Vec<float,3> normal = {0.f, 1.f, 0.f};
+  dray::Reflect reflector;
+  reflector.plane(point, normal);
+  dray::Collection reflected = reflector.execute(input);
+
+  dray::Collection collection;
+  for(int32_t i = 0; i < input.local_size(); ++i)
+  {
+    collection.add_domain(input.domain(i));
+  }
+  for(int32_t i = 0; i < reflected.local_size(); ++i)
+  {
+    collection.add_domain(reflected.domain(i));
+  }
+
+  // close in on one half so the other one is mostly off screen
+  dray::Camera camera;
+  camera.set_width (512);
+  camera.set_height (512);
+  camera.reset_to_bounds (input.bounds());
+  camera.set_zoom(2.f);
+
+  std::shared_ptr<dray::Surface> surface
+    = std::make_shared<dray::Surface>(collection);
+  surface->field("density");
+  dray::ColorTable color_table ("Spectral");
+  surface->color_map().color_table(color_table);
+
+  dray::Renderer renderer;
+  renderer.add(surface);
+  renderer.cull_domains(false);
+  dray::Framebuffer full = renderer.render(camera);
+
+  renderer.cull_domains(true);
+  dray::Framebuffer culled = renderer.render(camera);
+  culled.save(output_file);
+
+  const int32_t size = full.colors().size();
+  const dray::Vec<float,4> *full_ptr = full.colors().get_host_ptr_const();
+  const dray::Vec<float,4> *culled_ptr = culled.colors().get_host_ptr_const();
+  int32_t differences = 0;
+  for(int32_t i = 0; i < size; ++i)
+  {
+    for(int32_t c = 0; c < 4; ++c)
+    {
+      if(full_ptr[i][c] != culled_ptr[i][c])
+      {
+        differences++;
+        break;
+      }
+    }
+  }
+  EXPECT_LT(differences, size / 1000);
+
+  // turning around leaves nothing to trace
+  dray::Vec<float,3> pos = camera.get_pos();
+  camera.set_look_at(pos + (pos - camera.get_look_at()));
+  EXPECT_EQ(dray::visible_domains(collection, camera).size(), size_t(0));
+}
+
+TEST (dray_multi_render, dray_subset_rays)
+{
+  dray::Camera camera;
+  camera.set_width (64);
+  camera.set_height (48);
+
+  dray::Array<dray::Ray> full;
+  camera.create_rays (full);
+  ASSERT_EQ (full.size(), 64 * 48);
+
+  dray::AABB<2> rect;
+  rect.m_ranges[0].include(10.f);
+  rect.m_ranges[0].include(30.f);
+  rect.m_ranges[1].include(5.f);
+  rect.m_ranges[1].include(12.f);
+
+  dray::Array<dray::Ray> subset;
+  camera.create_rays (subset, rect);
+  ASSERT_EQ (subset.size(), 20 * 7);
+
+  // subset rays are the full image rays of the same pixels
+  const dray::Ray *full_ptr = full.get_host_ptr_const();
+  const dray::Ray *subset_ptr = subset.get_host_ptr_const();
+  for(int32_t i = 0; i < subset.size(); ++i)
+  {
+    const dray::Ray ray = subset_ptr[i];
+    const int32_t x = ray.m_pixel_id % 64;
+    const int32_t y = ray.m_pixel_id / 64;
+    EXPECT_TRUE (x >= 10 && x < 30 && y >= 5 && y < 12);
+    for(int32_t d = 0; d < 3; ++d)
+    {
+      EXPECT_FLOAT_EQ (ray.m_dir[d], full_ptr[ray.m_pixel_id].m_dir[d]);
+    }
+  }
+
+  // the rectangle is clamped to the image
+  rect.m_ranges[0].include(100.f);
+  camera.create_rays (subset, rect);
+  EXPECT_EQ (subset.size(), (64 - 10) * 7);
+
+  // the camera keeps the subset of its last full image
+  EXPECT_EQ (camera.get_subset_width(), 64);
+  EXPECT_EQ (camera.get_subset_height(), 48);
+}
+
+TEST (dray_multi_render, dray_progressive)
+{
+  std::string output_path = prepare_output_dir ();
+  std::string output_file =
+  conduit::utils::join_file_path (output_path, "progressive");
+  remove_test_image (output_file);
+
+  std::string root_file = std::string (DATA_DIR) + "taylor_green.cycle_000190.root";
+  dray::Collection collection = dray::BlueprintReader::load (root_file);
+
+  dray::Camera camera;
+  camera.set_width (256);
+  camera.set_height (256);
+  camera.reset_to_bounds(collection.bounds());
+  camera.azimuth(-40);
+  camera.elevate(-40);
+
+  std::shared_ptr<dray::Surface> surface
+    = std::make_shared<dray::Surface>(collection);
+  surface->field("density");
+
+  std::shared_ptr<dray::Volume> volume
+    = std::make_shared<dray::Volume>(collection);
+  volume->field("density");
+  dray::ColorTable tfunc("thermal");
+  tfunc.add_alpha(0.1f, 0.f);
+  tfunc.add_alpha(1.f, .3f);
+  volume->color_map().color_table(tfunc);
+
+  dray::Renderer renderer;
+  renderer.add(surface);
+  renderer.volume(volume);
+
+  // without a budget only the first coarse pass runs
+  renderer.max_samples(1);
+  renderer.render_progressive(camera, 0.f);
+  EXPECT_FALSE (renderer.converged());
+
+  // a single sample converges to the regular image
+  dray::Framebuffer progressive;
+  while(!renderer.converged())
+  {
+    progressive = renderer.render_progressive(camera, 1000.f);
+  }
+  dray::Framebuffer reference = renderer.render(camera);
+
+  const int32_t size = reference.colors().size();
+  const dray::Vec<float,4> *ref_ptr = reference.colors().get_host_ptr_const();
+  const dray::Vec<float,4> *prog_ptr = progressive.colors().get_host_ptr_const();
+  int32_t differences = 0;
+  for(int32_t i = 0; i < size; ++i)
+  {
+    for(int32_t c = 0; c < 4; ++c)
+    {
+      if(ref_ptr[i][c] != prog_ptr[i][c])
+      {
+        differences++;
+        break;
+      }
+    }
+  }
+  EXPECT_EQ (differences, 0);
+
+  // more samples refine the same view further
+  renderer.max_samples(4);
+  EXPECT_FALSE (renderer.converged());
+  progressive = renderer.render_progressive(camera, 1000.f);
+  EXPECT_TRUE (renderer.converged());
+  progressive.composite_background();
+  progressive.save(output_file);
+
+  // zooming starts over
+  dray::Camera zoomed = camera;
+  zoomed.set_zoom(2.f);
+  renderer.render_progressive(zoomed, 0.f);
+  EXPECT_FALSE (renderer.converged());
+
+  // moving the camera starts over
+  while(!renderer.converged())
+  {
+    renderer.render_progressive(camera, 1000.f);
+  }
+  camera.azimuth(10);
+  renderer.render_progressive(camera, 0.f);
+  EXPECT_FALSE (renderer.converged());
+}
+
+TEST (dray_multi_render, dray_batch)
+{
+  std::string output_path = prepare_output_dir ();
+  std::string output_file =
+  conduit::utils::join_file_path (output_path, "batch_render");
+  remove_test_image (output_file);
+
+  std::string root_file = std::string (DATA_DIR) + "taylor_green.cycle_000190.root";
+  dray::Collection collection = dray::BlueprintReader::load (root_file);
+
+  std::shared_ptr<dray::Surface> surface
+    = std::make_shared<dray::Surface>(collection);
+  surface->field("density");
+
+  std::shared_ptr<dray::Volume> volume
+    = std::make_shared<dray::Volume>(collection);
+  volume->field("density");
+  dray::ColorTable tfunc("thermal");
+  tfunc.add_alpha(0.1f, 0.f);
+  tfunc.add_alpha(1.f, .3f);
+  volume->color_map().color_table(tfunc);
+
+  dray::Renderer renderer;
+  renderer.add(surface);
+  renderer.volume(volume);
+
+  // views are only traced together with fixed lights
+  dray::PointLight light;
+  light.m_pos = { 2.f, 2.f, 2.f };
+  renderer.add_light(light);
+  renderer.batch_size(3);
+
+  // orbit the data set
+  const int32_t num_cameras = 8;
+  std::vector<dray::Camera> cameras(num_cameras);
+  for(int32_t i = 0; i < num_cameras; ++i)
+  {
+    cameras[i].set_width (128);
+    cameras[i].set_height (128);
+    cameras[i].reset_to_bounds(collection.bounds());
+    cameras[i].azimuth(i * 360.f / num_cameras);
+    cameras[i].elevate(-30);
+  }
+
+  std::vector<dray::Framebuffer> batch(num_cameras);
+  renderer.render_batch(cameras,
+                        [&](const int32_t index, dray::Framebuffer &framebuffer)
+  {
+    batch[index] = framebuffer;
+  });
+
+  std::vector<dray::Framebuffer> single(num_cameras);
+  for(int32_t i = 0; i < num_cameras; ++i)
+  {
+    single[i] = renderer.render(cameras[i]);
+  }
+
+  // batching must not change the images
+  for(int32_t i = 0; i < num_cameras; ++i)
+  {
+    const int32_t size = single[i].colors().size();
+    ASSERT_EQ (batch[i].colors().size(), size);
+    const dray::Vec<float,4> *single_ptr = single[i].colors().get_host_ptr_const();
+    const dray::Vec<float,4> *batch_ptr = batch[i].colors().get_host_ptr_const();
+    int32_t differences = 0;
+    for(int32_t p = 0; p < size; ++p)
+    {
+      for(int32_t c = 0; c < 4; ++c)
+      {
+        if(std::abs(single_ptr[p][c] - batch_ptr[p][c]) > 1e-5f)
+        {
+          differences++;
+          break;
+        }
+      }
+    }
+    EXPECT_EQ (differences, 0);
+  }
+
+  batch[1].composite_background();
+  batch[1].save(output_file);
+}
+
+TEST (dray_multi_render, dray_compact_framebuffer)
+{
+  std::string output_path = prepare_output_dir ();
+  std::string output_file =
+  conduit::utils::join_file_path (output_path, "compact_framebuffer");
+  remove_test_image (output_file);
+
+  std::string root_file = std::string (DATA_DIR) + "taylor_green.cycle_000190.root";
+  dray::Collection collection = dray::BlueprintReader::load (root_file);
+
+  dray::Camera camera;
+  camera.set_width (256);
+  camera.set_height (256);
+  camera.reset_to_bounds(collection.bounds());
+  camera.azimuth(-40);
+  camera.elevate(-40);
+
+  std::shared_ptr<dray::Surface> surface
+    = std::make_shared<dray::Surface>(collection);
+  surface->field("density");
+
+  dray::Renderer renderer;
+  renderer.add(surface);
+
+  dray::Framebuffer reference = renderer.render(camera);
+  EXPECT_EQ (reference.format(), dray::RGBA32F);
+
+  // the allowed color error of each format
+  const dray::PixelFormat formats[2] = {dray::RGBA16F, dray::RGBA8};
+  const float color_eps[2] = {1e-3f, 0.5f / 255.f + 1e-6f};
+  for(int32_t f = 0; f < 2; ++f)
+  {
+    renderer.composite_format(formats[f]);
+    dray::Framebuffer compact = renderer.render(camera);
+    EXPECT_EQ (compact.format(), formats[f]);
+
+    const int32_t size = reference.colors().size();
+    const dray::Vec<float,4> *ref_colors = reference.colors().get_host_ptr_const();
+    const dray::Vec<float,4> *colors = compact.colors().get_host_ptr_const();
+    const float *ref_depths = reference.depths().get_host_ptr_const();
+    const float *depths = compact.depths().get_host_ptr_const();
+    int32_t differences = 0;
+    for(int32_t i = 0; i < size; ++i)
+    {
+      bool same = true;
+      for(int32_t c = 0; c < 4; ++c)
+      {
+        same &= std::abs(ref_colors[i][c] - colors[i][c]) <= color_eps[f];
+      }
+      // depths keep 15 bits of mantissa
+      if(ref_depths[i] != depths[i])
+      {
+        same &= std::abs(ref_depths[i] - depths[i]) <= ref_depths[i] / 32768.f;
+      }
+      differences += same ? 0 : 1;
+    }
+    EXPECT_EQ (differences, 0);
+  }
+
+  dray::Framebuffer compact = renderer.render(camera);
+  compact.composite_background();
+  compact.save(output_file);
+}
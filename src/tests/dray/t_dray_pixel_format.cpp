@@ -0,0 +1,102 @@
+// Copyright 2019 Lawrence Livermore National Security, LLC and other
+// Devil Ray Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (BSD-3-Clause)
+
+#include "gtest/gtest.h"
+
+#include <dray/rendering/pixel_format.hpp>
+
+#include <cmath>
+#include <limits>
+
+using namespace dray;
+
+TEST (dray_pixel_format, dray_float_to_half)
+{
+  EXPECT_EQ (detail::float_to_half(0.f), 0x0000);
+  EXPECT_EQ (detail::float_to_half(-0.f), 0x8000);
+  EXPECT_EQ (detail::float_to_half(1.f), 0x3c00);
+  EXPECT_EQ (detail::float_to_half(-2.f), 0xc000);
+  EXPECT_EQ (detail::float_to_half(65504.f), 0x7bff);
+
+  // overflow goes to inf, including values that only round up to it
+  EXPECT_EQ (detail::float_to_half(1e10f), 0x7c00);
+  EXPECT_EQ (detail::float_to_half(-1e10f), 0xfc00);
+  EXPECT_EQ (detail::float_to_half(65519.f), 0x7bff);
+  EXPECT_EQ (detail::float_to_half(65520.f), 0x7c00);
+  EXPECT_EQ (detail::float_to_half(std::numeric_limits<float32>::infinity()), 0x7c00);
+
+  // nan stays a (quiet) nan
+  const uint16 nan = detail::float_to_half(std::numeric_limits<float32>::quiet_NaN());
+  EXPECT_EQ (nan & 0x7c00, 0x7c00);
+  EXPECT_NE (nan & 0x03ff, 0);
+  EXPECT_TRUE (std::isnan(detail::half_to_float(nan)));
+
+  // subnormals
+  EXPECT_EQ (detail::float_to_half(std::ldexp(1.f, -24)), 0x0001);
+  EXPECT_EQ (detail::float_to_half(std::ldexp(1023.f, -24)), 0x03ff);
+  EXPECT_EQ (detail::float_to_half(std::ldexp(3.f, -26)), 0x0001);
+  // half of the smallest subnormal is a tie and rounds to even zero
+  EXPECT_EQ (detail::float_to_half(std::ldexp(1.f, -25)), 0x0000);
+  EXPECT_EQ (detail::float_to_half(std::ldexp(1.f, -30)), 0x0000);
+
+  // ties round to even
+  EXPECT_EQ (detail::float_to_half(1.f + std::ldexp(1.f, -11)), 0x3c00);
+  EXPECT_EQ (detail::float_to_half(1.f + std::ldexp(3.f, -11)), 0x3c02);
+
+  // a carry out of the mantissa bumps the exponent
+  EXPECT_EQ (detail::float_to_half(1.9999999f), 0x4000);
+  EXPECT_EQ (detail::float_to_half(std::ldexp(1.f - std::ldexp(1.f, -12), -14)), 0x0400);
+}
+
+TEST (dray_pixel_format, dray_half_round_trip)
+{
+  // every finite half survives the trip through float
+  int32 errors = 0;
+  for(int32 h = 0; h < 0x10000; ++h)
+  {
+    if((h & 0x7c00) == 0x7c00 && (h & 0x03ff) != 0)
+    {
+      continue;
+    }
+    if(detail::float_to_half(detail::half_to_float(uint16(h))) != h)
+    {
+      errors++;
+    }
+  }
+  EXPECT_EQ (errors, 0);
+}
+
+TEST (dray_pixel_format, dray_pack_pixel)
+{
+  const PixelFormat formats[3] = {RGBA32F, RGBA16F, RGBA8};
+  const Vec<float32,4> color = {{0.25f, 0.5f, 0.75f, 1.f}};
+  const float32 depth = 3.5f;
+  for(int32 f = 0; f < 3; ++f)
+  {
+    uint8 packed[20];
+    detail::pack_pixel(formats[f], color, depth, packed);
+    Vec<float32,4> res_color;
+    float32 res_depth;
+    detail::unpack_pixel(formats[f], packed, res_color, res_depth);
+    // depths with a short mantissa are exact in the 24 bit depth
+    EXPECT_EQ (res_depth, depth);
+    for(int32 c = 0; c < 4; ++c)
+    {
+      EXPECT_NEAR (res_color[c], color[c], 1.f / 255.f);
+    }
+  }
+
+  // truncating the depth keeps the order of hit distances
+  uint8 near_packed[7];
+  uint8 far_packed[7];
+  detail::pack_pixel(RGBA8, color, 1.f, near_packed);
+  detail::pack_pixel(RGBA8, color, 1.f + std::ldexp(1.f, -14), far_packed);
+  Vec<float32,4> unused;
+  float32 near_depth;
+  float32 far_depth;
+  detail::unpack_pixel(RGBA8, near_packed, unused, near_depth);
+  detail::unpack_pixel(RGBA8, far_packed, unused, far_depth);
+  EXPECT_LT (near_depth, far_depth);
+}
@@ -18,6 +18,8 @@
 
 #include <dray/math.hpp>
 
+#include <algorithm>
+#include <cmath>
 #include <fstream>
 #include <stdlib.h>
 
@@ -79,3 +81,81 @@ TEST (dray_reflect, dray_reflect_2d)
   fb.save_depth (output_file + "_depth");
   dray::stats::StatStore::write_ray_stats (c_width, c_height);
 }
+
+TEST (dray_reflect, dray_reflect_instanced)
+{
+  std::string root_file = std::string (DATA_DIR) + "taylor_green_2d.cycle_000050.root";
+  std::string output_path = prepare_output_dir ();
+  std::string output_file =
+  conduit::utils::join_file_path (output_path, "tg_2d_reflect_instanced");
+  remove_test_image (output_file);
+
+  dray::Collection collection = dray::BlueprintReader::load (root_file);
+
+  dray::Vec<float,3> point = {0.f, 0.f, 0.f};
+  dray::Vec<float,3> normal = {0.f, 1.f, 0.f};
+
+  dray::Reflect reflector;
+  reflector.plane(point, normal);
+  dray::Collection copied = reflector.execute(collection);
+  reflector.instanced(true);
+  dray::Collection instanced = reflector.execute(collection);
+
+  // no geometry is copied
+  EXPECT_EQ(instanced.domain(0).mesh(), collection.domain(0).mesh());
+  EXPECT_TRUE(instanced.domain(0).has_transform());
+
+  dray::AABB<3> copied_bounds = copied.bounds();
+  dray::AABB<3> instanced_bounds = instanced.bounds();
+  for(int i = 0; i < 3; ++i)
+  {
+    EXPECT_NEAR(copied_bounds.m_ranges[i].min(), instanced_bounds.m_ranges[i].min(), 1e-5);
+    EXPECT_NEAR(copied_bounds.m_ranges[i].max(), instanced_bounds.m_ranges[i].max(), 1e-5);
+  }
+
+  dray::ColorTable color_table ("Spectral");
+
+  dray::Camera camera;
+  camera.set_width (512);
+  camera.set_height (512);
+  camera.reset_to_bounds (copied_bounds);
+  camera.azimuth(20);
+
+  std::shared_ptr<dray::Surface> copied_surface
+    = std::make_shared<dray::Surface>(copied);
+  copied_surface->field("density");
+  copied_surface->color_map().color_table(color_table);
+
+  std::shared_ptr<dray::Surface> instanced_surface
+    = std::make_shared<dray::Surface>(instanced);
+  instanced_surface->field("density");
+  instanced_surface->color_map().color_table(color_table);
+
+  dray::Renderer renderer;
+  renderer.add(copied_surface);
+  dray::Framebuffer copied_fb = renderer.render(camera);
+
+  renderer.clear();
+  renderer.add(instanced_surface);
+  dray::Framebuffer instanced_fb = renderer.render(camera);
+  instanced_fb.save(output_file);
+
+  const int size = copied_fb.colors().size();
+  const dray::Vec<float,4> *copied_ptr = copied_fb.colors().get_host_ptr_const();
+  const dray::Vec<float,4> *instanced_ptr = instanced_fb.colors().get_host_ptr_const();
+  int differences = 0;
+  for(int i = 0; i < size; ++i)
+  {
+    float diff = 0.f;
+    for(int c = 0; c < 4; ++c)
+    {
+      diff = std::max(diff, std::abs(copied_ptr[i][c] - instanced_ptr[i][c]));
+    }
+    if(diff > 0.01f)
+    {
+      differences++;
+    }
+  }
+  // allow for a few pixels on the silhouette
+  EXPECT_LT(differences, size / 1000);
+}
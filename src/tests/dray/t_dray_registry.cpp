@@ -8,6 +8,46 @@
 #include <dray/array_registry.hpp>
 #include <dray/dray.hpp>
 
+// first in the file, the pools are sized when the first array allocates
+TEST (dray_array, dray_registry_frame_arena)
+{
+  // a pool much smaller than one frame, so the first frame has to grow it
+  ASSERT_TRUE (dray::ArrayRegistry::pool_size (64 * 1024));
+
+  // the pools already exist, so changing the strategy is refused
+  dray::Array<int> warm_up;
+  warm_up.resize (1);
+  warm_up.get_host_ptr ();
+  ASSERT_FALSE (dray::ArrayRegistry::pool_strategy (dray::ArrayRegistry::None));
+  ASSERT_TRUE (dray::ArrayRegistry::pool_strategy (dray::ArrayRegistry::Quick));
+  ASSERT_FALSE (dray::ArrayRegistry::pool_size (1024));
+
+  for (int frame = 0; frame < 3; ++frame)
+  {
+    {
+      dray::FrameArena arena;
+      dray::Array<float> transient;
+      transient.resize (1024 * 1024);
+      transient.get_host_ptr ();
+
+      dray::ArrayRegistry::PoolStats stats = dray::ArrayRegistry::host_pool_stats ();
+      ASSERT_GE (stats.m_current, 1024 * 1024 * sizeof (float));
+      ASSERT_GE (stats.m_high_water, stats.m_current);
+    }
+
+    if (frame == 0)
+    {
+      // grown, then coalesced into one block
+      ASSERT_GE (dray::ArrayRegistry::frame_growth (), 1024 * 1024 * sizeof (float));
+    }
+    else
+    {
+      // identical frames are served from the merged block
+      ASSERT_EQ (dray::ArrayRegistry::frame_growth (), 0);
+    }
+  }
+}
+
 TEST (dray_array, dray_registry_basic)
 {
   dray::Array<int> int_array;
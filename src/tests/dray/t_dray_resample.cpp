@@ -0,0 +1,118 @@
+// Copyright 2019 Lawrence Livermore National Security, LLC and other
+// Devil Ray Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (BSD-3-Clause)
+
+#include "test_config.h"
+#include "gtest/gtest.h"
+
+#include "t_utils.hpp"
+#include <dray/io/blueprint_reader.hpp>
+#include <dray/filters/resample_to_uniform.hpp>
+#include <dray/queries/point_location.hpp>
+
+#include <dray/error.hpp>
+#include <dray/math.hpp>
+
+#include <conduit_blueprint.hpp>
+#include <conduit_relay.hpp>
+
+using namespace dray;
+
+TEST (dray_resample, dray_resample_to_uniform)
+{
+  std::string output_path = prepare_output_dir ();
+  std::string output_file =
+  conduit::utils::join_file_path (output_path, "tg_resample");
+
+  std::string root_file = std::string (DATA_DIR) + "taylor_green.cycle_001860.root";
+
+  Collection collection = dray::BlueprintReader::load (root_file);
+
+  const int32 nx = 17;
+  const int32 ny = 13;
+  const int32 nz = 9;
+  const Float empty = -1000.f;
+
+  // the data set bounds are [0,1] on each axis, stay inside of them
+  AABB<3> bounds;
+  bounds.include(Vec<Float,3>({{0.01f, 0.01f, 0.01f}}));
+  bounds.include(Vec<Float,3>({{0.99f, 0.99f, 0.99f}}));
+
+  ResampleToUniform resampler;
+  resampler.bounds(bounds);
+  resampler.dims(nx, ny, nz);
+  resampler.empty_val(empty);
+  // force several slabs
+  resampler.slab_size(2);
+  resampler.add_var("density");
+
+  conduit::Node mesh;
+  resampler.execute(collection, mesh);
+
+  conduit::Node info;
+  EXPECT_TRUE (conduit::blueprint::mesh::verify(mesh, info));
+
+  // compare against locating every lattice point
+  Array<Vec<Float,3>> points;
+  points.resize(nx * ny * nz);
+  Vec<Float,3> *points_ptr = points.get_host_ptr();
+  for(int32 k = 0; k < nz; ++k)
+    for(int32 j = 0; j < ny; ++j)
+      for(int32 i = 0; i < nx; ++i)
+      {
+        Vec<Float,3> point;
+        point[0] = 0.01f + 0.98f * Float(i) / Float(nx - 1);
+        point[1] = 0.01f + 0.98f * Float(j) / Float(ny - 1);
+        point[2] = 0.01f + 0.98f * Float(k) / Float(nz - 1);
+        points_ptr[(k * ny + j) * nx + i] = point;
+      }
+
+  PointLocation locator;
+  locator.empty_val(empty);
+  locator.add_var("density");
+  PointLocation::Result res = locator.execute(collection, points);
+
+  conduit::Node &n_values = mesh["fields/density/values"];
+  const int32 size = n_values.dtype().number_of_elements();
+  ASSERT_EQ (size, nx * ny * nz);
+
+  // values are stored as Float, which may be either precision
+  conduit::Node n_float64;
+  n_values.to_float64_array(n_float64);
+  conduit::float64_array values = n_float64.value();
+
+  const Float *expected = res.m_values[0].get_host_ptr();
+  int32 found = 0;
+  for(int32 i = 0; i < size; ++i)
+  {
+    const Float value = values[i];
+    EXPECT_NEAR (value, expected[i], 1e-3);
+    found += value != empty ? 1 : 0;
+  }
+  EXPECT_EQ (found, size);
+
+  conduit::relay::io::blueprint::save_mesh(mesh, output_file + ".blueprint_root_hdf5");
+}
+
+TEST (dray_resample, dray_resample_to_uniform_too_large)
+{
+  std::string root_file = std::string (DATA_DIR) + "taylor_green.cycle_001860.root";
+
+  Collection collection = dray::BlueprintReader::load (root_file);
+
+  ResampleToUniform resampler;
+  resampler.add_var("density");
+
+  // a single plane past the int32 range
+  resampler.dims(70000, 70000, 1);
+  conduit::Node mesh;
+  EXPECT_THROW (resampler.execute(collection, mesh), dray::DRayError);
+
+  // planes fit but the whole grid does not
+  if(sizeof(index_int) == sizeof(int32))
+  {
+    resampler.dims(40000, 40000, 40000);
+    EXPECT_THROW (resampler.execute(collection, mesh), dray::DRayError);
+  }
+}
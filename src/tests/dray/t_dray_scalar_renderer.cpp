@@ -12,10 +12,13 @@
 #include <dray/rendering/scalar_renderer.hpp>
 #include <dray/rendering/slice_plane.hpp>
 #include <dray/rendering/surface.hpp>
+#include <dray/transform_3d.hpp>
 
 #include <conduit_relay.hpp>
 #include <conduit_blueprint.hpp>
 
+#include <cmath>
+
 void setup_camera (dray::Camera &camera)
 {
   camera.set_width (512);
@@ -139,3 +142,148 @@ TEST (dray_scalar_renderer, dray_triple_plane)
   sb.to_node(mesh);
   conduit::relay::io::blueprint::save_mesh(mesh, output_file + ".blueprint_root_hdf5");
 }
+
+TEST (dray_scalar_renderer, dray_triple_plane_sample)
+{
+  std::string root_file = std::string(DATA_DIR) + "tripple_point/field_dump.cycle_006700.root";
+  std::string output_path = prepare_output_dir ();
+  std::string output_file =
+  conduit::utils::join_file_path (output_path, "triple_scalar_plane_sample");
+  remove_test_image (output_file);
+
+  dray::Collection collection = dray::BlueprintReader::load (root_file);
+
+  dray::AABB<3> bounds = collection.bounds();
+  dray::Vec<float32,3> center = bounds.center();
+
+  dray::PlaneDetector det;
+  det.m_view = {{0,0,1}};
+  det.m_up = {{0,1,0}};
+  det.m_center = {{center[0], center[1], center[2]}};
+  det.m_x_res = 256;
+  det.m_y_res = 128;
+  det.m_plane_width = bounds.m_ranges[0].length() * 1.1f;
+  det.m_plane_height = bounds.m_ranges[1].length() * 1.1f;
+
+  std::shared_ptr<dray::SlicePlane> slicer
+    = std::make_shared<dray::SlicePlane>(collection);
+  dray::Vec<float32,3> normal = {{0.f, 0.f, 1.f}};
+  slicer->point(center);
+  slicer->normal(normal);
+  slicer->field("density");
+
+  dray::ScalarRenderer renderer;
+  renderer.set(slicer);
+  renderer.field_names({"density"});
+  dray::ScalarBuffer sampled = renderer.sample(det);
+
+  // the traced version needs the rays to start in front of the slice
+  dray::PlaneDetector traced_det = det;
+  traced_det.m_center[2] -= bounds.m_ranges[2].length();
+  dray::ScalarBuffer traced = renderer.render(traced_det);
+
+  const int32 size = sampled.size();
+  const dray::Float *sampled_ptr = sampled.m_scalars["density"].get_host_ptr();
+  const dray::Float *traced_ptr = traced.m_scalars["density"].get_host_ptr();
+  int32 sampled_hits = 0;
+  int32 traced_hits = 0;
+  int32 mismatches = 0;
+  for(int32 i = 0; i < size; ++i)
+  {
+    const bool s_hit = sampled_ptr[i] == sampled_ptr[i];
+    const bool t_hit = traced_ptr[i] == traced_ptr[i];
+    sampled_hits += s_hit ? 1 : 0;
+    traced_hits += t_hit ? 1 : 0;
+    if(s_hit && t_hit && std::abs(sampled_ptr[i] - traced_ptr[i]) > 1e-3f)
+    {
+      mismatches++;
+    }
+  }
+  EXPECT_GT (sampled_hits, 0);
+  EXPECT_NEAR (sampled_hits, traced_hits, size / 100);
+  EXPECT_LT (mismatches, size / 100);
+
+  conduit::Node mesh;
+  sampled.to_node(mesh);
+  conduit::relay::io::blueprint::save_mesh(mesh, output_file + ".blueprint_root_hdf5");
+}
+
+TEST (dray_scalar_renderer, dray_triple_plane_sample_instanced)
+{
+  std::string root_file = std::string(DATA_DIR) + "tripple_point/field_dump.cycle_006700.root";
+
+  dray::Collection collection = dray::BlueprintReader::load (root_file);
+
+  // the same domains, moved by a rigid transform
+  const dray::Vec<float32,3> offset = {{2.f, -1.f, 3.f}};
+  dray::Collection moved;
+  for(int32 i = 0; i < collection.local_size(); ++i)
+  {
+    dray::DataSet domain = collection.domain(i);
+    domain.transform(dray::translate<dray::Float>(offset[0], offset[1], offset[2]));
+    moved.add_domain(domain);
+  }
+
+  dray::AABB<3> bounds = collection.bounds();
+  dray::Vec<float32,3> center = bounds.center();
+
+  dray::PlaneDetector det;
+  det.m_view = {{0,0,1}};
+  det.m_up = {{0,1,0}};
+  det.m_center = {{center[0], center[1], center[2]}};
+  det.m_x_res = 128;
+  det.m_y_res = 64;
+  det.m_plane_width = bounds.m_ranges[0].length() * 1.1f;
+  det.m_plane_height = bounds.m_ranges[1].length() * 1.1f;
+
+  dray::PlaneDetector moved_det = det;
+  moved_det.m_center = {{center[0] + offset[0],
+                         center[1] + offset[1],
+                         center[2] + offset[2]}};
+
+  dray::Vec<float32,3> normal = {{0.f, 0.f, 1.f}};
+  std::shared_ptr<dray::SlicePlane> slicer
+    = std::make_shared<dray::SlicePlane>(collection);
+  slicer->point(center);
+  slicer->normal(normal);
+  slicer->field("density");
+  std::shared_ptr<dray::SlicePlane> moved_slicer
+    = std::make_shared<dray::SlicePlane>(moved);
+  moved_slicer->point(center + offset);
+  moved_slicer->normal(normal);
+  moved_slicer->field("density");
+
+  dray::ScalarRenderer renderer(slicer);
+  renderer.field_names({"density"});
+  dray::ScalarBuffer sampled = renderer.sample(det);
+  // shared faces always resolve to the same element
+  dray::ScalarBuffer resampled = renderer.sample(det);
+
+  dray::ScalarRenderer moved_renderer(moved_slicer);
+  moved_renderer.field_names({"density"});
+  dray::ScalarBuffer moved_sampled = moved_renderer.sample(moved_det);
+
+  const int32 size = sampled.size();
+  const int32 *zone_ptr = sampled.m_zone_ids.get_host_ptr_const();
+  const int32 *rezone_ptr = resampled.m_zone_ids.get_host_ptr_const();
+  const dray::Float *sampled_ptr = sampled.m_scalars["density"].get_host_ptr();
+  const dray::Float *moved_ptr = moved_sampled.m_scalars["density"].get_host_ptr();
+  int32 hits = 0;
+  int32 moved_hits = 0;
+  int32 mismatches = 0;
+  for(int32 i = 0; i < size; ++i)
+  {
+    EXPECT_EQ (zone_ptr[i], rezone_ptr[i]);
+    const bool hit = sampled_ptr[i] == sampled_ptr[i];
+    const bool moved_hit = moved_ptr[i] == moved_ptr[i];
+    hits += hit ? 1 : 0;
+    moved_hits += moved_hit ? 1 : 0;
+    if(hit && moved_hit && std::abs(sampled_ptr[i] - moved_ptr[i]) > 1e-3f)
+    {
+      mismatches++;
+    }
+  }
+  EXPECT_GT (hits, 0);
+  EXPECT_NEAR (hits, moved_hits, size / 100);
+  EXPECT_LT (mismatches, size / 100);
+}
@@ -12,6 +12,8 @@
 #include <dray/rendering/slice_plane.hpp>
 #include <dray/utils/appstats.hpp>
 
+#include <cmath>
+
 dray::PointLight default_light(dray::Camera &camera)
 {
   dray::Vec<float32,3> look_at = camera.get_look_at();
@@ -192,3 +194,85 @@ TEST (dray_slice, dray_three_slice)
   //dray::stats::StatStore::write_point_stats ("locate_stats");
   EXPECT_TRUE (check_test_image (output_file));
 }
+
+TEST (dray_slice, dray_multi_plane_slice)
+{
+  std::string output_path = prepare_output_dir ();
+  std::string output_file =
+  conduit::utils::join_file_path (output_path, "multi_plane_slice");
+  remove_test_image (output_file);
+
+  std::string root_file = std::string (DATA_DIR) + "taylor_green.cycle_001860.root";
+
+  dray::Collection collection = dray::BlueprintReader::load (root_file);
+
+  dray::Camera camera;
+  setup_camera_three_slice(camera);
+  dray::PointLight plight = default_light(camera);
+
+  dray::Vec<float, 3> point;
+  point[0] = 0.5f;
+  point[1] = 0.5f;
+  point[2] = 0.5f;
+
+  dray::Vec<float,3> normals[3] = {{1.f, 0.f, 0.f},
+                                   {0.f, 1.f, 0.f},
+                                   {0.f, 0.f, 1.f}};
+
+  dray::ColorMap color_map("cool2warm");
+
+  // the same three planes, once as separate traceables
+  // and once in a single pass
+  dray::Renderer separate;
+  for(int i = 0; i < 3; ++i)
+  {
+    std::shared_ptr<dray::SlicePlane> slicer
+      = std::make_shared<dray::SlicePlane>(collection);
+    slicer->field("density");
+    slicer->color_map(color_map);
+    slicer->point(point);
+    slicer->normal(normals[i]);
+    separate.add(slicer);
+  }
+  separate.add_light(plight);
+
+  std::shared_ptr<dray::SlicePlane> multi
+    = std::make_shared<dray::SlicePlane>(collection);
+  multi->field("density");
+  multi->color_map(color_map);
+  multi->point(point);
+  multi->normal(normals[0]);
+  multi->add_plane(point, normals[1]);
+  multi->add_plane(point, normals[2]);
+  EXPECT_EQ (multi->num_planes(), 3);
+
+  dray::Renderer renderer;
+  renderer.add(multi);
+  renderer.add_light(plight);
+
+  dray::Framebuffer expected = separate.render(camera);
+  dray::Framebuffer fb = renderer.render(camera);
+
+  dray::Array<float32> expected_depths = expected.depths();
+  dray::Array<float32> depths = fb.depths();
+  const float32 *expected_ptr = expected_depths.get_host_ptr();
+  const float32 *depths_ptr = depths.get_host_ptr();
+  const int32 size = depths.size();
+  int32 mismatches = 0;
+  for(int32 i = 0; i < size; ++i)
+  {
+    const bool expected_hit = expected_ptr[i] < dray::infinity32();
+    const bool hit = depths_ptr[i] < dray::infinity32();
+    if(expected_hit != hit ||
+       (hit && std::abs(expected_ptr[i] - depths_ptr[i]) > 1e-3f))
+    {
+      mismatches++;
+    }
+  }
+  // only pixels along the plane intersections may differ
+  EXPECT_LT (mismatches, size / 100);
+
+  fb.composite_background();
+  fb.save (output_file);
+  EXPECT_TRUE (check_test_file (output_file + ".png"));
+}
@@ -17,6 +17,7 @@
 #include <dray/utils/appstats.hpp>
 
 #include <dray/math.hpp>
+#include <dray/location.hpp>
 
 #include <fstream>
 #include <stdlib.h>
@@ -67,3 +68,53 @@ TEST (dray_vector_ops, dray_vector_component)
   fb.save_depth (output_file + "_depth");
   dray::stats::StatStore::write_ray_stats (c_width, c_height);
 }
+
+TEST (dray_vector_ops, dray_vector_component_values)
+{
+  std::string root_file = std::string (DATA_DIR) + "taylor_green.cycle_001860.root";
+
+  dray::Collection collection = dray::BlueprintReader::load (root_file);
+  dray::DataSet domain = collection.domain(0);
+  std::shared_ptr<dray::Field> velocity = domain.field_shared("velocity");
+  std::vector<dray::Range> vel_ranges = velocity->range();
+
+  // the first vertex of each element, where the basis interpolates the
+  // first control point
+  const dray::int32 num_elems = domain.mesh()->cells();
+  dray::Array<dray::Location> locs;
+  locs.resize(num_elems);
+  dray::Location *locs_ptr = locs.get_host_ptr();
+  for(dray::int32 i = 0; i < num_elems; ++i)
+  {
+    locs_ptr[i].m_cell_id = i;
+    locs_ptr[i].m_ref_pt = {{0.f, 0.f, 0.f}};
+  }
+
+  conduit::Node n_velocity;
+  velocity->to_node(n_velocity);
+  const conduit::Node &n_gf = n_velocity["grid_function"];
+  const dray::int32 el_dofs = n_gf["dofs_per_element"].to_int32();
+  const dray::int32 *conn_ptr = n_gf["conn"].as_int32_ptr();
+  const dray::Float *vel_ptr
+    = static_cast<const dray::Float*>(n_gf["values"].data_ptr());
+
+  for(dray::int32 comp = 0; comp < 3; ++comp)
+  {
+    std::shared_ptr<dray::Field> component
+      = dray::VectorComponent::execute(velocity.get(), comp);
+    EXPECT_EQ(component->components(), 1);
+
+    std::vector<dray::Range> comp_range = component->range();
+    EXPECT_FLOAT_EQ(comp_range[0].min(), vel_ranges[comp].min());
+    EXPECT_FLOAT_EQ(comp_range[0].max(), vel_ranges[comp].max());
+
+    dray::Array<dray::Float> values;
+    component->eval(locs, values);
+    const dray::Float *values_ptr = values.get_host_ptr_const();
+    for(dray::int32 i = 0; i < num_elems; ++i)
+    {
+      const dray::int32 ctrl = conn_ptr[i * el_dofs];
+      EXPECT_NEAR(values_ptr[i], vel_ptr[ctrl * 3 + comp], 1e-5);
+    }
+  }
+}
@@ -0,0 +1,147 @@
+// Copyright 2019 Lawrence Livermore National Security, LLC and other
+// Devil Ray Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: (BSD-3-Clause)
+
+#include <dray/dray.hpp>
+#include <dray/filters/mesh_boundary.hpp>
+#include <dray/rendering/renderer.hpp>
+#include <dray/rendering/surface.hpp>
+#include <dray/utils/appstats.hpp>
+#include <dray/utils/image_writer.hpp>
+#include <dray/utils/timer.hpp>
+
+#include "parsing.hpp"
+#include <conduit.hpp>
+#include <iostream>
+#include <sstream>
+
+std::string image_name(const std::string &prefix, const int index)
+{
+  std::stringstream ss;
+  ss<<prefix<<"_"<<index;
+  return ss.str();
+}
+
+int main (int argc, char *argv[])
+{
+  init_furnace();
+
+  std::string config_file = "";
+
+  if (argc != 2)
+  {
+    std::cout << "Missing configure file name\n";
+    exit (1);
+  }
+
+  config_file = argv[1];
+
+  Config config (config_file);
+  config.load_data ();
+  config.load_camera ();
+  config.load_field ();
+
+  int trials = 5;
+  // parse any custon info out of config
+  if (config.m_config.has_path ("trials"))
+  {
+    trials = config.m_config["trials"].to_int32 ();
+  }
+
+  // views on an orbit around the configured camera
+  int views = 32;
+  if (config.m_config.has_path ("views"))
+  {
+    views = config.m_config["views"].to_int32 ();
+  }
+
+  int batch_size = 8;
+  if (config.m_config.has_path ("batch_size"))
+  {
+    batch_size = config.m_config["batch_size"].to_int32 ();
+  }
+
+  dray::MeshBoundary boundary;
+  dray::Collection faces = boundary.execute(config.m_collection);
+
+  std::shared_ptr<dray::Surface> surface
+    = std::make_shared<dray::Surface>(faces);
+  surface->field(config.m_field);
+
+  if(config.has_color_table())
+  {
+    config.load_color_table();
+    surface->color_map().color_table(config.m_color_table);
+  }
+
+  std::vector<dray::Camera> cameras;
+  for (int i = 0; i < views; ++i)
+  {
+    dray::Camera camera = config.m_camera;
+    camera.azimuth(360.f * float(i) / float(views));
+    cameras.push_back(camera);
+  }
+
+  // views only share launches with a fixed light
+  dray::AABB<3> bounds = faces.bounds();
+  dray::PointLight light;
+  light.m_pos = config.m_camera.get_pos();
+  light.m_pos[1] += bounds.max_length();
+  light.m_amb = { 0.4f, 0.4f, 0.4f };
+  light.m_diff = { 0.75f, 0.75f, 0.75f };
+  light.m_spec = { 0.3f, 0.3f, 0.3f };
+  light.m_spec_pow = 90.0;
+
+  dray::Renderer renderer;
+  renderer.add(surface);
+  renderer.add_light(light);
+  renderer.batch_size(batch_size);
+
+  const int rank = dray::dray::mpi_rank();
+  // only rank 0 holds the composited images
+  dray::ImageWriter writer;
+
+  float single_time = 0.f;
+  float batch_time = 0.f;
+  for (int t = 0; t < trials; ++t)
+  {
+    dray::Timer timer;
+    for (int i = 0; i < views; ++i)
+    {
+      dray::Framebuffer fb = renderer.render(cameras[i]);
+      if(rank == 0)
+      {
+        writer.write(fb, image_name("single", i));
+      }
+    }
+    writer.wait();
+    single_time += timer.elapsed();
+
+    timer.reset();
+    renderer.render_batch(cameras,
+                          [&](const dray::int32 index, dray::Framebuffer &fb)
+                          {
+                            if(rank == 0)
+                            {
+                              writer.write(fb, image_name("batch", index));
+                            }
+                          });
+    writer.wait();
+    batch_time += timer.elapsed();
+  }
+
+  if(rank == 0)
+  {
+    const float images = float(views) * float(trials);
+    std::cout<<"views "<<views<<" batch size "<<batch_size
+             <<" trials "<<trials<<"\n";
+    std::cout<<"single renders: "<<images / single_time<<" images/sec\n";
+    std::cout<<"batch renders:  "<<images / batch_time<<" images/sec\n";
+  }
+
+  dray::stats::StatStore::write_ray_stats (config.m_camera.get_width (),
+                                           config.m_camera.get_height ());
+
+  finalize_furnace();
+}